@@ -0,0 +1,152 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Size and speed of a telemetry message as JSON text, CBOR and MessagePack:
+ * eight scalar readings and two 16-sample arrays, one of integers and one of
+ * fractions, encoded into a buffer and decoded back:
+ *
+ *     parson_binary_bench [rounds]
+ *
+ * Each time is the best of rounds.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parson_sl.h"
+
+#define SAMPLES     16
+#define BUFFER_SIZE 4096
+
+typedef size_t (*SIZE_FUNCTION)(const JSON_Value* value);
+typedef JSON_Status (*ENCODE_FUNCTION)(const JSON_Value* value, char* buffer, size_t size);
+typedef JSON_Value* (*DECODE_FUNCTION)(const char* buffer, size_t size);
+
+static double Now(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e6 + (double)now.tv_nsec / 1e3;
+}
+
+static JSON_Value* MakeMessage(void)
+{
+    JSON_Value* message = json_value_init_object();
+    JSON_Object* object = json_object(message);
+    JSON_Value* counts = json_value_init_array();
+    JSON_Value* levels = json_value_init_array();
+    int i;
+
+    if ((message == NULL) || (counts == NULL) || (levels == NULL))
+    {
+        return NULL;
+    }
+    (void)json_object_set_string(object, "deviceId", "sensor-0042");
+    (void)json_object_set_number(object, "sequence", 123456);
+    (void)json_object_set_number(object, "temperature", 21.375);
+    (void)json_object_set_number(object, "humidity", 47.2);
+    (void)json_object_set_number(object, "pressure", 1013.25);
+    (void)json_object_set_boolean(object, "door", 0);
+    (void)json_object_set_null(object, "fault");
+    (void)json_object_set_number(object, "uptime", 86400);
+    for (i = 0; i < SAMPLES; i++)
+    {
+        (void)json_array_append_number(json_array(counts), i * 37 % 500);
+        (void)json_array_append_number(json_array(levels), i / 7.0);
+    }
+    (void)json_object_set_value(object, "counts", counts);
+    (void)json_object_set_value(object, "levels", levels);
+    return message;
+}
+
+static size_t JsonSize(const JSON_Value* value)
+{
+    return json_serialization_size(value) - 1;
+}
+
+static JSON_Status JsonEncode(const JSON_Value* value, char* buffer, size_t size)
+{
+    return json_serialize_to_buffer(value, buffer, size);
+}
+
+static JSON_Value* JsonDecode(const char* buffer, size_t size)
+{
+    (void)size;
+    return json_parse_string(buffer);
+}
+
+static JSON_Status CborEncode(const JSON_Value* value, char* buffer, size_t size)
+{
+    return json_serialize_to_buffer_cbor(value, buffer, size);
+}
+
+static JSON_Value* CborDecode(const char* buffer, size_t size)
+{
+    return json_parse_cbor(buffer, size);
+}
+
+static JSON_Status MsgpackEncode(const JSON_Value* value, char* buffer, size_t size)
+{
+    return json_serialize_to_buffer_msgpack(value, buffer, size);
+}
+
+static JSON_Value* MsgpackDecode(const char* buffer, size_t size)
+{
+    return json_parse_msgpack(buffer, size);
+}
+
+int main(int argc, char** argv)
+{
+    static const char* const names[] = { "JSON", "CBOR", "MsgPack" };
+    static const SIZE_FUNCTION sizes[] = { JsonSize, json_serialization_size_cbor, json_serialization_size_msgpack };
+    static const ENCODE_FUNCTION encoders[] = { JsonEncode, CborEncode, MsgpackEncode };
+    static const DECODE_FUNCTION decoders[] = { JsonDecode, CborDecode, MsgpackDecode };
+    int rounds = (argc > 1) ? atoi(argv[1]) : 20000;
+    JSON_Value* message = MakeMessage();
+    JSON_Value* decoded;
+    static char buffer[BUFFER_SIZE];
+    double bestEncode;
+    double bestDecode;
+    double start;
+    double elapsed;
+    size_t size;
+    size_t i;
+    int round;
+
+    if (message == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    (void)printf("%-8s %7s %10s %10s\n", "format", "bytes", "encode", "decode");
+    for (i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        size = sizes[i](message);
+        bestEncode = 1e12;
+        bestDecode = 1e12;
+        for (round = 0; round < rounds; round++)
+        {
+            start = Now();
+            if (encoders[i](message, buffer, sizeof(buffer)) != JSONSuccess)
+            {
+                return EXIT_FAILURE;
+            }
+            elapsed = Now() - start;
+            bestEncode = (elapsed < bestEncode) ? elapsed : bestEncode;
+
+            start = Now();
+            decoded = decoders[i](buffer, size);
+            elapsed = Now() - start;
+            if ((decoded == NULL) || !json_value_equals(decoded, message))
+            {
+                return EXIT_FAILURE;
+            }
+            bestDecode = (elapsed < bestDecode) ? elapsed : bestDecode;
+            json_value_free(decoded);
+        }
+        (void)printf("%-8s %5u B %7.2f us %7.2f us\n", names[i], (unsigned int)size, bestEncode, bestDecode);
+    }
+    json_value_free(message);
+    return EXIT_SUCCESS;
+}
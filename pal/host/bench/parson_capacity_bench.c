@@ -0,0 +1,163 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Building a 1000-item array of numbers and a 256-member object of numbers
+ * and freeing them, growing from the default capacity, with the capacity
+ * given at init and with it reserved after init; and the same growth when
+ * parson can't realloc and copies instead:
+ *
+ *     parson_capacity_bench [rounds]
+ *
+ * Each time is the best of rounds, in which the four take turns. The
+ * allocator counts the calls of one build to malloc and realloc, values
+ * included.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parson_sl.h"
+
+#define ITEMS   1000
+#define MEMBERS 256
+
+typedef enum WAY_TAG
+{
+    WAY_GROW,
+    WAY_INIT,
+    WAY_RESERVE,
+    WAY_COPY,
+    WAY_COUNT
+} WAY;
+
+static char names[MEMBERS][8];
+static unsigned long allocations;
+
+static double Now(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e6 + (double)now.tv_nsec / 1e3;
+}
+
+static void* CountMalloc(size_t size)
+{
+    allocations++;
+    return malloc(size);
+}
+
+static void* CountRealloc(void* block, size_t size)
+{
+    allocations++;
+    return realloc(block, size);
+}
+
+static JSON_Value* BuildArray(WAY way)
+{
+    JSON_Value* value = (way == WAY_INIT) ? json_value_init_array_with_capacity(ITEMS) : json_value_init_array();
+    int i;
+
+    if ((value == NULL) || ((way == WAY_RESERVE) && (json_array_reserve(json_array(value), ITEMS) != JSONSuccess)))
+    {
+        return NULL;
+    }
+    for (i = 0; i < ITEMS; i++)
+    {
+        if (json_array_append_number(json_array(value), i) != JSONSuccess)
+        {
+            return NULL;
+        }
+    }
+    return value;
+}
+
+static JSON_Value* BuildObject(WAY way)
+{
+    JSON_Value* value = (way == WAY_INIT) ? json_value_init_object_with_capacity(MEMBERS) : json_value_init_object();
+    int i;
+
+    if ((value == NULL) || ((way == WAY_RESERVE) && (json_object_reserve(json_object(value), MEMBERS) != JSONSuccess)))
+    {
+        return NULL;
+    }
+    for (i = 0; i < MEMBERS; i++)
+    {
+        if (json_object_set_number(json_object(value), names[i], i) != JSONSuccess)
+        {
+            return NULL;
+        }
+    }
+    return value;
+}
+
+/* Time of one build and free in us, or a negative time if the build failed */
+static double Time(JSON_Value* (*build)(WAY), WAY way, unsigned long* calls)
+{
+    JSON_Value* value;
+    double start;
+
+    json_set_allocation_functions(CountMalloc, free);
+    json_set_reallocation_function((way == WAY_COPY) ? NULL : CountRealloc);
+    allocations = 0;
+    start = Now();
+    value = build(way);
+    if (value == NULL)
+    {
+        return -1;
+    }
+    json_value_free(value);
+    *calls = allocations;
+    return Now() - start;
+}
+
+int main(int argc, char** argv)
+{
+    static const char* const wayNames[] = { "grow", "capacity at init", "reserve", "grow by copying" };
+    int rounds = (argc > 1) ? atoi(argv[1]) : 2000;
+    unsigned long arrayCalls[WAY_COUNT];
+    unsigned long objectCalls[WAY_COUNT];
+    double array[WAY_COUNT];
+    double object[WAY_COUNT];
+    double elapsed;
+    int round;
+    int way;
+    int i;
+
+    for (i = 0; i < MEMBERS; i++)
+    {
+        (void)sprintf(names[i], "key%d", i);
+    }
+    for (way = 0; way < WAY_COUNT; way++)
+    {
+        array[way] = object[way] = 1e12;
+    }
+    // the ways take turns, so the machine's noise falls on all of them alike
+    for (round = 0; round < rounds; round++)
+    {
+        for (way = 0; way < WAY_COUNT; way++)
+        {
+            elapsed = Time(BuildArray, (WAY)way, &arrayCalls[way]);
+            if (elapsed < 0)
+            {
+                return EXIT_FAILURE;
+            }
+            array[way] = (elapsed < array[way]) ? elapsed : array[way];
+            elapsed = Time(BuildObject, (WAY)way, &objectCalls[way]);
+            if (elapsed < 0)
+            {
+                return EXIT_FAILURE;
+            }
+            object[way] = (elapsed < object[way]) ? elapsed : object[way];
+        }
+    }
+
+    (void)printf("%-16s %22s %22s\n", "", "1000-item array", "256-member object");
+    for (way = 0; way < WAY_COUNT; way++)
+    {
+        (void)printf("%-16s %8.2f us %4lu allocs %8.2f us %4lu allocs\n", wayNames[way],
+            array[way], arrayCalls[way], object[way], objectCalls[way]);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Cost of a number to parson_sl.c, against strtod on the same text, for
+ * the kinds of numbers the exact conversion in parse_number takes and those
+ * it leaves to decimal_to_double:
+ *
+ *     parson_number_bench [documents]
+ *
+ * Each kind is an array of NUMBERS numbers parsed documents times; the
+ * times are per number, including the value parson allocates for it.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parson_sl.h"
+
+#define NUMBERS 10000
+
+typedef enum NUMBER_KIND_TAG
+{
+    NUMBER_INTEGER,     /* 0 to 1e9 */
+    NUMBER_SENSOR,      /* a few decimals, as the samples send */
+    NUMBER_ROUND_TRIP,  /* any double as parson serializes it, "%1.17g" */
+    NUMBER_EXPONENT,    /* 6 significant digits, exponent to +-300 */
+    NUMBER_KINDS
+} NUMBER_KIND;
+
+static const char* kindNames[NUMBER_KINDS] = { "integer", "sensor", "round trip", "exponent" };
+
+static volatile double sink; /* keeps the strtod loop */
+
+static uint64_t rngState = 0x2545F4914F6CDD1DULL;
+
+static uint64_t Random(void)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+static double Now(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int PrintNumber(char* text, size_t size, NUMBER_KIND kind)
+{
+    uint64_t bits;
+    double number;
+
+    switch (kind)
+    {
+    case NUMBER_INTEGER:
+        return snprintf(text, size, "%u", (unsigned int)(Random() % 1000000000));
+    case NUMBER_SENSOR:
+        return snprintf(text, size, "%.*f", 1 + (int)(Random() % 3), (double)(Random() % 100000) / 100.0 - 400.0);
+    case NUMBER_ROUND_TRIP:
+        do
+        {
+            bits = Random();
+            (void)memcpy(&number, &bits, sizeof(number));
+        } while ((number * 0.0) != 0.0);
+        return snprintf(text, size, "%1.17g", number);
+    default:
+        return snprintf(text, size, "%u.%05ue%d", 1 + (unsigned int)(Random() % 9),
+            (unsigned int)(Random() % 100000), (int)(Random() % 601) - 300);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int documents = (argc > 1) ? atoi(argv[1]) : 100;
+    size_t capacity = NUMBERS * 32;
+    char* doc = malloc(capacity);
+    char* end;
+    const char* next;
+    double parseTime;
+    double strtodTime;
+    double start;
+    size_t length;
+    int kind;
+    int i;
+    int j;
+
+    if (doc == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    (void)printf("%-12s %12s %12s\n", "numbers", "parson ns", "strtod ns");
+    for (kind = 0; kind < NUMBER_KINDS; kind++)
+    {
+        length = 0;
+        doc[length++] = '[';
+        for (i = 0; i < NUMBERS; i++)
+        {
+            length += (size_t)PrintNumber(doc + length, capacity - length, (NUMBER_KIND)kind);
+            doc[length++] = ',';
+        }
+        doc[length - 1] = ']';
+        doc[length] = '\0';
+
+        start = Now();
+        for (i = 0; i < documents; i++)
+        {
+            JSON_Value* value = json_parse_string(doc);
+            if (value == NULL)
+            {
+                (void)fprintf(stderr, "%s: parse failed\n", kindNames[kind]);
+                return EXIT_FAILURE;
+            }
+            json_value_free(value);
+        }
+        parseTime = Now() - start;
+
+        start = Now();
+        for (i = 0; i < documents; i++)
+        {
+            next = doc + 1;
+            for (j = 0; j < NUMBERS; j++)
+            {
+                sink = strtod(next, &end);
+                next = end + 1;
+            }
+        }
+        strtodTime = Now() - start;
+
+        (void)printf("%-12s %12.1f %12.1f\n", kindNames[kind],
+            parseTime * 1e9 / ((double)documents * NUMBERS), strtodTime * 1e9 / ((double)documents * NUMBERS));
+    }
+    free(doc);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * What reporting a few changed properties of a 200-property twin costs: the
+ * bytes sent and the time to build them by serializing the whole document,
+ * by diffing it against a copy of the last one sent (and copying it for the
+ * next time), and from the changes its objects tracked:
+ *
+ *     parson_patch_bench [rounds]
+ *
+ * Each time is the best of rounds, for 1, 3 and 5 changed properties.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parson_sl.h"
+
+#define GROUPS      10
+#define PROPERTIES  20
+
+static double Now(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e6 + (double)now.tv_nsec / 1e3;
+}
+
+static JSON_Value* MakeTwin(void)
+{
+    JSON_Value* twin = json_value_init_object();
+    char path[32];
+    int group;
+    int property;
+
+    for (group = 0; group < GROUPS; group++)
+    {
+        for (property = 0; property < PROPERTIES; property++)
+        {
+            (void)sprintf(path, "group%d.property%d", group, property);
+            if (json_object_dotset_number(json_object(twin), path, group * 100 + property) != JSONSuccess)
+            {
+                json_value_free(twin);
+                return NULL;
+            }
+        }
+    }
+    return twin;
+}
+
+/* Changes count properties spread over the groups */
+static void Change(JSON_Object* twin, int count, int round)
+{
+    char path[32];
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        (void)sprintf(path, "group%d.property%d", (i * 3) % GROUPS, (i * 7) % PROPERTIES);
+        (void)json_object_dotset_number(twin, path, round + i + 0.5);
+    }
+}
+
+/* Serializes and frees what would be sent, returns its size */
+static size_t Send(JSON_Value* message)
+{
+    char* text = json_serialize_to_string(message);
+    size_t size = (text != NULL) ? strlen(text) : 0;
+
+    json_free_serialized_string(text);
+    return size;
+}
+
+int main(int argc, char** argv)
+{
+    static const int counts[] = { 1, 3, 5 };
+    int rounds = (argc > 1) ? atoi(argv[1]) : 2000;
+    JSON_Value* twin;
+    JSON_Value* sent;
+    JSON_Value* patch;
+    double best[3];
+    double start;
+    double elapsed;
+    size_t bytes[3];
+    size_t i;
+    int round;
+    int way;
+
+    (void)printf("%7s %16s %16s %16s\n", "changes", "full doc", "diff", "tracked");
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        twin = MakeTwin();
+        sent = json_value_deep_copy(twin);
+        if ((twin == NULL) || (sent == NULL) || (json_object_track_changes(json_object(twin), 1) != JSONSuccess))
+        {
+            return EXIT_FAILURE;
+        }
+        best[0] = best[1] = best[2] = 1e12;
+        for (round = 0; round < rounds; round++)
+        {
+            Change(json_object(twin), counts[i], round);
+            for (way = 0; way < 3; way++)
+            {
+                start = Now();
+                if (way == 0)
+                {
+                    bytes[way] = Send(twin);
+                }
+                else if (way == 1)
+                {
+                    // the diff also needs a copy of what was sent for next time, tracking doesn't
+                    patch = json_value_diff(sent, twin);
+                    bytes[way] = Send(patch);
+                    json_value_free(patch);
+                    json_value_free(sent);
+                    sent = json_value_deep_copy(twin);
+                }
+                else
+                {
+                    patch = json_object_get_changes(json_object(twin));
+                    bytes[way] = Send(patch);
+                    json_value_free(patch);
+                }
+                elapsed = Now() - start;
+                best[way] = (elapsed < best[way]) ? elapsed : best[way];
+            }
+            json_object_clear_changes(json_object(twin));
+        }
+        (void)printf("%7d %6u B %6.2f us %6u B %6.2f us %6u B %6.2f us\n", counts[i],
+            (unsigned int)bytes[0], best[0], (unsigned int)bytes[1], best[1], (unsigned int)bytes[2], best[2]);
+        json_value_free(sent);
+        json_value_free(twin);
+    }
+    return EXIT_SUCCESS;
+}
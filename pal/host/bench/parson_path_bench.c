@@ -0,0 +1,136 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Reading and writing the properties of a device twin with compiled paths
+ * against the dotted-string functions they replace, on a twin with 16
+ * desired and 16 reported properties, 3 levels deep:
+ *
+ *     parson_path_bench [rounds]
+ *
+ * Each time is the best of rounds of 10,000 passes over the paths, divided
+ * down to one call.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parson_sl.h"
+
+#define PROPERTIES 16
+#define PASSES     10000
+
+static double Now(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e6 + (double)now.tv_nsec / 1e3;
+}
+
+/* {"desired":{"settings":{"property0":{"value":..}..}},"reported":{..}} with the paths to each value */
+static JSON_Value* MakeTwin(char paths[][64])
+{
+    JSON_Value* twin = json_value_init_object();
+    char path[64];
+    int section;
+    int i;
+
+    for (section = 0; section < 2; section++)
+    {
+        for (i = 0; i < PROPERTIES; i++)
+        {
+            (void)sprintf(path, "%s.settings.property%d.value", section ? "reported" : "desired", i);
+            if (json_object_dotset_number(json_object(twin), path, i * 1.5) != JSONSuccess)
+            {
+                json_value_free(twin);
+                return NULL;
+            }
+            (void)strcpy(paths[section * PROPERTIES + i], path);
+        }
+    }
+    return twin;
+}
+
+int main(int argc, char** argv)
+{
+    int rounds = (argc > 1) ? atoi(argv[1]) : 20;
+    static char paths[2 * PROPERTIES][64];
+    JSON_Path* compiled[2 * PROPERTIES];
+    JSON_Value* twin = MakeTwin(paths);
+    JSON_Object* root = json_object(twin);
+    double best[4] = { 1e12, 1e12, 1e12, 1e12 };
+    double times[5];
+    double sum = 0;
+    int round;
+    int pass;
+    int i;
+
+    if (twin == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < 2 * PROPERTIES; i++)
+    {
+        compiled[i] = json_path_compile(paths[i]);
+        if (compiled[i] == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (round = 0; round < rounds; round++)
+    {
+        times[0] = Now();
+        for (pass = 0; pass < PASSES; pass++)
+        {
+            for (i = 0; i < 2 * PROPERTIES; i++)
+            {
+                sum += json_object_dotget_number(root, paths[i]);
+            }
+        }
+        times[1] = Now();
+        for (pass = 0; pass < PASSES; pass++)
+        {
+            for (i = 0; i < 2 * PROPERTIES; i++)
+            {
+                sum += json_path_get_number(root, compiled[i]);
+            }
+        }
+        times[2] = Now();
+        for (pass = 0; pass < PASSES; pass++)
+        {
+            for (i = 0; i < 2 * PROPERTIES; i++)
+            {
+                (void)json_object_dotset_number(root, paths[i], pass);
+            }
+        }
+        times[3] = Now();
+        for (pass = 0; pass < PASSES; pass++)
+        {
+            for (i = 0; i < 2 * PROPERTIES; i++)
+            {
+                (void)json_path_set_number(root, compiled[i], pass);
+            }
+        }
+        times[4] = Now();
+        for (i = 0; i < 4; i++)
+        {
+            best[i] = (times[i + 1] - times[i] < best[i]) ? times[i + 1] - times[i] : best[i];
+        }
+    }
+
+    (void)printf("%-5s %12s %12s\n", "", "dotted ns", "compiled ns");
+    (void)printf("%-5s %12.1f %12.1f\n", "get", best[0] * 1e3 / (PASSES * 2 * PROPERTIES),
+        best[1] * 1e3 / (PASSES * 2 * PROPERTIES));
+    (void)printf("%-5s %12.1f %12.1f\n", "set", best[2] * 1e3 / (PASSES * 2 * PROPERTIES),
+        best[3] * 1e3 / (PASSES * 2 * PROPERTIES));
+    (void)printf("(checksum %g)\n", sum);
+
+    for (i = 0; i < 2 * PROPERTIES; i++)
+    {
+        json_path_free(compiled[i]);
+    }
+    json_value_free(twin);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Peak RAM and throughput of the streaming reader against json_parse_string()
+ * on telemetry documents of 1 KB to 512 KB:
+ *
+ *     parson_reader_bench [chunk size]
+ *
+ * The reader is fed chunks of the given size (256 bytes by default, about a
+ * TCP segment on the target) and visits every event. Peak RAM counts parson's
+ * heap, plus the input each needs at once: the whole document for the tree,
+ * one chunk for the reader.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parson_sl.h"
+
+#define MIN_SIZE      1024
+#define MAX_SIZE      (512 * 1024)
+#define BYTES_PER_RUN (64 * 1024 * 1024) /* each size is parsed about this many bytes' worth */
+
+/* Blocks carry their size so free() can account for them */
+typedef union BLOCK_HEADER_TAG
+{
+    size_t size;
+    double alignment;
+} BLOCK_HEADER;
+
+static size_t heapInUse;
+static size_t heapPeak;
+
+static void* CountingMalloc(size_t size)
+{
+    BLOCK_HEADER* block = malloc(sizeof(BLOCK_HEADER) + size);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+    block->size = size;
+    heapInUse += size;
+    if (heapInUse > heapPeak)
+    {
+        heapPeak = heapInUse;
+    }
+    return block + 1;
+}
+
+static void CountingFree(void* ptr)
+{
+    if (ptr != NULL)
+    {
+        BLOCK_HEADER* block = (BLOCK_HEADER*)ptr - 1;
+        heapInUse -= block->size;
+        free(block);
+    }
+}
+
+static double Now(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/* An array of readings as a device would report them, of about size bytes */
+static size_t MakeDocument(char* doc, size_t size)
+{
+    size_t length = 0;
+    unsigned int i = 0;
+
+    doc[length++] = '[';
+    while (length + 160 < size)
+    {
+        length += (size_t)sprintf(doc + length,
+            "%s{\"deviceId\":\"sensor-%04u\",\"temperature\":%.2f,\"humidity\":%u,"
+            "\"pressure\":%.1f,\"ok\":%s,\"tags\":[\"lab\",\"floor-%u\"]}",
+            (i > 0) ? "," : "", i % 10000, 20.0 + (double)(i % 500) / 100.0, 40 + i % 20,
+            1000.0 + (double)(i % 300) / 10.0, (i % 7 != 0) ? "true" : "false", i % 5);
+        i++;
+    }
+    doc[length++] = ']';
+    doc[length] = '\0';
+    return length;
+}
+
+/* Reads doc chunk bytes at a time; returns the number of events, 0 on error */
+static size_t ReadDocument(const char* doc, size_t length, size_t chunk)
+{
+    JSON_Reader* reader = json_reader_init(64, 8);
+    JSON_Reader_Event event;
+    size_t offset = 0;
+    size_t events = 0;
+    size_t part;
+
+    if (reader == NULL)
+    {
+        return 0;
+    }
+    while ((event = json_reader_next(reader)) != JSONReaderEnd)
+    {
+        if (event == JSONReaderNeedInput)
+        {
+            if (offset == length)
+            {
+                (void)json_reader_finish(reader);
+            }
+            else
+            {
+                part = (length - offset < chunk) ? length - offset : chunk;
+                (void)json_reader_feed(reader, doc + offset, part);
+                offset += part;
+            }
+        }
+        else if (event == JSONReaderError)
+        {
+            events = 0;
+            break;
+        }
+        else
+        {
+            events++;
+        }
+    }
+    json_reader_free(reader);
+    return events;
+}
+
+int main(int argc, char** argv)
+{
+    size_t chunk = (argc > 1) ? (size_t)atoi(argv[1]) : 256;
+    char* doc = malloc(MAX_SIZE + 1);
+    JSON_Value* value;
+    size_t length;
+    size_t size;
+    size_t treePeak;
+    size_t readerPeak;
+    double treeTime;
+    double readerTime;
+    double start;
+    int runs;
+    int i;
+
+    if ((doc == NULL) || (chunk == 0))
+    {
+        return EXIT_FAILURE;
+    }
+    json_set_allocation_functions(CountingMalloc, CountingFree);
+
+    (void)printf("%8s | %10s %10s | %10s %11s   (chunk %u)\n", "document",
+        "tree KB", "tree MB/s", "reader KB", "reader MB/s", (unsigned int)chunk);
+    for (size = MIN_SIZE; size <= MAX_SIZE; size *= 2)
+    {
+        length = MakeDocument(doc, size);
+        runs = (int)(BYTES_PER_RUN / length);
+
+        heapPeak = heapInUse;
+        start = Now();
+        for (i = 0; i < runs; i++)
+        {
+            value = json_parse_string(doc);
+            if (value == NULL)
+            {
+                (void)fprintf(stderr, "json_parse_string failed at %u bytes\n", (unsigned int)length);
+                return EXIT_FAILURE;
+            }
+            json_value_free(value);
+        }
+        treeTime = Now() - start;
+        treePeak = heapPeak + length;
+
+        heapPeak = heapInUse;
+        start = Now();
+        for (i = 0; i < runs; i++)
+        {
+            if (ReadDocument(doc, length, chunk) == 0)
+            {
+                (void)fprintf(stderr, "the reader failed at %u bytes\n", (unsigned int)length);
+                return EXIT_FAILURE;
+            }
+        }
+        readerTime = Now() - start;
+        readerPeak = heapPeak + ((chunk < length) ? chunk : length);
+
+        (void)printf("%6u K | %10.1f %10.1f | %10.1f %11.1f\n", (unsigned int)(size / 1024),
+            (double)treePeak / 1024.0, (double)length * runs / treeTime / 1e6,
+            (double)readerPeak / 1024.0, (double)length * runs / readerTime / 1e6);
+    }
+    free(doc);
+    return EXIT_SUCCESS;
+}
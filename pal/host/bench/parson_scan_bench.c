@@ -0,0 +1,146 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Throughput of the block scanners of parson_sl.c: parsing about 256 KB of
+ * strings of 4 to 256 bytes, each on its own line after an indentation of
+ * the same length, and checking 1 MB of UTF-8 in json_value_init_string():
+ *
+ *     parson_scan_bench [rounds]
+ *
+ * Each figure is the best of rounds. parson_scan_swar_bench is the same with
+ * the word-at-a-time scanners.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parson_sl.h"
+
+#define DOCUMENT_SIZE   (256 * 1024)
+#define UTF8_SIZE       (1024 * 1024)
+#define MIN_RUN         4
+#define MAX_RUN         256
+
+static double Now(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e6 + (double)now.tv_nsec / 1e3;
+}
+
+/* [\n<run spaces>"<run letters>",\n...] of about DOCUMENT_SIZE bytes */
+static char* MakeDocument(size_t run)
+{
+    char* document = malloc(DOCUMENT_SIZE + 2 * MAX_RUN + 16);
+    size_t length = 0;
+    size_t i;
+
+    if (document == NULL)
+    {
+        return NULL;
+    }
+    document[length++] = '[';
+    while (length < DOCUMENT_SIZE)
+    {
+        if (length > 1)
+        {
+            document[length++] = ',';
+        }
+        document[length++] = '\n';
+        (void)memset(document + length, ' ', run);
+        length += run;
+        document[length++] = '\"';
+        for (i = 0; i < run; i++)
+        {
+            document[length++] = (char)('a' + i % 26);
+        }
+        document[length++] = '\"';
+    }
+    document[length++] = ']';
+    document[length] = '\0';
+    return document;
+}
+
+/* Bytes of mostly ASCII with a two byte sequence every 64 */
+static char* MakeUtf8(void)
+{
+    char* text = malloc(UTF8_SIZE + 1);
+    size_t i;
+
+    if (text == NULL)
+    {
+        return NULL;
+    }
+    for (i = 0; i < UTF8_SIZE; i += 64)
+    {
+        (void)memset(text + i, 'x', 62);
+        text[i + 62] = '\xC3';
+        text[i + 63] = '\xA9';
+    }
+    text[UTF8_SIZE] = '\0';
+    return text;
+}
+
+int main(int argc, char** argv)
+{
+    int rounds = (argc > 1) ? atoi(argv[1]) : 50;
+    JSON_Value* value;
+    char* document;
+    char* text;
+    double best;
+    double start;
+    double elapsed;
+    size_t length;
+    size_t run;
+    int round;
+
+    (void)printf("%6s %10s\n", "run", "parse MB/s");
+    for (run = MIN_RUN; run <= MAX_RUN; run *= 2)
+    {
+        document = MakeDocument(run);
+        if (document == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        length = strlen(document);
+        best = 1e12;
+        for (round = 0; round < rounds; round++)
+        {
+            start = Now();
+            value = json_parse_string(document);
+            if (value == NULL)
+            {
+                return EXIT_FAILURE;
+            }
+            elapsed = Now() - start;
+            best = (elapsed < best) ? elapsed : best;
+            json_value_free(value);
+        }
+        (void)printf("%6u %10.1f\n", (unsigned int)run, (double)length / best);
+        free(document);
+    }
+
+    text = MakeUtf8();
+    if (text == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    best = 1e12;
+    for (round = 0; round < rounds; round++)
+    {
+        start = Now();
+        value = json_value_init_string(text);
+        if (value == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        elapsed = Now() - start;
+        best = (elapsed < best) ? elapsed : best;
+        json_value_free(value);
+    }
+    (void)printf("UTF-8 check of 1 MB: %.2f ms\n", best / 1e3);
+    free(text);
+    return EXIT_SUCCESS;
+}
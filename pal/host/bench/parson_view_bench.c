@@ -0,0 +1,129 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Finding the command name of a cloud-to-device message the way
+ * sample/simplesample_http.c does, with json_view_find() on the message in
+ * place, against copying it and parsing it with json_parse_string(), for
+ * messages of 0.5 to 8 KB with the name first or last:
+ *
+ *     parson_view_bench [rounds]
+ *
+ * Each time is the best of rounds of 100 lookups.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parson_sl.h"
+
+#define MIN_SIZE  512
+#define MAX_SIZE  (8 * 1024)
+#define LOOKUPS   100
+#define NAME      "SetAirResistance"
+
+static double Now(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1e6 + (double)now.tv_nsec / 1e3;
+}
+
+/* A command with its parameters, about size bytes */
+static size_t MakeMessage(char* message, size_t size, int nameLast)
+{
+    size_t length = 0;
+    int i = 0;
+
+    length += (size_t)sprintf(message, "{%s\"Parameters\":{", nameLast ? "" : "\"Name\":\"" NAME "\",");
+    while (length + 100 < size)
+    {
+        length += (size_t)sprintf(message + length, "%s\"param%d\":{\"value\":%d.25,\"unit\":\"m\\/s\",\"ok\":true}",
+            (i > 0) ? "," : "", i, i);
+        i++;
+    }
+    length += (size_t)sprintf(message + length, "}%s}", nameLast ? ",\"Name\":\"" NAME "\"" : "");
+    return length;
+}
+
+static int FindByView(const char* message, size_t length)
+{
+    JSON_View view;
+    char name[32];
+
+    return (json_view_find(message, length, "Name", &view) == JSONSuccess) && (view.type == JSONString) &&
+        (json_view_get_string(&view, name, sizeof(name)) == JSONSuccess) && (strcmp(name, NAME) == 0);
+}
+
+static int FindByParse(const char* message, size_t length)
+{
+    char* copy = malloc(length + 1);
+    JSON_Value* value;
+    const char* name;
+    int found = 0;
+
+    if (copy != NULL)
+    {
+        (void)memcpy(copy, message, length);
+        copy[length] = '\0';
+        value = json_parse_string(copy);
+        name = json_object_get_string(json_object(value), "Name");
+        found = (name != NULL) && (strcmp(name, NAME) == 0);
+        json_value_free(value);
+        free(copy);
+    }
+    return found;
+}
+
+int main(int argc, char** argv)
+{
+    int rounds = (argc > 1) ? atoi(argv[1]) : 200;
+    static char message[MAX_SIZE + 128];
+    double bestView;
+    double bestParse;
+    double start;
+    double middle;
+    double end;
+    size_t length;
+    size_t size;
+    int nameLast;
+    int round;
+    int i;
+
+    (void)printf("%7s %5s %10s %10s\n", "message", "name", "view us", "parse us");
+    for (size = MIN_SIZE; size <= MAX_SIZE; size *= 2)
+    {
+        for (nameLast = 0; nameLast < 2; nameLast++)
+        {
+            length = MakeMessage(message, size, nameLast);
+            bestView = 1e9;
+            bestParse = 1e9;
+            for (round = 0; round < rounds; round++)
+            {
+                start = Now();
+                for (i = 0; i < LOOKUPS; i++)
+                {
+                    if (!FindByView(message, length))
+                    {
+                        return EXIT_FAILURE;
+                    }
+                }
+                middle = Now();
+                for (i = 0; i < LOOKUPS; i++)
+                {
+                    if (!FindByParse(message, length))
+                    {
+                        return EXIT_FAILURE;
+                    }
+                }
+                end = Now();
+                bestView = (middle - start < bestView) ? middle - start : bestView;
+                bestParse = (end - middle < bestParse) ? end - middle : bestParse;
+            }
+            (void)printf("%7u %5s %10.2f %10.2f\n", (unsigned int)length, nameLast ? "last" : "first",
+                bestView / LOOKUPS, bestParse / LOOKUPS);
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Cost of an INC_REF_VAR/DEC_REF_VAR pair from refcount_os.h for 1 to 32
+ * threads, all on one shared count and each on a count of its own:
+ *
+ *     refcount_bench [pairs per thread]
+ *
+ * refcount_bench uses the default sequentially consistent orderings and
+ * refcount_relaxed_bench the same code with REFCOUNT_RELAXED_ORDERING. Every
+ * count has to be back at 1 at the end.
+ */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// the host build makes the counts plain integers for the single-threaded SDK code
+#undef REFCOUNT_ATOMIC_DONTCARE
+#include "refcount_os.h"
+
+#define MAX_THREADS 32
+#define CACHE_LINE  64
+
+/* One count per cache line, so the private counts don't share one */
+typedef union PADDED_COUNT_TAG
+{
+    COUNT_TYPE count;
+    char line[CACHE_LINE];
+} PADDED_COUNT;
+
+typedef struct WORKER_TAG
+{
+    PADDED_COUNT* count;
+    long pairs;
+    int broken;
+} WORKER;
+
+static PADDED_COUNT counts[MAX_THREADS];
+
+static double Now(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void* Run(void* arg)
+{
+    WORKER* worker = (WORKER*)arg;
+    long i;
+
+    for (i = 0; i < worker->pairs; i++)
+    {
+        INC_REF_VAR(worker->count->count);
+        if (DEC_REF_VAR(worker->count->count) == DEC_RETURN_ZERO)
+        {
+            worker->broken = 1;
+        }
+    }
+    return NULL;
+}
+
+/* ns per pair, -1 if a count went wrong */
+static double Measure(int threads, int shared, long pairs)
+{
+    pthread_t handles[MAX_THREADS];
+    WORKER workers[MAX_THREADS];
+    double start;
+    double elapsed;
+    int broken = 0;
+    int i;
+
+    for (i = 0; i < threads; i++)
+    {
+        INIT_REF_VAR(counts[i].count);
+        workers[i].count = &counts[shared ? 0 : i];
+        workers[i].pairs = pairs;
+        workers[i].broken = 0;
+    }
+    start = Now();
+    for (i = 0; i < threads; i++)
+    {
+        if (pthread_create(&handles[i], NULL, Run, &workers[i]) != 0)
+        {
+            (void)fprintf(stderr, "pthread_create failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < threads; i++)
+    {
+        (void)pthread_join(handles[i], NULL);
+        broken |= workers[i].broken;
+    }
+    elapsed = Now() - start;
+
+    for (i = 0; i < threads; i++)
+    {
+        if (DEC_REF_VAR(counts[i].count) != DEC_RETURN_ZERO)
+        {
+            broken = 1;
+        }
+    }
+    return broken ? -1.0 : elapsed * 1e9 / ((double)pairs * threads);
+}
+
+int main(int argc, char** argv)
+{
+    long pairs = (argc > 1) ? atol(argv[1]) : 2000000;
+    double shared;
+    double own;
+    int threads;
+
+#if defined(REFCOUNT_RELAXED_ORDERING)
+    (void)printf("relaxed increments, release decrements\n");
+#else
+    (void)printf("sequentially consistent\n");
+#endif
+    (void)printf("%7s %12s %12s\n", "threads", "shared ns", "own ns");
+    for (threads = 1; threads <= MAX_THREADS; threads *= 2)
+    {
+        shared = Measure(threads, 1, pairs);
+        own = Measure(threads, 0, pairs);
+        if ((shared < 0) || (own < 0))
+        {
+            (void)fprintf(stderr, "a count went wrong with %d threads\n", threads);
+            return EXIT_FAILURE;
+        }
+        (void)printf("%7d %12.2f %12.2f\n", threads, shared, own);
+    }
+    return EXIT_SUCCESS;
+}
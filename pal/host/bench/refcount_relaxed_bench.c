@@ -0,0 +1,6 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* refcount_bench with REFCOUNT_RELAXED_ORDERING */
+#define REFCOUNT_RELAXED_ORDERING 1
+#include "refcount_bench.c"
@@ -0,0 +1,91 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Host (Linux) stand-in for the SimpleLink HTTPClient, covering what
+ * httpapi_sl.c uses: one HTTP/1.1 connection per client, over the SlNet
+ * stand-in so "https://" hosts get TLS the way they do on the target.
+ *
+ * Request headers set by name are sent with the next request, and persistent
+ * ones with every request. The response's standard header fields are kept by
+ * their HTTPClient_HFIELD_RES_ index for HTTPClient_getHeader(), and headers
+ * registered with HTTPClient_CUSTOM_RESPONSE_HEADER by name for
+ * HTTPClient_getHeaderByName(). Bodies may have a Content-Length, be chunked
+ * or run to the end of the connection. Status codes are the host's own.
+ */
+#ifndef HTTPCLIENT_H
+#define HTTPCLIENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define HTTP_METHOD_GET     "GET"
+#define HTTP_METHOD_POST    "POST"
+#define HTTP_METHOD_HEAD    "HEAD"
+#define HTTP_METHOD_OPTIONS "OPTIONS"
+#define HTTP_METHOD_PUT     "PUT"
+#define HTTP_METHOD_DELETE  "DELETE"
+#define HTTP_METHOD_CONNECT "CONNECT"
+
+/* Standard response header fields 0 to HTTPClient_MAX_RESPONSE_HEADER_FILEDS, in this order */
+#define HTTPClient_HFIELD_RES_AGE                   0
+#define HTTPClient_HFIELD_RES_CONNECTION            3
+#define HTTPClient_HFIELD_RES_CONTENT_LENGTH        6
+#define HTTPClient_HFIELD_RES_TRANSFER_ENCODING     20
+#define HTTPClient_HFIELD_RES_WARNING               25
+#define HTTPClient_MAX_RESPONSE_HEADER_FILEDS       HTTPClient_HFIELD_RES_WARNING
+
+#define HTTPClient_REQUEST_HEADER_MASK              0x80000000
+#define HTTPClient_CUSTOM_RESPONSE_HEADER           0x40000000
+
+#define HTTPClient_HFIELD_NOT_PERSISTENT            0
+#define HTTPClient_HFIELD_PERSISTENT                1
+
+#define HTTPClient_EINVALIDARG                      (-3001)
+#define HTTPClient_ENOMEM                           (-3002)
+#define HTTPClient_EGETOPTBUFSMALL                  (-3003)
+#define HTTPClient_EGETCUSOMHEADERBUFSMALL          (-3004)
+#define HTTPClient_ENOHEADERNAMEDASINSERTED         (-3005)
+#define HTTPClient_ECONNECTFAILED                   (-3006)
+#define HTTPClient_ENOTCONNECTED                    (-3007)
+#define HTTPClient_ESENDERROR                       (-3008)
+#define HTTPClient_ERECVERROR                       (-3009)
+#define HTTPClient_ERESPONSEINVALID                 (-3010)
+#define HTTPClient_EHOSTNAMEINVALID                 (-3011)
+
+typedef void *HTTPClient_Handle;
+
+typedef struct HTTPClient_extSecParams_tag
+{
+    const char *privateKey;
+    const char *clientCert;
+    const char *rootCa;
+} HTTPClient_extSecParams;
+
+extern HTTPClient_Handle HTTPClient_create(int16_t *status, void *params);
+extern int16_t HTTPClient_destroy(HTTPClient_Handle client);
+
+/* hostName is "http://" or "https://" (the default), the host and an optional ":port"; flags are ignored */
+extern int16_t HTTPClient_connect(HTTPClient_Handle client, const char *hostName, HTTPClient_extSecParams *exSecParams, uint32_t flags);
+extern int16_t HTTPClient_disconnect(HTTPClient_Handle client);
+
+extern int16_t HTTPClient_setHeaderByName(HTTPClient_Handle client, uint32_t option, const char *name, void *value, uint32_t len, uint32_t flags);
+
+/* Sends the request and reads the response up to its body; returns the status code */
+extern int16_t HTTPClient_sendRequest(HTTPClient_Handle client, const char *method, const char *requestURI, const char *body, uint32_t bodyLen, uint32_t flags);
+
+extern int16_t HTTPClient_getHeader(HTTPClient_Handle client, uint32_t option, void *value, uint32_t *len, uint32_t flags);
+extern int16_t HTTPClient_getHeaderByName(HTTPClient_Handle client, uint32_t option, const char *name, void *value, uint32_t *len, uint32_t flags);
+
+/* Returns the number of body bytes copied to body; moreDataFlag is cleared with the last of them */
+extern int16_t HTTPClient_readResponseBody(HTTPClient_Handle client, char *body, uint32_t bodyLen, bool *moreDataFlag);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HTTPCLIENT_H */
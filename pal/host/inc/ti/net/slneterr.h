@@ -0,0 +1,21 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Status codes of the host (Linux) SlNet stand-in. The names follow the
+ * SimpleLink ones; the values are the host's own.
+ */
+#ifndef SLNETERR_H
+#define SLNETERR_H
+
+#define SLNETERR_RET_CODE_OK                    0
+#define SLNETERR_RET_CODE_INVALID_INPUT         (-2001)
+#define SLNETERR_RET_CODE_MALLOC_ERROR          (-2002)
+#define SLNETERR_RET_CODE_NO_FREE_SPACE         (-2003)     // descriptor beyond SLNETHOST_MAX_SOCKETS
+#define SLNETERR_NET_APP_DNS_QUERY_FAILED       (-2004)
+#define SLNETERR_ESEC_BAD_CERT                  (-2005)     // a certificate, key or root CA file couldn't be loaded
+#define SLNETERR_ESEC_HANDSHAKE_FAILED          (-2006)
+#define SLNETERR_ESEC_TIMEOUT                   (-2007)
+#define SLNETERR_ESEC_NO_DOMAIN_NAME            (-2008)     // no name to check the server certificate against
+
+#endif /* SLNETERR_H */
@@ -0,0 +1,13 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Host (Linux) stand-in for the SimpleLink SlNetIf API. The host has one
+ * interface, the OS's, and nothing to register: the PAL only includes this.
+ */
+#ifndef SLNETIF_H
+#define SLNETIF_H
+
+#include <ti/net/slnetsock.h>
+
+#endif /* SLNETIF_H */
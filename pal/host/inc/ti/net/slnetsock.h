@@ -0,0 +1,76 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Host (Linux) stand-in for the SimpleLink SlNetSock API, covering what the
+ * PAL uses so tlsio_sl.c and httpapi_sl.c build and run unchanged on a PC.
+ *
+ * On the target a BSD socket turns secure in place: SlNetSock_startSec()
+ * binds a security context to it and then runs the handshake, after which
+ * send() and recv() carry TLS. The host does the same with OpenSSL, so this
+ * header routes send(), recv(), close(), getsockopt() and setsockopt() in the
+ * files that include it to SlNetHost wrappers, which fall through to the C
+ * library for sockets without a session. Certificates named by the security
+ * attributes are PEM files under SLNETHOST_FS_ROOT (see slnet_host.c).
+ *
+ * Status codes are the host's own SLNETERR values, not the target's.
+ */
+#ifndef SLNETSOCK_H
+#define SLNETSOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define SLNETSOCK_LVL_SOCKET                        SOL_SOCKET
+#define SLNETSOCK_OPSOCK_SLNETSOCKSD                0x534C      // getsockopt(): the SlNetSock descriptor, a uint16_t
+#define SO_NONBLOCKING                              0x4E42      // setsockopt(): takes a SlNetSock_Nonblocking_t
+
+#define SLNETSOCK_SEC_BIND_CONTEXT_ONLY             (1 << 0)
+#define SLNETSOCK_SEC_START_SECURITY_SESSION_ONLY   (1 << 1)
+
+typedef enum SlNetSockSecAttribName_tag
+{
+    SLNETSOCK_SEC_ATTRIB_PRIVATE_KEY,
+    SLNETSOCK_SEC_ATTRIB_LOCAL_CERT,
+    SLNETSOCK_SEC_ATTRIB_PEER_ROOT_CA,
+    SLNETSOCK_SEC_ATTRIB_DOMAIN_NAME
+} SlNetSockSecAttribName_e;
+
+typedef struct SlNetSock_Nonblocking_tag
+{
+    uint32_t nonBlockingEnabled;
+} SlNetSock_Nonblocking_t;
+
+typedef struct SlNetSockSecAttrib_tag SlNetSockSecAttrib_t;
+
+extern SlNetSockSecAttrib_t *SlNetSock_secAttribCreate(void);
+extern int32_t SlNetSock_secAttribDelete(SlNetSockSecAttrib_t *secAttrib);
+extern int32_t SlNetSock_secAttribSet(SlNetSockSecAttrib_t *secAttrib, SlNetSockSecAttribName_e attribName, void *val, uint16_t len);
+extern int32_t SlNetSock_startSec(int16_t sd, SlNetSockSecAttrib_t *secAttrib, uint8_t flags);
+
+extern ssize_t SlNetHost_send(int sd, const void *buf, size_t len, int flags);
+extern ssize_t SlNetHost_recv(int sd, void *buf, size_t len, int flags);
+extern int SlNetHost_close(int sd);
+extern int SlNetHost_getsockopt(int sd, int level, int optname, void *optval, socklen_t *optlen);
+extern int SlNetHost_setsockopt(int sd, int level, int optname, const void *optval, socklen_t optlen);
+
+#if !defined(SLNETHOST_IMPLEMENTATION)
+#define send(sd, buf, len, flags) SlNetHost_send((sd), (buf), (len), (flags))
+#define recv(sd, buf, len, flags) SlNetHost_recv((sd), (buf), (len), (flags))
+#define close(sd) SlNetHost_close(sd)
+#define getsockopt(sd, level, optname, optval, optlen) SlNetHost_getsockopt((sd), (level), (optname), (optval), (optlen))
+#define setsockopt(sd, level, optname, optval, optlen) SlNetHost_setsockopt((sd), (level), (optname), (optval), (optlen))
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SLNETSOCK_H */
@@ -0,0 +1,27 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Host (Linux) stand-in for the SimpleLink SlNetUtil API: name lookup only.
+ */
+#ifndef SLNETUTILS_H
+#define SLNETUTILS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Resolves name with getaddrinfo() into up to *ipAddrLen IPv4 addresses in
+ * host byte order, and sets *ipAddrLen to the number found. ifBitmap is
+ * ignored and family must be AF_INET. Returns 0 or a negative SLNETERR.
+ */
+extern int32_t SlNetUtil_getHostByName(uint32_t ifBitmap, char *name, const uint16_t nameLen, uint32_t *ipAddr, uint16_t *ipAddrLen, const uint8_t family);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SLNETUTILS_H */
@@ -0,0 +1,735 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <ti/net/slnetsock.h>
+#include <ti/net/slnetutils.h>
+#include <ti/net/slneterr.h>
+#include <ti/net/http/httpclient.h>
+
+#include "azure_c_shared_utility/xlogging.h"
+
+#define HTTP_PORT           80
+#define HTTPS_PORT          443
+#define HTTPCLIENT_BUFFER_SIZE 2048     // received data not consumed yet; bounds the length of a header line
+
+typedef enum BODY_MODE_TAG
+{
+    BODY_NONE,                  // no body, or all of it read
+    BODY_LENGTH,                // bodyRemaining bytes
+    BODY_CHUNKED,               // bodyRemaining bytes left in the current chunk
+    BODY_TO_CLOSE               // until the server closes the connection
+} BODY_MODE;
+
+typedef struct HEADER_TAG
+{
+    char *name;
+    char *value;                // for a custom response header, NULL until one is received
+    bool persistent;
+    struct HEADER_TAG *next;
+} HEADER;
+
+typedef struct HTTPCLIENT_TAG
+{
+    int sock;                   // -1 when not connected
+    SlNetSockSecAttrib_t *secAttrib;
+    char *host;                 // value of the Host header
+    HEADER *requestHeaders;
+    HEADER *customHeaders;
+    char *responseFields[HTTPClient_MAX_RESPONSE_HEADER_FILEDS + 1];
+    BODY_MODE bodyMode;
+    unsigned long long bodyRemaining;
+    bool chunkStarted;          // a chunk's data was read, its CRLF is still to come
+    size_t bufferStart;
+    size_t bufferEnd;
+    char buffer[HTTPCLIENT_BUFFER_SIZE];
+} HTTPCLIENT;
+
+/* Same order as the HTTPClient_HFIELD_RES_ indexes */
+static const char *const responseFieldNames[HTTPClient_MAX_RESPONSE_HEADER_FILEDS + 1] =
+{
+    "Age", "Allow", "Cache-Control", "Connection", "Content-Encoding",
+    "Content-Language", "Content-Length", "Content-Location", "Content-Range",
+    "Content-Type", "Date", "ETag", "Expires", "Last-Modified", "Location",
+    "Proxy-Authenticate", "Retry-After", "Server", "Set-Cookie", "Trailer",
+    "Transfer-Encoding", "Upgrade", "Vary", "Via", "Www-Authenticate", "Warning"
+};
+
+static char *CopyString(const char *value, size_t length)
+{
+    char *result = malloc(length + 1);
+
+    if (result != NULL)
+    {
+        (void)memcpy(result, value, length);
+        result[length] = '\0';
+    }
+    return result;
+}
+
+static void FreeHeaders(HEADER **list, bool persistentToo)
+{
+    HEADER **link = list;
+
+    while (*link != NULL)
+    {
+        HEADER *header = *link;
+
+        if (header->persistent && !persistentToo)
+        {
+            link = &header->next;
+        }
+        else
+        {
+            *link = header->next;
+            free(header->name);
+            free(header->value);
+            free(header);
+        }
+    }
+}
+
+static HEADER *FindHeader(HEADER *list, const char *name)
+{
+    while ((list != NULL) && (strcasecmp(list->name, name) != 0))
+    {
+        list = list->next;
+    }
+    return list;
+}
+
+static void ClearResponse(HTTPCLIENT *client)
+{
+    HEADER *header;
+    int i;
+
+    for (i = 0; i <= HTTPClient_MAX_RESPONSE_HEADER_FILEDS; i++)
+    {
+        free(client->responseFields[i]);
+        client->responseFields[i] = NULL;
+    }
+    for (header = client->customHeaders; header != NULL; header = header->next)
+    {
+        free(header->value);
+        header->value = NULL;
+    }
+    client->bodyMode = BODY_NONE;
+    client->bodyRemaining = 0;
+    client->chunkStarted = false;
+}
+
+/* Receives more into the buffer; returns the bytes received, 0 at the end of the connection, or -1 */
+static int Fill(HTTPCLIENT *client)
+{
+    ssize_t received;
+
+    if (client->bufferStart == client->bufferEnd)
+    {
+        client->bufferStart = 0;
+        client->bufferEnd = 0;
+    }
+    else if (client->bufferStart > 0)
+    {
+        (void)memmove(client->buffer, client->buffer + client->bufferStart, client->bufferEnd - client->bufferStart);
+        client->bufferEnd -= client->bufferStart;
+        client->bufferStart = 0;
+    }
+    if (client->bufferEnd == sizeof(client->buffer))
+    {
+        return -1;
+    }
+
+    do
+    {
+        received = recv(client->sock, client->buffer + client->bufferEnd, sizeof(client->buffer) - client->bufferEnd, 0);
+    } while ((received < 0) && (errno == EINTR));
+
+    if (received > 0)
+    {
+        client->bufferEnd += (size_t)received;
+    }
+    return (received < 0) ? -1 : (int)received;
+}
+
+/* Returns the next line in place, without its CRLF, or NULL on an error or a line longer than the buffer */
+static char *ReadLine(HTTPCLIENT *client)
+{
+    char *line;
+    char *end;
+
+    for (;;)
+    {
+        line = client->buffer + client->bufferStart;
+        end = memchr(line, '\n', client->bufferEnd - client->bufferStart);
+        if (end != NULL)
+        {
+            client->bufferStart = (size_t)(end - client->buffer) + 1;
+            if ((end > line) && (end[-1] == '\r'))
+            {
+                end--;
+            }
+            *end = '\0';
+            return line;
+        }
+        if (Fill(client) <= 0)
+        {
+            return NULL;
+        }
+    }
+}
+
+static int SendAll(HTTPCLIENT *client, const char *data, size_t length)
+{
+    ssize_t sent;
+
+    while (length > 0)
+    {
+        sent = send(client->sock, data, length, 0);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return 0;
+}
+
+/* Reads the status line and the headers of a response, then decides how its body ends */
+static int16_t ReadResponseHead(HTTPCLIENT *client, const char *method)
+{
+    const char *encoding;
+    const char *length;
+    char *line;
+    char *value;
+    HEADER *custom;
+    int status;
+    int i;
+
+    line = ReadLine(client);
+    if ((line == NULL) || (sscanf(line, "HTTP/%*d.%*d %3d", &status) != 1) || (status < 100) || (status > 999))
+    {
+        LogError("invalid status line");
+        return HTTPClient_ERESPONSEINVALID;
+    }
+
+    while ((line = ReadLine(client)) != NULL)
+    {
+        if (*line == '\0')
+        {
+            break;
+        }
+        value = strchr(line, ':');
+        if (value == NULL)
+        {
+            continue;
+        }
+        *value++ = '\0';
+        while ((*value == ' ') || (*value == '\t'))
+        {
+            value++;
+        }
+
+        for (i = 0; i <= HTTPClient_MAX_RESPONSE_HEADER_FILEDS; i++)
+        {
+            if (strcasecmp(line, responseFieldNames[i]) == 0)
+            {
+                free(client->responseFields[i]);
+                client->responseFields[i] = CopyString(value, strlen(value));
+                break;
+            }
+        }
+        custom = FindHeader(client->customHeaders, line);
+        if (custom != NULL)
+        {
+            free(custom->value);
+            custom->value = CopyString(value, strlen(value));
+        }
+    }
+    if (line == NULL)
+    {
+        LogError("response headers cut short");
+        return HTTPClient_ERESPONSEINVALID;
+    }
+
+    encoding = client->responseFields[HTTPClient_HFIELD_RES_TRANSFER_ENCODING];
+    length = client->responseFields[HTTPClient_HFIELD_RES_CONTENT_LENGTH];
+    if ((strcmp(method, HTTP_METHOD_HEAD) == 0) || (status < 200) || (status == 204) || (status == 304))
+    {
+        client->bodyMode = BODY_NONE;
+    }
+    else if ((encoding != NULL) && (strstr(encoding, "chunked") != NULL))
+    {
+        client->bodyMode = BODY_CHUNKED;
+    }
+    else if (length != NULL)
+    {
+        client->bodyRemaining = strtoull(length, NULL, 10);
+        client->bodyMode = (client->bodyRemaining > 0) ? BODY_LENGTH : BODY_NONE;
+    }
+    else
+    {
+        client->bodyMode = BODY_TO_CLOSE;
+    }
+
+    return (int16_t)status;
+}
+
+/* Starts the next chunk; returns 1 with bodyRemaining set, 0 after the last one, or -1 */
+static int NextChunk(HTTPCLIENT *client)
+{
+    char *line;
+
+    if (client->chunkStarted)
+    {
+        line = ReadLine(client);
+        if ((line == NULL) || (*line != '\0'))
+        {
+            return -1;
+        }
+    }
+
+    line = ReadLine(client);
+    if ((line == NULL) || !isxdigit((unsigned char)*line))
+    {
+        return -1;
+    }
+    client->bodyRemaining = strtoull(line, NULL, 16);
+    client->chunkStarted = true;
+    if (client->bodyRemaining > 0)
+    {
+        return 1;
+    }
+
+    // the last chunk: skip any trailer up to the empty line
+    while (((line = ReadLine(client)) != NULL) && (*line != '\0'))
+    {
+    }
+    return (line == NULL) ? -1 : 0;
+}
+
+HTTPClient_Handle HTTPClient_create(int16_t *status, void *params)
+{
+    HTTPCLIENT *client = calloc(1, sizeof(HTTPCLIENT));
+
+    (void)params;
+    if (client != NULL)
+    {
+        client->sock = -1;
+    }
+    if (status != NULL)
+    {
+        *status = (client == NULL) ? HTTPClient_ENOMEM : 0;
+    }
+    return client;
+}
+
+int16_t HTTPClient_destroy(HTTPClient_Handle handle)
+{
+    HTTPCLIENT *client = handle;
+
+    if (client == NULL)
+    {
+        return HTTPClient_EINVALIDARG;
+    }
+
+    (void)HTTPClient_disconnect(client);
+    FreeHeaders(&client->requestHeaders, true);
+    FreeHeaders(&client->customHeaders, true);
+    ClearResponse(client);
+    free(client);
+    return 0;
+}
+
+int16_t HTTPClient_connect(HTTPClient_Handle handle, const char *hostName, HTTPClient_extSecParams *exSecParams, uint32_t flags)
+{
+    HTTPCLIENT *client = handle;
+    struct sockaddr_in address;
+    const char *name = hostName;
+    size_t nameLength;
+    unsigned long port;
+    bool secure = true;
+    uint32_t ipAddr;
+    uint16_t ipAddrLen = 1;
+    int32_t status;
+
+    (void)flags;
+    if ((client == NULL) || (hostName == NULL))
+    {
+        return HTTPClient_EINVALIDARG;
+    }
+    if (client->sock >= 0)
+    {
+        LogError("HTTPClient is already connected");
+        return HTTPClient_ECONNECTFAILED;
+    }
+
+    if (strncasecmp(name, "http://", 7) == 0)
+    {
+        secure = false;
+        name += 7;
+    }
+    else if (strncasecmp(name, "https://", 8) == 0)
+    {
+        name += 8;
+    }
+    nameLength = strcspn(name, ":/");
+    port = secure ? HTTPS_PORT : HTTP_PORT;
+    if (name[nameLength] == ':')
+    {
+        port = strtoul(name + nameLength + 1, NULL, 10);
+    }
+    if ((nameLength == 0) || (nameLength > UINT16_MAX) || (port == 0) || (port > UINT16_MAX))
+    {
+        return HTTPClient_EHOSTNAMEINVALID;
+    }
+
+    if (SlNetUtil_getHostByName(0, (char *)name, (uint16_t)nameLength, &ipAddr, &ipAddrLen, AF_INET) < 0)
+    {
+        LogError("unable to resolve %.*s", (int)nameLength, name);
+        return HTTPClient_EHOSTNAMEINVALID;
+    }
+
+    free(client->host);
+    client->host = CopyString(name, strcspn(name, "/"));
+    client->sock = socket(AF_INET, SOCK_STREAM, 0);
+    if ((client->host == NULL) || (client->sock < 0))
+    {
+        (void)HTTPClient_disconnect(client);
+        return HTTPClient_ENOMEM;
+    }
+
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(ipAddr);
+    if (connect(client->sock, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        LogError("unable to connect to %s, errno=%d", client->host, errno);
+        (void)HTTPClient_disconnect(client);
+        return HTTPClient_ECONNECTFAILED;
+    }
+
+    if (secure)
+    {
+        client->secAttrib = SlNetSock_secAttribCreate();
+        status = (client->secAttrib == NULL) ? SLNETERR_RET_CODE_MALLOC_ERROR : SLNETERR_RET_CODE_OK;
+        if ((status == 0) && (exSecParams != NULL) && (exSecParams->rootCa != NULL))
+        {
+            status = SlNetSock_secAttribSet(client->secAttrib, SLNETSOCK_SEC_ATTRIB_PEER_ROOT_CA,
+                (void *)exSecParams->rootCa, (uint16_t)(strlen(exSecParams->rootCa) + 1));
+        }
+        if ((status == 0) && (exSecParams != NULL) && (exSecParams->clientCert != NULL))
+        {
+            status = SlNetSock_secAttribSet(client->secAttrib, SLNETSOCK_SEC_ATTRIB_LOCAL_CERT,
+                (void *)exSecParams->clientCert, (uint16_t)(strlen(exSecParams->clientCert) + 1));
+        }
+        if ((status == 0) && (exSecParams != NULL) && (exSecParams->privateKey != NULL))
+        {
+            status = SlNetSock_secAttribSet(client->secAttrib, SLNETSOCK_SEC_ATTRIB_PRIVATE_KEY,
+                (void *)exSecParams->privateKey, (uint16_t)(strlen(exSecParams->privateKey) + 1));
+        }
+        if (status == 0)
+        {
+            status = SlNetSock_startSec((int16_t)client->sock, client->secAttrib, 0);
+        }
+        if (status < 0)
+        {
+            LogError("unable to secure the connection to %s, status=%d", client->host, (int)status);
+            (void)HTTPClient_disconnect(client);
+            return HTTPClient_ECONNECTFAILED;
+        }
+    }
+
+    return 0;
+}
+
+int16_t HTTPClient_disconnect(HTTPClient_Handle handle)
+{
+    HTTPCLIENT *client = handle;
+
+    if (client == NULL)
+    {
+        return HTTPClient_EINVALIDARG;
+    }
+
+    if (client->sock >= 0)
+    {
+        (void)close(client->sock);
+        client->sock = -1;
+    }
+    if (client->secAttrib != NULL)
+    {
+        (void)SlNetSock_secAttribDelete(client->secAttrib);
+        client->secAttrib = NULL;
+    }
+    free(client->host);
+    client->host = NULL;
+    client->bufferStart = 0;
+    client->bufferEnd = 0;
+    client->bodyMode = BODY_NONE;
+    return 0;
+}
+
+int16_t HTTPClient_setHeaderByName(HTTPClient_Handle handle, uint32_t option, const char *name, void *value, uint32_t len, uint32_t flags)
+{
+    HTTPCLIENT *client = handle;
+    HEADER **list;
+    HEADER *header;
+    char *copy = NULL;
+
+    if ((client == NULL) || (name == NULL))
+    {
+        return HTTPClient_EINVALIDARG;
+    }
+
+    if (option == HTTPClient_REQUEST_HEADER_MASK)
+    {
+        if (value == NULL)
+        {
+            return HTTPClient_EINVALIDARG;
+        }
+        // len counts the terminator when there is one
+        copy = CopyString(value, strnlen(value, len));
+        if (copy == NULL)
+        {
+            return HTTPClient_ENOMEM;
+        }
+        list = &client->requestHeaders;
+    }
+    else if (option == HTTPClient_CUSTOM_RESPONSE_HEADER)
+    {
+        list = &client->customHeaders;
+    }
+    else
+    {
+        return HTTPClient_EINVALIDARG;
+    }
+
+    header = FindHeader(*list, name);
+    if (header == NULL)
+    {
+        header = calloc(1, sizeof(HEADER));
+        if ((header == NULL) || ((header->name = CopyString(name, strlen(name))) == NULL))
+        {
+            free(header);
+            free(copy);
+            return HTTPClient_ENOMEM;
+        }
+        header->next = *list;
+        *list = header;
+    }
+    if (list == &client->requestHeaders)
+    {
+        free(header->value);
+        header->value = copy;
+    }
+    header->persistent = (flags == HTTPClient_HFIELD_PERSISTENT);
+    return 0;
+}
+
+int16_t HTTPClient_sendRequest(HTTPClient_Handle handle, const char *method, const char *requestURI, const char *body, uint32_t bodyLen, uint32_t flags)
+{
+    HTTPCLIENT *client = handle;
+    HEADER *header;
+    char *request;
+    size_t size;
+    int length;
+    char discard[256];
+    bool more = true;
+    int16_t result;
+
+    (void)flags;
+    if ((client == NULL) || (method == NULL) || (requestURI == NULL) || ((body == NULL) && (bodyLen > 0)))
+    {
+        return HTTPClient_EINVALIDARG;
+    }
+    if (client->sock < 0)
+    {
+        return HTTPClient_ENOTCONNECTED;
+    }
+
+    // what is left of the last response is in the way of this one's
+    while (more && (client->bodyMode != BODY_NONE))
+    {
+        if (HTTPClient_readResponseBody(client, discard, sizeof(discard), &more) < 0)
+        {
+            return HTTPClient_ERECVERROR;
+        }
+    }
+    ClearResponse(client);
+
+    size = strlen(method) + strlen(requestURI) + strlen(client->host) + 64;
+    for (header = client->requestHeaders; header != NULL; header = header->next)
+    {
+        size += strlen(header->name) + strlen(header->value) + 4;
+    }
+    request = malloc(size);
+    if (request == NULL)
+    {
+        return HTTPClient_ENOMEM;
+    }
+
+    length = snprintf(request, size, "%s %s HTTP/1.1\r\nHost: %s\r\n", method, requestURI, client->host);
+    for (header = client->requestHeaders; header != NULL; header = header->next)
+    {
+        length += snprintf(request + length, size - (size_t)length, "%s: %s\r\n", header->name, header->value);
+    }
+    if (bodyLen > 0)
+    {
+        length += snprintf(request + length, size - (size_t)length, "Content-Length: %lu\r\n", (unsigned long)bodyLen);
+    }
+    length += snprintf(request + length, size - (size_t)length, "\r\n");
+
+    if ((SendAll(client, request, (size_t)length) < 0) || ((bodyLen > 0) && (SendAll(client, body, bodyLen) < 0)))
+    {
+        LogError("unable to send the request, errno=%d", errno);
+        result = HTTPClient_ESENDERROR;
+    }
+    else
+    {
+        result = ReadResponseHead(client, method);
+    }
+
+    free(request);
+    FreeHeaders(&client->requestHeaders, false);
+    return result;
+}
+
+int16_t HTTPClient_getHeader(HTTPClient_Handle handle, uint32_t option, void *value, uint32_t *len, uint32_t flags)
+{
+    HTTPCLIENT *client = handle;
+    const char *field;
+    size_t length;
+
+    (void)flags;
+    if ((client == NULL) || (option > HTTPClient_MAX_RESPONSE_HEADER_FILEDS) || (value == NULL) || (len == NULL))
+    {
+        return HTTPClient_EINVALIDARG;
+    }
+
+    field = client->responseFields[option];
+    length = (field == NULL) ? 0 : strlen(field);
+    if (length >= *len)
+    {
+        return HTTPClient_EGETOPTBUFSMALL;
+    }
+    (void)memcpy(value, (field == NULL) ? "" : field, length + 1);
+    *len = (uint32_t)length;
+    return 0;
+}
+
+int16_t HTTPClient_getHeaderByName(HTTPClient_Handle handle, uint32_t option, const char *name, void *value, uint32_t *len, uint32_t flags)
+{
+    HTTPCLIENT *client = handle;
+    HEADER *header;
+    size_t length;
+
+    (void)flags;
+    if ((client == NULL) || (option != HTTPClient_CUSTOM_RESPONSE_HEADER) || (name == NULL) || (value == NULL) || (len == NULL))
+    {
+        return HTTPClient_EINVALIDARG;
+    }
+
+    header = FindHeader(client->customHeaders, name);
+    if ((header == NULL) || (header->value == NULL))
+    {
+        return HTTPClient_ENOHEADERNAMEDASINSERTED;
+    }
+    length = strlen(header->value);
+    if (length >= *len)
+    {
+        return HTTPClient_EGETCUSOMHEADERBUFSMALL;
+    }
+    (void)memcpy(value, header->value, length + 1);
+    *len = (uint32_t)length;
+    return 0;
+}
+
+int16_t HTTPClient_readResponseBody(HTTPClient_Handle handle, char *body, uint32_t bodyLen, bool *moreDataFlag)
+{
+    HTTPCLIENT *client = handle;
+    size_t available;
+    size_t count;
+    int filled;
+
+    if ((client == NULL) || (body == NULL) || (moreDataFlag == NULL))
+    {
+        return HTTPClient_EINVALIDARG;
+    }
+    if (bodyLen > INT16_MAX)
+    {
+        bodyLen = INT16_MAX;
+    }
+
+    if ((client->bodyMode == BODY_CHUNKED) && (client->bodyRemaining == 0))
+    {
+        filled = NextChunk(client);
+        if (filled < 0)
+        {
+            LogError("invalid chunk");
+            client->bodyMode = BODY_NONE;
+            *moreDataFlag = false;
+            return HTTPClient_ERECVERROR;
+        }
+        if (filled == 0)
+        {
+            client->bodyMode = BODY_NONE;
+        }
+    }
+    if ((client->bodyMode == BODY_NONE) || (bodyLen == 0))
+    {
+        *moreDataFlag = (client->bodyMode != BODY_NONE);
+        return 0;
+    }
+
+    if (client->bufferStart == client->bufferEnd)
+    {
+        filled = Fill(client);
+        if ((filled == 0) && (client->bodyMode == BODY_TO_CLOSE))
+        {
+            client->bodyMode = BODY_NONE;
+            *moreDataFlag = false;
+            return 0;
+        }
+        if (filled <= 0)
+        {
+            LogError("response body cut short");
+            client->bodyMode = BODY_NONE;
+            *moreDataFlag = false;
+            return HTTPClient_ERECVERROR;
+        }
+    }
+
+    available = client->bufferEnd - client->bufferStart;
+    count = (available < bodyLen) ? available : bodyLen;
+    if ((client->bodyMode != BODY_TO_CLOSE) && (count > client->bodyRemaining))
+    {
+        count = (size_t)client->bodyRemaining;
+    }
+    (void)memcpy(body, client->buffer + client->bufferStart, count);
+    client->bufferStart += count;
+
+    if (client->bodyMode != BODY_TO_CLOSE)
+    {
+        client->bodyRemaining -= count;
+        if ((client->bodyMode == BODY_LENGTH) && (client->bodyRemaining == 0))
+        {
+            client->bodyMode = BODY_NONE;
+        }
+    }
+    *moreDataFlag = (client->bodyMode != BODY_NONE);
+    return (int16_t)count;
+}
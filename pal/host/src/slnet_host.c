@@ -0,0 +1,553 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define SLNETHOST_IMPLEMENTATION
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <ti/net/slnetsock.h>
+#include <ti/net/slnetutils.h>
+#include <ti/net/slneterr.h>
+
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+ * Certificate and key names are SimpleLink file system paths such as
+ * "/cert/ms.pem". On the host they are PEM files under the directory in the
+ * SLNETHOST_FS_ROOT environment variable, or under SLNETHOST_FS_ROOT as
+ * built. A session with no root CA set is verified against the system's
+ * trust store; one whose root CA file can't be loaded fails, as it does on
+ * the target, rather than trust whatever the system does.
+ */
+#ifndef SLNETHOST_FS_ROOT
+#define SLNETHOST_FS_ROOT "."
+#endif
+
+#ifndef SLNETHOST_MAX_SOCKETS
+#define SLNETHOST_MAX_SOCKETS 256       // descriptors that can be made secure are below this
+#endif
+
+#ifndef SLNETHOST_HANDSHAKE_TIMEOUT_MS
+#define SLNETHOST_HANDSHAKE_TIMEOUT_MS 30000
+#endif
+
+/*
+ * The PAL resolves a name and connects to the address, so the handshake
+ * doesn't see the name. The last few lookups are remembered to give the
+ * session the name its peer address came from, for SNI and for checking the
+ * server certificate; SLNETSOCK_SEC_ATTRIB_DOMAIN_NAME overrides it. A
+ * session with neither has nothing to check the certificate against and
+ * fails.
+ */
+#define HOST_CACHE_SIZE 8
+
+struct SlNetSockSecAttrib_tag
+{
+    char *privateKey;
+    char *localCert;
+    char *rootCa;
+    char *domainName;
+};
+
+typedef struct SLNETHOST_SOCKET_TAG
+{
+    SlNetSockSecAttrib_t *secAttrib;    // bound, not copied: it has to outlive the session's start
+    SSL *ssl;                           // NULL until the session is started
+} SLNETHOST_SOCKET;
+
+typedef struct HOST_CACHE_ENTRY_TAG
+{
+    uint32_t ipAddr;
+    char name[NI_MAXHOST];
+} HOST_CACHE_ENTRY;
+
+static SLNETHOST_SOCKET sockets[SLNETHOST_MAX_SOCKETS];
+static HOST_CACHE_ENTRY hostCache[HOST_CACHE_SIZE];
+static unsigned int hostCacheNext;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static SSL *GetSession(int sd)
+{
+    SSL *result = NULL;
+
+    if ((sd >= 0) && (sd < SLNETHOST_MAX_SOCKETS))
+    {
+        (void)pthread_mutex_lock(&lock);
+        result = sockets[sd].ssl;
+        (void)pthread_mutex_unlock(&lock);
+    }
+    return result;
+}
+
+static const char *FsPath(const char *name, char *buffer, size_t size)
+{
+    const char *root = getenv("SLNETHOST_FS_ROOT");
+    int written;
+
+    if (root == NULL)
+    {
+        root = SLNETHOST_FS_ROOT;
+    }
+    written = snprintf(buffer, size, "%s%s%s", root, (name[0] == '/') ? "" : "/", name);
+    return ((written < 0) || ((size_t)written >= size)) ? NULL : buffer;
+}
+
+static int LookupHostName(int sd, char *name, size_t size)
+{
+    struct sockaddr_in peer;
+    socklen_t peerLen = sizeof(peer);
+    HOST_CACHE_ENTRY *entry;
+    int result = 0;
+    int i;
+
+    if ((getpeername(sd, (struct sockaddr *)&peer, &peerLen) == 0) && (peer.sin_family == AF_INET))
+    {
+        (void)pthread_mutex_lock(&lock);
+        // newest first
+        for (i = 1; i <= HOST_CACHE_SIZE; i++)
+        {
+            entry = &hostCache[(hostCacheNext + HOST_CACHE_SIZE - i) % HOST_CACHE_SIZE];
+            if ((entry->name[0] != '\0') && (entry->ipAddr == ntohl(peer.sin_addr.s_addr)))
+            {
+                (void)snprintf(name, size, "%s", entry->name);
+                result = 1;
+                break;
+            }
+        }
+        (void)pthread_mutex_unlock(&lock);
+    }
+    return result;
+}
+
+/* Sets errno and the return value of a failed SSL_read() or SSL_write() like a non-blocking socket's */
+static ssize_t SessionError(SSL *ssl, int ret)
+{
+    switch (SSL_get_error(ssl, ret))
+    {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+        errno = EAGAIN;
+        return -1;
+    case SSL_ERROR_ZERO_RETURN:
+        return 0;
+    case SSL_ERROR_SYSCALL:
+        if (errno == 0)
+        {
+            errno = ECONNRESET;
+        }
+        return -1;
+    default:
+        ERR_clear_error();
+        errno = EPROTO;
+        return -1;
+    }
+}
+
+static SSL_CTX *CreateContext(const SlNetSockSecAttrib_t *secAttrib)
+{
+    char path[PATH_MAX];
+    SSL_CTX *result = SSL_CTX_new(TLS_client_method());
+
+    if (result == NULL)
+    {
+        LogError("SSL_CTX_new failed");
+        return NULL;
+    }
+
+    (void)SSL_CTX_set_min_proto_version(result, TLS1_2_VERSION);
+    SSL_CTX_set_verify(result, SSL_VERIFY_PEER, NULL);
+    SSL_CTX_set_mode(result, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    if (secAttrib->rootCa == NULL)
+    {
+        if (SSL_CTX_set_default_verify_paths(result) != 1)
+        {
+            LogError("no root CA set and no system trust store");
+            SSL_CTX_free(result);
+            result = NULL;
+        }
+    }
+    else if ((FsPath(secAttrib->rootCa, path, sizeof(path)) == NULL) ||
+        (SSL_CTX_load_verify_locations(result, path, NULL) != 1))
+    {
+        LogError("unable to load root CA %s", secAttrib->rootCa);
+        SSL_CTX_free(result);
+        result = NULL;
+    }
+
+    if ((result != NULL) && (secAttrib->localCert != NULL) &&
+        ((FsPath(secAttrib->localCert, path, sizeof(path)) == NULL) ||
+        (SSL_CTX_use_certificate_chain_file(result, path) != 1)))
+    {
+        LogError("unable to load client certificate %s", secAttrib->localCert);
+        SSL_CTX_free(result);
+        result = NULL;
+    }
+
+    if ((result != NULL) && (secAttrib->privateKey != NULL) &&
+        ((FsPath(secAttrib->privateKey, path, sizeof(path)) == NULL) ||
+        (SSL_CTX_use_PrivateKey_file(result, path, SSL_FILETYPE_PEM) != 1)))
+    {
+        LogError("unable to load private key %s", secAttrib->privateKey);
+        SSL_CTX_free(result);
+        result = NULL;
+    }
+
+    ERR_clear_error();
+    return result;
+}
+
+/* Runs the client handshake, waiting on the socket if it is non-blocking */
+static int32_t Handshake(SSL *ssl, int sd)
+{
+    struct timespec start;
+    struct timespec now;
+    struct pollfd pfd;
+    int ret;
+    int elapsed;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    while ((ret = SSL_connect(ssl)) != 1)
+    {
+        switch (SSL_get_error(ssl, ret))
+        {
+        case SSL_ERROR_WANT_READ:
+            pfd.events = POLLIN;
+            break;
+        case SSL_ERROR_WANT_WRITE:
+            pfd.events = POLLOUT;
+            break;
+        default:
+            LogError("TLS handshake failed: %s", ERR_reason_error_string(ERR_peek_last_error()));
+            ERR_clear_error();
+            return SLNETERR_ESEC_HANDSHAKE_FAILED;
+        }
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed = (int)((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000);
+        if (elapsed >= SLNETHOST_HANDSHAKE_TIMEOUT_MS)
+        {
+            LogError("TLS handshake timed out");
+            return SLNETERR_ESEC_TIMEOUT;
+        }
+        pfd.fd = sd;
+        pfd.revents = 0;
+        (void)poll(&pfd, 1, SLNETHOST_HANDSHAKE_TIMEOUT_MS - elapsed);
+    }
+    return SLNETERR_RET_CODE_OK;
+}
+
+static int32_t StartSession(int16_t sd, SlNetSockSecAttrib_t *secAttrib)
+{
+    char hostName[NI_MAXHOST];
+    struct in_addr literal;
+    SSL_CTX *context;
+    SSL *ssl;
+    int32_t result;
+    int set;
+
+    context = CreateContext(secAttrib);
+    if (context == NULL)
+    {
+        return SLNETERR_ESEC_BAD_CERT;
+    }
+
+    ssl = SSL_new(context);
+    SSL_CTX_free(context);          // the session holds its own reference
+    if ((ssl == NULL) || (SSL_set_fd(ssl, sd) != 1))
+    {
+        LogError("unable to create the TLS session");
+        SSL_free(ssl);
+        return SLNETERR_RET_CODE_MALLOC_ERROR;
+    }
+
+    if (secAttrib->domainName != NULL)
+    {
+        (void)snprintf(hostName, sizeof(hostName), "%s", secAttrib->domainName);
+    }
+    else if (!LookupHostName(sd, hostName, sizeof(hostName)))
+    {
+        hostName[0] = '\0';
+    }
+    if (hostName[0] == '\0')
+    {
+        LogError("no domain name set and the peer address wasn't looked up by name");
+        SSL_free(ssl);
+        return SLNETERR_ESEC_NO_DOMAIN_NAME;
+    }
+    else if (inet_pton(AF_INET, hostName, &literal) == 1)
+    {
+        // an address is checked against the certificate's IP entries, and isn't sent as SNI
+        set = X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl), hostName);
+    }
+    else
+    {
+        set = (SSL_set_tlsext_host_name(ssl, hostName) == 1) && (SSL_set1_host(ssl, hostName) == 1);
+    }
+    if (set != 1)
+    {
+        LogError("unable to set the TLS host name %s", hostName);
+        SSL_free(ssl);
+        return SLNETERR_RET_CODE_INVALID_INPUT;
+    }
+
+    result = Handshake(ssl, sd);
+    if (result < 0)
+    {
+        SSL_free(ssl);
+    }
+    else
+    {
+        (void)pthread_mutex_lock(&lock);
+        sockets[sd].ssl = ssl;
+        (void)pthread_mutex_unlock(&lock);
+    }
+    return result;
+}
+
+SlNetSockSecAttrib_t *SlNetSock_secAttribCreate(void)
+{
+    return calloc(1, sizeof(SlNetSockSecAttrib_t));
+}
+
+int32_t SlNetSock_secAttribDelete(SlNetSockSecAttrib_t *secAttrib)
+{
+    if (secAttrib == NULL)
+    {
+        return SLNETERR_RET_CODE_INVALID_INPUT;
+    }
+    free(secAttrib->privateKey);
+    free(secAttrib->localCert);
+    free(secAttrib->rootCa);
+    free(secAttrib->domainName);
+    free(secAttrib);
+    return SLNETERR_RET_CODE_OK;
+}
+
+int32_t SlNetSock_secAttribSet(SlNetSockSecAttrib_t *secAttrib, SlNetSockSecAttribName_e attribName, void *val, uint16_t len)
+{
+    char **field;
+    char *copy;
+
+    if ((secAttrib == NULL) || (val == NULL) || (len == 0))
+    {
+        return SLNETERR_RET_CODE_INVALID_INPUT;
+    }
+
+    switch (attribName)
+    {
+    case SLNETSOCK_SEC_ATTRIB_PRIVATE_KEY:
+        field = &secAttrib->privateKey;
+        break;
+    case SLNETSOCK_SEC_ATTRIB_LOCAL_CERT:
+        field = &secAttrib->localCert;
+        break;
+    case SLNETSOCK_SEC_ATTRIB_PEER_ROOT_CA:
+        field = &secAttrib->rootCa;
+        break;
+    case SLNETSOCK_SEC_ATTRIB_DOMAIN_NAME:
+        field = &secAttrib->domainName;
+        break;
+    default:
+        return SLNETERR_RET_CODE_INVALID_INPUT;
+    }
+
+    // len counts the terminator when there is one
+    copy = malloc((size_t)len + 1);
+    if (copy == NULL)
+    {
+        return SLNETERR_RET_CODE_MALLOC_ERROR;
+    }
+    (void)memcpy(copy, val, len);
+    copy[len] = '\0';
+    free(*field);
+    *field = copy;
+    return SLNETERR_RET_CODE_OK;
+}
+
+int32_t SlNetSock_startSec(int16_t sd, SlNetSockSecAttrib_t *secAttrib, uint8_t flags)
+{
+    SlNetSockSecAttrib_t *bound;
+
+    if ((sd < 0) || (sd >= SLNETHOST_MAX_SOCKETS))
+    {
+        LogError("socket %d is beyond SLNETHOST_MAX_SOCKETS", (int)sd);
+        return SLNETERR_RET_CODE_NO_FREE_SPACE;
+    }
+    if (flags == 0)
+    {
+        flags = SLNETSOCK_SEC_BIND_CONTEXT_ONLY | SLNETSOCK_SEC_START_SECURITY_SESSION_ONLY;
+    }
+
+    (void)pthread_mutex_lock(&lock);
+    if ((flags & SLNETSOCK_SEC_BIND_CONTEXT_ONLY) != 0)
+    {
+        sockets[sd].secAttrib = secAttrib;
+    }
+    bound = sockets[sd].secAttrib;
+    (void)pthread_mutex_unlock(&lock);
+
+    if ((flags & SLNETSOCK_SEC_START_SECURITY_SESSION_ONLY) == 0)
+    {
+        return SLNETERR_RET_CODE_OK;
+    }
+    if (bound == NULL)
+    {
+        return SLNETERR_RET_CODE_INVALID_INPUT;
+    }
+    return StartSession(sd, bound);
+}
+
+int32_t SlNetUtil_getHostByName(uint32_t ifBitmap, char *name, const uint16_t nameLen, uint32_t *ipAddr, uint16_t *ipAddrLen, const uint8_t family)
+{
+    char hostName[NI_MAXHOST];
+    struct addrinfo hints;
+    struct addrinfo *addresses;
+    struct addrinfo *address;
+    uint16_t count = 0;
+
+    (void)ifBitmap;
+    if ((name == NULL) || (nameLen == 0) || (nameLen >= sizeof(hostName)) || (ipAddr == NULL) ||
+        (ipAddrLen == NULL) || (*ipAddrLen == 0) || (family != AF_INET))
+    {
+        return SLNETERR_RET_CODE_INVALID_INPUT;
+    }
+    (void)memcpy(hostName, name, nameLen);
+    hostName[nameLen] = '\0';
+
+    (void)memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(hostName, NULL, &hints, &addresses) != 0)
+    {
+        return SLNETERR_NET_APP_DNS_QUERY_FAILED;
+    }
+
+    for (address = addresses; (address != NULL) && (count < *ipAddrLen); address = address->ai_next)
+    {
+        ipAddr[count++] = ntohl(((struct sockaddr_in *)address->ai_addr)->sin_addr.s_addr);
+    }
+    freeaddrinfo(addresses);
+
+    if (count == 0)
+    {
+        return SLNETERR_NET_APP_DNS_QUERY_FAILED;
+    }
+    *ipAddrLen = count;
+
+    (void)pthread_mutex_lock(&lock);
+    hostCache[hostCacheNext].ipAddr = ipAddr[0];
+    (void)snprintf(hostCache[hostCacheNext].name, sizeof(hostCache[hostCacheNext].name), "%s", hostName);
+    hostCacheNext = (hostCacheNext + 1) % HOST_CACHE_SIZE;
+    (void)pthread_mutex_unlock(&lock);
+
+    return SLNETERR_RET_CODE_OK;
+}
+
+ssize_t SlNetHost_send(int sd, const void *buf, size_t len, int flags)
+{
+    SSL *ssl = GetSession(sd);
+    int ret;
+
+    if (ssl == NULL)
+    {
+        return send(sd, buf, len, flags);
+    }
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    ret = SSL_write(ssl, buf, (len > INT_MAX) ? INT_MAX : (int)len);
+    return (ret > 0) ? ret : SessionError(ssl, ret);
+}
+
+ssize_t SlNetHost_recv(int sd, void *buf, size_t len, int flags)
+{
+    SSL *ssl = GetSession(sd);
+    int ret;
+
+    if (ssl == NULL)
+    {
+        return recv(sd, buf, len, flags);
+    }
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    ret = SSL_read(ssl, buf, (len > INT_MAX) ? INT_MAX : (int)len);
+    return (ret > 0) ? ret : SessionError(ssl, ret);
+}
+
+int SlNetHost_close(int sd)
+{
+    SSL *ssl = NULL;
+
+    if ((sd >= 0) && (sd < SLNETHOST_MAX_SOCKETS))
+    {
+        (void)pthread_mutex_lock(&lock);
+        ssl = sockets[sd].ssl;
+        sockets[sd].ssl = NULL;
+        sockets[sd].secAttrib = NULL;
+        (void)pthread_mutex_unlock(&lock);
+    }
+
+    if (ssl != NULL)
+    {
+        // best effort close_notify, without waiting for the peer's
+        (void)SSL_shutdown(ssl);
+        SSL_free(ssl);
+        ERR_clear_error();
+    }
+    return close(sd);
+}
+
+int SlNetHost_getsockopt(int sd, int level, int optname, void *optval, socklen_t *optlen)
+{
+    if ((level == SLNETSOCK_LVL_SOCKET) && (optname == SLNETSOCK_OPSOCK_SLNETSOCKSD))
+    {
+        if ((optval == NULL) || (optlen == NULL) || (*optlen < sizeof(uint16_t)) || (sd < 0) || (sd > UINT16_MAX))
+        {
+            errno = EINVAL;
+            return -1;
+        }
+        *(uint16_t *)optval = (uint16_t)sd;
+        *optlen = sizeof(uint16_t);
+        return 0;
+    }
+    return getsockopt(sd, level, optname, optval, optlen);
+}
+
+int SlNetHost_setsockopt(int sd, int level, int optname, const void *optval, socklen_t optlen)
+{
+    if ((level == SOL_SOCKET) && (optname == SO_NONBLOCKING))
+    {
+        int fl = fcntl(sd, F_GETFL, 0);
+
+        if ((optval == NULL) || (optlen < sizeof(SlNetSock_Nonblocking_t)) || (fl < 0))
+        {
+            errno = (fl < 0) ? errno : EINVAL;
+            return -1;
+        }
+        fl = (((const SlNetSock_Nonblocking_t *)optval)->nonBlockingEnabled != 0) ? (fl | O_NONBLOCK) : (fl & ~O_NONBLOCK);
+        return fcntl(sd, F_SETFL, fl);
+    }
+    return setsockopt(sd, level, optname, optval, optlen);
+}
@@ -0,0 +1,229 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * The PAL's heap accounting in a build with both PAL_ALLOC_TRACKING and
+ * GB_MEASURE_MEMORY_FOR_THIS, as socketio_sl.c is compiled here: each
+ * allocation shows up in palalloc's statistics of its module and in gballoc's
+ * at once, blocks the SDK allocated with gballoc are given back to it when
+ * the PAL frees them. Eight times as many live blocks as the table starts
+ * with, allocated, reallocated and freed by one thread and then by several
+ * at once, are all tracked, and live bytes come back to zero.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "alloc_sl.h"
+#include "threadapi_sl.h"
+
+#include "test_sl.h"
+
+#define BLOCKS          (PALALLOC_TABLE_SIZE * 8 + 3)
+#define THREADS         4
+#define THREAD_BLOCKS   (PALALLOC_TABLE_SIZE * 2)
+#define THREAD_ROUNDS   200
+
+static PALALLOC_STATS GetStats(PALALLOC_MODULE module)
+{
+    PALALLOC_STATS stats;
+    TEST_REQUIRE(palalloc_get_stats(module, &stats) == 0);
+    return stats;
+}
+
+/* Sizes are counted once by each, and live bytes go back to where they were */
+static void CheckCounts(void)
+{
+    size_t gbBefore = gballoc_getCurrentMemoryUsed();
+    PALALLOC_STATS before = GetStats(PALALLOC_MODULE_HTTPAPI);
+    PALALLOC_STATS during;
+    PALALLOC_STATS after;
+    void* small = palalloc_malloc(PALALLOC_MODULE_HTTPAPI, 10);
+    void* zeroed = palalloc_calloc(PALALLOC_MODULE_HTTPAPI, 10, 100);
+    void* grown;
+
+    TEST_REQUIRE((small != NULL) && (zeroed != NULL));
+    grown = palalloc_realloc(PALALLOC_MODULE_HTTPAPI, small, 5000);
+    TEST_REQUIRE(grown != NULL);
+
+    during = GetStats(PALALLOC_MODULE_HTTPAPI);
+    TEST_CHECK(during.live_bytes - before.live_bytes == 5000 + 1000);
+    TEST_CHECK(during.live_count - before.live_count == 2);
+    TEST_CHECK(during.total_count - before.total_count == 3);
+    TEST_CHECK(during.histogram[0] - before.histogram[0] == 1);  // 10
+    TEST_CHECK(during.histogram[3] - before.histogram[3] == 1);  // 1000
+    TEST_CHECK(during.histogram[5] - before.histogram[5] == 1);  // 5000
+    TEST_CHECK(gballoc_getCurrentMemoryUsed() - gbBefore == 5000 + 1000);
+
+    palalloc_free(grown);
+    palalloc_free(zeroed);
+    after = GetStats(PALALLOC_MODULE_HTTPAPI);
+    TEST_CHECK(after.live_bytes == before.live_bytes);
+    TEST_CHECK(after.live_count == before.live_count);
+    TEST_CHECK(after.peak_bytes - before.live_bytes >= 6000);
+    TEST_CHECK(gballoc_getCurrentMemoryUsed() == gbBefore);
+}
+
+/* A block the SDK allocated and the PAL frees, as with the strings the SDK hands over */
+static void CheckSdkBlocks(void)
+{
+    size_t gbBefore = gballoc_getCurrentMemoryUsed();
+    char* sdkString = gballoc_malloc(64);
+
+    TEST_REQUIRE(sdkString != NULL);
+    (void)strcpy(sdkString, "allocated by the SDK");
+    palalloc_free(sdkString);
+    TEST_CHECK(gballoc_getCurrentMemoryUsed() == gbBefore);
+}
+
+/* A PAL module built with both: what socketio_create() takes is in both sets of books */
+static void CheckModule(void)
+{
+    SOCKETIO_CONFIG config;
+    CONCRETE_IO_HANDLE io;
+    size_t gbBefore = gballoc_getCurrentMemoryUsed();
+    PALALLOC_STATS before = GetStats(PALALLOC_MODULE_SOCKETIO);
+    PALALLOC_STATS during;
+    PALALLOC_STATS after;
+
+    (void)memset(&config, 0, sizeof(config));
+    config.hostname = "localhost";
+    config.port = 443;
+    io = socketio_create(&config);
+    TEST_REQUIRE(io != NULL);
+
+    during = GetStats(PALALLOC_MODULE_SOCKETIO);
+    TEST_CHECK(during.live_count - before.live_count == 2); // the instance and the host name
+    TEST_CHECK(during.live_bytes > before.live_bytes);
+    TEST_CHECK(gballoc_getCurrentMemoryUsed() - gbBefore == during.live_bytes - before.live_bytes);
+
+    socketio_destroy(io);
+    after = GetStats(PALALLOC_MODULE_SOCKETIO);
+    TEST_CHECK(after.live_bytes == before.live_bytes);
+    TEST_CHECK(after.live_count == before.live_count);
+    TEST_CHECK(gballoc_getCurrentMemoryUsed() == gbBefore);
+}
+
+static size_t BlockSize(size_t i)
+{
+    return 1 + (i * 37) % 700;
+}
+
+/* More live blocks than the table starts with, half of them reallocated, freed in another order */
+static void CheckManyBlocks(void)
+{
+    static void* blocks[BLOCKS];
+    size_t gbBefore = gballoc_getCurrentMemoryUsed();
+    size_t untrackedBefore = palalloc_get_untracked_count();
+    PALALLOC_STATS before = GetStats(PALALLOC_MODULE_PARSON);
+    PALALLOC_STATS full;
+    size_t bytes = 0;
+    size_t i;
+
+    TEST_CHECK((before.live_bytes == 0) && (before.live_count == 0));
+    for (i = 0; i < BLOCKS; i++)
+    {
+        blocks[i] = palalloc_malloc(PALALLOC_MODULE_PARSON, BlockSize(i));
+        TEST_REQUIRE(blocks[i] != NULL);
+        bytes += BlockSize(i);
+    }
+    for (i = 0; i < BLOCKS; i += 2)
+    {
+        blocks[i] = palalloc_realloc(PALALLOC_MODULE_PARSON, blocks[i], 2 * BlockSize(i));
+        TEST_REQUIRE(blocks[i] != NULL);
+        bytes += BlockSize(i);
+    }
+    full = GetStats(PALALLOC_MODULE_PARSON);
+    TEST_CHECK(palalloc_get_untracked_count() == untrackedBefore);
+    TEST_CHECK(full.live_count == BLOCKS);
+    TEST_CHECK(full.live_bytes == bytes);
+    TEST_CHECK(full.peak_bytes >= bytes);
+    TEST_CHECK(gballoc_getCurrentMemoryUsed() - gbBefore == bytes);
+
+    for (i = 0; i < BLOCKS; i++)
+    {
+        palalloc_free(blocks[(i * 7) % BLOCKS]);    // 7 is prime to BLOCKS: each block once
+    }
+    full = GetStats(PALALLOC_MODULE_PARSON);
+    TEST_CHECK(full.live_bytes == 0);
+    TEST_CHECK(full.live_count == 0);
+    TEST_CHECK(gballoc_getCurrentMemoryUsed() == gbBefore);
+}
+
+/* Each thread keeps THREAD_BLOCKS blocks live, replacing and resizing them */
+static int Churn(void* arg)
+{
+    static void* blocks[THREADS][THREAD_BLOCKS];
+    size_t thread = (size_t)arg;
+    size_t round;
+    size_t i;
+
+    for (i = 0; i < THREAD_BLOCKS; i++)
+    {
+        blocks[thread][i] = palalloc_malloc(PALALLOC_MODULE_THREADPOOL, BlockSize(i + thread));
+        TEST_REQUIRE(blocks[thread][i] != NULL);
+    }
+    for (round = 0; round < THREAD_ROUNDS; round++)
+    {
+        i = (round * 13 + thread) % THREAD_BLOCKS;
+        if (round % 2 == 0)
+        {
+            palalloc_free(blocks[thread][i]);
+            blocks[thread][i] = palalloc_calloc(PALALLOC_MODULE_THREADPOOL, 1, BlockSize(round));
+        }
+        else
+        {
+            blocks[thread][i] = palalloc_realloc(PALALLOC_MODULE_THREADPOOL, blocks[thread][i], BlockSize(round));
+        }
+        TEST_REQUIRE(blocks[thread][i] != NULL);
+    }
+    for (i = 0; i < THREAD_BLOCKS; i++)
+    {
+        palalloc_free(blocks[thread][i]);
+    }
+    return 0;
+}
+
+static void CheckThreads(void)
+{
+    THREAD_HANDLE threads[THREADS];
+    size_t untrackedBefore = palalloc_get_untracked_count();
+    size_t gbBefore = gballoc_getCurrentMemoryUsed();
+    PALALLOC_STATS after;
+    size_t i;
+
+    for (i = 0; i < THREADS; i++)
+    {
+        TEST_REQUIRE(ThreadAPI_Create(&threads[i], Churn, (void*)i) == THREADAPI_OK);
+    }
+    for (i = 0; i < THREADS; i++)
+    {
+        TEST_REQUIRE(ThreadAPI_Join(threads[i], NULL) == THREADAPI_OK);
+    }
+    after = GetStats(PALALLOC_MODULE_THREADPOOL);
+    TEST_CHECK(palalloc_get_untracked_count() == untrackedBefore);
+    TEST_CHECK(after.live_bytes == 0);
+    TEST_CHECK(after.live_count == 0);
+    TEST_CHECK(after.total_count == THREADS * (THREAD_BLOCKS + THREAD_ROUNDS));
+    TEST_CHECK(after.peak_bytes > 0);
+    TEST_CHECK(gballoc_getCurrentMemoryUsed() == gbBefore);
+}
+
+int main(void)
+{
+    char dump[2048];
+
+    TEST_REQUIRE(gballoc_init() == 0);
+    CheckCounts();
+    CheckSdkBlocks();
+    CheckModule();
+    CheckManyBlocks();
+    CheckThreads();
+
+    TEST_CHECK(palalloc_dump_json(dump, sizeof(dump)) < sizeof(dump));
+    (void)printf("%s\n", dump);
+    gballoc_deinit();
+    return TEST_RESULT();
+}
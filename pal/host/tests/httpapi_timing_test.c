@@ -0,0 +1,160 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * httpapi_sl built with PAL_HTTPAPI_TIMING, against the loopback HTTPS
+ * server holding back its status line and its body for set delays: each
+ * delay shows up in the phase that waits for it, the connection is timed
+ * once per handle, OPTION_HTTPAPI_TIMINGS copies the histograms out without
+ * writing through its value, the reset clears them, and neither can be saved
+ * for the HTTPAPIEX to replay.
+ *
+ * Only the lower bounds that follow from the server's delays are exact: a
+ * client slow to take the status line off the socket moves part of the body
+ * delay from the response phase into the request phase, so the split between
+ * the two is checked on the request least held up.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "httpapi_timing_sl.h"
+
+#include "loopback_sl.h"
+#include "test_sl.h"
+
+#define FIRST_BYTE_MS   80
+#define BODY_MS         120
+#define REQUESTS        3
+
+static const char body[] = "{\"temperature\":21.5}";
+
+static void Execute(HTTP_HANDLE http)
+{
+    HTTP_HEADERS_HANDLE requestHeaders = HTTPHeaders_Alloc();
+    HTTP_HEADERS_HANDLE responseHeaders = HTTPHeaders_Alloc();
+    BUFFER_HANDLE response = BUFFER_new();
+    unsigned int statusCode = 0;
+
+    TEST_REQUIRE((requestHeaders != NULL) && (responseHeaders != NULL) && (response != NULL));
+    TEST_CHECK(HTTPAPI_ExecuteRequest(http, HTTPAPI_REQUEST_POST, "/devices/test/messages/events",
+        requestHeaders, (const unsigned char*)body, sizeof(body) - 1, &statusCode, responseHeaders,
+        response) == HTTPAPI_OK);
+    TEST_CHECK(statusCode == 200);
+    TEST_CHECK((BUFFER_length(response) == sizeof(body) - 1) &&
+        (memcmp(BUFFER_u_char(response), body, sizeof(body) - 1) == 0));
+
+    BUFFER_delete(response);
+    HTTPHeaders_Free(responseHeaders);
+    HTTPHeaders_Free(requestHeaders);
+}
+
+static HTTPAPI_TIMINGS GetTimings(HTTP_HANDLE http)
+{
+    HTTPAPI_TIMINGS timings;
+    HTTPAPI_TIMINGS* const out = &timings;
+
+    TEST_REQUIRE(HTTPAPI_SetOption(http, OPTION_HTTPAPI_TIMINGS, &out) == HTTPAPI_OK);
+    return timings;
+}
+
+static void CheckDelays(HTTP_HANDLE http)
+{
+    HTTPAPI_TIMINGS timings = GetTimings(http);
+    int i;
+
+    for (i = 0; i < HTTPAPI_PHASE_COUNT; i++)
+    {
+        TEST_CHECK(timings.phases[i].count == 0);
+    }
+
+    for (i = 0; i < REQUESTS; i++)
+    {
+        Execute(http);
+    }
+    timings = GetTimings(http);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_CONNECT].count == 1);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_HEADERS].count == REQUESTS);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_REQUEST].count == REQUESTS);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_RESPONSE].count == REQUESTS);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_TOTAL].count == REQUESTS);
+
+    // microseconds; each delay lands in the phase that waits for it, not the other
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_REQUEST].min >= FIRST_BYTE_MS * 1000);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_REQUEST].min < (FIRST_BYTE_MS + BODY_MS) * 1000);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_RESPONSE].max >= BODY_MS * 1000 / 2);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_REQUEST].sum + timings.phases[HTTPAPI_PHASE_RESPONSE].sum >=
+        (uint64_t)REQUESTS * (FIRST_BYTE_MS + BODY_MS) * 1000);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_TOTAL].min >= (FIRST_BYTE_MS + BODY_MS) * 1000);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_TOTAL].sum >=
+        timings.phases[HTTPAPI_PHASE_REQUEST].sum + timings.phases[HTTPAPI_PHASE_RESPONSE].sum);
+}
+
+static void CheckReset(HTTP_HANDLE http, LOOPBACK_HANDLE server)
+{
+    HTTPAPI_TIMINGS timings;
+    HTTPAPI_TIMINGS* out = &timings;
+    const void* saved = NULL;
+    int reset = 1;
+    int i;
+
+    TEST_CHECK(HTTPAPI_SetOption(http, OPTION_HTTPAPI_TIMINGS_RESET, &reset) == HTTPAPI_OK);
+    timings = GetTimings(http);
+    for (i = 0; i < HTTPAPI_PHASE_COUNT; i++)
+    {
+        TEST_CHECK(timings.phases[i].count == 0);
+    }
+
+    // without the delays, and on the open connection
+    Loopback_SetHttpDelays(server, 0, 0);
+    Execute(http);
+    timings = GetTimings(http);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_CONNECT].count == 0);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_TOTAL].count == 1);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_REQUEST].max < FIRST_BYTE_MS * 1000);
+
+    // the HTTPAPIEX would replay a saved option at every reconnect
+    TEST_CHECK(HTTPAPI_CloneOption(OPTION_HTTPAPI_TIMINGS_RESET, &reset, &saved) == HTTPAPI_INVALID_ARG);
+    TEST_CHECK(HTTPAPI_CloneOption(OPTION_HTTPAPI_TIMINGS, &out, &saved) == HTTPAPI_INVALID_ARG);
+    TEST_CHECK(saved == NULL);
+
+    // the value isn't written: the histograms go where the pointer it points to points
+    (void)memset(&timings, 0x5A, sizeof(timings));
+    out = &timings;
+    TEST_CHECK(HTTPAPI_SetOption(http, OPTION_HTTPAPI_TIMINGS, &out) == HTTPAPI_OK);
+    TEST_CHECK(out == &timings);
+    TEST_CHECK(timings.phases[HTTPAPI_PHASE_TOTAL].count == 1);
+
+    out = NULL;
+    TEST_CHECK(HTTPAPI_SetOption(http, OPTION_HTTPAPI_TIMINGS, &out) == HTTPAPI_INVALID_ARG);
+    TEST_CHECK(HTTPAPI_SetOption(http, OPTION_HTTPAPI_TIMINGS, NULL) == HTTPAPI_INVALID_ARG);
+    TEST_CHECK(HTTPAPI_SetOption(NULL, OPTION_HTTPAPI_TIMINGS, &out) == HTTPAPI_INVALID_ARG);
+}
+
+int main(void)
+{
+    LOOPBACK_HANDLE server = Loopback_Start(LOOPBACK_HTTP, 1);
+    HTTP_HANDLE http;
+    char host[32];
+
+    TEST_REQUIRE(server != NULL);
+    Loopback_SetHttpDelays(server, FIRST_BYTE_MS, BODY_MS);
+    (void)snprintf(host, sizeof(host), "localhost:%d", Loopback_GetPort(server));
+
+    TEST_REQUIRE(HTTPAPI_Init() == HTTPAPI_OK);
+    http = HTTPAPI_CreateConnection(host);
+    TEST_REQUIRE(http != NULL);
+
+    CheckDelays(http);
+    CheckReset(http, server);
+
+    HTTPAPI_CloseConnection(http);
+    HTTPAPI_Deinit();
+    TEST_CHECK(Loopback_GetConnectionCount(server) == 1);
+    Loopback_Stop(server);
+    return TEST_RESULT();
+}
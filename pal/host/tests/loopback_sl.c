@@ -0,0 +1,516 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include "cert_sl.h"
+#include "loopback_sl.h"
+
+#define POLL_MS         100
+#define IO_TIMEOUT_S    5
+#define HTTP_BUFFER     65536
+
+typedef struct LOOPBACK_INSTANCE_TAG
+{
+    LOOPBACK_MODE mode;
+    SSL_CTX* ctx;               // NULL without TLS
+    int listener;
+    int port;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    int stop;
+    unsigned int firstByteMs;
+    unsigned int bodyMs;
+    size_t bytesReceived;
+    size_t bytesSent;
+    unsigned int connections;
+    char root[64];              // SLNETHOST_FS_ROOT of a TLS server
+    char certPath[96];
+} LOOPBACK_INSTANCE;
+
+typedef struct CONNECTION_TAG
+{
+    LOOPBACK_INSTANCE* server;
+    int sock;
+    SSL* ssl;
+} CONNECTION;
+
+static void SleepMs(unsigned int ms)
+{
+    struct timespec delay;
+
+    delay.tv_sec = ms / 1000;
+    delay.tv_nsec = (long)(ms % 1000) * 1000000;
+    while ((nanosleep(&delay, &delay) != 0) && (errno == EINTR))
+    {
+    }
+}
+
+static int Stopping(LOOPBACK_INSTANCE* server)
+{
+    int result;
+
+    (void)pthread_mutex_lock(&server->lock);
+    result = server->stop;
+    (void)pthread_mutex_unlock(&server->lock);
+    return result;
+}
+
+static void Count(LOOPBACK_INSTANCE* server, size_t* counter, size_t n)
+{
+    (void)pthread_mutex_lock(&server->lock);
+    *counter += n;
+    (void)pthread_mutex_unlock(&server->lock);
+}
+
+/* Waits for data: 1 when there is some, 0 on stop */
+static int WaitReadable(CONNECTION* connection)
+{
+    struct pollfd pfd;
+
+    if ((connection->ssl != NULL) && (SSL_pending(connection->ssl) > 0))
+    {
+        return 1;
+    }
+
+    pfd.fd = connection->sock;
+    pfd.events = POLLIN;
+    while (!Stopping(connection->server))
+    {
+        pfd.revents = 0;
+        if (poll(&pfd, 1, POLL_MS) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Bytes read, 0 at the end of the connection or on stop, -1 on error */
+static int Read(CONNECTION* connection, char* buffer, size_t size)
+{
+    int result;
+
+    if (!WaitReadable(connection))
+    {
+        return 0;
+    }
+
+    if (connection->ssl != NULL)
+    {
+        result = SSL_read(connection->ssl, buffer, (int)size);
+        if (result <= 0)
+        {
+            result = (SSL_get_error(connection->ssl, result) == SSL_ERROR_ZERO_RETURN) ? 0 : -1;
+        }
+    }
+    else
+    {
+        result = (int)recv(connection->sock, buffer, size, 0);
+    }
+
+    if (result > 0)
+    {
+        Count(connection->server, &connection->server->bytesReceived, (size_t)result);
+    }
+    return result;
+}
+
+static int Write(CONNECTION* connection, const char* buffer, size_t size)
+{
+    size_t done = 0;
+
+    while (done < size)
+    {
+        int result;
+
+        if (connection->ssl != NULL)
+        {
+            result = SSL_write(connection->ssl, buffer + done, (int)(size - done));
+        }
+        else
+        {
+            result = (int)send(connection->sock, buffer + done, size - done, MSG_NOSIGNAL);
+        }
+        if (result <= 0)
+        {
+            return -1;
+        }
+        done += (size_t)result;
+    }
+
+    Count(connection->server, &connection->server->bytesSent, size);
+    return 0;
+}
+
+static void ServeEcho(CONNECTION* connection)
+{
+    char buffer[16384];
+    int received;
+
+    while ((received = Read(connection, buffer, sizeof(buffer))) > 0)
+    {
+        if (Write(connection, buffer, (size_t)received) != 0)
+        {
+            break;
+        }
+    }
+}
+
+static size_t ContentLength(const char* headers, size_t length)
+{
+    const char* line = headers;
+    const char* end = headers + length;
+
+    while (line < end)
+    {
+        const char* next = memchr(line, '\n', (size_t)(end - line));
+
+        if (strncasecmp(line, "Content-Length:", 15) == 0)
+        {
+            return (size_t)strtoul(line + 15, NULL, 10);
+        }
+        if (next == NULL)
+        {
+            break;
+        }
+        line = next + 1;
+    }
+    return 0;
+}
+
+static void ServeHttp(CONNECTION* connection)
+{
+    char* buffer = malloc(HTTP_BUFFER);
+    size_t used = 0;
+
+    while (buffer != NULL)
+    {
+        char* headersEnd = NULL;
+        size_t request;
+        size_t bodyLength;
+        int received;
+
+        // one whole request: the headers, then as much body as they announce
+        while (((headersEnd = (used > 0) ? memmem(buffer, used, "\r\n\r\n", 4) : NULL) == NULL) ||
+            (used < (size_t)(headersEnd + 4 - buffer) + ContentLength(buffer, (size_t)(headersEnd - buffer))))
+        {
+            if ((used == HTTP_BUFFER) || ((received = Read(connection, buffer + used, HTTP_BUFFER - used)) <= 0))
+            {
+                free(buffer);
+                return;
+            }
+            used += (size_t)received;
+        }
+        bodyLength = ContentLength(buffer, (size_t)(headersEnd - buffer));
+        request = (size_t)(headersEnd + 4 - buffer) + bodyLength;
+
+        {
+            LOOPBACK_INSTANCE* server = connection->server;
+            unsigned int firstByteMs;
+            unsigned int bodyMs;
+            char status[128];
+
+            (void)pthread_mutex_lock(&server->lock);
+            firstByteMs = server->firstByteMs;
+            bodyMs = server->bodyMs;
+            (void)pthread_mutex_unlock(&server->lock);
+
+            SleepMs(firstByteMs);
+            (void)snprintf(status, sizeof(status), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                "Content-Length: %lu\r\n\r\n", (unsigned long)bodyLength);
+            if (Write(connection, status, strlen(status)) != 0)
+            {
+                break;
+            }
+            SleepMs(bodyMs);
+            if ((bodyLength > 0) && (Write(connection, headersEnd + 4, bodyLength) != 0))
+            {
+                break;
+            }
+        }
+
+        (void)memmove(buffer, buffer + request, used - request);
+        used -= request;
+    }
+    free(buffer);
+}
+
+static void* ServerThread(void* arg)
+{
+    LOOPBACK_INSTANCE* server = arg;
+    struct pollfd pfd;
+
+    pfd.fd = server->listener;
+    pfd.events = POLLIN;
+    while (!Stopping(server))
+    {
+        CONNECTION connection;
+        struct timeval timeout;
+
+        pfd.revents = 0;
+        if ((poll(&pfd, 1, POLL_MS) <= 0) || ((connection.sock = accept(server->listener, NULL, NULL)) < 0))
+        {
+            continue;
+        }
+
+        // a client that stops talking can't hold the server up for long
+        timeout.tv_sec = IO_TIMEOUT_S;
+        timeout.tv_usec = 0;
+        (void)setsockopt(connection.sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        (void)setsockopt(connection.sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        connection.server = server;
+        connection.ssl = NULL;
+        (void)pthread_mutex_lock(&server->lock);
+        server->connections++;
+        (void)pthread_mutex_unlock(&server->lock);
+
+        if (server->ctx != NULL)
+        {
+            connection.ssl = SSL_new(server->ctx);
+            if ((connection.ssl == NULL) || (SSL_set_fd(connection.ssl, connection.sock) != 1) ||
+                (SSL_accept(connection.ssl) != 1))
+            {
+                // the client didn't trust us, which some tests want
+                ERR_clear_error();
+                SSL_free(connection.ssl);
+                (void)close(connection.sock);
+                continue;
+            }
+        }
+
+        if (server->mode == LOOPBACK_ECHO)
+        {
+            ServeEcho(&connection);
+        }
+        else
+        {
+            ServeHttp(&connection);
+        }
+
+        if (connection.ssl != NULL)
+        {
+            (void)SSL_shutdown(connection.ssl);
+            SSL_free(connection.ssl);
+        }
+        (void)close(connection.sock);
+    }
+    return NULL;
+}
+
+/* A self-signed certificate for "localhost", written to certPath */
+static int CreateCredentials(LOOPBACK_INSTANCE* server)
+{
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    X509* cert = X509_new();
+    X509_NAME* name;
+    X509V3_CTX extensionCtx;
+    X509_EXTENSION* san = NULL;
+    X509_EXTENSION* constraints = NULL;
+    FILE* file = NULL;
+    char* slash;
+    int result = -1;
+
+    (void)snprintf(server->root, sizeof(server->root), "/tmp/pal_loopback_XXXXXX");
+    if ((key == NULL) || (cert == NULL) || (mkdtemp(server->root) == NULL))
+    {
+        goto done;
+    }
+    (void)snprintf(server->certPath, sizeof(server->certPath), "%s%s", server->root, SL_SSL_CA_CERT);
+    slash = strrchr(server->certPath, '/');
+    *slash = '\0';
+    if (mkdir(server->certPath, 0700) != 0)
+    {
+        goto done;
+    }
+    *slash = '/';
+
+    (void)X509_set_version(cert, 2);
+    (void)ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    (void)X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+    (void)X509_gmtime_adj(X509_getm_notAfter(cert), 24 * 3600);
+    (void)X509_set_pubkey(cert, key);
+    name = X509_get_subject_name(cert);
+    (void)X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+    (void)X509_set_issuer_name(cert, name);
+
+    X509V3_set_ctx_nodb(&extensionCtx);
+    X509V3_set_ctx(&extensionCtx, cert, cert, NULL, NULL, 0);
+    san = X509V3_EXT_conf_nid(NULL, &extensionCtx, NID_subject_alt_name, "DNS:localhost");
+    constraints = X509V3_EXT_conf_nid(NULL, &extensionCtx, NID_basic_constraints, "critical,CA:TRUE");
+    if ((san == NULL) || (constraints == NULL) ||
+        (X509_add_ext(cert, san, -1) != 1) || (X509_add_ext(cert, constraints, -1) != 1) ||
+        (X509_sign(cert, key, EVP_sha256()) == 0))
+    {
+        goto done;
+    }
+
+    if (((file = fopen(server->certPath, "w")) == NULL) || (PEM_write_X509(file, cert) != 1) ||
+        (SSL_CTX_use_certificate(server->ctx, cert) != 1) || (SSL_CTX_use_PrivateKey(server->ctx, key) != 1))
+    {
+        goto done;
+    }
+    result = 0;
+
+done:
+    if (file != NULL)
+    {
+        (void)fclose(file);
+    }
+    X509_EXTENSION_free(san);
+    X509_EXTENSION_free(constraints);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return result;
+}
+
+static void RemoveCredentials(LOOPBACK_INSTANCE* server)
+{
+    char* slash;
+
+    if (server->certPath[0] != '\0')
+    {
+        (void)unlink(server->certPath);
+        slash = strrchr(server->certPath, '/');
+        *slash = '\0';
+        (void)rmdir(server->certPath);
+    }
+    if (server->root[0] != '\0')
+    {
+        (void)rmdir(server->root);
+    }
+}
+
+LOOPBACK_HANDLE Loopback_Start(LOOPBACK_MODE mode, int tls)
+{
+    LOOPBACK_INSTANCE* server = calloc(1, sizeof(LOOPBACK_INSTANCE));
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof(address);
+
+    if (server == NULL)
+    {
+        return NULL;
+    }
+    server->mode = mode;
+    server->listener = -1;
+    (void)pthread_mutex_init(&server->lock, NULL);
+
+    // a client that goes away mid-write must not take the test with it
+    (void)signal(SIGPIPE, SIG_IGN);
+
+    if (tls && (((server->ctx = SSL_CTX_new(TLS_server_method())) == NULL) ||
+        (CreateCredentials(server) != 0) || (setenv("SLNETHOST_FS_ROOT", server->root, 1) != 0)))
+    {
+        (void)fprintf(stderr, "loopback: no TLS credentials\n");
+        ERR_print_errors_fp(stderr);
+        Loopback_Stop(server);
+        return NULL;
+    }
+
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (((server->listener = socket(AF_INET, SOCK_STREAM, 0)) < 0) ||
+        (bind(server->listener, (struct sockaddr*)&address, sizeof(address)) != 0) ||
+        (listen(server->listener, 4) != 0) ||
+        (getsockname(server->listener, (struct sockaddr*)&address, &addressLength) != 0))
+    {
+        (void)fprintf(stderr, "loopback: can't listen: %s\n", strerror(errno));
+        Loopback_Stop(server);
+        return NULL;
+    }
+    server->port = ntohs(address.sin_port);
+
+    if (pthread_create(&server->thread, NULL, ServerThread, server) != 0)
+    {
+        (void)close(server->listener);
+        server->listener = -1;
+        Loopback_Stop(server);
+        return NULL;
+    }
+    return server;
+}
+
+void Loopback_Stop(LOOPBACK_HANDLE server)
+{
+    if (server != NULL)
+    {
+        if (server->listener >= 0)
+        {
+            (void)pthread_mutex_lock(&server->lock);
+            server->stop = 1;
+            (void)pthread_mutex_unlock(&server->lock);
+            (void)pthread_join(server->thread, NULL);
+            (void)close(server->listener);
+        }
+        if (server->ctx != NULL)
+        {
+            SSL_CTX_free(server->ctx);
+            RemoveCredentials(server);
+        }
+        (void)pthread_mutex_destroy(&server->lock);
+        free(server);
+    }
+}
+
+int Loopback_GetPort(LOOPBACK_HANDLE server)
+{
+    return server->port;
+}
+
+void Loopback_SetHttpDelays(LOOPBACK_HANDLE server, unsigned int firstByteMs, unsigned int bodyMs)
+{
+    (void)pthread_mutex_lock(&server->lock);
+    server->firstByteMs = firstByteMs;
+    server->bodyMs = bodyMs;
+    (void)pthread_mutex_unlock(&server->lock);
+}
+
+size_t Loopback_GetBytesReceived(LOOPBACK_HANDLE server)
+{
+    size_t result;
+
+    (void)pthread_mutex_lock(&server->lock);
+    result = server->bytesReceived;
+    (void)pthread_mutex_unlock(&server->lock);
+    return result;
+}
+
+size_t Loopback_GetBytesSent(LOOPBACK_HANDLE server)
+{
+    size_t result;
+
+    (void)pthread_mutex_lock(&server->lock);
+    result = server->bytesSent;
+    (void)pthread_mutex_unlock(&server->lock);
+    return result;
+}
+
+unsigned int Loopback_GetConnectionCount(LOOPBACK_HANDLE server)
+{
+    unsigned int result;
+
+    (void)pthread_mutex_lock(&server->lock);
+    result = server->connections;
+    (void)pthread_mutex_unlock(&server->lock);
+    return result;
+}
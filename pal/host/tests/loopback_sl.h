@@ -0,0 +1,50 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * A server on 127.0.0.1 for the tests of the network modules, run by a
+ * thread of the test itself. It serves one connection at a time, either
+ * echoing every byte or answering HTTP/1.1 requests with their own body,
+ * after the delays set with Loopback_SetHttpDelays().
+ *
+ * A TLS server makes a self-signed certificate for "localhost" and writes it
+ * to SL_SSL_CA_CERT under a new directory, which it puts in
+ * SLNETHOST_FS_ROOT, so the host SlNet trusts it the way the target trusts
+ * the certificate flashed there.
+ */
+#ifndef LOOPBACK_SL_H
+#define LOOPBACK_SL_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+typedef struct LOOPBACK_INSTANCE_TAG* LOOPBACK_HANDLE;
+
+typedef enum LOOPBACK_MODE_TAG
+{
+    LOOPBACK_ECHO,
+    LOOPBACK_HTTP
+} LOOPBACK_MODE;
+
+extern LOOPBACK_HANDLE Loopback_Start(LOOPBACK_MODE mode, int tls);
+extern void Loopback_Stop(LOOPBACK_HANDLE server);
+
+extern int Loopback_GetPort(LOOPBACK_HANDLE server);
+
+/* HTTP: waits before the status line of each response, and again before its body */
+extern void Loopback_SetHttpDelays(LOOPBACK_HANDLE server, unsigned int firstByteMs, unsigned int bodyMs);
+
+/* Totals since the start, over all connections */
+extern size_t Loopback_GetBytesReceived(LOOPBACK_HANDLE server);
+extern size_t Loopback_GetBytesSent(LOOPBACK_HANDLE server);
+extern unsigned int Loopback_GetConnectionCount(LOOPBACK_HANDLE server);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOOPBACK_SL_H */
@@ -0,0 +1,289 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * The CBOR and MessagePack encodings of parson_sl.c, built here with
+ * PARSON_MSGPACK: the RFC 8949 appendix A examples and MessagePack's format
+ * boundaries encode and decode to the listed bytes, -0.0 keeps its sign,
+ * random documents come back equal from both with the size announced, and
+ * every cut-off or corrupted encoding is refused or decoded without reading
+ * past its end.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parson_sl.h"
+
+#include "test_sl.h"
+
+#define RANDOM_DOCUMENTS 2000
+#define MAX_DEPTH        4
+#define MAX_ENCODED      (64 * 1024)
+
+typedef struct EXAMPLE_TAG
+{
+    const char* json;
+    const char* hex;
+} EXAMPLE;
+
+/* RFC 8949 appendix A, where this encoder makes the same choice: integral numbers within int64 are integers */
+static const EXAMPLE cborExamples[] =
+{
+    { "0", "00" }, { "1", "01" }, { "10", "0a" }, { "23", "17" }, { "24", "1818" }, { "25", "1819" },
+    { "100", "1864" }, { "1000", "1903e8" }, { "1000000", "1a000f4240" }, { "1000000000000", "1b000000e8d4a51000" },
+    { "-1", "20" }, { "-10", "29" }, { "-100", "3863" },
+    { "-1000", "3903e7" }, { "1.1", "fb3ff199999999999a" }, { "3.4028234663852886e+38", "fa7f7fffff" },
+    { "1.0e+300", "fb7e37e43c8800759c" }, { "-4.1", "fbc010666666666666" }, { "0.5", "fa3f000000" },
+    { "false", "f4" }, { "true", "f5" }, { "null", "f6" }, { "\"\"", "60" }, { "\"a\"", "6161" },
+    { "\"IETF\"", "6449455446" }, { "\"\\\"\\\\\"", "62225c" }, { "\"\\u00fc\"", "62c3bc" },
+    { "\"\\u6c34\"", "63e6b0b4" }, { "\"\\ud800\\udd51\"", "64f0908591" }, { "[]", "80" },
+    { "[1,2,3]", "83010203" }, { "[1,[2,3],[4,5]]", "8301820203820405" }, { "{}", "a0" },
+    { "{\"a\":1,\"b\":[2,3]}", "a26161016162820203" }, { "[\"a\",{\"b\":\"c\"}]", "826161a161626163" },
+    { "-0.0", "fa80000000" },
+};
+
+/* Decoded only: other lengths of the same values, half floats, tags and indefinite lengths */
+static const EXAMPLE cborDecodeOnly[] =
+{
+    { "1.0", "f93c00" }, { "-2.0", "f9c000" }, { "65504.0", "f97bff" }, { "5.960464477539063e-8", "f90001" },
+    { "-0.0", "f98000" }, { "100000.0", "fa47c35000" }, { "1000", "1a000003e8" },
+    { "\"2013-03-21T20:04:00Z\"", "c074323031332d30332d32315432303a30343a30305a" },
+    { "[1,[2,3],[4,5]]", "9f018202039f0405ffff" }, { "{\"a\":1,\"b\":[2,3]}", "bf61610161629f0203ffff" },
+    { "[]", "9fff" },
+};
+
+static const EXAMPLE msgpackExamples[] =
+{
+    { "0", "00" }, { "127", "7f" }, { "128", "cc80" }, { "255", "ccff" }, { "256", "cd0100" },
+    { "65536", "ce00010000" }, { "4294967296", "cf0000000100000000" }, { "-1", "ff" }, { "-32", "e0" },
+    { "-33", "d0df" }, { "-129", "d1ff7f" }, { "-32769", "d2ffff7fff" }, { "-2147483649", "d3ffffffff7fffffff" },
+    { "0.5", "ca3f000000" }, { "1.1", "cb3ff199999999999a" }, { "-0.0", "ca80000000" },
+    { "false", "c2" }, { "true", "c3" }, { "null", "c0" }, { "\"a\"", "a161" },
+    { "\"0123456789012345678901234567890\"", "bf30313233343536373839303132333435363738393031323334353637383930" },
+    { "\"01234567890123456789012345678901\"", "d9203031323334353637383930313233343536373839303132333435363738393031" },
+    { "[1,2]", "920102" }, { "{\"a\":[]}", "81a16190" }, { "{}", "80" },
+};
+
+static uint32_t rngState = 0x6C8E9CF5u;
+
+static uint32_t Random(uint32_t range)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState % range;
+}
+
+static size_t FromHex(const char* hex, unsigned char* bytes)
+{
+    size_t length = strlen(hex) / 2;
+    unsigned int byte;
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        TEST_REQUIRE(sscanf(hex + 2 * i, "%2x", &byte) == 1);
+        bytes[i] = (unsigned char)byte;
+    }
+    return length;
+}
+
+static int SameNumber(double a, double b)
+{
+    return (a == b) && (signbit(a) == signbit(b));
+}
+
+/* Encodes one example, compares the bytes, and decodes them back */
+static void CheckExample(const EXAMPLE* example, int msgpack, int encode)
+{
+    unsigned char expected[128];
+    unsigned char encoded[128];
+    JSON_Value* value = json_parse_string(example->json);
+    JSON_Value* decoded;
+    size_t length = FromHex(example->hex, expected);
+    size_t size;
+
+    TEST_REQUIRE(value != NULL);
+    if (encode)
+    {
+        size = msgpack ? json_serialization_size_msgpack(value) : json_serialization_size_cbor(value);
+        TEST_CHECK(size == length);
+        TEST_CHECK((msgpack ? json_serialize_to_buffer_msgpack(value, encoded, sizeof(encoded)) :
+            json_serialize_to_buffer_cbor(value, encoded, sizeof(encoded))) == JSONSuccess);
+        if ((size != length) || (memcmp(encoded, expected, length) != 0))
+        {
+            (void)fprintf(stderr, "%s encoded %s wrong\n", msgpack ? "MessagePack" : "CBOR", example->json);
+            TEST_CHECK(0);
+        }
+    }
+
+    decoded = msgpack ? json_parse_msgpack(expected, length) : json_parse_cbor(expected, length);
+    if ((decoded == NULL) || !json_value_equals(decoded, value) ||
+        ((json_value_get_type(value) == JSONNumber) &&
+         !SameNumber(json_value_get_number(decoded), json_value_get_number(value))))
+    {
+        (void)fprintf(stderr, "%s decoded %s wrong\n", msgpack ? "MessagePack" : "CBOR", example->hex);
+        TEST_CHECK(0);
+    }
+    json_value_free(decoded);
+    json_value_free(value);
+}
+
+static void CheckExamples(void)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(cborExamples) / sizeof(cborExamples[0]); i++)
+    {
+        CheckExample(&cborExamples[i], 0, 1);
+    }
+    for (i = 0; i < sizeof(cborDecodeOnly) / sizeof(cborDecodeOnly[0]); i++)
+    {
+        CheckExample(&cborDecodeOnly[i], 0, 0);
+    }
+    for (i = 0; i < sizeof(msgpackExamples) / sizeof(msgpackExamples[0]); i++)
+    {
+        CheckExample(&msgpackExamples[i], 1, 1);
+    }
+}
+
+static JSON_Value* RandomNumber(void)
+{
+    static const double specials[] = { 0.0, -0.0, 0.5, -1.5, 1e-300, 1.7976931348623157e308, 4.9e-324, 0.1 };
+
+    switch (Random(6))
+    {
+        case 0:
+            return json_value_init_number((double)Random(300) - 150);
+        case 1:
+            return json_value_init_int64((int64_t)(((uint64_t)Random(0xFFFFFFFF) << 32) | Random(0xFFFFFFFF)));
+        case 2:
+            return json_value_init_number((double)(float)((double)Random(1000000) / 1024));
+        case 3:
+            return json_value_init_number((double)Random(1000000) / 3);
+        case 4:
+            return json_value_init_number(-(double)Random(0xFFFFFFFF) * 65536.0);
+        default:
+            return json_value_init_number(specials[Random(sizeof(specials) / sizeof(specials[0]))]);
+    }
+}
+
+static JSON_Value* RandomString(void)
+{
+    static const char* const pieces[] = { "a", "temperature", "\xC3\xBC", "\xE6\xB0\xB4", "\xF0\x90\x85\x91", " ", "\"" };
+    char text[320];
+    size_t length = 0;
+    uint32_t count = Random(40);
+    uint32_t i;
+
+    text[0] = '\0';
+    for (i = 0; i < count; i++)
+    {
+        (void)strcpy(text + length, pieces[Random(sizeof(pieces) / sizeof(pieces[0]))]);
+        length += strlen(text + length);
+    }
+    return json_value_init_string(text);
+}
+
+static JSON_Value* RandomValue(int depth)
+{
+    JSON_Value* value;
+    char name[16];
+    uint32_t count;
+    uint32_t i;
+
+    switch (Random(depth < MAX_DEPTH ? 7 : 5))
+    {
+        case 0:
+            return json_value_init_null();
+        case 1:
+            return json_value_init_boolean((int)Random(2));
+        case 2:
+        case 3:
+            return RandomNumber();
+        case 4:
+            return RandomString();
+        case 5:
+            value = json_value_init_array();
+            count = Random(20);
+            for (i = 0; i < count; i++)
+            {
+                TEST_REQUIRE(json_array_append_value(json_array(value), RandomValue(depth + 1)) == JSONSuccess);
+            }
+            return value;
+        default:
+            value = json_value_init_object();
+            count = Random(20);
+            for (i = 0; i < count; i++)
+            {
+                (void)sprintf(name, "k%u", (unsigned int)Random(40));
+                TEST_REQUIRE(json_object_set_value(json_object(value), name, RandomValue(depth + 1)) == JSONSuccess);
+            }
+            return value;
+    }
+}
+
+/* Encodes, checks the size and decodes; then every prefix and a corrupted copy must decode safely */
+static void CheckRoundTrip(const JSON_Value* value, int msgpack, unsigned char* encoded)
+{
+    size_t size = msgpack ? json_serialization_size_msgpack(value) : json_serialization_size_cbor(value);
+    unsigned char* copy;
+    JSON_Value* decoded;
+    size_t cut;
+
+    TEST_REQUIRE((size > 0) && (size <= MAX_ENCODED));
+    TEST_CHECK((msgpack ? json_serialize_to_buffer_msgpack(value, encoded, size - 1) :
+        json_serialize_to_buffer_cbor(value, encoded, size - 1)) == JSONFailure);
+    TEST_REQUIRE((msgpack ? json_serialize_to_buffer_msgpack(value, encoded, size) :
+        json_serialize_to_buffer_cbor(value, encoded, size)) == JSONSuccess);
+
+    decoded = msgpack ? json_parse_msgpack(encoded, size) : json_parse_cbor(encoded, size);
+    TEST_CHECK((decoded != NULL) && json_value_equals(decoded, value));
+    json_value_free(decoded);
+
+    // exact-size copies, so a read past the end is an ASan report
+    for (cut = (size > 64) ? size - 64 : 0; cut < size; cut++)
+    {
+        copy = malloc(cut + 1);
+        TEST_REQUIRE(copy != NULL);
+        (void)memcpy(copy, encoded, cut);
+        TEST_CHECK((msgpack ? json_parse_msgpack(copy, cut) : json_parse_cbor(copy, cut)) == NULL);
+        free(copy);
+    }
+    copy = malloc(size);
+    TEST_REQUIRE(copy != NULL);
+    (void)memcpy(copy, encoded, size);
+    copy[Random((uint32_t)size)] ^= (unsigned char)(1 + Random(255));
+    json_value_free(msgpack ? json_parse_msgpack(copy, size) : json_parse_cbor(copy, size));
+    free(copy);
+}
+
+static void CheckRandomDocuments(void)
+{
+    unsigned char* encoded = malloc(MAX_ENCODED);
+    JSON_Value* value;
+    int i;
+
+    TEST_REQUIRE(encoded != NULL);
+    json_set_parse_int64(1);
+    for (i = 0; i < RANDOM_DOCUMENTS; i++)
+    {
+        value = RandomValue(0);
+        TEST_REQUIRE(value != NULL);
+        CheckRoundTrip(value, 0, encoded);
+        CheckRoundTrip(value, 1, encoded);
+        json_value_free(value);
+    }
+    json_set_parse_int64(0);
+    free(encoded);
+}
+
+int main(void)
+{
+    CheckExamples();
+    CheckRandomDocuments();
+    return TEST_RESULT();
+}
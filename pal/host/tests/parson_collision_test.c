@@ -0,0 +1,84 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Member names of parson_sl.c whose hashes collide: a lookup of a long name
+ * that hashes like a shorter stored one finds nothing, reads nothing past
+ * the stored name (AddressSanitizer reports it otherwise), and both names
+ * can live in one object, with and without interned keys. A compiled
+ * schema naming one of them checks a member of that name only, wherever the
+ * other one stands.
+ *
+ * The long name below hashes like "id" with djb2 in 64 bits, and so also in
+ * the 32 bits of an unsigned long on Cortex-M.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parson_sl.h"
+
+#include "test_sl.h"
+
+#define SHORT_NAME  "id"
+#define LONG_NAME   "003-//%%, :'8"
+
+static void CheckObject(void)
+{
+    JSON_Value* value = json_parse_string("{\"" SHORT_NAME "\":1}");
+    JSON_Object* object = json_object(value);
+    JSON_Path* path = json_path_compile(LONG_NAME);
+
+    TEST_REQUIRE((value != NULL) && (path != NULL));
+    TEST_CHECK(json_object_get_value(object, LONG_NAME) == NULL);
+    TEST_CHECK(json_object_dotget_value(object, LONG_NAME) == NULL);
+    TEST_CHECK(json_path_get_value(object, path) == NULL);
+    TEST_CHECK(json_object_has_value(object, LONG_NAME) == 0);
+    TEST_CHECK(json_object_remove(object, LONG_NAME) == JSONFailure);
+
+    TEST_CHECK(json_object_set_number(object, LONG_NAME, 2) == JSONSuccess);
+    TEST_CHECK(json_object_get_count(object) == 2);
+    TEST_CHECK(json_object_get_number(object, SHORT_NAME) == 1);
+    TEST_CHECK(json_object_get_number(object, LONG_NAME) == 2);
+    TEST_CHECK(json_path_set_number(object, path, 3) == JSONSuccess);
+    TEST_CHECK(json_object_get_number(object, SHORT_NAME) == 1);
+    TEST_CHECK(json_object_get_number(object, LONG_NAME) == 3);
+
+    json_path_free(path);
+    json_value_free(value);
+}
+
+static void CheckSchema(void)
+{
+    JSON_Value* schemaValue = json_parse_string("{\"" LONG_NAME "\":0}");
+    JSON_Schema* schema = json_schema_compile(schemaValue);
+    JSON_Value* shortFirst = json_parse_string("{\"" SHORT_NAME "\":1,\"other\":2}");
+    JSON_Value* longFirst = json_parse_string("{\"" LONG_NAME "\":1,\"other\":2}");
+    JSON_Value* longSecond = json_parse_string("{\"" SHORT_NAME "\":1,\"" LONG_NAME "\":2}");
+    JSON_Value* wrongType = json_parse_string("{\"" LONG_NAME "\":\"1\",\"" SHORT_NAME "\":2}");
+
+    TEST_REQUIRE((schema != NULL) && (shortFirst != NULL) && (longFirst != NULL) && (longSecond != NULL) && (wrongType != NULL));
+    TEST_CHECK(json_schema_validate(schema, shortFirst) == JSONFailure);
+    TEST_CHECK(json_schema_validate(schema, longFirst) == JSONSuccess);
+    TEST_CHECK(json_schema_validate(schema, longSecond) == JSONSuccess);
+    TEST_CHECK(json_schema_validate(schema, wrongType) == JSONFailure);
+    TEST_CHECK(json_validate(schemaValue, shortFirst) == JSONFailure);
+    TEST_CHECK(json_validate(schemaValue, longSecond) == JSONSuccess);
+
+    json_value_free(wrongType);
+    json_value_free(longSecond);
+    json_value_free(longFirst);
+    json_value_free(shortFirst);
+    json_schema_free(schema);
+    json_value_free(schemaValue);
+}
+
+int main(void)
+{
+    CheckObject();
+    CheckSchema();
+    json_set_intern_keys(1);
+    CheckObject();
+    json_set_intern_keys(0);
+    return TEST_RESULT();
+}
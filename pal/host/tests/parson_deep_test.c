@@ -0,0 +1,130 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * parson_sl.c on documents nested far deeper than the parser's default
+ * limit: they are built, serialized and freed without recursion, and the
+ * pretty size, which grows with the square of the depth, is either exact or
+ * refused, never wrapped into a buffer too small for it.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parson_sl.h"
+
+#include "test_sl.h"
+
+#define DEEP         50000
+#define SHALLOW      1000
+#define MAX_ALLOC    (64 * 1024 * 1024)
+
+/* Refuses the allocations a deep pretty document would need instead of trying them */
+static void* LimitedMalloc(size_t size)
+{
+    return (size > MAX_ALLOC) ? NULL : malloc(size);
+}
+
+/* [[[...1...]]], depth arrays deep */
+static JSON_Value* MakeNested(size_t depth)
+{
+    JSON_Value* value = json_value_init_number(1);
+    JSON_Value* array;
+    size_t i;
+
+    for (i = 0; i < depth; i++)
+    {
+        array = json_value_init_array();
+        TEST_REQUIRE(array != NULL);
+        TEST_REQUIRE(json_array_append_value(json_array(array), value) == JSONSuccess);
+        value = array;
+    }
+    return value;
+}
+
+/* Each level writes "[\n", its indentation twice and "\n]": 4 * depth * depth + 4 * depth + "1" and '\0' */
+static uint64_t PrettySize(uint64_t depth)
+{
+    return 4 * depth * depth + 4 * depth + 2;
+}
+
+static JSON_Status CountChunk(void* context, const char* data, size_t len)
+{
+    (void)data;
+    *(size_t*)context += len;
+    return JSONSuccess;
+}
+
+static void CheckShallow(void)
+{
+    JSON_Value* value = MakeNested(SHALLOW);
+    JSON_Value* parsed;
+    char* pretty;
+    char chunk[256];
+    size_t written = 0;
+
+    TEST_CHECK(json_serialization_size_pretty(value) == PrettySize(SHALLOW));
+    pretty = json_serialize_to_string_pretty(value);
+    TEST_REQUIRE(pretty != NULL);
+    TEST_CHECK(strlen(pretty) + 1 == PrettySize(SHALLOW));
+
+    TEST_CHECK(json_serialize_to_writer(value, chunk, sizeof(chunk), CountChunk, &written) == JSONSuccess);
+    TEST_CHECK(written == json_serialization_size(value) - 1);
+
+    json_set_max_nesting(SHALLOW);
+    parsed = json_parse_string(pretty);
+    TEST_CHECK(json_value_equals(parsed, value));
+    json_value_free(parsed);
+
+    json_free_serialized_string(pretty);
+    json_value_free(value);
+}
+
+static void CheckDeep(void)
+{
+    JSON_Value* value = MakeNested(DEEP);
+    JSON_Value* parsed;
+    char* compact;
+    char* reserialized;
+    char small[64];
+    size_t size;
+
+    // about 10 GB: exact where a size_t holds it, refused where it doesn't
+    size = json_serialization_size_pretty(value);
+    if (PrettySize(DEEP) <= SIZE_MAX)
+    {
+        TEST_CHECK(size == PrettySize(DEEP));
+    }
+    else
+    {
+        TEST_CHECK(size == 0);
+    }
+    TEST_CHECK(json_serialize_to_buffer_pretty(value, small, sizeof(small)) == JSONFailure);
+    TEST_CHECK(json_serialize_to_string_pretty(value) == NULL);
+
+    compact = json_serialize_to_string(value);
+    TEST_REQUIRE(compact != NULL);
+    TEST_CHECK(strlen(compact) == 2 * DEEP + 1);
+
+    json_set_max_nesting(DEEP - 1);
+    TEST_CHECK(json_parse_string(compact) == NULL);
+    json_set_max_nesting(DEEP);
+    parsed = json_parse_string(compact);
+    TEST_REQUIRE(parsed != NULL);
+    reserialized = json_serialize_to_string(parsed); // json_value_equals() recurses
+    TEST_CHECK((reserialized != NULL) && (strcmp(reserialized, compact) == 0));
+
+    json_free_serialized_string(reserialized);
+    json_value_free(parsed);
+    json_free_serialized_string(compact);
+    json_value_free(value);
+}
+
+int main(void)
+{
+    json_set_allocation_functions(LimitedMalloc, free);
+    CheckShallow();
+    CheckDeep();
+    return TEST_RESULT();
+}
@@ -0,0 +1,259 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Numbers parsed by parson_sl.c against strtod in the C locale: every
+ * double printed back with "%.17g", and random digit strings of every
+ * length and exponent, must come out with the same bits, out of range
+ * magnitudes must be refused, and the result must not change with a
+ * locale whose decimal point is ','. The streaming reader's int64 getter
+ * refuses numbers outside the int64 range.
+ */
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parson_sl.h"
+
+#include "test_sl.h"
+
+#define RANDOM_DOUBLES 400000
+#define RANDOM_STRINGS 400000
+#define MAX_REPORTED   20
+
+static uint64_t rngState = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t Random(void)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+/* Parses text as a JSON document and compares it with strtod; returns 0 if they agree */
+static int CheckNumber(const char* text)
+{
+    JSON_Value* value = json_parse_string(text);
+    char* end;
+    double expected;
+    double parsed;
+    int overflow;
+    int result = 0;
+
+    errno = 0;
+    expected = strtod(text, &end);
+    overflow = (errno == ERANGE) && isinf(expected);
+
+    if (overflow)
+    {
+        result = (value != NULL);
+    }
+    else if ((value == NULL) || (json_value_get_type(value) != JSONNumber))
+    {
+        result = 1;
+    }
+    else
+    {
+        parsed = json_value_get_number(value);
+        result = (memcmp(&parsed, &expected, sizeof(double)) != 0);
+    }
+    if ((result != 0) && (testFailures < MAX_REPORTED))
+    {
+        (void)fprintf(stderr, "%s: parsed %.17g, strtod %.17g\n", text,
+            (value != NULL) ? json_value_get_number(value) : 0.0, expected);
+    }
+    json_value_free(value);
+    return result;
+}
+
+static void CheckRandomDoubles(void)
+{
+    char text[64];
+    uint64_t bits;
+    double number;
+    int i;
+
+    for (i = 0; i < RANDOM_DOUBLES; i++)
+    {
+        do
+        {
+            bits = Random();
+            (void)memcpy(&number, &bits, sizeof(number));
+        } while (isnan(number) || isinf(number));
+        if (i & 1)
+        {
+            (void)snprintf(text, sizeof(text), "%.17g", number);
+        }
+        else
+        {
+            (void)snprintf(text, sizeof(text), "%.*e", (int)(Random() % 17), number);
+        }
+        TEST_CHECK(CheckNumber(text) == 0);
+    }
+}
+
+/* Digit strings of up to 40 digits, with or without fraction and exponent */
+static void CheckRandomStrings(void)
+{
+    char text[128];
+    int length;
+    int digits;
+    int i;
+    int k;
+
+    for (i = 0; i < RANDOM_STRINGS; i++)
+    {
+        length = 0;
+        if (Random() & 1)
+        {
+            text[length++] = '-';
+        }
+        digits = 1 + (int)(Random() % 40);
+        text[length++] = (char)((digits == 1 && (Random() & 1)) ? '0' : '1' + Random() % 9);
+        for (k = 1; k < digits; k++)
+        {
+            text[length++] = (char)('0' + Random() % 10);
+        }
+        if (Random() % 3 != 0)
+        {
+            text[length++] = '.';
+            digits = 1 + (int)(Random() % 40);
+            for (k = 0; k < digits; k++)
+            {
+                text[length++] = (char)('0' + Random() % 10);
+            }
+        }
+        if (Random() % 3 != 0)
+        {
+            length += sprintf(text + length, "%s%d", (Random() & 1) ? "e-" : "E+", (int)(Random() % 340));
+        }
+        text[length] = '\0';
+        TEST_CHECK(CheckNumber(text) == 0);
+    }
+}
+
+static void CheckEdges(void)
+{
+    static const char* edges[] =
+    {
+        "0", "-0", "0.0e-999999", "1e-999999", "9e999999999999",
+        "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308", "1e309", "-1e400",
+        "2.2250738585072011e-308", "2.2250738585072014e-308", "2.225073858507201136057409796709131975934819546351645648e-308",
+        "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324", "1e-324", "5e-324",
+        "9007199254740993", "9007199254740992.5", "9007199254740993.0000000000000000000000000001",
+        "18446744073709551615", "123456789012345678901234567890", "0.1", "0.30000000000000004",
+        "1.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000011102230246251565404236316680908203124",
+        "1.00000000000000011102230246251565404236316680908203126",
+        "7.038531e-26", "2.9802322387695312e-8", "1e23", "8.98846567431158e307", "3.4e38"
+    };
+    char longText[2048];
+    size_t i;
+
+    for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    {
+        TEST_CHECK(CheckNumber(edges[i]) == 0);
+    }
+
+    // a halfway case decided by its 1000th digit, past the digits decimal_to_double keeps
+    (void)strcpy(longText, "1.00000000000000011102230246251565404236316680908203125");
+    (void)memset(longText + strlen(longText), '0', 1000);
+    (void)strcpy(longText + 1055, "1");
+    TEST_CHECK(CheckNumber(longText) == 0);
+    longText[1055] = '\0';
+    TEST_CHECK(CheckNumber(longText) == 0);
+
+    // out of range magnitudes are refused whatever the sign
+    TEST_CHECK(json_parse_string("1e400") == NULL);
+    TEST_CHECK(json_parse_string("[1, -1e400]") == NULL);
+}
+
+/* The same text parses the same way in a locale with a decimal comma, where strtod stops at the '.' */
+static void CheckLocale(void)
+{
+    static const char* locales[] = { "de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8", "de_DE", "fr_FR" };
+    JSON_Value* value;
+    size_t i;
+
+    for (i = 0; i < sizeof(locales) / sizeof(locales[0]); i++)
+    {
+        if (setlocale(LC_NUMERIC, locales[i]) != NULL)
+        {
+            break;
+        }
+    }
+    if (i == sizeof(locales) / sizeof(locales[0]))
+    {
+        (void)printf("no locale with a decimal comma installed, skipping that part\n");
+        return;
+    }
+    TEST_CHECK(strcmp(localeconv()->decimal_point, ",") == 0);
+
+    value = json_parse_string("[0.1, 1.00000000000000011102230246251565404236316680908203125, 1e-320]");
+    TEST_REQUIRE(value != NULL);
+    TEST_CHECK(json_array_get_number(json_array(value), 0) == 0.1);
+    TEST_CHECK(json_array_get_number(json_array(value), 1) == 1.0000000000000002);
+    TEST_CHECK(json_array_get_number(json_array(value), 2) == 1e-320);
+    json_value_free(value);
+    (void)setlocale(LC_NUMERIC, "C");
+}
+
+/* Feeds text to a reader, moves it to the number and reads it as an int64 */
+static JSON_Status ReaderInt64(const char* text, int64_t* number)
+{
+    JSON_Reader* reader = json_reader_init(64, 4);
+    JSON_Reader_Event event;
+    JSON_Status result = JSONFailure;
+
+    TEST_REQUIRE(reader != NULL);
+    TEST_REQUIRE(json_reader_feed(reader, text, strlen(text)) == JSONSuccess);
+    TEST_REQUIRE(json_reader_finish(reader) == JSONSuccess);
+    while (((event = json_reader_next(reader)) != JSONReaderEnd) && (event != JSONReaderError))
+    {
+        if (event == JSONReaderNumber)
+        {
+            result = json_reader_get_int64(reader, number);
+            break;
+        }
+    }
+    TEST_CHECK(event == JSONReaderNumber);
+    json_reader_free(reader);
+    return result;
+}
+
+/* The reader's int64 getter truncates what fits and refuses what doesn't, instead of casting it */
+static void CheckReaderInt64(void)
+{
+    int64_t number = 0;
+
+    TEST_CHECK((ReaderInt64("[12.75]", &number) == JSONSuccess) && (number == 12));
+    TEST_CHECK((ReaderInt64("[-12.75]", &number) == JSONSuccess) && (number == -12));
+    TEST_CHECK((ReaderInt64("[-9223372036854775808.0]", &number) == JSONSuccess) && (number == INT64_MIN));
+    TEST_CHECK((ReaderInt64("[9.2233720368547748e18]", &number) == JSONSuccess) &&
+        (number == INT64_C(9223372036854774784)));
+    TEST_CHECK((ReaderInt64("[9223372036854775807]", &number) == JSONSuccess) && (number == INT64_MAX));
+
+    number = 7;
+    TEST_CHECK(ReaderInt64("[9223372036854775808.0]", &number) == JSONFailure);
+    TEST_CHECK(ReaderInt64("[-9223372036854777856.0]", &number) == JSONFailure);
+    TEST_CHECK(ReaderInt64("[1e300]", &number) == JSONFailure);
+    TEST_CHECK(ReaderInt64("[-1e19]", &number) == JSONFailure);
+    TEST_CHECK(number == 7);
+
+    TEST_CHECK(json_reader_get_int64(NULL, &number) == JSONFailure);
+}
+
+int main(void)
+{
+    CheckEdges();
+    CheckReaderInt64();
+    CheckRandomDoubles();
+    CheckRandomStrings();
+    CheckLocale();
+    return TEST_RESULT();
+}
@@ -0,0 +1,254 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Merge patches of parson_sl.c: the examples of RFC 7386 appendix A, diffs
+ * that rebuild the document they were taken to, and change tracking on a
+ * twin changed at random, where the tracked patch applied to a copy of the
+ * document as last sent must give the live document every time.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parson_sl.h"
+
+#include "test_sl.h"
+
+#define GROUPS      6
+#define PROPERTIES  8
+#define ROUNDS      3000
+#define MAX_CHANGES 6
+
+static uint32_t rngState = 0x2545F491u;
+
+static uint32_t Random(uint32_t range)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState % range;
+}
+
+/* RFC 7386 appendix A: target, patch and result */
+static const char* const rfcExamples[][3] =
+{
+    { "{\"a\":\"b\"}", "{\"a\":\"c\"}", "{\"a\":\"c\"}" },
+    { "{\"a\":\"b\"}", "{\"b\":\"c\"}", "{\"a\":\"b\",\"b\":\"c\"}" },
+    { "{\"a\":\"b\"}", "{\"a\":null}", "{}" },
+    { "{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}", "{\"b\":\"c\"}" },
+    { "{\"a\":[\"b\"]}", "{\"a\":\"c\"}", "{\"a\":\"c\"}" },
+    { "{\"a\":\"c\"}", "{\"a\":[\"b\"]}", "{\"a\":[\"b\"]}" },
+    { "{\"a\":{\"b\":\"c\"}}", "{\"a\":{\"b\":\"d\",\"c\":null}}", "{\"a\":{\"b\":\"d\"}}" },
+    { "{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}", "{\"a\":[1]}" },
+    { "[\"a\",\"b\"]", "[\"c\",\"d\"]", "[\"c\",\"d\"]" },
+    { "{\"a\":\"b\"}", "[\"c\"]", "[\"c\"]" },
+    { "{\"a\":\"foo\"}", "null", "null" },
+    { "{\"a\":\"foo\"}", "\"bar\"", "\"bar\"" },
+    { "{\"e\":null}", "{\"a\":1}", "{\"e\":null,\"a\":1}" },
+    { "[1,2]", "{\"a\":\"b\",\"c\":null}", "{\"a\":\"b\"}" },
+    { "{}", "{\"a\":{\"bb\":{\"ccc\":null}}}", "{\"a\":{\"bb\":{}}}" },
+};
+
+static void Print(const char* label, const JSON_Value* value)
+{
+    char* text = json_serialize_to_string(value);
+    (void)fprintf(stderr, "%s %s\n", label, (text != NULL) ? text : "?");
+    json_free_serialized_string(text);
+}
+
+/* Patches that replace the whole document can't be applied in place and are refused */
+static void CheckRfcExamples(void)
+{
+    JSON_Value* target;
+    JSON_Value* patch;
+    JSON_Value* result;
+    JSON_Value* original;
+    JSON_Value* diff;
+    size_t i;
+    int inPlace;
+
+    for (i = 0; i < sizeof(rfcExamples) / sizeof(rfcExamples[0]); i++)
+    {
+        target = json_parse_string(rfcExamples[i][0]);
+        patch = json_parse_string(rfcExamples[i][1]);
+        result = json_parse_string(rfcExamples[i][2]);
+        TEST_REQUIRE((target != NULL) && (patch != NULL) && (result != NULL));
+        inPlace = (json_value_get_type(target) == JSONObject) && (json_value_get_type(patch) == JSONObject);
+        original = json_value_deep_copy(target);
+
+        if (!inPlace)
+        {
+            TEST_CHECK(json_value_merge_patch(target, patch) == JSONFailure);
+            TEST_CHECK(json_value_equals(target, original));
+        }
+        else
+        {
+            TEST_CHECK(json_value_merge_patch(target, patch) == JSONSuccess);
+            if (!json_value_equals(target, result))
+            {
+                (void)fprintf(stderr, "RFC 7386 example %u:\n", (unsigned int)i + 1);
+                Print("gave", target);
+                TEST_CHECK(0);
+            }
+        }
+
+        // a diff never needs null values (example 13 keeps one the patch didn't touch)
+        if ((json_value_get_type(original) == JSONObject) && (json_value_get_type(result) == JSONObject) && (i != 12))
+        {
+            diff = json_value_diff(original, result);
+            TEST_REQUIRE(diff != NULL);
+            TEST_CHECK(json_value_merge_patch(original, diff) == JSONSuccess);
+            TEST_CHECK(json_value_equals(original, result));
+            json_value_free(diff);
+        }
+
+        json_value_free(original);
+        json_value_free(result);
+        json_value_free(patch);
+        json_value_free(target);
+    }
+}
+
+static void MakeName(char* name, const char* prefix, uint32_t index)
+{
+    (void)sprintf(name, "%s%u", prefix, (unsigned int)index);
+}
+
+/* One random change somewhere in the twin: set, replace, remove, nest or grow an array */
+static void Change(JSON_Object* twin)
+{
+    char group[16];
+    char property[16];
+    char path[48];
+    JSON_Object* groupObject;
+    JSON_Array* list;
+    JSON_Value* value;
+
+    MakeName(group, "group", Random(GROUPS));
+    MakeName(property, "p", Random(PROPERTIES));
+    groupObject = json_object_get_object(twin, group);
+    switch (Random(8))
+    {
+        case 0:
+        case 1:
+            (void)sprintf(path, "%s.%s", group, property);
+            TEST_CHECK(json_object_dotset_number(twin, path, Random(1000)) == JSONSuccess);
+            break;
+        case 2:
+            (void)sprintf(path, "%s.%s", group, property);
+            TEST_CHECK(json_object_dotset_string(twin, path, (Random(2) == 0) ? "on" : "off") == JSONSuccess);
+            break;
+        case 3:
+            if (groupObject != NULL)
+            {
+                (void)json_object_remove(groupObject, property);
+            }
+            break;
+        case 4:
+            (void)sprintf(path, "%s.nested.%s", group, property);
+            TEST_CHECK(json_object_dotset_boolean(twin, path, (int)Random(2)) == JSONSuccess);
+            break;
+        case 5:
+            list = json_object_get_array(twin, "list");
+            if (list == NULL || json_array_get_count(list) > 8)
+            {
+                value = json_value_init_array();
+                TEST_REQUIRE(value != NULL);
+                TEST_CHECK(json_object_set_value(twin, "list", value) == JSONSuccess);
+                list = json_array(value);
+            }
+            TEST_CHECK(json_array_append_number(list, Random(100)) == JSONSuccess);
+            break;
+        case 6:
+            if (Random(4) == 0)
+            {
+                (void)json_object_remove(twin, group);
+            }
+            break;
+        default:
+            // an object replaced by another one: its old members must go
+            value = json_value_init_object();
+            TEST_REQUIRE(value != NULL);
+            TEST_CHECK(json_object_set_number(json_object(value), property, 1) == JSONSuccess);
+            (void)sprintf(path, "%s.nested", group);
+            TEST_CHECK(json_object_dotset_value(twin, path, value) == JSONSuccess);
+            break;
+    }
+}
+
+/* The copy as last sent, patched with the tracked changes, is the live twin again */
+static void CheckTracking(void)
+{
+    JSON_Value* live = json_value_init_object();
+    JSON_Value* sent;
+    JSON_Value* patch;
+    JSON_Value* diff;
+    JSON_Value* previous;
+    int round;
+    int changes;
+    int i;
+
+    TEST_REQUIRE(live != NULL);
+    for (i = 0; i < GROUPS * PROPERTIES; i++)
+    {
+        Change(json_object(live));
+    }
+    TEST_REQUIRE(json_object_get_changes(json_object(live)) == NULL);
+    TEST_REQUIRE(json_object_track_changes(json_object(live), 1) == JSONSuccess);
+    sent = json_value_deep_copy(live);
+    TEST_REQUIRE(sent != NULL);
+
+    patch = json_object_get_changes(json_object(live));
+    TEST_CHECK((patch != NULL) && (json_object_get_count(json_object(patch)) == 0));
+    json_value_free(patch);
+
+    for (round = 0; round < ROUNDS; round++)
+    {
+        previous = json_value_deep_copy(sent);
+        changes = 1 + (int)Random(MAX_CHANGES);
+        for (i = 0; i < changes; i++)
+        {
+            Change(json_object(live));
+        }
+
+        patch = json_object_get_changes(json_object(live));
+        TEST_REQUIRE(patch != NULL);
+        TEST_CHECK(json_value_merge_patch(sent, patch) == JSONSuccess);
+        if (!json_value_equals(sent, live))
+        {
+            (void)fprintf(stderr, "round %d:\n", round);
+            Print("patch", patch);
+            TEST_REQUIRE(0);
+        }
+
+        // the diff gives the same document, and is never smaller than needed
+        diff = json_value_diff(previous, live);
+        TEST_REQUIRE(diff != NULL);
+        TEST_CHECK(json_value_merge_patch(previous, diff) == JSONSuccess);
+        TEST_CHECK(json_value_equals(previous, live));
+        TEST_CHECK(json_serialization_size(diff) <= json_serialization_size(patch));
+
+        json_value_free(diff);
+        json_value_free(previous);
+        json_value_free(patch);
+        json_object_clear_changes(json_object(live));
+
+        patch = json_object_get_changes(json_object(live));
+        TEST_CHECK((patch != NULL) && (json_object_get_count(json_object(patch)) == 0));
+        json_value_free(patch);
+    }
+
+    TEST_CHECK(json_object_track_changes(json_object(live), 0) == JSONSuccess);
+    TEST_CHECK(json_object_get_changes(json_object(live)) == NULL);
+    json_value_free(sent);
+    json_value_free(live);
+}
+
+int main(void)
+{
+    CheckRfcExamples();
+    CheckTracking();
+    return TEST_RESULT();
+}
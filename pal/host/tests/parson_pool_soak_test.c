@@ -0,0 +1,186 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * A million parses and frees of a device twin with the node pools on:
+ *
+ *     parson_pool_soak_test [iterations]
+ *
+ * Once the pools hold a document's worth of blocks, every value node comes
+ * from them, the pool statistics add up to the nodes parsed, no pool grows
+ * past its limit, and the heap in use is the same after every iteration;
+ * json_set_pool_limit(kind, 0) then gives all of it back.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parson_sl.h"
+
+#include "test_sl.h"
+
+#define ITERATIONS  1000000
+#define SMALL_LIMIT 2 /* fewer than the nodes of any kind in the twin */
+
+static const char twin[] =
+    "{\"desired\":{\"telemetryInterval\":30,\"mode\":\"eco\",\"thresholds\":[1,2,3,4,5,6],"
+    "\"schedule\":[{\"on\":\"07:00\",\"off\":\"19:00\"},{\"on\":\"08:00\",\"off\":\"17:30\"}],\"$version\":12},"
+    "\"reported\":{\"firmware\":\"1.2.3-build.4567\",\"uptime\":123456,\"rssi\":-61,\"ok\":true,"
+    "\"sensors\":[{\"id\":1,\"t\":21.5},{\"id\":2,\"t\":22.25},{\"id\":3,\"t\":20.75}]}}";
+
+static const JSON_Pool_Kind kinds[] = { JSONPoolValue, JSONPoolObject, JSONPoolArray };
+#define KIND_COUNT (sizeof(kinds) / sizeof(kinds[0]))
+
+/* Blocks carry their size so free() can account for them */
+typedef union BLOCK_HEADER_TAG
+{
+    size_t size;
+    double alignment;
+} BLOCK_HEADER;
+
+static size_t heapInUse;
+static size_t heapAllocations;
+static size_t nodesPerParse[KIND_COUNT];
+
+static void* CountingMalloc(size_t size)
+{
+    BLOCK_HEADER* block = malloc(sizeof(BLOCK_HEADER) + size);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+    block->size = size;
+    heapInUse += size;
+    heapAllocations++;
+    return block + 1;
+}
+
+static void CountingFree(void* ptr)
+{
+    if (ptr != NULL)
+    {
+        BLOCK_HEADER* block = (BLOCK_HEADER*)ptr - 1;
+        heapInUse -= block->size;
+        free(block);
+    }
+}
+
+static void ParseAndFree(void)
+{
+    JSON_Value* value = json_parse_string(twin);
+    TEST_REQUIRE(value != NULL);
+    json_value_free(value);
+}
+
+static void GetStats(JSON_Pool_Stats stats[KIND_COUNT])
+{
+    size_t i;
+    for (i = 0; i < KIND_COUNT; i++)
+    {
+        TEST_REQUIRE(json_get_pool_stats(kinds[i], &stats[i]) == JSONSuccess);
+    }
+}
+
+/* Pools large enough for the whole document: the heap only serves what isn't pooled */
+static void Soak(long iterations)
+{
+    JSON_Pool_Stats first[KIND_COUNT];
+    JSON_Pool_Stats last[KIND_COUNT];
+    size_t heapAfterFirst;
+    size_t allocationsPerParse;
+    size_t allocationsBefore;
+    long n;
+    size_t i;
+
+    json_set_pool_limit(JSONPoolValue, 256);
+    json_set_pool_limit(JSONPoolObject, 32);
+    json_set_pool_limit(JSONPoolArray, 32);
+
+    ParseAndFree();
+    GetStats(first);
+    heapAfterFirst = heapInUse;
+    for (i = 0; i < KIND_COUNT; i++)
+    {
+        TEST_CHECK(first[i].hits == 0);
+        TEST_CHECK(first[i].misses > 0);
+        TEST_CHECK(first[i].free_count == first[i].misses);
+        nodesPerParse[i] = first[i].misses;
+    }
+
+    allocationsBefore = heapAllocations;
+    ParseAndFree();
+    allocationsPerParse = heapAllocations - allocationsBefore;
+
+    for (n = 2; n < iterations; n++)
+    {
+        allocationsBefore = heapAllocations;
+        ParseAndFree();
+        if ((heapAllocations - allocationsBefore != allocationsPerParse) || (heapInUse != heapAfterFirst))
+        {
+            TEST_CHECK(heapAllocations - allocationsBefore == allocationsPerParse);
+            TEST_CHECK(heapInUse == heapAfterFirst);
+            break;
+        }
+    }
+
+    GetStats(last);
+    for (i = 0; i < KIND_COUNT; i++)
+    {
+        TEST_CHECK(last[i].misses == first[i].misses);
+        TEST_CHECK(last[i].hits == (size_t)(iterations - 1) * first[i].misses);
+        TEST_CHECK(last[i].free_count == first[i].misses);
+        TEST_CHECK(last[i].high_water == first[i].misses);
+    }
+    (void)printf("%ld parses, %u heap allocations each with %u/%u/%u value/object/array nodes pooled\n",
+        iterations, (unsigned int)allocationsPerParse, (unsigned int)first[0].misses,
+        (unsigned int)first[1].misses, (unsigned int)first[2].misses);
+}
+
+/* Pools smaller than the document: they fill up to their limit and the rest goes to the heap */
+static void SoakSmall(long iterations)
+{
+    JSON_Pool_Stats before[KIND_COUNT];
+    JSON_Pool_Stats after[KIND_COUNT];
+    size_t heapBefore;
+    long n;
+    size_t i;
+
+    for (i = 0; i < KIND_COUNT; i++)
+    {
+        json_set_pool_limit(kinds[i], SMALL_LIMIT);
+    }
+    ParseAndFree();
+    GetStats(before);
+    heapBefore = heapInUse;
+    for (n = 0; n < iterations; n++)
+    {
+        ParseAndFree();
+    }
+    GetStats(after);
+    TEST_CHECK(heapInUse == heapBefore);
+    for (i = 0; i < KIND_COUNT; i++)
+    {
+        TEST_CHECK(after[i].free_count == SMALL_LIMIT);
+        TEST_CHECK(after[i].hits - before[i].hits == (size_t)iterations * SMALL_LIMIT);
+        TEST_CHECK(after[i].misses - before[i].misses == (size_t)iterations * (nodesPerParse[i] - SMALL_LIMIT));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    long iterations = (argc > 1) ? atol(argv[1]) : ITERATIONS;
+    size_t i;
+
+    TEST_REQUIRE(iterations > 1);
+    json_set_allocation_functions(CountingMalloc, CountingFree);
+
+    Soak(iterations);
+    SoakSmall(iterations / 100);
+
+    for (i = 0; i < KIND_COUNT; i++)
+    {
+        json_set_pool_limit(kinds[i], 0);
+    }
+    TEST_CHECK(heapInUse == 0);
+    return TEST_RESULT();
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * The block scanners of parson_sl.c on documents that end exactly where
+ * their allocation does: whitespace runs and string bodies of every length
+ * up to a few blocks, starting at every offset in a block, parse to the same
+ * values as before, and strings cut off by the terminator are refused.
+ * Built with AddressSanitizer, a block read past the terminator fails the
+ * test.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parson_sl.h"
+
+#include "test_sl.h"
+
+#define MAX_RUN     70
+#define MAX_OFFSET  16
+
+static const char spaces[] = " \t\n\r";
+
+/* Parses text from a copy that starts offset bytes into an allocation ending at its terminator */
+static JSON_Value* ParseExact(const char* text, size_t offset)
+{
+    size_t length = strlen(text);
+    char* buffer = malloc(offset + length + 1);
+    JSON_Value* value;
+
+    TEST_REQUIRE(buffer != NULL);
+    (void)memset(buffer, 'x', offset);
+    (void)memcpy(buffer + offset, text, length + 1);
+    value = json_parse_string(buffer + offset);
+    free(buffer);
+    return value;
+}
+
+static void MakeBody(char* body, size_t length)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        body[i] = (char)('a' + i % 26);
+    }
+    body[length] = '\0';
+}
+
+static void MakeWhitespace(char* run, size_t length, int mixed)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        run[i] = mixed ? spaces[i % 4] : ' ';
+    }
+    run[length] = '\0';
+}
+
+/* "<body>" and <run>{"k":"<body>"}<run>, a run or body of each length at each offset */
+static void CheckRuns(void)
+{
+    static char text[7 * MAX_RUN + 32];
+    char body[MAX_RUN + 1];
+    char run[MAX_RUN + 1];
+    JSON_Value* value;
+    size_t length;
+    size_t offset;
+    int mixed;
+
+    for (length = 0; length <= MAX_RUN; length++)
+    {
+        MakeBody(body, length);
+        for (mixed = 0; mixed < 2; mixed++)
+        {
+            MakeWhitespace(run, length, mixed);
+            for (offset = 0; offset < MAX_OFFSET; offset++)
+            {
+                (void)sprintf(text, "\"%s\"", body);
+                value = ParseExact(text, offset);
+                TEST_CHECK((value != NULL) && (strcmp(json_value_get_string(value), body) == 0));
+                json_value_free(value);
+
+                (void)sprintf(text, "%s{%s\"k\"%s:%s\"%s\"%s}%s", run, run, run, run, body, run, run);
+                value = ParseExact(text, offset);
+                TEST_CHECK((value != NULL) && (strcmp(json_object_get_string(json_object(value), "k"), body) == 0));
+                json_value_free(value);
+
+                // cut off: the scanners run into the terminator
+                (void)sprintf(text, "[%s\"%s", run, body);
+                TEST_CHECK(ParseExact(text, offset) == NULL);
+                (void)sprintf(text, "[\"%s\\", body);
+                TEST_CHECK(ParseExact(text, offset) == NULL);
+                (void)sprintf(text, "[1,%s", run);
+                TEST_CHECK(ParseExact(text, offset) == NULL);
+            }
+        }
+    }
+}
+
+/* Where a run stops inside a block: escapes and control characters in the body */
+static void CheckStops(void)
+{
+    static char text[2 * MAX_RUN + 32];
+    char body[MAX_RUN + 1];
+    JSON_Value* value;
+    size_t length;
+    size_t at;
+
+    for (length = 1; length <= MAX_RUN; length++)
+    {
+        for (at = 0; at < length; at++)
+        {
+            MakeBody(body, length);
+            (void)sprintf(text, "[\"%.*s\\n%s\"]", (int)at, body, body + at);
+            value = ParseExact(text, 0);
+            TEST_REQUIRE(value != NULL);
+            TEST_CHECK(json_array_get_string(json_array(value), 0)[at] == '\n');
+            TEST_CHECK(strlen(json_array_get_string(json_array(value), 0)) == length + 1);
+            json_value_free(value);
+
+            body[at] = '\x01';
+            (void)sprintf(text, "[\"%s\"]", body);
+            TEST_CHECK(ParseExact(text, 0) == NULL);
+        }
+    }
+}
+
+int main(void)
+{
+    CheckRuns();
+    CheckStops();
+    return TEST_RESULT();
+}
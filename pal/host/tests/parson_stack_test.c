@@ -0,0 +1,163 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * The stack parson_sl.c needs for a document nested as deep as the parser
+ * accepts: on a thread with a small painted stack, parsing, serializing
+ * (compact, pretty and in chunks) and freeing it uses no more stack than
+ * doing the same with a document one level deep, and what it uses fits in
+ * the 4 KB the sample applications give their Azure thread (main_tirtos.c).
+ *
+ * Linux won't start a thread on less than PTHREAD_STACK_MIN, so the thread
+ * gets that much and the high-water mark of a thread that does nothing is
+ * taken off. A first run binds the shared library calls, which the dynamic
+ * linker does on the stack of whichever thread makes them first.
+ * AddressSanitizer pads every frame, so the 4 KB bound is only checked in
+ * builds without it.
+ */
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parson_sl.h"
+#include "threadapi_sl.h"
+
+#include "test_sl.h"
+
+#define TASK_STACK      4096
+#define NESTING         2048
+#define NESTING_SLACK   64
+
+#if defined(__SANITIZE_ADDRESS__)
+#define STACK_SANITIZED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define STACK_SANITIZED 1
+#endif
+#endif
+
+typedef struct WORK_TAG
+{
+    const char* document;       // NULL for a thread that does nothing
+    int ok;
+    THREADAPI_EVENT_HANDLE done;
+    THREADAPI_EVENT_HANDLE release;
+} WORK;
+
+static JSON_Status DiscardChunk(void* context, const char* data, size_t len)
+{
+    (void)data;
+    *(size_t*)context += len;
+    return JSONSuccess;
+}
+
+static int Work(void* arg)
+{
+    WORK* work = (WORK*)arg;
+    JSON_Value* value;
+    char* text;
+    char chunk[64];
+    size_t written = 0;
+
+    if (work->document == NULL)
+    {
+        work->ok = 1;
+    }
+    else if ((value = json_parse_string(work->document)) != NULL)
+    {
+        text = json_serialize_to_string(value);
+        work->ok = (text != NULL) && (strcmp(text, work->document) == 0);
+        json_free_serialized_string(text);
+
+        text = json_serialize_to_string_pretty(value);
+        work->ok = work->ok && (text != NULL);
+        json_free_serialized_string(text);
+
+        work->ok = work->ok && (json_serialize_to_writer(value, chunk, sizeof(chunk), DiscardChunk, &written) == JSONSuccess) &&
+            (written == strlen(work->document));
+        json_value_free(value);
+    }
+
+    (void)ThreadAPI_Event_Signal(work->done);
+    (void)ThreadAPI_Event_SleepUntil(work->release, ThreadAPI_GetMonotonicTime() + 10000);
+    return 0;
+}
+
+/* {"a":[{"a":[...1...]}]}, objects and arrays alternating, nesting levels deep */
+static char* MakeDocument(size_t nesting)
+{
+    char* document = malloc(8 * nesting + 2);
+    size_t length = 0;
+    size_t i;
+
+    TEST_REQUIRE(document != NULL);
+    for (i = 0; i < nesting; i++)
+    {
+        (void)strcpy(document + length, (i % 2 == 0) ? "{\"a\":" : "[");
+        length += strlen(document + length);
+    }
+    document[length++] = '1';
+    for (i = nesting; i > 0; i--)
+    {
+        document[length++] = ((i - 1) % 2 == 0) ? '}' : ']';
+    }
+    document[length] = '\0';
+    return document;
+}
+
+/* Runs the work on a fresh thread and returns its stack high-water mark */
+static size_t Measure(const char* document)
+{
+    THREADAPI_ATTRIBUTES attributes;
+    THREAD_HANDLE thread;
+    WORK work;
+    size_t used = 0;
+
+    (void)memset(&work, 0, sizeof(work));
+    work.document = document;
+    work.done = ThreadAPI_Event_Create();
+    work.release = ThreadAPI_Event_Create();
+    TEST_REQUIRE((work.done != NULL) && (work.release != NULL));
+
+    ThreadAPI_Attributes_Init(&attributes);
+    attributes.stack_size = (PTHREAD_STACK_MIN > TASK_STACK) ? PTHREAD_STACK_MIN : TASK_STACK;
+    TEST_REQUIRE(ThreadAPI_CreateWithAttributes(&thread, Work, &work, &attributes) == THREADAPI_OK);
+    TEST_REQUIRE(ThreadAPI_Event_SleepUntil(work.done, ThreadAPI_GetMonotonicTime() + 10000) == 1);
+    TEST_CHECK(ThreadAPI_GetStackHighWaterMark(thread, &used) == THREADAPI_OK);
+    (void)ThreadAPI_Event_Signal(work.release);
+    TEST_REQUIRE(ThreadAPI_Join(thread, NULL) == THREADAPI_OK);
+    ThreadAPI_Event_Destroy(work.done);
+    ThreadAPI_Event_Destroy(work.release);
+
+    TEST_CHECK(work.ok);
+    return used;
+}
+
+int main(void)
+{
+    char* shallow = MakeDocument(1);
+    char* deep = MakeDocument(NESTING);
+    size_t idle;
+    size_t flat;
+    size_t nested;
+
+    json_set_max_nesting(NESTING);
+    (void)Measure(deep); // binds the library calls, which costs stack the first time only
+    idle = Measure(NULL);
+    flat = Measure(shallow);
+    nested = Measure(deep);
+    (void)printf("parson stack: %u bytes at nesting 1, %u at nesting %u (thread start %u)\n",
+        (unsigned int)(flat - idle), (unsigned int)(nested - idle), (unsigned int)NESTING, (unsigned int)idle);
+
+    TEST_CHECK(flat > idle);
+    TEST_CHECK(nested <= flat + NESTING_SLACK);
+#if !defined(STACK_SANITIZED)
+    TEST_CHECK(nested - idle < TASK_STACK);
+#endif
+
+    free(deep);
+    free(shallow);
+    return TEST_RESULT();
+}
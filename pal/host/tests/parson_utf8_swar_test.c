@@ -0,0 +1,8 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * parson_utf8_test against the word-at-a-time ASCII skips the Cortex-M build
+ * uses: parson_sl.c is compiled into this test with PARSON_NO_SIMD.
+ */
+#include "parson_utf8_test.c"
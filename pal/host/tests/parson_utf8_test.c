@@ -0,0 +1,270 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * The UTF-8 checks of parson_sl.c against a decoder written out from RFC
+ * 3629: overlong forms, surrogates, code points past U+10FFFF, stray
+ * continuation bytes and cut-off sequences are refused, the boundaries of
+ * each sequence length are accepted. Every entry point agrees:
+ * json_value_init_string(), json_parse_string() (which accepted any bytes
+ * in strings before it validated), the streaming reader fed a byte at a time
+ * and the CBOR decoder. Sequences are tried after ASCII runs of every length
+ * up to two blocks, so they land on each position of the block scanners.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parson_sl.h"
+
+#include "test_sl.h"
+
+#define MAX_PREFIX      40
+#define MAX_SEQUENCE    8
+#define RANDOM_SEQUENCES 200000
+
+typedef struct SEQUENCE_TAG
+{
+    const char* bytes;
+    int valid;
+} SEQUENCE;
+
+static const SEQUENCE sequences[] =
+{
+    { "\xC2\x80", 1 }, { "\xDF\xBF", 1 }, { "\xE0\xA0\x80", 1 }, { "\xED\x9F\xBF", 1 }, { "\xEE\x80\x80", 1 },
+    { "\xEF\xBF\xBF", 1 }, { "\xF0\x90\x80\x80", 1 }, { "\xF4\x8F\xBF\xBF", 1 }, { "\xE2\x82\xAC", 1 },
+    { "\x80", 0 }, { "\xBF", 0 }, { "\xC2", 0 }, { "\xC2\x41", 0 }, { "\xC0\x80", 0 }, { "\xC1\xBF", 0 },
+    { "\xE0\x80\x80", 0 }, { "\xE0\x9F\xBF", 0 }, { "\xE2\x82", 0 }, { "\xE2\x28\xA1", 0 },
+    { "\xED\xA0\x80", 0 }, { "\xED\xBF\xBF", 0 }, { "\xED\xA0\x80\xED\xB0\x80", 0 },
+    { "\xF0\x80\x80\x80", 0 }, { "\xF0\x8F\xBF\xBF", 0 }, { "\xF0\x9F\x98", 0 }, { "\xF4\x90\x80\x80", 0 },
+    { "\xF5\x80\x80\x80", 0 }, { "\xF8\x88\x80\x80\x80", 0 }, { "\xFE", 0 }, { "\xFF", 0 },
+};
+
+static uint32_t rngState = 0x1B873593u;
+
+static uint32_t Random(uint32_t range)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState % range;
+}
+
+/* RFC 3629 section 4, one sequence at a time */
+static int ReferenceValid(const unsigned char* bytes, size_t length)
+{
+    size_t i = 0;
+    size_t needed;
+    size_t k;
+    uint32_t code;
+
+    while (i < length)
+    {
+        if (bytes[i] < 0x80)
+        {
+            i++;
+            continue;
+        }
+        else if ((bytes[i] & 0xE0) == 0xC0)
+        {
+            needed = 1;
+            code = bytes[i] & 0x1F;
+        }
+        else if ((bytes[i] & 0xF0) == 0xE0)
+        {
+            needed = 2;
+            code = bytes[i] & 0x0F;
+        }
+        else if ((bytes[i] & 0xF8) == 0xF0)
+        {
+            needed = 3;
+            code = bytes[i] & 0x07;
+        }
+        else
+        {
+            return 0;
+        }
+        if (i + needed >= length)
+        {
+            return 0;
+        }
+        for (k = 1; k <= needed; k++)
+        {
+            if ((bytes[i + k] & 0xC0) != 0x80)
+            {
+                return 0;
+            }
+            code = (code << 6) | (bytes[i + k] & 0x3F);
+        }
+        if ((needed == 1 && code < 0x80) || (needed == 2 && code < 0x800) || (needed == 3 && code < 0x10000) ||
+            (code >= 0xD800 && code <= 0xDFFF) || (code > 0x10FFFF))
+        {
+            return 0;
+        }
+        i += needed + 1;
+    }
+    return 1;
+}
+
+static int ReaderAccepts(const char* json, size_t length)
+{
+    JSON_Reader* reader = json_reader_init(256, 4);
+    JSON_Reader_Event event;
+    size_t fed = 0;
+    int accepted = 0;
+
+    TEST_REQUIRE(reader != NULL);
+    while ((event = json_reader_next(reader)) != JSONReaderEnd)
+    {
+        if (event == JSONReaderNeedInput)
+        {
+            (void)((fed < length) ? json_reader_feed(reader, json + fed++, 1) : json_reader_finish(reader));
+        }
+        else if (event == JSONReaderError)
+        {
+            break;
+        }
+        else if (event == JSONReaderString)
+        {
+            accepted = 1;
+        }
+    }
+    json_reader_free(reader);
+    return accepted && (event == JSONReaderEnd);
+}
+
+static int CborAccepts(const char* text, size_t length)
+{
+    unsigned char encoded[2 + MAX_PREFIX + MAX_SEQUENCE];
+    JSON_Value* value;
+
+    encoded[0] = 0x78;  // text string, one byte length
+    encoded[1] = (unsigned char)length;
+    (void)memcpy(encoded + 2, text, length);
+    value = json_parse_cbor(encoded, length + 2);
+    json_value_free(value);
+    return value != NULL;
+}
+
+/* All entry points on prefix ASCII bytes followed by the sequence */
+static void Check(const char* sequence, size_t sequenceLength, size_t prefix, int valid)
+{
+    char text[MAX_PREFIX + MAX_SEQUENCE + 1];
+    char json[MAX_PREFIX + MAX_SEQUENCE + 3];
+    size_t length = prefix + sequenceLength;
+    JSON_Value* value;
+    int results[4];
+
+    (void)memset(text, 'a', prefix);
+    (void)memcpy(text + prefix, sequence, sequenceLength);
+    text[length] = '\0';
+    json[0] = '\"';
+    (void)memcpy(json + 1, text, length);
+    json[length + 1] = '\"';
+    json[length + 2] = '\0';
+
+    value = json_value_init_string(text);
+    results[0] = (value != NULL);
+    json_value_free(value);
+    value = json_parse_string(json);
+    results[1] = (value != NULL);
+    TEST_CHECK((value == NULL) || (strcmp(json_value_get_string(value), text) == 0));
+    json_value_free(value);
+    results[2] = ReaderAccepts(json, length + 2);
+    results[3] = CborAccepts(text, length);
+
+    if ((results[0] != valid) || (results[1] != valid) || (results[2] != valid) || (results[3] != valid))
+    {
+        size_t i;
+        (void)fprintf(stderr, "after %u ASCII bytes,", (unsigned int)prefix);
+        for (i = 0; i < sequenceLength; i++)
+        {
+            (void)fprintf(stderr, " %02X", (unsigned int)(unsigned char)sequence[i]);
+        }
+        (void)fprintf(stderr, " should be %s: init %d, parse %d, reader %d, CBOR %d\n",
+            valid ? "accepted" : "refused", results[0], results[1], results[2], results[3]);
+        TEST_CHECK(0);
+    }
+}
+
+static void CheckSequences(void)
+{
+    size_t i;
+    size_t prefix;
+
+    for (i = 0; i < sizeof(sequences) / sizeof(sequences[0]); i++)
+    {
+        TEST_CHECK(ReferenceValid((const unsigned char*)sequences[i].bytes, strlen(sequences[i].bytes)) == sequences[i].valid);
+        for (prefix = 0; prefix <= MAX_PREFIX; prefix++)
+        {
+            Check(sequences[i].bytes, strlen(sequences[i].bytes), prefix, sequences[i].valid);
+        }
+    }
+}
+
+/* Every two-byte string, and random ones of three to six bytes leaning towards lead bytes */
+static void CheckAgainstReference(void)
+{
+    unsigned char bytes[MAX_SEQUENCE];
+    size_t length;
+    uint32_t pair;
+    int i;
+    size_t k;
+
+    for (pair = 0; pair < 0x10000; pair++)
+    {
+        bytes[0] = (unsigned char)(pair >> 8);
+        bytes[1] = (unsigned char)pair;
+        // control characters, quotes and backslashes mean something else in JSON
+        if ((bytes[0] >= 0x20) && (bytes[1] >= 0x20) && (bytes[0] != '\"') && (bytes[1] != '\"') &&
+            (bytes[0] != '\\') && (bytes[1] != '\\'))
+        {
+            Check((const char*)bytes, 2, pair % 20, ReferenceValid(bytes, 2));
+        }
+    }
+
+    for (i = 0; i < RANDOM_SEQUENCES; i++)
+    {
+        length = 3 + Random(4);
+        for (k = 0; k < length; k++)
+        {
+            switch (Random(4))
+            {
+                case 0:
+                    bytes[k] = (unsigned char)(0xC0 + Random(0x40));
+                    break;
+                case 1:
+                case 2:
+                    bytes[k] = (unsigned char)(0x80 + Random(0x40));
+                    break;
+                default:
+                    bytes[k] = (unsigned char)(0x20 + Random(0x5F));
+                    bytes[k] = ((bytes[k] == '\"') || (bytes[k] == '\\')) ? 'b' : bytes[k];
+                    break;
+            }
+        }
+        Check((const char*)bytes, length, Random(MAX_PREFIX + 1), ReferenceValid(bytes, length));
+    }
+}
+
+/* Escapes decode to valid UTF-8 only: a lone or reversed surrogate is refused */
+static void CheckEscapes(void)
+{
+    JSON_Value* value;
+
+    value = json_parse_string("\"\\u00e9\\u20ac\\ud83d\\ude00\"");
+    TEST_CHECK((value != NULL) && (strcmp(json_value_get_string(value), "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80") == 0));
+    json_value_free(value);
+    TEST_CHECK(json_parse_string("\"\\ud83d\"") == NULL);
+    TEST_CHECK(json_parse_string("\"\\ude00\\ud83d\"") == NULL);
+    TEST_CHECK(json_parse_string("\"\\ud83dx\"") == NULL);
+}
+
+int main(void)
+{
+    CheckSequences();
+    CheckAgainstReference();
+    CheckEscapes();
+    return TEST_RESULT();
+}
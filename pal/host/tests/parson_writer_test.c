@@ -0,0 +1,229 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * The streaming writer of parson_sl.c: random documents, with long strings,
+ * escapes, int64 and fractional numbers and nesting past the 16 levels kept
+ * on the stack, written in chunks of 1 byte to 4 KB come out byte for byte
+ * as json_serialize_to_string() and json_serialize_to_string_pretty() give
+ * them, with slashes escaped or not. Every piece but the last is chunk_size
+ * bytes; a sink that fails stops the writer with a prefix of the document.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parson_sl.h"
+
+#include "test_sl.h"
+
+#define RANDOM_DOCUMENTS 200
+#define MAX_DEPTH        24
+#define MAX_OUTPUT       (1024 * 1024)
+
+typedef struct SINK_TAG
+{
+    char* output;
+    size_t used;
+    size_t chunk_size;
+    size_t pieces;
+    size_t short_pieces;        // pieces shorter than chunk_size
+    size_t fail_after;          // pieces accepted before failing, SIZE_MAX for never
+} SINK;
+
+static const size_t chunkSizes[] = { 1, 2, 3, 7, 16, 63, 64, 255, 4096 };
+
+static uint32_t rngState = 0x85EBCA6Bu;
+
+static uint32_t Random(uint32_t range)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState % range;
+}
+
+static JSON_Status Collect(void* context, const char* data, size_t len)
+{
+    SINK* sink = (SINK*)context;
+
+    if (sink->pieces == sink->fail_after)
+    {
+        return JSONFailure;
+    }
+    TEST_REQUIRE((len > 0) && (len <= sink->chunk_size) && (sink->used + len <= MAX_OUTPUT));
+    (void)memcpy(sink->output + sink->used, data, len);
+    sink->used += len;
+    sink->pieces++;
+    sink->short_pieces += (len < sink->chunk_size) ? 1 : 0;
+    return JSONSuccess;
+}
+
+static JSON_Value* RandomString(void)
+{
+    static const char* const pieces[] = { "a", "temperature", "\"", "\\", "/", "\n", "\t", "\x01", "\x1F", "\xC3\xBC", "\xF0\x9F\x98\x80" };
+    char* text;
+    JSON_Value* value;
+    size_t length = 0;
+    int plain = (Random(8) == 0);
+    uint32_t count = plain ? 300 + Random(5000) : Random(20);
+    uint32_t i;
+
+    text = malloc(count * sizeof("temperature") + 1);
+    TEST_REQUIRE(text != NULL);
+    text[0] = '\0';
+    for (i = 0; i < count; i++)
+    {
+        // long strings are mostly plain runs, which go to the sink without staging
+        (void)strcpy(text + length, pieces[(plain && (Random(500) != 0)) ? 1 : Random(sizeof(pieces) / sizeof(pieces[0]))]);
+        length += strlen(text + length);
+    }
+    value = json_value_init_string(text);
+    free(text);
+    return value;
+}
+
+static JSON_Value* RandomNumber(void)
+{
+    switch (Random(5))
+    {
+        case 0:
+            return json_value_init_number((double)Random(2000) - 1000);
+        case 1:
+            return json_value_init_int64((int64_t)(((uint64_t)Random(0xFFFFFFFF) << 32) | Random(0xFFFFFFFF)));
+        case 2:
+            return json_value_init_number((double)Random(1000000) / 7);
+        case 3:
+            return json_value_init_number(1e300 / (1 + Random(1000)));
+        default:
+            return json_value_init_number(-0.0);
+    }
+}
+
+static JSON_Value* RandomValue(int depth)
+{
+    JSON_Value* value;
+    char name[16];
+    uint32_t count;
+    uint32_t i;
+
+    // containers below level 3 hold one value and go all the way down, past the writer's stack frames
+    switch ((depth < MAX_DEPTH) ? ((depth > 3) ? 5 + Random(2) : Random(8)) : Random(5))
+    {
+        case 0:
+            return (Random(2) == 0) ? json_value_init_null() : json_value_init_boolean((int)Random(2));
+        case 1:
+        case 2:
+            return RandomNumber();
+        case 3:
+        case 4:
+            return RandomString();
+        case 5:
+            value = json_value_init_array();
+            count = (depth > 3) ? 1 : Random(12);
+            for (i = 0; i < count; i++)
+            {
+                TEST_REQUIRE(json_array_append_value(json_array(value), RandomValue(depth + 1)) == JSONSuccess);
+            }
+            return value;
+        default:
+            value = json_value_init_object();
+            count = (depth > 3) ? 1 : Random(12);
+            for (i = 0; i < count; i++)
+            {
+                (void)sprintf(name, (Random(4) == 0) ? "k/\"%u" : "k%u", (unsigned int)Random(40));
+                TEST_REQUIRE(json_object_set_value(json_object(value), name, RandomValue(depth + 1)) == JSONSuccess);
+            }
+            return value;
+    }
+}
+
+static void CheckWriter(const JSON_Value* value, int pretty, SINK* sink)
+{
+    char* expected = pretty ? json_serialize_to_string_pretty(value) : json_serialize_to_string(value);
+    char* chunk;
+    size_t length;
+    size_t i;
+    JSON_Status status;
+
+    TEST_REQUIRE(expected != NULL);
+    length = strlen(expected);
+    for (i = 0; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++)
+    {
+        // exact-size chunk buffers, so writing past one is an ASan report
+        chunk = malloc(chunkSizes[i]);
+        TEST_REQUIRE(chunk != NULL);
+        sink->used = 0;
+        sink->pieces = 0;
+        sink->short_pieces = 0;
+        sink->chunk_size = chunkSizes[i];
+        sink->fail_after = SIZE_MAX;
+        status = pretty ? json_serialize_to_writer_pretty(value, chunk, chunkSizes[i], Collect, sink) :
+            json_serialize_to_writer(value, chunk, chunkSizes[i], Collect, sink);
+        TEST_CHECK(status == JSONSuccess);
+        if ((sink->used != length) || (memcmp(sink->output, expected, length) != 0))
+        {
+            (void)fprintf(stderr, "%s writer, chunks of %u: %u bytes, expected %u\n", pretty ? "pretty" : "compact",
+                (unsigned int)chunkSizes[i], (unsigned int)sink->used, (unsigned int)length);
+            TEST_REQUIRE(0);
+        }
+        TEST_CHECK(sink->pieces == (length + chunkSizes[i] - 1) / chunkSizes[i]);
+        TEST_CHECK(sink->short_pieces == ((length % chunkSizes[i]) != 0 ? 1 : 0));
+
+        if (sink->pieces > 1)
+        {
+            sink->used = 0;
+            sink->pieces = 0;
+            sink->short_pieces = 0;
+            sink->fail_after = Random((uint32_t)((length + chunkSizes[i] - 1) / chunkSizes[i]));
+            status = pretty ? json_serialize_to_writer_pretty(value, chunk, chunkSizes[i], Collect, sink) :
+                json_serialize_to_writer(value, chunk, chunkSizes[i], Collect, sink);
+            TEST_CHECK(status == JSONFailure);
+            TEST_CHECK(sink->used == sink->fail_after * chunkSizes[i]);
+            TEST_CHECK(memcmp(sink->output, expected, sink->used) == 0);
+        }
+        free(chunk);
+    }
+    json_free_serialized_string(expected);
+}
+
+static void CheckArguments(void)
+{
+    JSON_Value* value = json_parse_string("[1]");
+    SINK sink;
+    char chunk[8];
+
+    (void)memset(&sink, 0, sizeof(sink));
+    TEST_REQUIRE(value != NULL);
+    TEST_CHECK(json_serialize_to_writer(NULL, chunk, sizeof(chunk), Collect, &sink) == JSONFailure);
+    TEST_CHECK(json_serialize_to_writer(value, NULL, sizeof(chunk), Collect, &sink) == JSONFailure);
+    TEST_CHECK(json_serialize_to_writer(value, chunk, 0, Collect, &sink) == JSONFailure);
+    TEST_CHECK(json_serialize_to_writer(value, chunk, sizeof(chunk), NULL, &sink) == JSONFailure);
+    TEST_CHECK(sink.pieces == 0);
+    json_value_free(value);
+}
+
+int main(void)
+{
+    SINK sink;
+    JSON_Value* value;
+    int i;
+
+    (void)memset(&sink, 0, sizeof(sink));
+    sink.output = malloc(MAX_OUTPUT);
+    TEST_REQUIRE(sink.output != NULL);
+    CheckArguments();
+    for (i = 0; i < RANDOM_DOCUMENTS; i++)
+    {
+        value = RandomValue(0);
+        TEST_REQUIRE(value != NULL);
+        json_set_escape_slashes(i % 2);
+        CheckWriter(value, 0, &sink);
+        CheckWriter(value, 1, &sink);
+        json_value_free(value);
+    }
+    json_set_escape_slashes(1);
+    free(sink.output);
+    return TEST_RESULT();
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Checks for the host tests. Each test is a program that ctest runs: a
+ * failed TEST_CHECK() reports itself and the test goes on, a failed
+ * TEST_REQUIRE() ends it, and main() returns TEST_RESULT().
+ */
+#ifndef TEST_SL_H
+#define TEST_SL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int testFailures;
+
+#define TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            (void)fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define TEST_REQUIRE(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            (void)fprintf(stderr, "%s:%d: requirement failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(EXIT_FAILURE); \
+        } \
+    } while (0)
+
+#define TEST_RESULT() ((testFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE)
+
+#endif /* TEST_SL_H */
@@ -0,0 +1,227 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * The attributes of ThreadAPI_CreateWithAttributes() as the Linux thread
+ * sees them from inside: its stack is the one the ThreadAPI allocated, of the
+ * size asked for, and it runs with the policy, name and CPUs asked for, also
+ * when they come from ThreadAPI_SetDefaultAttributes() through
+ * ThreadAPI_Create(). The high-water mark read from the 0xA5 paint covers
+ * what the thread wrote to its stack and stays under its size.
+ *
+ * glibc only takes SCHED_OTHER, SCHED_FIFO and SCHED_RR as thread
+ * attributes, and the real-time policies are only checked when the test may
+ * use them.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "threadapi_sl.h"
+
+#include "test_sl.h"
+
+#define STACK_SIZE  (128 * 1024)
+#define DEEP_USE    (48 * 1024)
+#define LONG_NAME   "attributes-test-long-name" /* Linux keeps 15 characters */
+
+/* What the thread found out about itself */
+typedef struct SEEN_TAG
+{
+    uintptr_t stack_low;
+    size_t stack_size;
+    uintptr_t local;
+    int policy;
+    int priority;
+    char name[16];
+    cpu_set_t cpus;
+    size_t use;                     // bytes of stack to write before reporting
+    THREADAPI_EVENT_HANDLE ready;   // signaled once the above is filled in
+    THREADAPI_EVENT_HANDLE release; // the thread returns once signaled
+} SEEN;
+
+static void UseStack(size_t bytes)
+{
+    volatile unsigned char buffer[DEEP_USE];
+    size_t i;
+
+    for (i = 0; (i < bytes) && (i < sizeof(buffer)); i++)
+    {
+        buffer[i] = (unsigned char)i;
+    }
+}
+
+static int Observe(void* arg)
+{
+    SEEN* seen = (SEEN*)arg;
+    pthread_attr_t attr;
+    struct sched_param param;
+    void* stack;
+
+    seen->local = (uintptr_t)&attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0)
+    {
+        (void)pthread_attr_getstack(&attr, &stack, &seen->stack_size);
+        seen->stack_low = (uintptr_t)stack;
+        (void)pthread_attr_destroy(&attr);
+    }
+    (void)pthread_getschedparam(pthread_self(), &seen->policy, &param);
+    seen->priority = param.sched_priority;
+    (void)pthread_getname_np(pthread_self(), seen->name, sizeof(seen->name));
+    (void)pthread_getaffinity_np(pthread_self(), sizeof(seen->cpus), &seen->cpus);
+    if (seen->use != 0)
+    {
+        UseStack(seen->use);
+    }
+
+    (void)ThreadAPI_Event_Signal(seen->ready);
+    (void)ThreadAPI_Event_SleepUntil(seen->release, ThreadAPI_GetMonotonicTime() + 10000);
+    return 0;
+}
+
+static void InitSeen(SEEN* seen, size_t use)
+{
+    (void)memset(seen, 0, sizeof(*seen));
+    seen->use = use;
+    seen->ready = ThreadAPI_Event_Create();
+    seen->release = ThreadAPI_Event_Create();
+    TEST_REQUIRE((seen->ready != NULL) && (seen->release != NULL));
+}
+
+/* Waits for the thread to report, reads its high-water mark (0 if it has none) and joins it */
+static size_t Finish(THREAD_HANDLE thread, SEEN* seen)
+{
+    size_t used = 0;
+
+    TEST_REQUIRE(ThreadAPI_Event_SleepUntil(seen->ready, ThreadAPI_GetMonotonicTime() + 10000) == 1);
+    if (ThreadAPI_GetStackHighWaterMark(thread, &used) != THREADAPI_OK)
+    {
+        used = 0;
+    }
+    (void)ThreadAPI_Event_Signal(seen->release);
+    TEST_REQUIRE(ThreadAPI_Join(thread, NULL) == THREADAPI_OK);
+    ThreadAPI_Event_Destroy(seen->ready);
+    ThreadAPI_Event_Destroy(seen->release);
+    return used;
+}
+
+static int FirstAllowedCpu(void)
+{
+    cpu_set_t cpus;
+    int cpu;
+
+    TEST_REQUIRE(sched_getaffinity(0, sizeof(cpus), &cpus) == 0);
+    for (cpu = 0; cpu < (int)(sizeof(unsigned long) * 8); cpu++)
+    {
+        if (CPU_ISSET(cpu, &cpus))
+        {
+            return cpu;
+        }
+    }
+    return -1;
+}
+
+static void CheckAttributes(void)
+{
+    THREADAPI_ATTRIBUTES attributes;
+    THREAD_HANDLE thread;
+    SEEN seen;
+    size_t shallow;
+    size_t deep;
+    int cpu = FirstAllowedCpu();
+
+    TEST_REQUIRE(cpu >= 0);
+    ThreadAPI_Attributes_Init(&attributes);
+    attributes.stack_size = STACK_SIZE;
+    attributes.policy = SCHED_OTHER;
+    attributes.priority = 0;
+    attributes.name = LONG_NAME;
+    attributes.affinity = 1UL << cpu;
+
+    InitSeen(&seen, 0);
+    TEST_REQUIRE(ThreadAPI_CreateWithAttributes(&thread, Observe, &seen, &attributes) == THREADAPI_OK);
+    shallow = Finish(thread, &seen);
+
+    TEST_CHECK(seen.stack_size == STACK_SIZE);
+    TEST_CHECK((seen.local > seen.stack_low) && (seen.local < seen.stack_low + seen.stack_size));
+    TEST_CHECK(seen.policy == SCHED_OTHER);
+    TEST_CHECK(strncmp(seen.name, LONG_NAME, 15) == 0);
+    TEST_CHECK(strlen(seen.name) == 15);
+    TEST_CHECK(CPU_COUNT(&seen.cpus) == 1);
+    TEST_CHECK(CPU_ISSET(cpu, &seen.cpus));
+
+    InitSeen(&seen, DEEP_USE);
+    TEST_REQUIRE(ThreadAPI_CreateWithAttributes(&thread, Observe, &seen, &attributes) == THREADAPI_OK);
+    deep = Finish(thread, &seen);
+
+    (void)printf("stack high-water mark %u bytes idle, %u after writing %u\n",
+        (unsigned int)shallow, (unsigned int)deep, (unsigned int)DEEP_USE);
+    TEST_CHECK(shallow > 0);
+    TEST_CHECK(deep >= DEEP_USE);
+    TEST_CHECK(deep > shallow);
+    TEST_CHECK(deep < STACK_SIZE);
+}
+
+static void CheckDefaults(void)
+{
+    THREADAPI_ATTRIBUTES attributes;
+    THREAD_HANDLE thread;
+    SEEN seen;
+    size_t used;
+
+    ThreadAPI_Attributes_Init(&attributes);
+    attributes.name = "defaults";
+    attributes.stack_size = STACK_SIZE;
+    TEST_REQUIRE(ThreadAPI_SetDefaultAttributes(&attributes) == THREADAPI_OK);
+
+    InitSeen(&seen, 0);
+    TEST_REQUIRE(ThreadAPI_Create(&thread, Observe, &seen) == THREADAPI_OK);
+    used = Finish(thread, &seen);
+    TEST_CHECK(strcmp(seen.name, "defaults") == 0);
+    TEST_CHECK(seen.stack_size == STACK_SIZE);
+    TEST_CHECK(used > 0);
+
+    TEST_REQUIRE(ThreadAPI_SetDefaultAttributes(NULL) == THREADAPI_OK);
+    InitSeen(&seen, 0);
+    TEST_REQUIRE(ThreadAPI_Create(&thread, Observe, &seen) == THREADAPI_OK);
+    used = Finish(thread, &seen);
+    TEST_CHECK(strcmp(seen.name, "defaults") != 0);
+    TEST_CHECK(used == 0); // the platform's stack isn't painted
+}
+
+static void CheckRealTime(int policy, const char* policyName)
+{
+    THREADAPI_ATTRIBUTES attributes;
+    THREAD_HANDLE thread;
+    SEEN seen;
+
+    ThreadAPI_Attributes_Init(&attributes);
+    attributes.policy = policy;
+    attributes.priority = sched_get_priority_min(policy) + 1;
+
+    InitSeen(&seen, 0);
+    if (ThreadAPI_CreateWithAttributes(&thread, Observe, &seen, &attributes) != THREADAPI_OK)
+    {
+        (void)printf("%s not permitted, skipped\n", policyName);
+        ThreadAPI_Event_Destroy(seen.ready);
+        ThreadAPI_Event_Destroy(seen.release);
+    }
+    else
+    {
+        (void)Finish(thread, &seen);
+        TEST_CHECK(seen.policy == policy);
+        TEST_CHECK(seen.priority == attributes.priority);
+    }
+}
+
+int main(void)
+{
+    CheckAttributes();
+    CheckDefaults();
+    CheckRealTime(SCHED_FIFO, "SCHED_FIFO");
+    CheckRealTime(SCHED_RR, "SCHED_RR");
+    return TEST_RESULT();
+}
@@ -0,0 +1,157 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Deadlines, tickers and events of threadapi_pthreads_sl.c. A ticker waited
+ * on in time never wakes before its tick and doesn't drift by the work done
+ * between ticks; one waited on late returns at once with the number of
+ * ticks that passed entirely, and is back on its grid for the next one. An
+ * event signaled before the sleep (once or several times) cuts one sleep
+ * short and no more, a signal from another thread wakes the sleeper long
+ * before its deadline, and an unsignaled sleep lasts until the deadline.
+ *
+ * Only the lower bounds of sleeps are exact; upper bounds are loose enough
+ * for a loaded machine running the tests in parallel.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "threadapi_sl.h"
+
+#include "test_sl.h"
+
+#define PERIOD_MS   20
+#define TICKS       10
+#define WORK_MS     7
+#define LATE_MS     75      // between two ticks, so it skips 2 unless the machine stalls
+#define LONG_MS     5000
+#define SIGNAL_MS   20
+
+static void CheckPunctual(void)
+{
+    THREADAPI_TICKER ticker;
+    uint64_t start;
+    uint64_t first;
+    uint64_t now;
+    unsigned int missed = 0;
+    int i;
+
+    start = ThreadAPI_GetMonotonicTime();
+    ThreadAPI_Ticker_Init(&ticker, PERIOD_MS);
+    first = ticker.next;
+    TEST_CHECK(first >= start + PERIOD_MS);
+    for (i = 1; i <= TICKS; i++)
+    {
+        ThreadAPI_Sleep(WORK_MS);
+        missed += ThreadAPI_Ticker_Wait(&ticker);
+        now = ThreadAPI_GetMonotonicTime();
+        TEST_CHECK(now >= start + (uint64_t)i * PERIOD_MS);
+    }
+
+    // the work between waits doesn't push the grid back: ten ticks take ten periods, not ten and the work
+    (void)printf("%u ticks of %u ms with %u ms of work each: %u ms, %u missed\n", (unsigned int)TICKS,
+        (unsigned int)PERIOD_MS, (unsigned int)WORK_MS, (unsigned int)(now - start), missed);
+    TEST_CHECK(ticker.next == first + (uint64_t)(TICKS + missed) * PERIOD_MS);
+    if (missed == 0)
+    {
+        TEST_CHECK(now < start + (uint64_t)TICKS * (PERIOD_MS + WORK_MS));
+    }
+}
+
+static void CheckLate(void)
+{
+    THREADAPI_TICKER ticker;
+    uint64_t due;
+    uint64_t before;
+    uint64_t after;
+    unsigned int missed;
+    unsigned int lowest;
+
+    ThreadAPI_Ticker_Init(&ticker, PERIOD_MS);
+    due = ticker.next;
+    ThreadAPI_Sleep(LATE_MS);
+
+    before = ThreadAPI_GetMonotonicTime();
+    missed = ThreadAPI_Ticker_Wait(&ticker);
+    after = ThreadAPI_GetMonotonicTime();
+
+    // the ticker read the clock between before and after
+    lowest = (unsigned int)((before - due) / PERIOD_MS);
+    (void)printf("%u ms late on a %u ms ticker: %u ticks skipped\n", (unsigned int)(before - due + PERIOD_MS),
+        (unsigned int)PERIOD_MS, missed);
+    TEST_CHECK(lowest >= LATE_MS / PERIOD_MS - 1);
+    TEST_CHECK((missed >= lowest) && (missed <= (unsigned int)((after - due) / PERIOD_MS)));
+    TEST_CHECK(ticker.next == due + (uint64_t)(missed + 1) * PERIOD_MS);
+
+    // back on the grid: the next tick sleeps until its time
+    due = ticker.next;
+    missed = ThreadAPI_Ticker_Wait(&ticker);
+    after = ThreadAPI_GetMonotonicTime();
+    TEST_CHECK((missed != 0) || (after >= due));
+}
+
+/* Signals the event after SIGNAL_MS */
+static int SignalLater(void* arg)
+{
+    ThreadAPI_Sleep(SIGNAL_MS);
+    (void)ThreadAPI_Event_Signal((THREADAPI_EVENT_HANDLE)arg);
+    return 0;
+}
+
+static void CheckEvent(void)
+{
+    THREADAPI_EVENT_HANDLE event = ThreadAPI_Event_Create();
+    THREAD_HANDLE thread;
+    uint64_t start;
+    uint64_t now;
+
+    TEST_REQUIRE(event != NULL);
+
+    // signaled before the sleep: returns at once and clears the signal
+    TEST_CHECK(ThreadAPI_Event_Signal(event) == THREADAPI_OK);
+    start = ThreadAPI_GetMonotonicTime();
+    TEST_CHECK(ThreadAPI_Event_SleepUntil(event, start + LONG_MS) == 1);
+    TEST_CHECK(ThreadAPI_GetMonotonicTime() < start + LONG_MS / 2);
+    TEST_CHECK(ThreadAPI_Event_SleepUntil(event, ThreadAPI_GetMonotonicTime()) == 0);
+
+    // signals don't count up: two signals cut one sleep short
+    TEST_CHECK(ThreadAPI_Event_Signal(event) == THREADAPI_OK);
+    TEST_CHECK(ThreadAPI_Event_Signal(event) == THREADAPI_OK);
+    TEST_CHECK(ThreadAPI_Event_SleepUntil(event, ThreadAPI_GetMonotonicTime() + LONG_MS) == 1);
+    start = ThreadAPI_GetMonotonicTime();
+    TEST_CHECK(ThreadAPI_Event_SleepUntil(event, start + PERIOD_MS) == 0);
+    TEST_CHECK(ThreadAPI_GetMonotonicTime() >= start + PERIOD_MS);
+
+    // a deadline already passed returns at once, a signal pending still wins over it
+    start = ThreadAPI_GetMonotonicTime();
+    TEST_CHECK(ThreadAPI_Event_SleepUntil(event, start - 1) == 0);
+    TEST_CHECK(ThreadAPI_Event_Signal(event) == THREADAPI_OK);
+    TEST_CHECK(ThreadAPI_Event_SleepUntil(event, start - 1) == 1);
+    TEST_CHECK(ThreadAPI_GetMonotonicTime() < start + LONG_MS / 2);
+
+    // signaled by another thread while asleep
+    start = ThreadAPI_GetMonotonicTime();
+    TEST_REQUIRE(ThreadAPI_Create(&thread, SignalLater, event) == THREADAPI_OK);
+    TEST_CHECK(ThreadAPI_Event_SleepUntil(event, start + LONG_MS) == 1);
+    now = ThreadAPI_GetMonotonicTime();
+    (void)printf("signaled after %u ms, woke after %u ms\n", (unsigned int)SIGNAL_MS, (unsigned int)(now - start));
+    TEST_CHECK((now >= start + SIGNAL_MS) && (now < start + LONG_MS / 2));
+    TEST_REQUIRE(ThreadAPI_Join(thread, NULL) == THREADAPI_OK);
+
+    // a NULL event still sleeps until the deadline
+    start = ThreadAPI_GetMonotonicTime();
+    TEST_CHECK(ThreadAPI_Event_SleepUntil(NULL, start + PERIOD_MS) == 0);
+    TEST_CHECK(ThreadAPI_GetMonotonicTime() >= start + PERIOD_MS);
+    TEST_CHECK(ThreadAPI_Event_Signal(NULL) == THREADAPI_INVALID_ARG);
+
+    ThreadAPI_Event_Destroy(event);
+}
+
+int main(void)
+{
+    CheckPunctual();
+    CheckLate();
+    CheckEvent();
+    return TEST_RESULT();
+}
@@ -0,0 +1,147 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * threadpool_sl.c with the whole process on one core, as on the target:
+ * producers submitting at once, preempted anywhere, never leave a worker
+ * waiting on a task that isn't there, every future reports its own task's
+ * result, a full queue is refused rather than overrun, and destroying the
+ * pool runs what is still queued.
+ */
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "azure_c_shared_utility/threadapi.h"
+#include "threadpool_sl.h"
+
+#include "test_sl.h"
+
+#define PRODUCERS   4
+#define TASKS       20000   /* per producer */
+#define WORKERS     3
+#define QUEUE_SIZE  16
+
+static volatile int tasksRun;
+
+static int Square(void* arg)
+{
+    int n = (int)(intptr_t)arg;
+
+    __atomic_fetch_add(&tasksRun, 1, __ATOMIC_RELAXED);
+    return n * n;
+}
+
+static int Block(void* arg)
+{
+    while (!__atomic_load_n((volatile int*)arg, __ATOMIC_ACQUIRE))
+    {
+        (void)sched_yield();
+    }
+    return 0;
+}
+
+static THREADPOOL_HANDLE pool;
+
+/* Submits TASKS squares, waiting for the oldest futures when the queue is full */
+static int Producer(void* arg)
+{
+    THREADPOOL_FUTURE_HANDLE futures[QUEUE_SIZE];
+    THREADPOOL_RESULT result;
+    int base = (int)(intptr_t)arg * TASKS;
+    int submitted = 0;
+    int waited = 0;
+    int value;
+    int wrong = 0;
+
+    while (waited < TASKS)
+    {
+        if ((submitted < TASKS) && (submitted - waited < QUEUE_SIZE))
+        {
+            result = ThreadPool_Submit(pool, Square, (void*)(intptr_t)((base + submitted) % 1000),
+                &futures[submitted % QUEUE_SIZE]);
+            if (result == THREADPOOL_OK)
+            {
+                submitted++;
+                continue;
+            }
+            if (result != THREADPOOL_FULL)
+            {
+                return -1;
+            }
+        }
+        if (waited == submitted)
+        {
+            // the other producers have filled the queue
+            (void)sched_yield();
+            continue;
+        }
+        if ((ThreadPool_Wait(futures[waited % QUEUE_SIZE], &value) != THREADPOOL_OK) ||
+            (value != ((base + waited) % 1000) * ((base + waited) % 1000)))
+        {
+            wrong++;
+        }
+        waited++;
+    }
+    return wrong;
+}
+
+static void CheckProducers(void)
+{
+    THREAD_HANDLE producers[PRODUCERS];
+    int wrong;
+    int i;
+
+    tasksRun = 0;
+    pool = ThreadPool_Create(WORKERS, QUEUE_SIZE);
+    TEST_REQUIRE(pool != NULL);
+    for (i = 0; i < PRODUCERS; i++)
+    {
+        TEST_REQUIRE(ThreadAPI_Create(&producers[i], Producer, (void*)(intptr_t)i) == THREADAPI_OK);
+    }
+    for (i = 0; i < PRODUCERS; i++)
+    {
+        TEST_REQUIRE(ThreadAPI_Join(producers[i], &wrong) == THREADAPI_OK);
+        TEST_CHECK(wrong == 0);
+    }
+    ThreadPool_Destroy(pool);
+    TEST_CHECK(tasksRun == PRODUCERS * TASKS);
+}
+
+static void CheckFullAndDestroy(void)
+{
+    volatile int release = 0;
+    int queued = 0;
+    int i;
+
+    tasksRun = 0;
+    pool = ThreadPool_Create(1, QUEUE_SIZE);
+    TEST_REQUIRE(pool != NULL);
+    TEST_REQUIRE(ThreadPool_Submit(pool, Block, (void*)&release, NULL) == THREADPOOL_OK);
+    for (i = 0; i < 2 * QUEUE_SIZE; i++)
+    {
+        if (ThreadPool_Submit(pool, Square, (void*)(intptr_t)i, NULL) == THREADPOOL_OK)
+        {
+            queued++;
+        }
+    }
+    // the worker may or may not have taken Block off the queue yet
+    TEST_CHECK((queued == QUEUE_SIZE) || (queued == QUEUE_SIZE - 1));
+    __atomic_store_n(&release, 1, __ATOMIC_RELEASE);
+    ThreadPool_Destroy(pool);
+    TEST_CHECK(tasksRun == queued);
+}
+
+int main(void)
+{
+    cpu_set_t one;
+
+    CPU_ZERO(&one);
+    CPU_SET(sched_getcpu() >= 0 ? sched_getcpu() : 0, &one);
+    TEST_REQUIRE(sched_setaffinity(0, sizeof(one), &one) == 0);
+
+    CheckProducers();
+    CheckFullAndDestroy();
+    return TEST_RESULT();
+}
@@ -0,0 +1,182 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * tlsio_sl over the host SlNet: data survives the round trip through a TLS
+ * echo server, and the peer is verified, by name and against the CA. The
+ * host SlNet fails closed: a session with no name to check the certificate
+ * against, or whose root CA file is missing, doesn't start, and only a
+ * session with no root CA set falls back to the system's trust store (which
+ * doesn't know the server).
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "azure_c_shared_utility/tlsio.h"
+#include "tlsio_sl.h"
+#include "threadapi_sl.h"
+#include "cert_sl.h"
+#include "ti/net/slnetsock.h"
+#include "ti/net/slneterr.h"
+
+#include "loopback_sl.h"
+#include "test_sl.h"
+
+#define ECHO_SIZE       150000
+#define ECHO_TIMEOUT_MS 10000
+
+static unsigned char sent[ECHO_SIZE];
+static unsigned char received[ECHO_SIZE];
+static size_t receivedLength;
+static int openResult;
+static int sendResult;
+
+static void OnOpenComplete(void* context, IO_OPEN_RESULT result)
+{
+    (void)context;
+    openResult = (int)result;
+}
+
+static void OnBytesReceived(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    if (receivedLength + size <= sizeof(received))
+    {
+        (void)memcpy(received + receivedLength, buffer, size);
+    }
+    receivedLength += size;
+}
+
+static void OnSendComplete(void* context, IO_SEND_RESULT result)
+{
+    (void)context;
+    sendResult = (int)result;
+}
+
+static void OnError(void* context)
+{
+    (void)context;
+}
+
+static void OnCloseComplete(void* context)
+{
+    (void)context;
+}
+
+/* Sends size bytes to the echo server at host and checks they come back; -1 if it can't open */
+static int Echo(const char* host, int port, size_t size)
+{
+    TLSIO_CONFIG config;
+    CONCRETE_IO_HANDLE io;
+    uint64_t start;
+    size_t i;
+
+    (void)memset(&config, 0, sizeof(config));
+    config.hostname = host;
+    config.port = port;
+    io = tlsio_sl_create(&config);
+    TEST_REQUIRE(io != NULL);
+
+    openResult = -1;
+    sendResult = -1;
+    receivedLength = 0;
+    if (tlsio_sl_open(io, OnOpenComplete, NULL, OnBytesReceived, NULL, OnError, NULL) != 0)
+    {
+        tlsio_sl_destroy(io);
+        return -1;
+    }
+    TEST_CHECK(openResult == IO_OPEN_OK);
+
+    for (i = 0; i < size; i++)
+    {
+        sent[i] = (unsigned char)rand();
+    }
+    TEST_CHECK(tlsio_sl_send(io, sent, size, OnSendComplete, NULL) == 0);
+    TEST_CHECK(sendResult == IO_SEND_OK);
+
+    start = ThreadAPI_GetMonotonicTime();
+    while ((receivedLength < size) && (ThreadAPI_GetMonotonicTime() - start < ECHO_TIMEOUT_MS))
+    {
+        tlsio_sl_dowork(io);
+        ThreadAPI_Sleep(1);
+    }
+    TEST_CHECK(receivedLength == size);
+    TEST_CHECK(memcmp(received, sent, size) == 0);
+
+    TEST_CHECK(tlsio_sl_close(io, OnCloseComplete, NULL) == 0);
+    tlsio_sl_destroy(io);
+    return 0;
+}
+
+/* Starts a session on a connection to 127.0.0.1:port made without a name lookup; returns SlNetSock_startSec()'s status */
+static int32_t StartSecure(int port, const char* domainName, const char* rootCa)
+{
+    SlNetSockSecAttrib_t* secAttrib = SlNetSock_secAttribCreate();
+    struct sockaddr_in address;
+    int sd = socket(AF_INET, SOCK_STREAM, 0);
+    int32_t result;
+
+    TEST_REQUIRE((secAttrib != NULL) && (sd >= 0));
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_REQUIRE(connect(sd, (struct sockaddr*)&address, sizeof(address)) == 0);
+
+    if (domainName != NULL)
+    {
+        TEST_REQUIRE(SlNetSock_secAttribSet(secAttrib, SLNETSOCK_SEC_ATTRIB_DOMAIN_NAME, (void*)domainName,
+            (uint16_t)(strlen(domainName) + 1)) == SLNETERR_RET_CODE_OK);
+    }
+    if (rootCa != NULL)
+    {
+        TEST_REQUIRE(SlNetSock_secAttribSet(secAttrib, SLNETSOCK_SEC_ATTRIB_PEER_ROOT_CA, (void*)rootCa,
+            (uint16_t)(strlen(rootCa) + 1)) == SLNETERR_RET_CODE_OK);
+    }
+    result = SlNetSock_startSec((int16_t)sd, secAttrib, 0);
+    (void)SlNetHost_close(sd);
+    (void)SlNetSock_secAttribDelete(secAttrib);
+    return result;
+}
+
+int main(void)
+{
+    LOOPBACK_HANDLE server = Loopback_Start(LOOPBACK_ECHO, 1);
+    uint64_t start;
+    int port;
+
+    TEST_REQUIRE(server != NULL);
+    port = Loopback_GetPort(server);
+
+    // before any lookup: 127.0.0.1 has no name, so only a domain name set lets the session start
+    TEST_CHECK(StartSecure(port, NULL, SL_SSL_CA_CERT) == SLNETERR_ESEC_NO_DOMAIN_NAME);
+    TEST_CHECK(StartSecure(port, "localhost", SL_SSL_CA_CERT) == SLNETERR_RET_CODE_OK);
+
+    TEST_CHECK(Echo("localhost", port, ECHO_SIZE) == 0);
+    TEST_CHECK(Loopback_GetBytesReceived(server) == ECHO_SIZE);
+
+    // the certificate names localhost only
+    TEST_CHECK(Echo("127.0.0.1", port, 1) == -1);
+
+    // no root CA set: the system store is used, which doesn't know the server
+    TEST_CHECK(StartSecure(port, "localhost", NULL) == SLNETERR_ESEC_HANDSHAKE_FAILED);
+
+    // a root CA set but missing fails before the handshake, rather than fall back to the system store
+    TEST_REQUIRE(setenv("SLNETHOST_FS_ROOT", "/nonexistent", 1) == 0);
+    TEST_CHECK(StartSecure(port, "localhost", SL_SSL_CA_CERT) == SLNETERR_ESEC_BAD_CERT);
+    TEST_CHECK(Echo("localhost", port, 1) == -1);
+
+    // the sessions refused before the handshake are accepted by the server in its own time
+    start = ThreadAPI_GetMonotonicTime();
+    while ((Loopback_GetConnectionCount(server) < 7) && (ThreadAPI_GetMonotonicTime() - start < ECHO_TIMEOUT_MS))
+    {
+        ThreadAPI_Sleep(1);
+    }
+    TEST_CHECK(Loopback_GetConnectionCount(server) == 7);
+    Loopback_Stop(server);
+    return TEST_RESULT();
+}
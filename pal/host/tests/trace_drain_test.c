@@ -0,0 +1,229 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * The trace ring of trace_sl.c drained while several threads record into it
+ * far faster than the drain keeps up: every record claimed is either handed
+ * to the output once or counted lost, never both and never torn (each
+ * writer's event matches the writer stamped in its value), and each writer's
+ * records come out in the order it recorded them. The same holds without
+ * threads, where the numbers are exact: a ring overrun between drains keeps
+ * the newest TRACE_RING_SIZE records, and one lapped during a drain (by the
+ * output function recording) loses the rest of that drain rather than output
+ * the next lap's records in their place. A Chrome trace of a quiet ring
+ * parses as JSON with one event per record.
+ */
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace_sl.h"
+#include "threadapi_sl.h"
+#include "parson_sl.h"
+
+#include "test_sl.h"
+
+#define WRITERS         4
+#define RECORDS         200000      // per writer
+#define QUIET_RECORDS   (TRACE_RING_SIZE / 2)
+
+typedef struct DRAIN_TAG
+{
+    size_t lines;
+    long last[WRITERS];             // last record number seen per writer
+    size_t torn;
+    size_t reordered;
+} DRAIN;
+
+static const char* const eventNames[TRACE_EVENT_COUNT] = { "tlsio_open", "tlsio_send", "httpapi_execute", "socketio_dowork" };
+
+static int finished;
+
+/* Records RECORDS instants of event writer % TRACE_EVENT_COUNT, valued writer << 24 | record number */
+static int Write(void* arg)
+{
+    int writer = (int)(intptr_t)arg;
+    int32_t i;
+
+    for (i = 0; i < RECORDS; i++)
+    {
+        Trace_Record((TRACE_EVENT)(writer % TRACE_EVENT_COUNT), TRACE_PHASE_INSTANT, ((int32_t)writer << 24) | i);
+        if ((i % 64) == 0)
+        {
+            // let the drain catch up now and then, so both full and overrun drains are seen
+            (void)sched_yield();
+        }
+    }
+    (void)__atomic_add_fetch(&finished, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* Checks a text line: "<us> us <thread> i <event> <value>" */
+static void Collect(void* context, const char* line)
+{
+    DRAIN* drain = (DRAIN*)context;
+    unsigned long timestamp;
+    unsigned long thread;
+    char phase;
+    char event[32];
+    long value;
+    int writer;
+
+    drain->lines++;
+    if ((sscanf(line, "%lu us %lx %c %31s %ld", &timestamp, &thread, &phase, event, &value) != 5) || (phase != 'i'))
+    {
+        (void)fprintf(stderr, "bad line: %s\n", line);
+        drain->torn++;
+        return;
+    }
+    writer = (int)(value >> 24);
+    if ((writer < 0) || (writer >= WRITERS) || (strcmp(event, eventNames[writer % TRACE_EVENT_COUNT]) != 0))
+    {
+        (void)fprintf(stderr, "torn record: %s\n", line);
+        drain->torn++;
+        return;
+    }
+    if ((value & 0xFFFFFF) <= drain->last[writer])
+    {
+        drain->reordered++;
+    }
+    drain->last[writer] = value & 0xFFFFFF;
+}
+
+static void CheckConcurrent(void)
+{
+    THREAD_HANDLE threads[WRITERS];
+    DRAIN drain;
+    size_t seen = 0;
+    size_t drains = 0;
+    int i;
+
+    (void)memset(&drain, 0, sizeof(drain));
+    for (i = 0; i < WRITERS; i++)
+    {
+        drain.last[i] = -1;
+        TEST_REQUIRE(ThreadAPI_Create(&threads[i], Write, (void*)(intptr_t)i) == THREADAPI_OK);
+    }
+    while (__atomic_load_n(&finished, __ATOMIC_ACQUIRE) < WRITERS)
+    {
+        seen += Trace_Drain(TRACE_FORMAT_TEXT, Collect, &drain);
+        drains++;
+    }
+    for (i = 0; i < WRITERS; i++)
+    {
+        TEST_REQUIRE(ThreadAPI_Join(threads[i], NULL) == THREADAPI_OK);
+    }
+    // everything is published now: one drain empties the ring, the next finds nothing
+    seen += Trace_Drain(TRACE_FORMAT_TEXT, Collect, &drain);
+    TEST_CHECK(Trace_Drain(TRACE_FORMAT_TEXT, Collect, &drain) == 0);
+
+    (void)printf("%u records from %u threads in %u drains: %u seen, %u lost\n", (unsigned int)(WRITERS * RECORDS),
+        (unsigned int)WRITERS, (unsigned int)drains + 1, (unsigned int)seen, (unsigned int)Trace_GetLostCount());
+    TEST_CHECK(seen == drain.lines);
+    TEST_CHECK(seen + Trace_GetLostCount() == (size_t)WRITERS * RECORDS);
+    TEST_CHECK(drain.torn == 0);
+    TEST_CHECK(drain.reordered == 0);
+}
+
+/* Counts the lines and the values in order; the first line of a drain records a whole lap */
+static void Lap(void* context, const char* line)
+{
+    DRAIN* drain = (DRAIN*)context;
+    long value;
+    int32_t i;
+
+    TEST_REQUIRE(sscanf(line, "%*lu us %*lx i tlsio_send %ld", &value) == 1);
+    TEST_CHECK(value > drain->last[0]);
+    drain->last[0] = value;
+    if (drain->lines++ == 0)
+    {
+        for (i = 0; i < TRACE_RING_SIZE; i++)
+        {
+            TRACE_INSTANT(TRACE_EVENT_TLSIO_SEND, 1000000 + i);
+        }
+    }
+}
+
+static void CheckOverrun(void)
+{
+    DRAIN drain;
+    size_t lost = Trace_GetLostCount();
+    int32_t i;
+
+    // three laps between drains: the last one comes out, the two before are lost
+    for (i = 0; i < 3 * TRACE_RING_SIZE; i++)
+    {
+        TRACE_INSTANT(TRACE_EVENT_TLSIO_SEND, i);
+    }
+    (void)memset(&drain, 0, sizeof(drain));
+    drain.last[0] = 2 * TRACE_RING_SIZE - 1;
+    drain.lines = 1;
+    TEST_CHECK(Trace_Drain(TRACE_FORMAT_TEXT, Lap, &drain) == TRACE_RING_SIZE);
+    TEST_CHECK(drain.last[0] == 3 * TRACE_RING_SIZE - 1);
+    TEST_CHECK(Trace_GetLostCount() == lost + 2 * TRACE_RING_SIZE);
+
+    // lapped after the first line: the rest of the drain is lost, the lap comes out whole next time
+    for (i = 0; i < TRACE_RING_SIZE / 2; i++)
+    {
+        TRACE_INSTANT(TRACE_EVENT_TLSIO_SEND, i);
+    }
+    (void)memset(&drain, 0, sizeof(drain));
+    drain.last[0] = -1;
+    TEST_CHECK(Trace_Drain(TRACE_FORMAT_TEXT, Lap, &drain) == 1);
+    TEST_CHECK(Trace_GetLostCount() == lost + 2 * TRACE_RING_SIZE + TRACE_RING_SIZE / 2 - 1);
+    TEST_CHECK(Trace_Drain(TRACE_FORMAT_TEXT, Lap, &drain) == TRACE_RING_SIZE);
+    TEST_CHECK(drain.last[0] == 1000000 + TRACE_RING_SIZE - 1);
+    TEST_CHECK(Trace_GetLostCount() == lost + 2 * TRACE_RING_SIZE + TRACE_RING_SIZE / 2 - 1);
+}
+
+static void Append(void* context, const char* line)
+{
+    char* trace = (char*)context;
+
+    TEST_REQUIRE(strlen(trace) + strlen(line) < QUIET_RECORDS * 160);
+    (void)strcat(trace, line);
+}
+
+static void CheckChrome(void)
+{
+    char* trace = calloc(QUIET_RECORDS, 160);
+    size_t lost = Trace_GetLostCount();
+    JSON_Value* value;
+    JSON_Array* events;
+    int i;
+
+    TEST_REQUIRE(trace != NULL);
+    for (i = 0; i < QUIET_RECORDS; i++)
+    {
+        Trace_Record(TRACE_EVENT_HTTPAPI_EXECUTE, (TRACE_PHASE)(i % 3), i);
+    }
+    TEST_CHECK(Trace_Drain(TRACE_FORMAT_CHROME, Append, trace) == QUIET_RECORDS);
+    TEST_CHECK(Trace_GetLostCount() == lost);
+
+    value = json_parse_string(trace);
+    events = json_object_get_array(json_object(value), "traceEvents");
+    TEST_REQUIRE(events != NULL);
+    TEST_CHECK(json_array_get_count(events) == QUIET_RECORDS);
+    for (i = 0; i < QUIET_RECORDS; i++)
+    {
+        JSON_Object* event = json_array_get_object(events, (size_t)i);
+
+        TEST_CHECK(strcmp(json_object_get_string(event, "name"), "httpapi_execute") == 0);
+        TEST_CHECK(json_object_get_string(event, "ph")[0] == "BEi"[i % 3]);
+        TEST_CHECK(json_object_dotget_number(event, (i % 3 == 0) ? "args.begin" : (i % 3 == 1) ? "args.end" : "args.value") == i);
+        TEST_CHECK((i == 0) || (json_object_get_number(event, "ts") >= json_object_get_number(json_array_get_object(events, (size_t)i - 1), "ts")));
+    }
+    json_value_free(value);
+    free(trace);
+}
+
+int main(void)
+{
+    TEST_CHECK(Trace_Drain(TRACE_FORMAT_TEXT, NULL, NULL) == 0);
+    CheckConcurrent();
+    CheckOverrun();
+    CheckChrome();
+    return TEST_RESULT();
+}
@@ -0,0 +1,272 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * The XIO_STATS of socketio_sl and tlsio_sl against an echo server that
+ * counts what it gets, read as the SDK reads them, through the setoption of
+ * the xio's interface description: the bytes each side reports match the
+ * server's, a reopen counts as a reconnect, OPTION_XIO_STATS_RESET clears the
+ * counters, neither option can be saved by retrieveoptions, and a name that
+ * doesn't resolve leaves the resolver's own status in last_error.
+ *
+ * socketio_sl leaves the sockets it connects blocking, so its DoWork would
+ * wait in recv() once the echo is in; it is given a connected nonblocking
+ * socket instead, which it can't reopen.
+ */
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "tlsio_sl.h"
+#include "threadapi_sl.h"
+#include "xio_stats_sl.h"
+#include "ti/net/slneterr.h"
+
+#include "loopback_sl.h"
+#include "test_sl.h"
+
+#define SEND_SIZE       20000
+#define SENDS           5
+#define ECHO_TIMEOUT_MS 10000
+
+/* The calls of one xio implementation, so both go through the same checks */
+typedef struct XIO_UNDER_TEST_TAG
+{
+    IO_CREATE create;
+    IO_DESTROY destroy;
+    IO_OPEN open;
+    IO_CLOSE close;
+    IO_SEND send;
+    IO_DOWORK dowork;
+    const IO_INTERFACE_DESCRIPTION* (*get_interface_description)(void);
+    int tls;
+} XIO_UNDER_TEST;
+
+static unsigned char buffer[SEND_SIZE];
+static size_t receivedLength;
+static int openResult;
+
+static void OnOpenComplete(void* context, IO_OPEN_RESULT result)
+{
+    (void)context;
+    openResult = (int)result;
+}
+
+static void OnBytesReceived(void* context, const unsigned char* data, size_t size)
+{
+    (void)context;
+    (void)data;
+    receivedLength += size;
+}
+
+static void OnSendComplete(void* context, IO_SEND_RESULT result)
+{
+    (void)context;
+    (void)result;
+}
+
+static void OnError(void* context)
+{
+    (void)context;
+}
+
+static void OnCloseComplete(void* context)
+{
+    (void)context;
+}
+
+static CONCRETE_IO_HANDLE Create(const XIO_UNDER_TEST* xio, const char* host, int port)
+{
+    SOCKETIO_CONFIG socketConfig;
+    TLSIO_CONFIG tlsConfig;
+    CONCRETE_IO_HANDLE io;
+
+    if (xio->tls)
+    {
+        (void)memset(&tlsConfig, 0, sizeof(tlsConfig));
+        tlsConfig.hostname = host;
+        tlsConfig.port = port;
+        io = xio->create(&tlsConfig);
+    }
+    else
+    {
+        (void)memset(&socketConfig, 0, sizeof(socketConfig));
+        socketConfig.hostname = host;
+        socketConfig.port = port;
+        io = xio->create(&socketConfig);
+    }
+    TEST_REQUIRE(io != NULL);
+    return io;
+}
+
+/* A socketio on a nonblocking socket connected to 127.0.0.1:port */
+static CONCRETE_IO_HANDLE CreateConnected(const XIO_UNDER_TEST* xio, int port)
+{
+    SOCKETIO_CONFIG config;
+    struct sockaddr_in address;
+    CONCRETE_IO_HANDLE io;
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+
+    TEST_REQUIRE(sock >= 0);
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_REQUIRE(connect(sock, (struct sockaddr*)&address, sizeof(address)) == 0);
+    TEST_REQUIRE(fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK) == 0);
+
+    (void)memset(&config, 0, sizeof(config));
+    config.accepted_socket = &sock;
+    io = xio->create(&config);
+    TEST_REQUIRE(io != NULL);
+    return io;
+}
+
+/* What xio_setoption(io, OPTION_XIO_STATS, &out) does */
+static int GetStats(const XIO_UNDER_TEST* xio, CONCRETE_IO_HANDLE io, XIO_STATS* stats)
+{
+    XIO_STATS* const out = stats;
+
+    return xio->get_interface_description()->concrete_io_setoption(io, OPTION_XIO_STATS, &out);
+}
+
+static int Open(const XIO_UNDER_TEST* xio, CONCRETE_IO_HANDLE io)
+{
+    openResult = -1;
+    return xio->open(io, OnOpenComplete, NULL, OnBytesReceived, NULL, OnError, NULL);
+}
+
+/* Sends SENDS buffers and runs DoWork until they are all back */
+static void Echo(const XIO_UNDER_TEST* xio, CONCRETE_IO_HANDLE io)
+{
+    uint64_t start;
+    int i;
+
+    receivedLength = 0;
+    for (i = 0; i < SENDS; i++)
+    {
+        TEST_CHECK(xio->send(io, buffer, sizeof(buffer), OnSendComplete, NULL) == 0);
+        xio->dowork(io);
+    }
+    start = ThreadAPI_GetMonotonicTime();
+    while ((receivedLength < SENDS * SEND_SIZE) && (ThreadAPI_GetMonotonicTime() - start < ECHO_TIMEOUT_MS))
+    {
+        xio->dowork(io);
+        ThreadAPI_Sleep(1);
+    }
+    TEST_CHECK(receivedLength == SENDS * SEND_SIZE);
+}
+
+static void CheckCounters(const XIO_UNDER_TEST* xio)
+{
+    LOOPBACK_HANDLE server = Loopback_Start(LOOPBACK_ECHO, xio->tls);
+    CONCRETE_IO_HANDLE io;
+    XIO_STATS stats;
+    XIO_STATS unwritten;
+    XIO_STATS* out;
+    OPTIONHANDLER_HANDLE options;
+    int reset = 1;
+
+    TEST_REQUIRE(server != NULL);
+    io = xio->tls ? Create(xio, "localhost", Loopback_GetPort(server)) : CreateConnected(xio, Loopback_GetPort(server));
+
+    TEST_CHECK(GetStats(xio, io, &stats) == 0);
+    TEST_CHECK((stats.bytes_sent == 0) && (stats.bytes_received == 0) && (stats.last_error == 0));
+
+    TEST_REQUIRE(Open(xio, io) == 0);
+    TEST_CHECK(openResult == IO_OPEN_OK);
+    Echo(xio, io);
+
+    TEST_CHECK(GetStats(xio, io, &stats) == 0);
+    TEST_CHECK(stats.bytes_sent == SENDS * SEND_SIZE);
+    TEST_CHECK(stats.bytes_received == SENDS * SEND_SIZE);
+    TEST_CHECK(stats.bytes_sent == Loopback_GetBytesReceived(server));
+    TEST_CHECK(stats.bytes_received == Loopback_GetBytesSent(server));
+    TEST_CHECK(stats.send_calls >= SENDS);
+    TEST_CHECK(stats.receive_calls > stats.eagain_count);
+    TEST_CHECK(stats.queued_bytes == 0);
+    TEST_CHECK(stats.reconnect_count == 0);
+    TEST_CHECK(stats.last_error == 0);
+
+    if (xio->tls)
+    {
+        TEST_CHECK(stats.connect_ms < ECHO_TIMEOUT_MS);
+        TEST_CHECK(xio->close(io, OnCloseComplete, NULL) == 0);
+        TEST_REQUIRE(Open(xio, io) == 0);
+        Echo(xio, io);
+        TEST_CHECK(GetStats(xio, io, &stats) == 0);
+        TEST_CHECK(stats.reconnect_count == 1);
+        TEST_CHECK(stats.bytes_sent == 2 * SENDS * SEND_SIZE);
+        TEST_CHECK(stats.bytes_sent == Loopback_GetBytesReceived(server));
+        TEST_CHECK(stats.bytes_received == Loopback_GetBytesSent(server));
+    }
+
+    TEST_CHECK(xio->get_interface_description()->concrete_io_setoption(io, OPTION_XIO_STATS_RESET, &reset) == 0);
+    TEST_CHECK(GetStats(xio, io, &stats) == 0);
+    TEST_CHECK((stats.bytes_sent == 0) && (stats.bytes_received == 0) && (stats.send_calls == 0) &&
+        (stats.receive_calls == 0) && (stats.reconnect_count == 0));
+
+    // the value isn't written: the counters go where the pointer it points to points
+    (void)memset(&unwritten, 0x5A, sizeof(unwritten));
+    (void)memcpy(&stats, &unwritten, sizeof(stats));
+    out = &stats;
+    TEST_CHECK(xio->get_interface_description()->concrete_io_setoption(io, OPTION_XIO_STATS, &out) == 0);
+    TEST_CHECK(out == &stats);
+    TEST_CHECK(memcmp(&stats, &unwritten, sizeof(stats)) != 0);
+    TEST_CHECK(GetStats(xio, io, NULL) != 0);
+    TEST_CHECK(GetStats(xio, NULL, &stats) != 0);
+
+    // a reopened xio doesn't get the options of the old one back
+    options = xio->get_interface_description()->concrete_io_retrieveoptions(io);
+    TEST_REQUIRE(options != NULL);
+    TEST_CHECK(OptionHandler_AddOption(options, OPTION_XIO_STATS, &out) != OPTIONHANDLER_OK);
+    TEST_CHECK(OptionHandler_AddOption(options, OPTION_XIO_STATS_RESET, &reset) != OPTIONHANDLER_OK);
+    OptionHandler_Destroy(options);
+
+    TEST_CHECK(xio->close(io, OnCloseComplete, NULL) == 0);
+    xio->destroy(io);
+    TEST_CHECK(Loopback_GetConnectionCount(server) == (xio->tls ? 2u : 1u));
+    Loopback_Stop(server);
+}
+
+/* Returns the last_error of a failed open of a name that doesn't resolve */
+static int UnresolvedError(const XIO_UNDER_TEST* xio)
+{
+    CONCRETE_IO_HANDLE io = Create(xio, "no-such-host.invalid", 443);
+    XIO_STATS stats;
+
+    TEST_CHECK(Open(xio, io) != 0);
+    TEST_CHECK(GetStats(xio, io, &stats) == 0);
+    xio->destroy(io);
+    return stats.last_error;
+}
+
+int main(void)
+{
+    static const XIO_UNDER_TEST socketio =
+    {
+        socketio_create, socketio_destroy, socketio_open, socketio_close, socketio_send, socketio_dowork,
+        socketio_get_interface_description, 0
+    };
+    static const XIO_UNDER_TEST tlsio =
+    {
+        tlsio_sl_create, tlsio_sl_destroy, tlsio_sl_open, tlsio_sl_close, tlsio_sl_send, tlsio_sl_dowork,
+        tlsio_sl_get_interface_description, 1
+    };
+
+    CheckCounters(&socketio);
+    CheckCounters(&tlsio);
+
+    // getaddrinfo()'s EAI_ code, and SlNetUtil_getHostByName()'s status
+    TEST_CHECK(UnresolvedError(&socketio) != 0);
+    TEST_CHECK(UnresolvedError(&tlsio) == SLNETERR_NET_APP_DNS_QUERY_FAILED);
+    return TEST_RESULT();
+}
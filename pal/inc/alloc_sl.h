@@ -0,0 +1,102 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Heap accounting for the PAL. Built with PAL_ALLOC_TRACKING defined, every
+ * malloc, calloc, realloc and free in a PAL module is routed through the
+ * palalloc functions, which keep live bytes, peak, counts and a size
+ * histogram per module. Without it this header only declares the types and
+ * the PAL calls the C library directly, so there is no cost.
+ *
+ * A PAL source opts in by defining PALALLOC_THIS_MODULE before including
+ * this header, after the system headers (like gballoc.h, it redefines
+ * malloc and friends). Blocks are remembered in a table keyed by address
+ * rather than with a header in front of each block, because the PAL frees
+ * strings the SDK allocated and the SDK frees some of the PAL's: frees of
+ * blocks not in the table go straight to free().
+ *
+ * The table starts as a static array of PALALLOC_TABLE_SIZE entries and
+ * doubles, from the C library heap, whenever it is three quarters full, so
+ * every live block is accounted for. Each entry takes 12 bytes on the target
+ * (24 on a 64-bit host): the default of 128 costs 1.5 KB of RAM and holds 96
+ * blocks before the first growth. The table never shrinks. Only when the
+ * heap can't give it room to grow are allocations counted as untracked
+ * instead. The lock is held for the table and statistics only, not for the
+ * allocator calls.
+ *
+ * In builds with GB_MEASURE_MEMORY_FOR_THIS, the palalloc functions allocate
+ * with gballoc_malloc() and friends rather than the C library, so gballoc
+ * still measures the PAL's blocks and frees blocks that the SDK allocated
+ * through it.
+ */
+#ifndef ALLOC_SL_H
+#define ALLOC_SL_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+typedef enum PALALLOC_MODULE_TAG
+{
+    PALALLOC_MODULE_HTTPAPI,
+    PALALLOC_MODULE_TLSIO,
+    PALALLOC_MODULE_SOCKETIO,
+    PALALLOC_MODULE_THREADAPI,
+    PALALLOC_MODULE_THREADPOOL,
+    PALALLOC_MODULE_PARSON,
+    PALALLOC_MODULE_COUNT
+} PALALLOC_MODULE;
+
+/* Buckets of requested sizes: up to 16, 64, 256, 1K, 4K, 16K, 64K bytes and larger */
+#define PALALLOC_HISTOGRAM_BUCKETS 8
+
+typedef struct PALALLOC_STATS_TAG
+{
+    size_t live_bytes;
+    size_t peak_bytes;          // highest live_bytes since start or palalloc_reset_peaks()
+    size_t live_count;
+    size_t total_count;         // successful allocations, reallocations included
+    size_t failed_count;
+    size_t histogram[PALALLOC_HISTOGRAM_BUCKETS];
+} PALALLOC_STATS;
+
+#if defined(PAL_ALLOC_TRACKING)
+
+#ifndef PALALLOC_TABLE_SIZE
+#define PALALLOC_TABLE_SIZE 128 /* initial entries */
+#endif
+
+extern void* palalloc_malloc(PALALLOC_MODULE module, size_t size);
+extern void* palalloc_calloc(PALALLOC_MODULE module, size_t nmemb, size_t size);
+extern void* palalloc_realloc(PALALLOC_MODULE module, void* ptr, size_t size);
+extern void palalloc_free(void* ptr);
+
+/* Return 0 on success */
+extern int palalloc_get_stats(PALALLOC_MODULE module, PALALLOC_STATS* stats);
+extern size_t palalloc_get_untracked_count(void);
+extern void palalloc_reset_peaks(void);
+
+/* Writes all modules as a JSON object, snprintf style: returns the length the whole dump needs */
+extern size_t palalloc_dump_json(char* buffer, size_t size);
+
+#if defined(PALALLOC_THIS_MODULE)
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+#define malloc(size) palalloc_malloc(PALALLOC_THIS_MODULE, (size))
+#define calloc(nmemb, size) palalloc_calloc(PALALLOC_THIS_MODULE, (nmemb), (size))
+#define realloc(ptr, size) palalloc_realloc(PALALLOC_THIS_MODULE, (ptr), (size))
+#define free(ptr) palalloc_free(ptr)
+#endif /* PALALLOC_THIS_MODULE */
+
+#endif /* PAL_ALLOC_TRACKING */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* ALLOC_SL_H */
@@ -0,0 +1,63 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Log-bucketed latency histograms, in the manner of HdrHistogram. Values
+ * below 2^HISTOGRAM_SUB_BUCKET_BITS get a bucket each; above that every
+ * power of two is split into 2^HISTOGRAM_SUB_BUCKET_BITS equal buckets, so a
+ * percentile is within 1 / 2^HISTOGRAM_SUB_BUCKET_BITS (12.5% by default) of
+ * the value recorded. Values of 2^HISTOGRAM_MAX_BITS and more share the last
+ * bucket. The count, minimum, maximum and sum are exact.
+ *
+ * A histogram is a plain struct: zeroed memory is an empty histogram, and it
+ * can be copied by assignment. It has no lock; the owner serializes access.
+ */
+#ifndef HISTOGRAM_SL_H
+#define HISTOGRAM_SL_H
+
+#include "parson.h"
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif /* __cplusplus */
+
+#ifndef HISTOGRAM_SUB_BUCKET_BITS
+#define HISTOGRAM_SUB_BUCKET_BITS 3
+#endif
+
+#ifndef HISTOGRAM_MAX_BITS
+#define HISTOGRAM_MAX_BITS 26           // 67 s when recording microseconds
+#endif
+
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BUCKET_BITS + 1) << HISTOGRAM_SUB_BUCKET_BITS)
+
+typedef struct HISTOGRAM_TAG
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t buckets[HISTOGRAM_BUCKETS];
+} HISTOGRAM;
+
+extern void Histogram_Reset(HISTOGRAM* histogram);
+extern void Histogram_Record(HISTOGRAM* histogram, uint32_t value);
+
+/*
+ * Returns the value percentile (0 to 100) of the recorded values are at or
+ * below: the top of the bucket holding that rank, capped by the maximum.
+ * Returns 0 for an empty histogram.
+ */
+extern uint32_t Histogram_GetPercentile(const HISTOGRAM* histogram, double percentile);
+
+/* Returns {"count","min","mean","p50","p90","p99","max"} as a new JSON object, or NULL when out of memory */
+extern JSON_Value* Histogram_ToJson(const HISTOGRAM* histogram);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HISTOGRAM_SL_H */
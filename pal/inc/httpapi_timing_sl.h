@@ -0,0 +1,65 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Request phase timing for httpapi_sl. Built with PAL_HTTPAPI_TIMING defined,
+ * each HTTPAPI handle times the phases of every HTTPAPI_ExecuteRequest() in
+ * microseconds and records them in a HISTOGRAM per phase (see HTTPAPI_PHASE).
+ * A phase is recorded once it completes, so failed requests still count
+ * towards the phases before the failure; the total only counts requests that
+ * succeeded.
+ *
+ * HTTPAPI_SetOption() reads and clears them. OPTION_HTTPAPI_TIMINGS copies
+ * the histograms of the handle to where the pointer its value points to
+ * points (value is HTTPAPI_TIMINGS* const*, so nothing is written through
+ * the const value), and OPTION_HTTPAPI_TIMINGS_RESET clears them (value is
+ * ignored but must not be NULL). Set them from the thread that runs the
+ * requests, or with the same lock held. Without PAL_HTTPAPI_TIMING both are
+ * unknown options.
+ *
+ * HTTPAPI_CloneOption() refuses both: the HTTPAPIEX replays saved options on
+ * every handle it opens, which would clear the timings at each reconnect or
+ * write them through a pointer long gone. HTTPAPIEX_SetOption() saves an
+ * option with HTTPAPI_CloneOption() before it passes it to the handle, and
+ * fails without passing it when the clone is refused, so neither option gets
+ * through an HTTPAPIEX_HANDLE: the timings are only available for an
+ * HTTP_HANDLE the application creates and drives with HTTPAPI_* itself, not
+ * for the requests of the IoT Hub HTTP transport.
+ */
+#ifndef HTTPAPI_TIMING_SL_H
+#define HTTPAPI_TIMING_SL_H
+
+#include "azure_c_shared_utility/httpapi.h"
+#include "histogram_sl.h"
+#include "parson.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define OPTION_HTTPAPI_TIMINGS          "HttpTimings"       // value is HTTPAPI_TIMINGS* const*
+#define OPTION_HTTPAPI_TIMINGS_RESET    "HttpTimingsReset"
+
+typedef enum HTTPAPI_PHASE_TAG
+{
+    HTTPAPI_PHASE_CONNECT,      // name lookup, TCP and TLS; only requests that open the connection
+    HTTPAPI_PHASE_HEADERS,      // handing the request headers to the HTTPClient
+    HTTPAPI_PHASE_REQUEST,      // sending the request until the status line and headers arrive
+    HTTPAPI_PHASE_RESPONSE,     // copying the response headers and reading the body to its end
+    HTTPAPI_PHASE_TOTAL,
+    HTTPAPI_PHASE_COUNT
+} HTTPAPI_PHASE;
+
+typedef struct HTTPAPI_TIMINGS_TAG
+{
+    HISTOGRAM phases[HTTPAPI_PHASE_COUNT];
+} HTTPAPI_TIMINGS;
+
+/* Returns {"connect":{...},"headers":{...},...} with a Histogram_ToJson() object per phase, or NULL when out of memory */
+extern JSON_Value* HTTPAPI_Timings_ToJson(const HTTPAPI_TIMINGS* timings);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HTTPAPI_TIMING_SL_H */
@@ -0,0 +1,336 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Extensions to the Parson API that are only available with parson_sl.c.
+ * Everything declared in parson.h keeps its upstream behavior, except that
+ * booleans and null are shared read-only values: json_value_init_boolean()
+ * and json_value_init_null() don't allocate, the same value can be added to
+ * any number of objects and arrays, and json_value_get_parent() returns NULL
+ * for it.
+ */
+#ifndef PARSON_SL_H
+#define PARSON_SL_H
+
+#include "parson.h"
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif /* __cplusplus */
+
+/*
+ * 64-bit integers
+ *
+ * Integer values are reported as JSONNumber, json_value_get_number() returns
+ * them converted to double. The int64 getters return the exact value for
+ * integers and the truncated value for other numbers (0 if it doesn't fit).
+ * By default the parser creates doubles only; json_set_parse_int64(1) makes
+ * it keep integer literals that fit in 64 bits as integers, so large IDs
+ * don't lose precision.
+ */
+void json_set_parse_int64(int parse_int64);
+
+JSON_Value * json_value_init_int64(int64_t number);
+int64_t      json_value_get_int64(const JSON_Value *value);
+int          json_value_is_int64(const JSON_Value *value);
+
+int64_t      json_object_get_int64(const JSON_Object *object, const char *name);
+int64_t      json_object_dotget_int64(const JSON_Object *object, const char *name);
+int64_t      json_array_get_int64(const JSON_Array *array, size_t index);
+
+JSON_Status  json_object_set_int64(JSON_Object *object, const char *name, int64_t number);
+JSON_Status  json_object_dotset_int64(JSON_Object *object, const char *name, int64_t number);
+JSON_Status  json_array_append_int64(JSON_Array *array, int64_t number);
+
+/*
+ * Nesting
+ *
+ * Parsing, serializing and freeing don't recurse: the C stack use is the
+ * same for any depth, deeper documents only use heap (one pointer pair per
+ * level beyond 16 while serializing). json_set_max_nesting() sets the deepest
+ * nesting of objects and arrays the parsers accept, 2048 by default.
+ * json_value_deep_copy(), json_value_equals(), json_validate(),
+ * json_value_diff() and json_value_merge_patch() still recurse once per
+ * level, and json_schema_validate() once per level of its schema.
+ */
+void json_set_max_nesting(size_t max_nesting);
+
+/*
+ * Node pools
+ *
+ * Freed values of a fixed size can be kept on per kind free lists and reused
+ * by the next values of that kind instead of going back to the heap, so a
+ * device parsing similar documents over and over stops churning it. Pools are
+ * off by default; json_set_pool_limit() sets how many free blocks a pool may
+ * keep (0 returns them all to the heap). Long strings and the member and item
+ * storage of objects and arrays aren't pooled. json_set_allocation_functions()
+ * empties the pools. Like the other settings, pools aren't thread safe.
+ */
+typedef int JSON_Pool_Kind;
+enum json_pool_kind {
+    JSONPoolValue  = 0, /* numbers and strings of up to 7 bytes */
+    JSONPoolObject = 1,
+    JSONPoolArray  = 2
+};
+
+typedef struct json_pool_stats_t {
+    size_t hits;        /* allocations served from the pool */
+    size_t misses;      /* allocations that went to the heap */
+    size_t free_count;  /* blocks in the pool now */
+    size_t high_water;  /* most blocks the pool held */
+} JSON_Pool_Stats;
+
+void        json_set_pool_limit(JSON_Pool_Kind kind, size_t max_free);
+JSON_Status json_get_pool_stats(JSON_Pool_Kind kind, JSON_Pool_Stats *stats);
+
+/*
+ * Capacity
+ *
+ * Objects and arrays start with room for 16 members or items and double when
+ * full. Builders that know the final size can allocate it up front, either at
+ * init or with the reserve functions (which never shrink). Storage grows in
+ * place with realloc when parson uses the C library allocator.
+ * json_set_allocation_functions() turns that off, since realloc can't resize
+ * their blocks; call json_set_reallocation_function() after it to supply a
+ * matching realloc, or NULL to always grow by copying.
+ */
+typedef void * (*JSON_Realloc_Function)(void *, size_t);
+
+void         json_set_reallocation_function(JSON_Realloc_Function realloc_fun);
+
+JSON_Value * json_value_init_object_with_capacity(size_t capacity);
+JSON_Value * json_value_init_array_with_capacity(size_t capacity);
+JSON_Status  json_object_reserve(JSON_Object *object, size_t capacity);
+JSON_Status  json_array_reserve(JSON_Array *array, size_t capacity);
+
+/*
+ * Key interning
+ *
+ * With json_set_intern_keys(1), member names added from then on are kept in
+ * one global table and shared by every object using them, so an array of
+ * records stores each key once. Names are reference counted and the table is
+ * freed with the last one. Switching it off only affects names added later.
+ * Like the other settings, the table isn't thread safe: use documents from
+ * one thread at a time while interning is in use.
+ */
+void   json_set_intern_keys(int intern_keys);
+size_t json_interned_key_count(void);
+
+/*
+ * Streaming reader
+ *
+ * Pull parser that reads a document fed in chunks of any size and reports it
+ * as a sequence of events, without building a value tree. Memory use is fixed
+ * at init: one block holding the reader, a token buffer of max_token_len bytes
+ * (longest string, name or number) and max_depth bytes of nesting state.
+ *
+ *   reader = json_reader_init(256, 16);
+ *   while ((event = json_reader_next(reader)) != JSONReaderEnd) {
+ *       if (event == JSONReaderNeedInput) {
+ *           n = recv(...);
+ *           n > 0 ? json_reader_feed(reader, buf, n) : json_reader_finish(reader);
+ *       } else if (event == JSONReaderError) {
+ *           break;
+ *       } else ...
+ *   }
+ *   json_reader_free(reader);
+ *
+ * A fed chunk must stay valid until the next JSONReaderNeedInput. Tokens are
+ * copied, so json_reader_get_string() is valid until the next json_reader_next().
+ * As with json_parse_string(), anything after the root value is ignored.
+ */
+typedef struct json_reader_t JSON_Reader;
+
+typedef int JSON_Reader_Event;
+enum json_reader_event {
+    JSONReaderNeedInput = 0,
+    JSONReaderError     = -1,
+    JSONReaderEnd       = 1,
+    JSONReaderObjectBegin,
+    JSONReaderObjectEnd,
+    JSONReaderArrayBegin,
+    JSONReaderArrayEnd,
+    JSONReaderKey,          /* member name, see json_reader_get_string() */
+    JSONReaderString,
+    JSONReaderNumber,
+    JSONReaderBoolean,
+    JSONReaderNull
+};
+
+JSON_Reader *     json_reader_init(size_t max_token_len, size_t max_depth);
+void              json_reader_free(JSON_Reader *reader);
+JSON_Status       json_reader_feed(JSON_Reader *reader, const char *chunk, size_t chunk_len);
+JSON_Status       json_reader_finish(JSON_Reader *reader);  /* no more input after the last chunk */
+JSON_Reader_Event json_reader_next(JSON_Reader *reader);
+
+/* Value of the last event; len receives the string length (strings may contain '\0') */
+const char *      json_reader_get_string(const JSON_Reader *reader, size_t *len);
+double            json_reader_get_number(const JSON_Reader *reader);
+/* Exact for integer literals, truncated otherwise; fails if the number doesn't fit in 64 bits */
+JSON_Status       json_reader_get_int64(const JSON_Reader *reader, int64_t *number);
+int               json_reader_get_boolean(const JSON_Reader *reader);
+size_t            json_reader_get_depth(const JSON_Reader *reader);
+
+/*
+ * Streaming writer
+ *
+ * Serializes straight to a sink (socket, file, flash page) without building
+ * the string first. The output is the same as json_serialize_to_string() or
+ * json_serialize_to_string_pretty(), without the terminator, handed to
+ * write_fun in pieces of chunk_size bytes; only the last piece may be shorter.
+ * Pieces are staged in the caller's chunk buffer, except whole pieces of long
+ * strings, which point into the value. Nothing else is allocated for documents
+ * less than 16 levels deep. write_fun returns JSONFailure to stop serializing;
+ * the sink then holds a truncated document. The value must not change during
+ * the call.
+ *
+ *   static JSON_Status send_chunk(void *context, const char *data, size_t len) {
+ *       return send(*(int*)context, data, len, 0) == (ssize_t)len ? JSONSuccess : JSONFailure;
+ *   }
+ *   ...
+ *   char chunk[256];
+ *   json_serialize_to_writer(value, chunk, sizeof(chunk), send_chunk, &socket);
+ */
+typedef JSON_Status (*JSON_Write_Function)(void *context, const char *data, size_t len);
+
+JSON_Status json_serialize_to_writer(const JSON_Value *value, char *chunk, size_t chunk_size,
+                                     JSON_Write_Function write_fun, void *context);
+JSON_Status json_serialize_to_writer_pretty(const JSON_Value *value, char *chunk, size_t chunk_size,
+                                            JSON_Write_Function write_fun, void *context);
+
+/*
+ * Compiled paths
+ *
+ * A dotted path ("desired.telemetryInterval") split and hashed once, for
+ * lookups done on every message. Get and set behave like the dotget/dotset
+ * functions with the same path string. A path isn't tied to a document and
+ * can be shared by readers.
+ */
+typedef struct json_path_t JSON_Path;
+
+JSON_Path *   json_path_compile(const char *dotted_path);
+void          json_path_free(JSON_Path *path);
+
+JSON_Value  * json_path_get_value  (const JSON_Object *object, const JSON_Path *path);
+const char  * json_path_get_string (const JSON_Object *object, const JSON_Path *path);
+double        json_path_get_number (const JSON_Object *object, const JSON_Path *path);
+int64_t       json_path_get_int64  (const JSON_Object *object, const JSON_Path *path);
+JSON_Object * json_path_get_object (const JSON_Object *object, const JSON_Path *path);
+JSON_Array  * json_path_get_array  (const JSON_Object *object, const JSON_Path *path);
+int           json_path_get_boolean(const JSON_Object *object, const JSON_Path *path);
+
+JSON_Status   json_path_set_value  (JSON_Object *object, const JSON_Path *path, JSON_Value *value);
+JSON_Status   json_path_set_string (JSON_Object *object, const JSON_Path *path, const char *string);
+JSON_Status   json_path_set_number (JSON_Object *object, const JSON_Path *path, double number);
+JSON_Status   json_path_set_int64  (JSON_Object *object, const JSON_Path *path, int64_t number);
+JSON_Status   json_path_set_boolean(JSON_Object *object, const JSON_Path *path, int boolean);
+JSON_Status   json_path_set_null   (JSON_Object *object, const JSON_Path *path);
+
+/*
+ * Views
+ *
+ * Finds one value in JSON text without parsing it into values: no
+ * allocation, the text needn't be NUL terminated, and the scan stops at the
+ * value found. dotted_path works like json_object_dotget_value(), NULL gives
+ * the root value. The view is the slice of text holding the value (quotes
+ * included for strings) and stays valid as long as the text. Skipped parts
+ * are only checked as far as needed to find their end, so a view isn't
+ * proof that the whole text is valid JSON. Duplicate names give the first.
+ *
+ *   if (json_view_find(payload, size, "Name", &view) == JSONSuccess &&
+ *       json_view_get_string(&view, name, sizeof(name)) == JSONSuccess) ...
+ */
+typedef struct json_view_t {
+    const char      *text;
+    size_t           len;
+    JSON_Value_Type  type;
+} JSON_View;
+
+JSON_Status json_view_find(const char *json, size_t json_len, const char *dotted_path, JSON_View *view);
+
+/* Unescapes a string view into buf, failing if it doesn't fit with its terminator */
+JSON_Status json_view_get_string(const JSON_View *view, char *buf, size_t buf_size);
+double      json_view_get_number(const JSON_View *view);
+int         json_view_get_boolean(const JSON_View *view);
+
+/*
+ * Compiled schemas
+ *
+ * A json_validate() schema flattened once into a single block with the member
+ * names hashed, for validating every message against the same schema.
+ * json_schema_validate() gives the same result as json_validate() with the
+ * schema it was compiled from, without allocating or looking names up in the
+ * schema. Members are first looked for at the position they have in the
+ * schema. The schema value can be freed after compiling, a compiled schema
+ * can be shared by readers.
+ */
+typedef struct json_schema_t JSON_Schema;
+
+JSON_Schema * json_schema_compile(const JSON_Value *schema);
+void          json_schema_free(JSON_Schema *schema);
+JSON_Status   json_schema_validate(const JSON_Schema *schema, const JSON_Value *value);
+
+/*
+ * Binary encodings
+ *
+ * The same value trees as CBOR (RFC 8949) and, when built with
+ * PARSON_MSGPACK, MessagePack. Numbers are written as integers when they are
+ * integral (except -0.0), as single precision floats when that's exact and
+ * as doubles otherwise; decoded integers follow json_set_parse_int64(). The size
+ * functions return the exact encoded size (no terminator), 0 on failure.
+ * Decoding rejects byte strings, extension types and indefinite length
+ * strings, ignores CBOR tags and, like json_parse_string(), anything after
+ * the root value.
+ */
+size_t       json_serialization_size_cbor(const JSON_Value *value);
+JSON_Status  json_serialize_to_buffer_cbor(const JSON_Value *value, void *buf, size_t buf_size_in_bytes);
+JSON_Value * json_parse_cbor(const void *data, size_t size);
+
+#ifdef PARSON_MSGPACK
+size_t       json_serialization_size_msgpack(const JSON_Value *value);
+JSON_Status  json_serialize_to_buffer_msgpack(const JSON_Value *value, void *buf, size_t buf_size_in_bytes);
+JSON_Value * json_parse_msgpack(const void *data, size_t size);
+#endif
+
+/*
+ * Merge patches (RFC 7386)
+ *
+ * json_value_diff() returns the patch turning from into to: changed and added
+ * members, null for removed ones, nested objects diffed member by member and
+ * anything else (arrays included) replaced whole. json_value_merge_patch()
+ * applies a patch in place. Patches can't carry null values: a null member
+ * removes the member. A patch or target that isn't an object would replace
+ * the whole document, which can't be done in place: that fails and leaves
+ * target unchanged.
+ *
+ * Instead of keeping a copy of the last document sent, an object can track
+ * its own changes. json_object_get_changes() then builds the patch from the
+ * members set, replaced or removed since tracking started or since the last
+ * json_object_clear_changes(), without walking unchanged subtrees. Tracking
+ * covers the nested objects, a change inside an array marks the whole array.
+ * It returns NULL if object isn't tracked. Tracking isn't thread safe.
+ *
+ *   json_object_track_changes(reported, 1);
+ *   ...set properties...
+ *   patch = json_object_get_changes(reported);
+ *   if (json_object_get_count(json_value_get_object(patch)) > 0) send(patch);
+ *   json_value_free(patch);
+ *   json_object_clear_changes(reported);
+ */
+JSON_Value * json_value_diff(const JSON_Value *from, const JSON_Value *to);
+JSON_Status  json_value_merge_patch(JSON_Value *target, const JSON_Value *patch);
+
+JSON_Status  json_object_track_changes(JSON_Object *object, int track);
+JSON_Value * json_object_get_changes(const JSON_Object *object);
+void         json_object_clear_changes(JSON_Object *object);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PARSON_SL_H */
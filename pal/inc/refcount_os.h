@@ -8,9 +8,15 @@
 
 
 // This Linux-specific header offers 3 strategies:
-//   REFCOUNT_ATOMIC_DONTCARE     -- no atomicity guarantee
+//   REFCOUNT_ATOMIC_DONTCARE     -- no atomicity guarantee, for single-threaded builds
 //   REFCOUNT_USE_STD_ATOMIC      -- C11 atomicity
 //   REFCOUNT_USE_GNU_C_ATOMIC    -- GNU-specific atomicity
+//
+// The atomic strategies are sequentially consistent by default. Defining
+// REFCOUNT_RELAXED_ORDERING makes increments relaxed and decrements release,
+// with an acquire fence only on the decrement that reaches zero: enough for
+// the last owner to see every write made through other references before it
+// frees the object, and much cheaper on contended counts.
 
 #if defined(__GNUC__)
 #define REFCOUNT_USE_GNU_C_ATOMIC 1
@@ -51,16 +57,31 @@ gcc
 - will result in no include (for gcc these are intrinsics build in)
 - will use __sync_fetch_and_add/sub
 - about the return value: "... returns the value that had previously been in memory." (https://gcc.gnu.org/onlinedocs/gcc-4.4.3/gcc/Atomic-Builtins.html#Atomic-Builtins)
+With REFCOUNT_RELAXED_ORDERING, C11 and gcc use the _explicit functions and the __atomic builtins instead;
+DEC_REF_VAR then only tells whether the count reached zero (DEC_RETURN_ZERO) or not.
 */
 
 
 /*if macro DEC_REF returns DEC_RETURN_ZERO that means the ref count has reached zero.*/
+/*REFCOUNT_RELAXED_ORDERING needs explicit orderings: C11, or the gcc >= 4.7 __atomic builtins*/
+#if defined(REFCOUNT_RELAXED_ORDERING) && defined(REFCOUNT_USE_GNU_C_ATOMIC) && !defined(__ATOMIC_RELAXED)
+#undef REFCOUNT_RELAXED_ORDERING
+#endif
+
 #if defined(REFCOUNT_ATOMIC_DONTCARE)
 #define DEC_RETURN_ZERO (0)
 #define INC_REF_VAR(count) ++(count)
 #define DEC_REF_VAR(count) --(count)
 #define INIT_REF_VAR(count) do { count = 1; } while((void)0,0)
 
+#elif defined(REFCOUNT_USE_STD_ATOMIC) && defined(REFCOUNT_RELAXED_ORDERING)
+#include <stdatomic.h>
+#define DEC_RETURN_ZERO (1)
+#define INC_REF_VAR(count) atomic_fetch_add_explicit(&(count), 1, memory_order_relaxed)
+#define DEC_REF_VAR(count) (atomic_fetch_sub_explicit(&(count), 1, memory_order_release) == 1 ? \
+    (atomic_thread_fence(memory_order_acquire), (uint32_t)1) : (uint32_t)0)
+#define INIT_REF_VAR(count) atomic_store(&(count), 1)
+
 #elif defined(REFCOUNT_USE_STD_ATOMIC)
 #include <stdatomic.h>
 #define DEC_RETURN_ZERO (1)
@@ -68,6 +89,13 @@ gcc
 #define DEC_REF_VAR(count) atomic_fetch_sub(&(count), 1)
 #define INIT_REF_VAR(count) atomic_store(&(count), 1)
 
+#elif defined(REFCOUNT_USE_GNU_C_ATOMIC) && defined(REFCOUNT_RELAXED_ORDERING)
+#define DEC_RETURN_ZERO (0)
+#define INC_REF_VAR(count) __atomic_add_fetch(&(count), 1, __ATOMIC_RELAXED)
+#define DEC_REF_VAR(count) (__atomic_sub_fetch(&(count), 1, __ATOMIC_RELEASE) == 0 ? \
+    (__atomic_thread_fence(__ATOMIC_ACQUIRE), (uint32_t)0) : (uint32_t)1)
+#define INIT_REF_VAR(count) do { count = 1; __sync_synchronize(); } while((void)0,0)
+
 #elif defined(REFCOUNT_USE_GNU_C_ATOMIC)
 #define DEC_RETURN_ZERO (0)
 #define INC_REF_VAR(count) __sync_add_and_fetch(&(count), 1)
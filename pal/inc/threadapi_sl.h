@@ -0,0 +1,81 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Extensions to the ThreadAPI that are only available with
+ * threadapi_pthreads_sl.c: creating threads with explicit attributes, a
+ * process-wide default used by ThreadAPI_Create() (and so by every thread the
+ * SDK starts), and stack high-water marks for right-sizing stacks.
+ *
+ * Fields left at their ThreadAPI_Attributes_Init() value keep the platform
+ * default. A thread with a stack_size gets a stack allocated and painted by
+ * the ThreadAPI, which ThreadAPI_GetStackHighWaterMark() can measure; it is
+ * freed by ThreadAPI_Join(). The name and affinity are only applied on Linux
+ * and are ignored elsewhere.
+ *
+ * Deadlines are absolute times in milliseconds of CLOCK_MONOTONIC, so loops
+ * that sleep until one don't drift by the time their work took. A ticker
+ * wakes every period_ms from its init; ThreadAPI_Ticker_Wait() returns how
+ * many ticks were skipped because the caller was late. An event is a sleep
+ * that other threads can cut short: ThreadAPI_Event_Signal() wakes the
+ * sleeper, or makes its next sleep return at once.
+ */
+#ifndef THREADAPI_SL_H
+#define THREADAPI_SL_H
+
+#include "azure_c_shared_utility/threadapi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif /* __cplusplus */
+
+#define THREADAPI_POLICY_DEFAULT (-1)
+
+typedef struct THREADAPI_ATTRIBUTES_TAG
+{
+    size_t stack_size;          // bytes, 0 for the platform default
+    int policy;                 // SCHED_OTHER, SCHED_FIFO, ... or THREADAPI_POLICY_DEFAULT to inherit
+    int priority;               // sched_priority, used when policy isn't THREADAPI_POLICY_DEFAULT
+    const char* name;           // NULL for none, must stay valid while in the defaults
+    unsigned long affinity;     // mask of the CPUs to run on, 0 for any
+} THREADAPI_ATTRIBUTES;
+
+extern void ThreadAPI_Attributes_Init(THREADAPI_ATTRIBUTES* attributes);
+
+/* Copies attributes (NULL restores the platform defaults); not thread safe, call it before starting threads */
+extern THREADAPI_RESULT ThreadAPI_SetDefaultAttributes(const THREADAPI_ATTRIBUTES* attributes);
+extern THREADAPI_RESULT ThreadAPI_CreateWithAttributes(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg, const THREADAPI_ATTRIBUTES* attributes);
+
+/* Most stack bytes the thread has used so far; fails for threads created without a stack_size */
+extern THREADAPI_RESULT ThreadAPI_GetStackHighWaterMark(THREAD_HANDLE threadHandle, size_t* used);
+
+typedef struct THREADAPI_TICKER_TAG
+{
+    uint64_t next;              // deadline of the next tick
+    unsigned int period;
+} THREADAPI_TICKER;
+
+typedef struct THREADAPI_EVENT_TAG* THREADAPI_EVENT_HANDLE;
+
+extern uint64_t ThreadAPI_GetMonotonicTime(void);
+extern void ThreadAPI_SleepUntil(uint64_t deadline);
+
+extern void ThreadAPI_Ticker_Init(THREADAPI_TICKER* ticker, unsigned int period_ms);
+extern unsigned int ThreadAPI_Ticker_Wait(THREADAPI_TICKER* ticker);
+
+extern THREADAPI_EVENT_HANDLE ThreadAPI_Event_Create(void);
+extern void ThreadAPI_Event_Destroy(THREADAPI_EVENT_HANDLE event);
+extern THREADAPI_RESULT ThreadAPI_Event_Signal(THREADAPI_EVENT_HANDLE event);
+/* Returns 1 if signaled (clearing the signal), 0 at the deadline */
+extern int ThreadAPI_Event_SleepUntil(THREADAPI_EVENT_HANDLE event, uint64_t deadline);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* THREADAPI_SL_H */
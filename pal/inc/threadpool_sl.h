@@ -0,0 +1,56 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Fixed-size pool of worker threads, for components that offload short tasks
+ * (serialization, compression, crypto) and shouldn't pay ThreadAPI_Create()
+ * and ThreadAPI_Join() for each one.
+ *
+ * The workers are started once with ThreadAPI_Create() and take tasks from a
+ * bounded queue shared by all of them. ThreadPool_Submit() never blocks: it
+ * returns THREADPOOL_FULL when queue_size tasks are already waiting. A task
+ * submitted with a future reports its result through ThreadPool_Wait(), which
+ * blocks until the task has run and releases the future; every future must be
+ * waited on exactly once. Tasks without a future can't be waited on.
+ *
+ * ThreadPool_Destroy() runs the tasks already queued, then stops and joins the
+ * workers. Don't submit to a pool while it is being destroyed.
+ */
+#ifndef THREADPOOL_SL_H
+#define THREADPOOL_SL_H
+
+#include "azure_macro_utils/macro_utils.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#define THREADPOOL_RESULT_VALUES \
+    THREADPOOL_OK, \
+    THREADPOOL_INVALID_ARG, \
+    THREADPOOL_NO_MEMORY, \
+    THREADPOOL_FULL, \
+    THREADPOOL_ERROR
+
+MU_DEFINE_ENUM(THREADPOOL_RESULT, THREADPOOL_RESULT_VALUES);
+
+typedef struct THREADPOOL_TAG* THREADPOOL_HANDLE;
+typedef struct THREADPOOL_FUTURE_TAG* THREADPOOL_FUTURE_HANDLE;
+
+/* queue_size is rounded up to a power of two */
+extern THREADPOOL_HANDLE ThreadPool_Create(size_t thread_count, size_t queue_size);
+extern void ThreadPool_Destroy(THREADPOOL_HANDLE pool);
+
+/* future may be NULL when the result isn't needed */
+extern THREADPOOL_RESULT ThreadPool_Submit(THREADPOOL_HANDLE pool, THREAD_START_FUNC func, void* arg, THREADPOOL_FUTURE_HANDLE* future);
+extern THREADPOOL_RESULT ThreadPool_Wait(THREADPOOL_FUTURE_HANDLE future, int* res);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* THREADPOOL_SL_H */
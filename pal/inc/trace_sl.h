@@ -0,0 +1,94 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Latency tracing for the PAL hot paths. Built with PAL_TRACE defined, the
+ * TRACE_BEGIN() and TRACE_END() marks in tlsio_sl_open(), tlsio_sl_send(),
+ * HTTPAPI_ExecuteRequest() and socketio_dowork() record a timestamped event
+ * with one value (see TRACE_EVENT) into a fixed ring of TRACE_RING_SIZE
+ * records in RAM. Without it the marks compile to nothing.
+ *
+ * Recording takes no lock: a writer claims a record with one atomic add and
+ * publishes it with a sequence number, so it can be called from any thread.
+ * The ring keeps the newest records; Trace_Drain() hands the ones recorded
+ * since the last drain to an output function one line at a time, as text for
+ * the Display or a UART, or as a Chrome trace (chrome://tracing, Perfetto)
+ * for a timeline of the calls per thread. Only one thread may drain at once.
+ *
+ * Timestamps come from TRACE_TIMESTAMP(), in TRACE_TIMESTAMP_HZ units. The
+ * default reads CLOCK_MONOTONIC in microseconds; a target with a cycle
+ * counter can define both to use it instead. The counter may wrap at 32 bits
+ * as long as the trace is drained within half a wrap.
+ */
+#ifndef TRACE_SL_H
+#define TRACE_SL_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif /* __cplusplus */
+
+typedef enum TRACE_EVENT_TAG
+{
+    TRACE_EVENT_TLSIO_OPEN,         // begin 0, end result
+    TRACE_EVENT_TLSIO_SEND,         // begin bytes to send, end result
+    TRACE_EVENT_HTTPAPI_EXECUTE,    // begin content bytes, end HTTPAPI_RESULT
+    TRACE_EVENT_SOCKETIO_DOWORK,    // begin 0, end bytes received
+    TRACE_EVENT_COUNT
+} TRACE_EVENT;
+
+typedef enum TRACE_PHASE_TAG
+{
+    TRACE_PHASE_BEGIN,
+    TRACE_PHASE_END,
+    TRACE_PHASE_INSTANT
+} TRACE_PHASE;
+
+typedef enum TRACE_FORMAT_TAG
+{
+    TRACE_FORMAT_TEXT,
+    TRACE_FORMAT_CHROME
+} TRACE_FORMAT;
+
+/* Receives the drained trace one NUL terminated line at a time, without the newline */
+typedef void (*TRACE_OUTPUT_FUNCTION)(void* context, const char* line);
+
+#if defined(PAL_TRACE)
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 256     // records, a power of two
+#endif
+
+#ifndef TRACE_TIMESTAMP
+#define TRACE_TIMESTAMP() Trace_GetTimestamp()
+#define TRACE_TIMESTAMP_HZ 1000000
+extern uint32_t Trace_GetTimestamp(void);
+#endif
+
+extern void Trace_Record(TRACE_EVENT event, TRACE_PHASE phase, int32_t value);
+
+/* Returns the number of records output; records overwritten before the drain are counted as lost */
+extern size_t Trace_Drain(TRACE_FORMAT format, TRACE_OUTPUT_FUNCTION output, void* context);
+extern size_t Trace_GetLostCount(void);
+
+#define TRACE_BEGIN(event, value) Trace_Record((event), TRACE_PHASE_BEGIN, (int32_t)(value))
+#define TRACE_END(event, value) Trace_Record((event), TRACE_PHASE_END, (int32_t)(value))
+#define TRACE_INSTANT(event, value) Trace_Record((event), TRACE_PHASE_INSTANT, (int32_t)(value))
+
+#else
+
+#define TRACE_BEGIN(event, value) ((void)0)
+#define TRACE_END(event, value) ((void)0)
+#define TRACE_INSTANT(event, value) ((void)0)
+
+#endif /* PAL_TRACE */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* TRACE_SL_H */
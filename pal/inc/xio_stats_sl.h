@@ -0,0 +1,56 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+ * Operational counters kept by each socketio_sl and tlsio_sl instance. The
+ * xio interface has no getoption, so both reading and clearing them go
+ * through xio_setoption(), which reaches them through the XIO_HANDLE (or an
+ * upper layer that passes options down):
+ *
+ *     XIO_STATS stats;
+ *     XIO_STATS* const out = &stats;
+ *     xio_setoption(io, OPTION_XIO_STATS, &out);
+ *
+ * OPTION_XIO_STATS copies them to where the pointer its value points to
+ * points, so nothing is written through the const value itself.
+ * OPTION_XIO_STATS_RESET clears them (value is ignored but must not be
+ * NULL). Neither is saved by retrieveoptions. Like the rest of the xio, set
+ * them from the thread that runs DoWork.
+ */
+#ifndef XIO_STATS_SL_H
+#define XIO_STATS_SL_H
+
+#include "azure_c_shared_utility/xio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif /* __cplusplus */
+
+#define OPTION_XIO_STATS        "xio_stats"         // value is XIO_STATS* const*
+#define OPTION_XIO_STATS_RESET  "xio_stats_reset"
+
+typedef struct XIO_STATS_TAG
+{
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint32_t send_calls;            // send() calls, the ones that would have blocked included
+    uint32_t receive_calls;         // recv() calls, likewise
+    uint32_t eagain_count;          // send() and recv() calls that would have blocked
+    size_t queued_bytes;            // waiting to be sent by DoWork (socketio only, tlsio sends in place); not cleared by a reset
+    size_t queued_bytes_peak;
+    uint32_t connect_ms;            // duration of the last successful connect, name lookup included
+    uint32_t handshake_ms;          // duration of the last successful TLS handshake (tlsio only)
+    uint32_t reconnect_count;       // successful opens after the instance's first
+    int last_error;                 // errno of the last failed call, or the status getaddrinfo() or SlNetSock returned; 0 for none
+} XIO_STATS;
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* XIO_STATS_SL_H */
@@ -0,0 +1,400 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc_sl.h"
+
+#if defined(PAL_ALLOC_TRACKING)
+
+#include <pthread.h>
+
+/* The table is bookkeeping, not the PAL's memory: it comes from the C library even where gballoc
+ * measures the rest */
+static void* TableCalloc(size_t count, size_t size)
+{
+    return calloc(count, size);
+}
+
+static void TableFree(void* table)
+{
+    free(table);
+}
+
+// with GB_MEASURE_MEMORY_FOR_THIS, the malloc and free below are gballoc's
+#include "azure_c_shared_utility/gballoc.h"
+
+typedef struct ALLOC_ENTRY_TAG
+{
+    void* ptr;                  // NULL for a free entry
+    size_t size;
+    PALALLOC_MODULE module;
+} ALLOC_ENTRY;
+
+static const char* const moduleNames[PALALLOC_MODULE_COUNT] =
+{
+    "httpapi",
+    "tlsio",
+    "socketio",
+    "threadapi",
+    "threadpool",
+    "parson"
+};
+
+static ALLOC_ENTRY initialTable[PALALLOC_TABLE_SIZE];
+static ALLOC_ENTRY* table = initialTable;
+static size_t tableSize = PALALLOC_TABLE_SIZE;
+static PALALLOC_STATS moduleStats[PALALLOC_MODULE_COUNT];
+static size_t trackedCount;
+static size_t untrackedCount;
+
+static pthread_once_t lockOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t lock;
+
+static void InitLock(void)
+{
+    (void)pthread_mutex_init(&lock, NULL);
+}
+
+static void Lock(void)
+{
+    (void)pthread_once(&lockOnce, InitLock);
+    (void)pthread_mutex_lock(&lock);
+}
+
+static void Unlock(void)
+{
+    (void)pthread_mutex_unlock(&lock);
+}
+
+static size_t HomeSlot(const void* ptr)
+{
+    // blocks are at least 8 byte aligned, the low bits carry nothing
+    return (size_t)((((uintptr_t)ptr >> 3) * 2654435761u) % tableSize);
+}
+
+static int HistogramBucket(size_t size)
+{
+    int bucket = 0;
+    size_t limit = 16;
+
+    while ((bucket < PALALLOC_HISTOGRAM_BUCKETS - 1) && (size > limit))
+    {
+        bucket++;
+        limit <<= 2;
+    }
+    return bucket;
+}
+
+/* Index of ptr in the table, or of the free entry ending its probe sequence */
+static size_t FindSlot(const void* ptr)
+{
+    size_t slot = HomeSlot(ptr);
+
+    while ((table[slot].ptr != NULL) && (table[slot].ptr != ptr))
+    {
+        slot = (slot + 1) % tableSize;
+    }
+    return slot;
+}
+
+/* Forgets ptr, returns 0 if it wasn't tracked; entry may be NULL */
+static int Forget(void* ptr, ALLOC_ENTRY* entry)
+{
+    size_t slot = FindSlot(ptr);
+    size_t next;
+
+    if (table[slot].ptr == NULL)
+    {
+        return 0;
+    }
+    if (entry != NULL)
+    {
+        *entry = table[slot];
+    }
+
+    moduleStats[table[slot].module].live_count--;
+    moduleStats[table[slot].module].live_bytes -= table[slot].size;
+    trackedCount--;
+
+    // backward shift deletion: move later entries of the run into the hole when their home allows
+    table[slot].ptr = NULL;
+    next = (slot + 1) % tableSize;
+    while (table[next].ptr != NULL)
+    {
+        size_t home = HomeSlot(table[next].ptr);
+        if (((next > slot) && ((home <= slot) || (home > next))) ||
+            ((next < slot) && ((home <= slot) && (home > next))))
+        {
+            table[slot] = table[next];
+            table[next].ptr = NULL;
+            slot = next;
+        }
+        next = (next + 1) % tableSize;
+    }
+    return 1;
+}
+
+/* Doubles the table, returns 0 if there was no memory for it */
+static int Grow(void)
+{
+    ALLOC_ENTRY* oldTable = table;
+    size_t oldSize = tableSize;
+    ALLOC_ENTRY* newTable = TableCalloc(oldSize * 2, sizeof(ALLOC_ENTRY));
+    size_t i;
+
+    if (newTable == NULL)
+    {
+        return 0;
+    }
+    table = newTable;
+    tableSize = oldSize * 2;
+    for (i = 0; i < oldSize; i++)
+    {
+        if (oldTable[i].ptr != NULL)
+        {
+            table[FindSlot(oldTable[i].ptr)] = oldTable[i];
+        }
+    }
+    if (oldTable != initialTable)
+    {
+        TableFree(oldTable);
+    }
+    return 1;
+}
+
+static void Track(PALALLOC_MODULE module, void* ptr, size_t size)
+{
+    PALALLOC_STATS* stats = &moduleStats[module];
+    size_t slot = FindSlot(ptr);
+
+    if (table[slot].ptr != NULL)
+    {
+        // stale: the block was freed by code outside the PAL, and the address handed out again
+        (void)Forget(ptr, NULL);
+    }
+
+    // grow at three quarters full; without memory to grow, fill up but keep one entry free so probes end
+    if ((4 * (trackedCount + 1) > 3 * tableSize) && !Grow() && (trackedCount + 1 >= tableSize))
+    {
+        untrackedCount++;
+    }
+    else
+    {
+        slot = FindSlot(ptr);
+        table[slot].ptr = ptr;
+        table[slot].size = size;
+        table[slot].module = module;
+        trackedCount++;
+
+        stats->live_count++;
+        stats->live_bytes += size;
+        if (stats->live_bytes > stats->peak_bytes)
+        {
+            stats->peak_bytes = stats->live_bytes;
+        }
+    }
+}
+
+static void Record(PALALLOC_MODULE module, void* ptr, size_t size)
+{
+    moduleStats[module].total_count++;
+    moduleStats[module].histogram[HistogramBucket(size)]++;
+    Track(module, ptr, size);
+}
+
+void* palalloc_malloc(PALALLOC_MODULE module, size_t size)
+{
+    void* result = malloc(size);
+
+    if ((unsigned int)module < PALALLOC_MODULE_COUNT)
+    {
+        Lock();
+        if (result == NULL)
+        {
+            moduleStats[module].failed_count++;
+        }
+        else
+        {
+            Record(module, result, size);
+        }
+        Unlock();
+    }
+    return result;
+}
+
+void* palalloc_calloc(PALALLOC_MODULE module, size_t nmemb, size_t size)
+{
+    void* result = calloc(nmemb, size);
+
+    if ((unsigned int)module < PALALLOC_MODULE_COUNT)
+    {
+        Lock();
+        if (result == NULL)
+        {
+            moduleStats[module].failed_count++;
+        }
+        else
+        {
+            Record(module, result, nmemb * size);
+        }
+        Unlock();
+    }
+    return result;
+}
+
+void* palalloc_realloc(PALALLOC_MODULE module, void* ptr, size_t size)
+{
+    void* result;
+
+    if (ptr == NULL)
+    {
+        result = palalloc_malloc(module, size);
+    }
+    else if (size == 0)
+    {
+        palalloc_free(ptr);
+        result = NULL;
+    }
+    else
+    {
+        ALLOC_ENTRY old;
+        int tracked;
+
+        // forgotten before realloc frees it, as in palalloc_free(); on failure ptr is still the caller's
+        Lock();
+        tracked = Forget(ptr, &old);
+        Unlock();
+        result = realloc(ptr, size);
+        Lock();
+        if (result == NULL)
+        {
+            if (tracked)
+            {
+                Track(old.module, ptr, old.size);
+            }
+            if ((unsigned int)module < PALALLOC_MODULE_COUNT)
+            {
+                moduleStats[module].failed_count++;
+            }
+        }
+        else if ((unsigned int)module < PALALLOC_MODULE_COUNT)
+        {
+            Record(module, result, size);
+        }
+        Unlock();
+    }
+    return result;
+}
+
+void palalloc_free(void* ptr)
+{
+    if (ptr != NULL)
+    {
+        // forgotten before it's freed, so an allocation reusing the address can't be forgotten instead
+        Lock();
+        (void)Forget(ptr, NULL);
+        Unlock();
+        free(ptr);
+    }
+}
+
+int palalloc_get_stats(PALALLOC_MODULE module, PALALLOC_STATS* stats)
+{
+    if (((unsigned int)module >= PALALLOC_MODULE_COUNT) || (stats == NULL))
+    {
+        return -1;
+    }
+
+    Lock();
+    *stats = moduleStats[module];
+    Unlock();
+    return 0;
+}
+
+size_t palalloc_get_untracked_count(void)
+{
+    size_t result;
+
+    Lock();
+    result = untrackedCount;
+    Unlock();
+    return result;
+}
+
+void palalloc_reset_peaks(void)
+{
+    int i;
+
+    Lock();
+    for (i = 0; i < PALALLOC_MODULE_COUNT; i++)
+    {
+        moduleStats[i].peak_bytes = moduleStats[i].live_bytes;
+    }
+    Unlock();
+}
+
+static void Append(char* buffer, size_t size, size_t* length, const char* format, ...)
+{
+    va_list args;
+    int written;
+
+    va_start(args, format);
+    written = vsnprintf((*length < size) ? buffer + *length : NULL, (*length < size) ? size - *length : 0, format, args);
+    va_end(args);
+    if (written > 0)
+    {
+        *length += (size_t)written;
+    }
+}
+
+size_t palalloc_dump_json(char* buffer, size_t size)
+{
+    PALALLOC_STATS stats[PALALLOC_MODULE_COUNT];
+    size_t untracked;
+    size_t length = 0;
+    int i;
+    int j;
+
+    if (buffer == NULL)
+    {
+        size = 0;
+    }
+    else if (size > 0)
+    {
+        buffer[0] = '\0';
+    }
+
+    Lock();
+    (void)memcpy(stats, moduleStats, sizeof(stats));
+    untracked = untrackedCount;
+    Unlock();
+
+    Append(buffer, size, &length, "{\"untracked\":%lu,\"modules\":{", (unsigned long)untracked);
+    for (i = 0; i < PALALLOC_MODULE_COUNT; i++)
+    {
+        Append(buffer, size, &length, "%s\"%s\":{\"live_bytes\":%lu,\"peak_bytes\":%lu,\"live_count\":%lu,"
+            "\"total_count\":%lu,\"failed_count\":%lu,\"histogram\":[",
+            (i == 0) ? "" : ",", moduleNames[i],
+            (unsigned long)stats[i].live_bytes, (unsigned long)stats[i].peak_bytes, (unsigned long)stats[i].live_count,
+            (unsigned long)stats[i].total_count, (unsigned long)stats[i].failed_count);
+        for (j = 0; j < PALALLOC_HISTOGRAM_BUCKETS; j++)
+        {
+            Append(buffer, size, &length, "%s%lu", (j == 0) ? "" : ",", (unsigned long)stats[i].histogram[j]);
+        }
+        Append(buffer, size, &length, "]}");
+    }
+    Append(buffer, size, &length, "}}");
+
+    return length;
+}
+
+#else
+
+typedef int palalloc_disabled; /* ISO C doesn't allow an empty translation unit */
+
+#endif /* PAL_ALLOC_TRACKING */
@@ -0,0 +1,150 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "histogram_sl.h"
+
+#define SUB_BUCKETS (1u << HISTOGRAM_SUB_BUCKET_BITS)
+
+static unsigned int HighestBit(uint32_t value)
+{
+    unsigned int bit = 0;
+
+    while (value >>= 1)
+    {
+        bit++;
+    }
+    return bit;
+}
+
+static unsigned int BucketIndex(uint32_t value)
+{
+    unsigned int exponent;
+
+    if (value < SUB_BUCKETS)
+    {
+        return value;
+    }
+
+    exponent = HighestBit(value);
+    if (exponent >= HISTOGRAM_MAX_BITS)
+    {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+
+    // the bits below the leading one pick the sub-bucket
+    return ((exponent - HISTOGRAM_SUB_BUCKET_BITS + 1) << HISTOGRAM_SUB_BUCKET_BITS) +
+        ((value >> (exponent - HISTOGRAM_SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+}
+
+/* Largest value that falls in bucket index */
+static uint32_t BucketTop(unsigned int index)
+{
+    unsigned int shift;
+
+    if (index < SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    shift = (index >> HISTOGRAM_SUB_BUCKET_BITS) - 1;
+    return (((SUB_BUCKETS + (index & (SUB_BUCKETS - 1)) + 1) << shift) - 1);
+}
+
+void Histogram_Reset(HISTOGRAM* histogram)
+{
+    if (histogram != NULL)
+    {
+        (void)memset(histogram, 0, sizeof(*histogram));
+    }
+}
+
+void Histogram_Record(HISTOGRAM* histogram, uint32_t value)
+{
+    if ((histogram != NULL) && (histogram->count != UINT32_MAX))
+    {
+        if ((histogram->count == 0) || (value < histogram->min))
+        {
+            histogram->min = value;
+        }
+        if (value > histogram->max)
+        {
+            histogram->max = value;
+        }
+        histogram->count++;
+        histogram->sum += value;
+        histogram->buckets[BucketIndex(value)]++;
+    }
+}
+
+uint32_t Histogram_GetPercentile(const HISTOGRAM* histogram, double percentile)
+{
+    uint32_t rank;
+    uint32_t seen = 0;
+    unsigned int i;
+
+    if ((histogram == NULL) || (histogram->count == 0))
+    {
+        return 0;
+    }
+    if (percentile <= 0.0)
+    {
+        return histogram->min;
+    }
+    if (percentile >= 100.0)
+    {
+        return histogram->max;
+    }
+
+    // nearest rank, rounded up
+    rank = (uint32_t)(percentile * histogram->count / 100.0);
+    if ((double)rank * 100.0 < percentile * histogram->count)
+    {
+        rank++;
+    }
+
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+
+    if ((i >= HISTOGRAM_BUCKETS - 1) || (BucketTop(i) > histogram->max))
+    {
+        return histogram->max;
+    }
+    return (BucketTop(i) < histogram->min) ? histogram->min : BucketTop(i);
+}
+
+JSON_Value* Histogram_ToJson(const HISTOGRAM* histogram)
+{
+    JSON_Value* result;
+    JSON_Object* object;
+
+    if (histogram == NULL)
+    {
+        result = NULL;
+    }
+    else if ((result = json_value_init_object()) != NULL)
+    {
+        object = json_value_get_object(result);
+        if ((json_object_set_number(object, "count", histogram->count) != JSONSuccess) ||
+            (json_object_set_number(object, "min", histogram->min) != JSONSuccess) ||
+            (json_object_set_number(object, "mean", (histogram->count == 0) ? 0.0 : (double)histogram->sum / histogram->count) != JSONSuccess) ||
+            (json_object_set_number(object, "p50", Histogram_GetPercentile(histogram, 50.0)) != JSONSuccess) ||
+            (json_object_set_number(object, "p90", Histogram_GetPercentile(histogram, 90.0)) != JSONSuccess) ||
+            (json_object_set_number(object, "p99", Histogram_GetPercentile(histogram, 99.0)) != JSONSuccess) ||
+            (json_object_set_number(object, "max", histogram->max) != JSONSuccess))
+        {
+            json_value_free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
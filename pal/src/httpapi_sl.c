@@ -5,10 +5,13 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include <ti/net/http/httpclient.h>
 
 #include "cert_sl.h"
+#include "httpapi_timing_sl.h"
+#include "trace_sl.h"
 
 #include "azure_c_shared_utility/httpapi.h"
 #include "azure_c_shared_utility/strings.h"
@@ -16,11 +19,16 @@
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/shared_util_options.h"
 
+#define PALALLOC_THIS_MODULE PALALLOC_MODULE_HTTPAPI
+#include "alloc_sl.h"
+
 #define CONTENT_BUF_LEN     (128 * 10)
 #define HTTP_SECURE_PORT    443
 #define HEADER_TO_STR(x) (headerFieldStr[(x) & (~HTTPClient_REQUEST_HEADER_MASK)])
 
 #define OPTION_INCOMING_PROP "IncomingProperty"
+/* Replaces the Content-Type of requests with a body, e.g. "application/cbor" */
+#define OPTION_CONTENT_TYPE  "ContentType"
 
 typedef struct {
     HTTPClient_Handle cli;
@@ -28,7 +36,11 @@ typedef struct {
     char *prefixedHostName;
     char *x509Certificate;
     char *x509PrivateKey;
+    char *contentType;
     bool  isConnected;
+#if defined(PAL_HTTPAPI_TIMING)
+    HTTPAPI_TIMINGS timings;
+#endif
 } HTTPAPI_Object;
 
 struct msgProperties{
@@ -85,6 +97,14 @@ static const char * headerFieldStr[] = {
 "User-Agent",
 };
 
+static const char * phaseNames[HTTPAPI_PHASE_COUNT] = {
+"connect",
+"headers",
+"request",
+"response",
+"total",
+};
+
 static int16_t stringcasecmp (const char *s1, const char *s2)
 {
     const unsigned char *p1 = (const unsigned char *) s1;
@@ -135,6 +155,40 @@ static int splitHeader(char *headerName, char **headerValue)
     return (0);
 }
 
+/*
+ * Phase timing: timingMark() starts a request, timingRecord() records the
+ * time since the previous mark in the phase's histogram and moves the mark.
+ * Both compile to nothing without PAL_HTTPAPI_TIMING.
+ */
+static uint64_t timingMark(void)
+{
+#if defined(PAL_HTTPAPI_TIMING)
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000);
+#else
+    return (0);
+#endif
+}
+
+static void timingRecord(HTTPAPI_Object *apiH, HTTPAPI_PHASE phase,
+        uint64_t *mark)
+{
+#if defined(PAL_HTTPAPI_TIMING)
+    uint64_t now = timingMark();
+    uint64_t elapsed = now - *mark;
+
+    Histogram_Record(&apiH->timings.phases[phase],
+            (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed);
+    *mark = now;
+#else
+    (void)apiH;
+    (void)phase;
+    (void)mark;
+#endif
+}
+
 HTTPAPI_RESULT HTTPAPI_Init(void)
 {
     return (HTTPAPI_OK);
@@ -201,8 +255,15 @@ error:
 void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
 {
     HTTPAPI_Object * apiH = (HTTPAPI_Object *)handle;
+    struct msgProperties *node;
 
     if ((apiH) && (apiH->cli != NULL)) {
+        while (apiH->properties != NULL) {
+            node = apiH->properties;
+            apiH->properties = node->next;
+            free(node->key);
+            free(node);
+        }
         if (apiH->isConnected) {
             HTTPClient_disconnect(apiH->cli);
         }
@@ -215,6 +276,9 @@ void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
         if (apiH->x509PrivateKey != NULL) {
             free(apiH->x509PrivateKey);
         }
+        if (apiH->contentType != NULL) {
+            free(apiH->contentType);
+        }
         HTTPClient_destroy(apiH->cli);
     }
 
@@ -223,7 +287,7 @@ void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
     }
 }
 
-HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle,
+static HTTPAPI_RESULT executeRequest(HTTP_HANDLE handle,
         HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
         HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
         size_t contentLength, unsigned int* statusCode,
@@ -245,8 +309,11 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle,
     unsigned char *buffer = NULL;
     const char *method;
     bool moreFlag;
+    bool contentTypeSet = false;
     HTTPClient_extSecParams esParams = {NULL, NULL, SL_SSL_CA_CERT};
     struct msgProperties *props = apiH->properties;
+    uint64_t start = timingMark();
+    uint64_t mark = start;
 
     method = getHttpMethod(requestType);
 
@@ -286,6 +353,7 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle,
         }
         else {
             apiH->isConnected = true;
+            timingRecord(apiH, HTTPAPI_PHASE_CONNECT, &mark);
         }
     }
 
@@ -300,6 +368,13 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle,
         ret = splitHeader(hname, &hvalue);
 
         if (ret == 0) {
+            if (stringcasecmp(hname, "content-type") == 0) {
+                contentTypeSet = true;
+                if (apiH->contentType != NULL) {
+                    hvalue = apiH->contentType;
+                }
+            }
+
             /*
              * HOST and Content-Length headers are set by HTTPClient
              * automatically. Note that Content-Length = 0 never gets sent.
@@ -326,6 +401,17 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle,
         }
     }
 
+    if ((apiH->contentType != NULL) && (contentTypeSet == false) &&
+            (contentLength > 0)) {
+        ret = HTTPClient_setHeaderByName(cli, HTTPClient_REQUEST_HEADER_MASK,
+                "Content-Type", apiH->contentType,
+                strlen(apiH->contentType) + 1, HTTPClient_HFIELD_NOT_PERSISTENT);
+        if (ret < 0) {
+            LogError("Failed setting content type header, ret=%d", ret);
+            return (HTTPAPI_SEND_REQUEST_FAILED);
+        }
+    }
+
     /* Add custom response headers for any expected properties */
     while (props != NULL) {
         ret = HTTPClient_setHeaderByName(cli, HTTPClient_CUSTOM_RESPONSE_HEADER,
@@ -336,7 +422,13 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle,
         props = props->next;
     }
 
-    /* Send the request */
+    timingRecord(apiH, HTTPAPI_PHASE_HEADERS, &mark);
+
+    /*
+     * Send the request. This returns once the status line and headers of
+     * the response are in, so sending and the wait for the first byte are
+     * timed as one phase.
+     */
     ret = HTTPClient_sendRequest(cli, method,
             relativePath, (const char *)content, contentLength, 0);
     if (ret < 0) {
@@ -344,6 +436,8 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle,
         return (HTTPAPI_SEND_REQUEST_FAILED);
     }
 
+    timingRecord(apiH, HTTPAPI_PHASE_REQUEST, &mark);
+
     *statusCode = (unsigned int)ret;
 
     /* Get the response headers */
@@ -493,9 +587,31 @@ contentDone:
         free(contentBuf);
     }
 
+    timingRecord(apiH, HTTPAPI_PHASE_RESPONSE, &mark);
+    mark = start;
+    timingRecord(apiH, HTTPAPI_PHASE_TOTAL, &mark);
+
     return (HTTPAPI_OK);
 }
 
+HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle,
+        HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+        HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+        size_t contentLength, unsigned int* statusCode,
+        HTTP_HEADERS_HANDLE responseHeadersHandle,
+        BUFFER_HANDLE responseContent)
+{
+    HTTPAPI_RESULT result;
+
+    TRACE_BEGIN(TRACE_EVENT_HTTPAPI_EXECUTE, contentLength);
+    result = executeRequest(handle, requestType, relativePath,
+            httpHeadersHandle, content, contentLength, statusCode,
+            responseHeadersHandle, responseContent);
+    TRACE_END(TRACE_EVENT_HTTPAPI_EXECUTE, result);
+
+    return (result);
+}
+
 HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName,
         const void* value)
 {
@@ -537,6 +653,20 @@ HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName,
             result = HTTPAPI_OK;
         }
     }
+    else if (strcmp(OPTION_CONTENT_TYPE, optionName) == 0) {
+        if (apiH->contentType) {
+            free(apiH->contentType);
+        }
+
+        if (mallocAndStrcpy_s(&(apiH->contentType), value) != 0) {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("unable to allocate memory for the content type"
+                    " in HTTPAPI_SetOption");
+        }
+        else {
+            result = HTTPAPI_OK;
+        }
+    }
     else if ((strncmp(OPTION_INCOMING_PROP, optionName,
             strlen(OPTION_INCOMING_PROP)) == 0)) {
         /*
@@ -577,6 +707,24 @@ HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName,
                     " in HTTPAPI_SetOption");
         }
     }
+#if defined(PAL_HTTPAPI_TIMING)
+    else if (strcmp(OPTION_HTTPAPI_TIMINGS, optionName) == 0) {
+        HTTPAPI_TIMINGS *timings = *(HTTPAPI_TIMINGS * const *)value;
+
+        if (timings == NULL) {
+            result = HTTPAPI_INVALID_ARG;
+            LogError("invalid parameter detected: timings=NULL");
+        }
+        else {
+            *timings = apiH->timings;
+            result = HTTPAPI_OK;
+        }
+    }
+    else if (strcmp(OPTION_HTTPAPI_TIMINGS_RESET, optionName) == 0) {
+        memset(&apiH->timings, 0, sizeof(HTTPAPI_TIMINGS));
+        result = HTTPAPI_OK;
+    }
+#endif
     else {
         result = HTTPAPI_INVALID_ARG;
         LogError("unknown option %s", optionName);
@@ -600,6 +748,7 @@ HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value,
             (strcmp(SU_OPTION_X509_CERT, optionName) == 0) ||
             (strcmp(OPTION_X509_ECC_KEY, optionName) == 0) ||
             (strcmp(SU_OPTION_X509_PRIVATE_KEY, optionName) == 0) ||
+            (strcmp(OPTION_CONTENT_TYPE, optionName) == 0) ||
             (strncmp(OPTION_INCOMING_PROP, optionName,
                     strlen(OPTION_INCOMING_PROP)) == 0)) {
         if (mallocAndStrcpy_s(&temp, value) != 0) {
@@ -611,6 +760,18 @@ HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value,
             result = HTTPAPI_OK;
         }
     }
+#if defined(PAL_HTTPAPI_TIMING)
+    else if ((strcmp(OPTION_HTTPAPI_TIMINGS, optionName) == 0) ||
+            (strcmp(OPTION_HTTPAPI_TIMINGS_RESET, optionName) == 0)) {
+        /*
+         * Not saved: the HTTPAPIEX replays saved options on every handle it
+         * opens, which would clear the timings at each reconnect, or copy
+         * them to a pointer the caller no longer owns.
+         */
+        result = HTTPAPI_INVALID_ARG;
+        LogError("%s can't be saved, set it on the HTTP_HANDLE", optionName);
+    }
+#endif
     else {
         result = HTTPAPI_INVALID_ARG;
         LogError("unknown option %s", optionName);
@@ -618,3 +779,28 @@ HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value,
 
     return (result);
 }
+
+JSON_Value* HTTPAPI_Timings_ToJson(const HTTPAPI_TIMINGS* timings)
+{
+    JSON_Value *result;
+    JSON_Value *phase;
+    int i;
+
+    if (timings == NULL) {
+        return (NULL);
+    }
+
+    result = json_value_init_object();
+    for (i = 0; (result != NULL) && (i < HTTPAPI_PHASE_COUNT); i++) {
+        phase = Histogram_ToJson(&timings->phases[i]);
+        if ((phase == NULL) ||
+                (json_object_set_value(json_value_get_object(result),
+                phaseNames[i], phase) != JSONSuccess)) {
+            json_value_free(phase);
+            json_value_free(result);
+            result = NULL;
+        }
+    }
+
+    return (result);
+}
@@ -32,14 +32,19 @@
 #endif /* _CRT_SECURE_NO_WARNINGS */
 #endif /* _MSC_VER */
 
-#include "parson.h"
+#include "parson_sl.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 #include <math.h>
-#include <errno.h>
+#include <stdint.h>
+
+#if defined(PAL_ALLOC_TRACKING)
+#include "alloc_sl.h" /* defaults the allocators to the PAL's accounting */
+#endif
 
 /* Apparently sscanf is not implemented in some "standard" libraries, so don't use it, if you
  * don't have to. */
@@ -51,13 +56,25 @@
 #define FLOAT_FORMAT "%1.17g" /* do not increase precision without incresing NUM_BUF_SIZE */
 #define NUM_BUF_SIZE 64 /* double printed with "%1.17g" shouldn't be longer than 25 bytes so let's be paranoid and use 64 */
 
+#define MAX_MANTISSA_DIGITS 19 /* decimal digits that always fit in an uint64_t */
+#define MAX_EXACT_MANTISSA  ((uint64_t)1 << 53) /* largest integer a double holds exactly */
+#define MAX_EXACT_POW10     22 /* largest power of 10 a double holds exactly */
+#define DECIMAL_MAX_DIGITS  800 /* more than the 767 significant digits of the longest halfway case */
+#define DECIMAL_MAX_SHIFT   60  /* largest shift that leaves room for * 10 in an uint64_t */
+#define CACHED_POW10_MIN    -348 /* decimal exponent of the first power of 10 in approximate_decimal */
+#define CACHED_POW10_STEP   8
+#define CACHED_POW10_COUNT  87
+
 #define SIZEOF_TOKEN(a)       (sizeof(a) - 1)
 #define SKIP_CHAR(str)        ((*str)++)
-#define SKIP_WHITESPACES(str) while (isspace((unsigned char)(**str))) { SKIP_CHAR(str); }
+#define SKIP_WHITESPACES(str, end) (*(str) = skip_whitespaces(*(str), (end)))
 #define MAX(a, b)             ((a) > (b) ? (a) : (b))
+#define MIN(a, b)             ((a) < (b) ? (a) : (b))
+#define MAY_ESCAPE(c)         ((unsigned char)(c) < 0x20 || (c) == '\"' || (c) == '\\' || (c) == '/') /* see json_escape_char() */
 
 #undef malloc
 #undef free
+#undef realloc
 
 #if defined(isnan) && defined(isinf)
 #define IS_NUMBER_INVALID(x) (isnan((x)) || isinf((x)))
@@ -65,17 +82,71 @@
 #define IS_NUMBER_INVALID(x) (((x) * 0.0) != 0.0)
 #endif
 
+/* Scanners for runs of plain bytes (see the Various section). Define PARSON_NO_SIMD to use the
+ * word-at-a-time versions everywhere. */
+#if !defined(PARSON_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define PARSON_SSE2
+#include <emmintrin.h>
+#elif !defined(PARSON_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__GNUC__)
+#define PARSON_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && defined(PARSON_SSE2)
+#include <intrin.h>
+static unsigned int parson_ctz(unsigned int x) { unsigned long i; _BitScanForward(&i, x); return (unsigned int)i; }
+#elif defined(PARSON_SSE2) || defined(PARSON_NEON)
+#define parson_ctz(x) ((unsigned int)__builtin_ctzll(x))
+#endif
+
+#if UINTPTR_MAX > 0xFFFFFFFFu
+typedef uint64_t parson_word;
+#else
+typedef uint32_t parson_word;
+#endif
+#define WORD_ONES   ((parson_word)-1 / 0xFF)  /* 0x0101... */
+#define WORD_HIGHS  (WORD_ONES * 0x80)         /* 0x8080... */
+#define WORD_HAS_ZERO(w)     (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+#define WORD_HAS_BYTE(w, b)  WORD_HAS_ZERO((w) ^ (WORD_ONES * (b)))
+#define WORD_HAS_LESS(w, n)  (((w) - WORD_ONES * (n)) & ~(w) & WORD_HIGHS) /* n <= 128 */
+
+#if defined(PAL_ALLOC_TRACKING)
+static void * parson_tracked_malloc(size_t size) { return palalloc_malloc(PALALLOC_MODULE_PARSON, size); }
+static void * parson_tracked_realloc(void *ptr, size_t size) { return palalloc_realloc(PALALLOC_MODULE_PARSON, ptr, size); }
+static JSON_Malloc_Function parson_malloc = parson_tracked_malloc;
+static JSON_Free_Function parson_free = palalloc_free;
+static JSON_Realloc_Function parson_realloc = parson_tracked_realloc; /* NULL: grow by copying */
+#else
 static JSON_Malloc_Function parson_malloc = malloc;
 static JSON_Free_Function parson_free = free;
+static JSON_Realloc_Function parson_realloc = realloc; /* NULL: grow by copying */
+#endif
 
 static int parson_escape_slashes = 1;
+static int parson_parse_int64 = 0;
+static int parson_intern_keys = 0;
+static size_t parson_max_nesting = MAX_NESTING;
+
+#define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
 
-#define IS_CONT(b) (((unsigned char)(b) & 0xC0) == 0x80) /* is utf-8 continuation byte */
+/* Numbers created with json_value_init_int64 (or parsed with int64 parsing enabled) keep all 64 bits.
+ * They are still reported as JSONNumber by the public API. */
+#define JSONInteger (JSONNumber | 0x100)
+/* Strings short enough to fit in the value's union, see json_value_alloc_string */
+#define JSONShortString (JSONString | 0x100)
+#define SHORT_STRING_MAX_LEN (sizeof(JSON_Value_Value) - 1)
+#define STRING_BUFFER(v) ((v)->type == JSONShortString ? (v)->value.short_string : (v)->value.string)
+
+/* Booleans and null are shared, read-only values. Their parent is always NULL and freeing them does nothing. */
+#define IS_SHARED_VALUE(v) ((v) == &parson_true || (v) == &parson_false || (v) == &parson_null)
+#define SET_PARENT(v, p) do { if (!IS_SHARED_VALUE(v)) { (v)->parent = (p); } } while (0)
 
 /* Type definitions */
 typedef union json_value_value {
     char        *string;
+    char         short_string[sizeof(double)];
     double       number;
+    int64_t      integer;
     JSON_Object *object;
     JSON_Array  *array;
     int          boolean;
@@ -88,12 +159,49 @@ struct json_value_t {
     JSON_Value_Value value;
 };
 
+/* Objects and arrays are allocated in the same block as their wrapping value */
+typedef struct json_object_cell_t {
+    char          *name;
+    unsigned long  hash;     /* hash_string() of the name, bit 0 set if the name is interned */
+    JSON_Value    *value;
+} JSON_Object_Cell;
+
+#define CELL_HASH(cell)        ((cell)->hash & ~(unsigned long)1)
+#define CELL_IS_INTERNED(cell) ((cell)->hash & 1)
+
+/* Interned names are shared by every object using them and freed with the last one. The name's
+ * characters follow the entry, so a name pointer leads back to its entry. */
+typedef struct json_key_t {
+    struct json_key_t *next;
+    unsigned long      hash;
+    size_t             refcount;
+    size_t             len;
+} JSON_Key;
+
+#define KEY_OF_NAME(name) ((JSON_Key*)(name) - 1)
+
+static JSON_Key **parson_keys = NULL; /* hash table buckets, allocated while keys exist */
+static size_t     parson_keys_capacity = 0;
+static size_t     parson_keys_count = 0;
+
+/* Changes since the last json_object_clear_changes, kept by objects with tracking enabled */
+typedef struct json_changes_t {
+    unsigned char *dirty;             /* one flag per cell (same capacity as cells): member set or modified */
+    char         **removed;           /* names removed */
+    size_t         removed_count;
+    size_t         removed_capacity;
+    JSON_Value    *previous;          /* objects replaced or removed, by name, to null their members in the patch */
+    int            pending;           /* anything changed here or in a tracked descendant */
+} JSON_Changes;
+
+static size_t parson_tracked_objects = 0; /* skip change notifications while nothing is tracked */
+
 struct json_object_t {
-    JSON_Value  *wrapping_value;
-    char       **names;
-    JSON_Value **values;
-    size_t       count;
-    size_t       capacity;
+    JSON_Value       *wrapping_value;
+    JSON_Object_Cell *cells;
+    JSON_Changes     *changes;        /* NULL unless tracking changes */
+    size_t            count;
+    size_t            capacity;
 };
 
 struct json_array_t {
@@ -103,6 +211,146 @@ struct json_array_t {
     size_t       capacity;
 };
 
+/* Free lists of the fixed size blocks: plain values (numbers and short strings), values with their
+ * object and values with their array. Blocks on a list are linked through their first bytes. */
+typedef struct json_pool_node_t {
+    struct json_pool_node_t *next;
+} JSON_Pool_Node;
+
+typedef struct json_pool_t {
+    JSON_Pool_Node *free_list;
+    size_t          size;       /* block size */
+    size_t          max_free;   /* 0 disables the pool */
+    JSON_Pool_Stats stats;
+} JSON_Pool;
+
+static JSON_Pool parson_pools[] = {
+    { NULL, sizeof(JSON_Value),                       0, { 0, 0, 0, 0 } }, /* JSONPoolValue */
+    { NULL, sizeof(JSON_Value) + sizeof(JSON_Object), 0, { 0, 0, 0, 0 } }, /* JSONPoolObject */
+    { NULL, sizeof(JSON_Value) + sizeof(JSON_Array),  0, { 0, 0, 0, 0 } }, /* JSONPoolArray */
+};
+
+#define POOL_COUNT (sizeof(parson_pools) / sizeof(parson_pools[0]))
+
+static JSON_Value parson_true  = { NULL, JSONBoolean, { .boolean = 1 } };
+static JSON_Value parson_false = { NULL, JSONBoolean, { .boolean = 0 } };
+static JSON_Value parson_null  = { NULL, JSONNull,    { .null = 0 } };
+
+typedef enum json_reader_state {
+    READER_STATE_VALUE,         /* root value, value after ':' or array element after ',' */
+    READER_STATE_VALUE_OR_END,  /* first array element or ']' */
+    READER_STATE_KEY,           /* name after ',' in an object */
+    READER_STATE_KEY_OR_END,    /* first name of an object or '}' */
+    READER_STATE_COLON,
+    READER_STATE_COMMA_OR_END,
+    READER_STATE_DONE,
+    READER_STATE_ERROR
+} JSON_Reader_State;
+
+typedef enum json_reader_token {
+    READER_TOKEN_NONE,
+    READER_TOKEN_KEY,
+    READER_TOKEN_STRING,
+    READER_TOKEN_NUMBER,
+    READER_TOKEN_LITERAL
+} JSON_Reader_Token;
+
+struct json_reader_t {
+    const char        *input;          /* unread part of the current chunk */
+    size_t             input_len;
+    int                input_finished;
+    size_t             position;       /* bytes consumed so far, used to skip a BOM */
+    JSON_Reader_State  state;
+    JSON_Reader_Token  token;          /* token spanning chunks */
+    int                escaped;
+    char              *token_buf;      /* raw, then processed, token; always NUL terminated */
+    size_t             token_len;
+    size_t             max_token_len;
+    unsigned char     *stack;          /* 1 for objects, 0 for arrays */
+    size_t             depth;
+    size_t             max_depth;
+    double             number;
+    int64_t            integer;
+    int                is_integer;
+    int                boolean;
+};
+
+typedef struct json_path_segment_t {
+    const char    *name;   /* NUL terminated, points into the path's copy of the string */
+    size_t         len;
+    unsigned long  hash;
+} JSON_Path_Segment;
+
+struct json_path_t {
+    JSON_Path_Segment *segments;
+    size_t             count;
+};
+
+/* A compiled schema is its tree flattened in preorder: a node's members or item schema follow it
+ * and next skips its whole subtree. */
+typedef struct json_schema_node_t {
+    const char      *name;   /* member name if the parent is an object, points into the schema's block */
+    size_t           name_len;
+    unsigned long    hash;
+    JSON_Value_Type  type;   /* JSONNull matches any value */
+    size_t           count;  /* members of an object schema, 0 or 1 item schema for an array */
+    size_t           next;   /* index of the node after this subtree */
+} JSON_Schema_Node;
+
+struct json_schema_t {
+    JSON_Schema_Node *nodes;
+    size_t            count;
+};
+
+/* Explicit stack of the iterative tree walks, kept on the C stack for the first WALK_INLINE_DEPTH
+ * levels and moved to the heap beyond */
+#define WALK_INLINE_DEPTH 16
+#define WALK_INDEFINITE   ((size_t)-1) /* items left in a CBOR indefinite length container */
+
+typedef struct json_walk_frame_t {
+    const JSON_Value *container;
+    size_t            index;     /* next member or item, or items left when parsing */
+} JSON_Walk_Frame;
+
+typedef struct json_walk_t {
+    JSON_Walk_Frame *frames;
+    size_t           depth;
+    size_t           capacity;
+    JSON_Walk_Frame  inline_frames[WALK_INLINE_DEPTH];
+} JSON_Walk;
+
+/* Sink of the streaming serializer: output is staged in chunk and handed to write when it fills */
+typedef struct json_writer_t {
+    JSON_Write_Function write;
+    void               *context;
+    char               *chunk;
+    size_t              chunk_size;
+    size_t              used;
+    JSON_Status         status;   /* JSONFailure once write failed, later output is dropped */
+} JSON_Writer;
+
+/* Binary encodings share the tree walks, only item heads differ (see Binary serialization) */
+typedef enum json_binary_format {
+    BINARY_CBOR,
+    BINARY_MSGPACK
+} JSON_Binary_Format;
+
+typedef enum json_binary_kind {
+    BINARY_UINT,      /* n */
+    BINARY_NEGINT,    /* -1 - n */
+    BINARY_FLOAT,
+    BINARY_STRING,    /* n bytes follow */
+    BINARY_ARRAY,     /* n items follow */
+    BINARY_MAP,       /* n name/value pairs follow */
+    BINARY_TRUE,
+    BINARY_FALSE,
+    BINARY_NULL,
+    BINARY_TAG,       /* CBOR tag of the next item, ignored */
+    BINARY_BREAK      /* end of a CBOR indefinite length array or map */
+} JSON_Binary_Kind;
+
+#define BINARY_INDEFINITE UINT64_MAX /* n of CBOR indefinite length arrays and maps */
+
 /* Various */
 #ifdef PARSON_FILES
 static char * read_file(const char *filename);
@@ -110,52 +358,237 @@ static char * read_file(const char *filename);
 static void   remove_comments(char *string, const char *start_token, const char *end_token);
 static char * parson_strndup(const char *string, size_t n);
 static char * parson_strdup(const char *string);
-static int    hex_char_to_int(char c);
 static int    parse_utf16_hex(const char *string, unsigned int *result);
-static int    num_bytes_in_utf8_sequence(unsigned char c);
-static int    verify_utf8_sequence(const unsigned char *string, int *len);
 static int    is_valid_utf8(const char *string, size_t string_len);
-static int    is_decimal(const char *string, size_t length);
+static size_t parse_number(const char *string, size_t max_len, double *number, int64_t *integer, int *is_integer);
+static int    approximate_decimal(uint64_t mantissa, long exponent10, double *number);
+static int    decimal_to_double(const char *string, size_t length, double *number);
+static int    int64_to_string(int64_t number, char *buf);
+static unsigned long hash_string(const char *string, size_t n);
+static int           key_equals(const char *key, const char *name, size_t name_len);
+static char * intern_key(const char *name, size_t name_len, unsigned long hash);
+static void   release_key(char *name);
+static char * copy_key(const char *name, size_t name_len, unsigned long hash, unsigned long *cell_hash);
+static void   free_key(const JSON_Object_Cell *cell);
+static const char * skip_whitespaces(const char *string, const char *end);
+static const char * scan_string_body(const char *string, const char *end);
+static size_t count_unescaped(const char *string, size_t len);
+static size_t count_ascii(const char *string, size_t len);
 
 /* JSON Object */
-static JSON_Object * json_object_init(JSON_Value *wrapping_value);
-static JSON_Status   json_object_add(JSON_Object *object, const char *name, JSON_Value *value);
+static void          json_object_init(JSON_Object *object, JSON_Value *wrapping_value);
 static JSON_Status   json_object_addn(JSON_Object *object, const char *name, size_t name_len, JSON_Value *value);
+static JSON_Status   json_object_addn_hashed(JSON_Object *object, const char *name, size_t name_len, unsigned long hash, JSON_Value *value);
+static JSON_Status   json_object_add_cell(JSON_Object *object, char *name, unsigned long hash, JSON_Value *value);
 static JSON_Status   json_object_resize(JSON_Object *object, size_t new_capacity);
+static size_t        json_object_find(const JSON_Object *object, const char *name, size_t name_len, unsigned long hash);
 static JSON_Value  * json_object_getn_value(const JSON_Object *object, const char *name, size_t name_len);
+static JSON_Status   json_object_setn_value_hashed(JSON_Object *object, const char *name, size_t name_len, unsigned long hash, JSON_Value *value);
 static JSON_Status   json_object_remove_internal(JSON_Object *object, const char *name, int free_value);
 static JSON_Status   json_object_dotremove_internal(JSON_Object *object, const char *name, int free_value);
 static void          json_object_free(JSON_Object *object);
 
+/* Change tracking */
+static JSON_Status   json_object_track(JSON_Object *object);
+static void          json_object_untrack(JSON_Object *object);
+static void          json_object_mark_dirty(JSON_Object *object, size_t index);
+static void          json_object_set_pending(JSON_Object *object);
+static void          json_object_note_removed(JSON_Object *object, const char *name);
+static void          json_object_note_added(JSON_Object *object, size_t index);
+static void          json_object_free_value(JSON_Object *object, const char *name, JSON_Value *value);
+static JSON_Value *  json_object_replacement_patch(const JSON_Object *previous, const JSON_Object *object);
+static void          json_value_note_change(JSON_Value *container);
+
 /* JSON Array */
-static JSON_Array * json_array_init(JSON_Value *wrapping_value);
+static void         json_array_init(JSON_Array *array, JSON_Value *wrapping_value);
 static JSON_Status  json_array_add(JSON_Array *array, JSON_Value *value);
 static JSON_Status  json_array_resize(JSON_Array *array, size_t new_capacity);
 static void         json_array_free(JSON_Array *array);
 
 /* JSON Value */
-static JSON_Value * json_value_init_string_no_copy(char *string);
+static JSON_Value * json_value_alloc_string(size_t len);
+static JSON_Value * json_value_init_string_n(const char *string, size_t len);
 
 /* Parser */
-static JSON_Status  skip_quotes(const char **string);
+static JSON_Status  skip_quotes(const char **string, const char *end);
 static int          parse_utf16(const char **unprocessed, char **processed);
+static int          unescape_string(const char *input, size_t len, char *output, size_t *output_len);
 static char *       process_string(const char *input, size_t len);
-static char *       get_quoted_string(const char **string);
-static JSON_Value * parse_object_value(const char **string, size_t nesting);
-static JSON_Value * parse_array_value(const char **string, size_t nesting);
-static JSON_Value * parse_string_value(const char **string);
+static char *       get_quoted_string(const char **string, const char *end);
+static char *       parse_member_name(const char **string, const char *end, size_t *name_len);
+static JSON_Status  parse_add_member(JSON_Object *object, char *name, size_t name_len, JSON_Value *value);
+static JSON_Status  parse_close_container(JSON_Value *container);
+static JSON_Value * parse_string_value(const char **string, const char *end);
 static JSON_Value * parse_boolean_value(const char **string);
 static JSON_Value * parse_number_value(const char **string);
 static JSON_Value * parse_null_value(const char **string);
-static JSON_Value * parse_value(const char **string, size_t nesting);
+static JSON_Value * parse_value(const char **string, const char *end);
 
 /* Serialization */
-static int    json_serialize_to_buffer_r(const JSON_Value *value, char *buf, int level, int is_pretty, char *num_buf);
+static size_t json_serialize_to_buffer_r(const JSON_Value *value, char *buf, int is_pretty, char *num_buf);
+static size_t json_serialize_walk(JSON_Walk *walk, const JSON_Value *value, char *buf, int is_pretty, char *num_buf);
+static int    add_written(size_t *written_total, int written);
+static int    json_serialize_scalar(const JSON_Value *value, char *buf, char *num_buf);
 static int    json_serialize_string(const char *string, char *buf);
-static int    append_indent(char *buf, int level);
+static const char * json_escape_char(char c);
+static int    append_indent(char *buf, size_t level);
 static int    append_string(char *buf, const char *string);
 
+/* Streaming serialization */
+static void        writer_flush(JSON_Writer *writer);
+static void        writer_put(JSON_Writer *writer, const char *data, size_t len);
+static void        writer_put_indent(JSON_Writer *writer, size_t level);
+static void        writer_put_string(JSON_Writer *writer, const char *string);
+static void        writer_put_scalar(JSON_Writer *writer, const JSON_Value *value);
+static JSON_Status json_serialize_writer_walk(JSON_Walk *walk, const JSON_Value *value, JSON_Writer *writer, int is_pretty);
+static JSON_Status json_serialize_to_writer_r(const JSON_Value *value, char *chunk, size_t chunk_size,
+                                              JSON_Write_Function write_fun, void *context, int is_pretty);
+
+/* Binary serialization */
+static int          binary_put_uint(unsigned char *buf, unsigned char prefix, uint64_t n, int size);
+static int          binary_put_head(unsigned char *buf, JSON_Binary_Format format, JSON_Binary_Kind kind, uint64_t n);
+static int          binary_put_number(unsigned char *buf, JSON_Binary_Format format, const JSON_Value *value);
+static int          binary_put_string(unsigned char *buf, JSON_Binary_Format format, const char *string);
+static int          binary_put_scalar(unsigned char *buf, JSON_Binary_Format format, const JSON_Value *value);
+static int          json_serialize_to_binary_r(const JSON_Value *value, unsigned char *buf, JSON_Binary_Format format);
+static int          json_serialize_binary_walk(JSON_Walk *walk, const JSON_Value *value, unsigned char *buf, JSON_Binary_Format format);
+static uint64_t     binary_get_uint(const unsigned char *data, int size);
+static JSON_Status  binary_read_head(const unsigned char **data, const unsigned char *end, JSON_Binary_Format format,
+                                     JSON_Binary_Kind *kind, uint64_t *n, double *number);
+static JSON_Value * parse_binary_item(const unsigned char **data, const unsigned char *end, JSON_Binary_Kind kind, uint64_t n, double number);
+static JSON_Value * parse_binary_value(const unsigned char **data, const unsigned char *end, JSON_Binary_Format format);
+static JSON_Value * parse_binary_walk(JSON_Walk *walk, const unsigned char **data, const unsigned char *end, JSON_Binary_Format format);
+static size_t       json_binary_size(const JSON_Value *value, JSON_Binary_Format format);
+static JSON_Status  json_serialize_to_binary(const JSON_Value *value, void *buf, size_t buf_size_in_bytes, JSON_Binary_Format format);
+static JSON_Value * json_parse_binary(const void *data, size_t size, JSON_Binary_Format format);
+
+/* Views */
+static const char * view_skip_whitespaces(const char *text, const char *end);
+static const char * view_skip_string(const char *text, const char *end);
+static const char * view_skip_value(const char *text, const char *end);
+static const char * view_find_member(const char *text, const char *end, const char *name, size_t name_len);
+static int          view_next_char(const char **raw, const char *end, char *out);
+static int          view_key_equals(const char *raw, const char *raw_end, const char *name, size_t name_len);
+static JSON_Status  view_init(JSON_View *view, const char *text, const char *end);
+
+/* Compiled schemas */
+static void         schema_measure(const JSON_Value *schema, size_t *node_count, size_t *names_size);
+static size_t       schema_compile_node(JSON_Schema *compiled, size_t index, char **names, const JSON_Value *schema);
+static JSON_Status  schema_validate_node(const JSON_Schema *compiled, size_t index, const JSON_Value *value);
+
+/* Streaming reader */
+static JSON_Reader_Event reader_fail(JSON_Reader *reader);
+static JSON_Reader_Event reader_value_done(JSON_Reader *reader, JSON_Reader_Event event);
+static JSON_Reader_Event reader_push(JSON_Reader *reader, unsigned char is_object);
+static JSON_Reader_Event reader_pop(JSON_Reader *reader, unsigned char is_object);
+static JSON_Reader_Event reader_continue_token(JSON_Reader *reader);
+
 /* Various */
+static void walk_init(JSON_Walk *walk) {
+    walk->frames = walk->inline_frames;
+    walk->depth = 0;
+    walk->capacity = WALK_INLINE_DEPTH;
+}
+
+static JSON_Walk_Frame * walk_push(JSON_Walk *walk, const JSON_Value *container, size_t index) {
+    JSON_Walk_Frame *new_frames = NULL;
+    if (walk->depth >= walk->capacity) {
+        new_frames = (JSON_Walk_Frame*)parson_malloc(walk->capacity * 2 * sizeof(JSON_Walk_Frame));
+        if (new_frames == NULL) {
+            return NULL;
+        }
+        memcpy(new_frames, walk->frames, walk->depth * sizeof(JSON_Walk_Frame));
+        if (walk->frames != walk->inline_frames) {
+            parson_free(walk->frames);
+        }
+        walk->frames = new_frames;
+        walk->capacity *= 2;
+    }
+    walk->frames[walk->depth].container = container;
+    walk->frames[walk->depth].index = index;
+    return &walk->frames[walk->depth++];
+}
+
+static void walk_free(JSON_Walk *walk) {
+    if (walk->frames != walk->inline_frames) {
+        parson_free(walk->frames);
+    }
+}
+
+static void * pool_alloc(JSON_Pool_Kind kind) {
+    JSON_Pool *pool = &parson_pools[kind];
+    JSON_Pool_Node *node = pool->free_list;
+    if (node == NULL) {
+        pool->stats.misses++;
+        return parson_malloc(pool->size);
+    }
+    pool->free_list = node->next;
+    pool->stats.free_count--;
+    pool->stats.hits++;
+    return node;
+}
+
+static void pool_free(JSON_Pool_Kind kind, void *block) {
+    JSON_Pool *pool = &parson_pools[kind];
+    JSON_Pool_Node *node = (JSON_Pool_Node*)block;
+    if (pool->stats.free_count >= pool->max_free) {
+        parson_free(block);
+        return;
+    }
+    node->next = pool->free_list;
+    pool->free_list = node;
+    pool->stats.free_count++;
+    if (pool->stats.free_count > pool->stats.high_water) {
+        pool->stats.high_water = pool->stats.free_count;
+    }
+}
+
+/* Returns free blocks to the allocator until at most max_free are left */
+static void pool_trim(JSON_Pool *pool, size_t max_free) {
+    JSON_Pool_Node *node = NULL;
+    while (pool->stats.free_count > max_free) {
+        node = pool->free_list;
+        pool->free_list = node->next;
+        pool->stats.free_count--;
+        parson_free(node);
+    }
+}
+
+/* Frees a value's block, not its contents */
+static void json_value_release(JSON_Value *value) {
+    switch (value->type) {
+        case JSONObject:
+            pool_free(JSONPoolObject, value);
+            break;
+        case JSONArray:
+            pool_free(JSONPoolArray, value);
+            break;
+        case JSONString: /* long strings are stored in the value's block */
+            parson_free(value);
+            break;
+        default:
+            pool_free(JSONPoolValue, value);
+            break;
+    }
+}
+
+/* Resizes a block whose first used_size bytes are in use, in place if the allocator can */
+static void * parson_resize(void *block, size_t used_size, size_t new_size) {
+    void *new_block = NULL;
+    if (parson_realloc != NULL) {
+        return parson_realloc(block, new_size);
+    }
+    new_block = parson_malloc(new_size);
+    if (new_block == NULL) {
+        return NULL;
+    }
+    if (block != NULL && used_size > 0) {
+        memcpy(new_block, block, MIN(used_size, new_size));
+    }
+    parson_free(block);
+    return new_block;
+}
+
 static char * parson_strndup(const char *string, size_t n) {
     char *output_string = (char*)parson_malloc(n + 1);
     if (!output_string) {
@@ -170,115 +603,844 @@ static char * parson_strdup(const char *string) {
     return parson_strndup(string, strlen(string));
 }
 
-static int hex_char_to_int(char c) {
-    if (c >= '0' && c <= '9') {
-        return c - '0';
-    } else if (c >= 'a' && c <= 'f') {
-        return c - 'a' + 10;
-    } else if (c >= 'A' && c <= 'F') {
-        return c - 'A' + 10;
+/* djb2 */
+static unsigned long hash_string(const char *string, size_t n) {
+    unsigned long hash = 5381;
+    size_t i;
+    for (i = 0; i < n; i++) {
+        hash = ((hash << 5) + hash) + (unsigned char)string[i];
+    }
+    return hash & ~(unsigned long)1; /* bit 0 is the cell's interned flag */
+}
+
+/* Whether the stored key is name[0..name_len). Nothing past the key's terminator is read, the key
+ * may be shorter than name_len when only the hashes matched. */
+static int key_equals(const char *key, const char *name, size_t name_len) {
+    size_t i;
+    for (i = 0; i < name_len; i++) {
+        if (key[i] != name[i] || key[i] == '\0') {
+            return 0;
+        }
+    }
+    return key[name_len] == '\0';
+}
+
+/* Returns the shared copy of name, creating it if needed. The caller owns one reference. */
+static char * intern_key(const char *name, size_t name_len, unsigned long hash) {
+    JSON_Key *key = NULL, *next = NULL, **buckets = NULL;
+    size_t i = 0, capacity = 0;
+    if (parson_keys_count >= parson_keys_capacity) {
+        capacity = MAX(parson_keys_capacity * 2, STARTING_CAPACITY * 4);
+        buckets = (JSON_Key**)parson_malloc(capacity * sizeof(JSON_Key*));
+        if (buckets == NULL) {
+            return NULL;
+        }
+        memset(buckets, 0, capacity * sizeof(JSON_Key*));
+        for (i = 0; i < parson_keys_capacity; i++) {
+            for (key = parson_keys[i]; key != NULL; key = next) {
+                next = key->next;
+                key->next = buckets[(key->hash >> 1) & (capacity - 1)];
+                buckets[(key->hash >> 1) & (capacity - 1)] = key;
+            }
+        }
+        parson_free(parson_keys);
+        parson_keys = buckets;
+        parson_keys_capacity = capacity;
+    }
+    for (key = parson_keys[(hash >> 1) & (parson_keys_capacity - 1)]; key != NULL; key = key->next) {
+        if (key->hash == hash && key->len == name_len && memcmp(key + 1, name, name_len) == 0) {
+            key->refcount++;
+            return (char*)(key + 1);
+        }
+    }
+    key = (JSON_Key*)parson_malloc(sizeof(JSON_Key) + name_len + 1);
+    if (key == NULL) {
+        return NULL;
+    }
+    key->hash = hash;
+    key->refcount = 1;
+    key->len = name_len;
+    memcpy(key + 1, name, name_len);
+    ((char*)(key + 1))[name_len] = '\0';
+    key->next = parson_keys[(hash >> 1) & (parson_keys_capacity - 1)];
+    parson_keys[(hash >> 1) & (parson_keys_capacity - 1)] = key;
+    parson_keys_count++;
+    return (char*)(key + 1);
+}
+
+static void release_key(char *name) {
+    JSON_Key *key = KEY_OF_NAME(name), **link = NULL;
+    if (--key->refcount > 0) {
+        return;
+    }
+    for (link = &parson_keys[(key->hash >> 1) & (parson_keys_capacity - 1)]; *link != key; link = &(*link)->next) {
+    }
+    *link = key->next;
+    parson_free(key);
+    if (--parson_keys_count == 0) { /* don't keep the table around without keys */
+        parson_free(parson_keys);
+        parson_keys = NULL;
+        parson_keys_capacity = 0;
+    }
+}
+
+/* Copies a member name, interned if enabled. cell_hash receives the hash to store in the cell. */
+static char * copy_key(const char *name, size_t name_len, unsigned long hash, unsigned long *cell_hash) {
+    if (parson_intern_keys) {
+        *cell_hash = hash | 1;
+        return intern_key(name, name_len, hash);
+    }
+    *cell_hash = hash;
+    return parson_strndup(name, name_len);
+}
+
+static void free_key(const JSON_Object_Cell *cell) {
+    if (CELL_IS_INTERNED(cell)) {
+        release_key(cell->name);
+    } else {
+        parson_free(cell->name);
+    }
+}
+
+/* Returns the first byte that isn't whitespace, end (the terminator) at the latest. Runs of JSON
+ * whitespace are skipped a block at a time (only spaces for the word version, that's what
+ * indentation is made of); a block is only read if it ends before end. */
+static const char * skip_whitespaces(const char *string, const char *end) {
+#if defined(PARSON_SSE2)
+    __m128i bytes;
+    unsigned int mask = 0;
+#elif defined(PARSON_NEON)
+    uint8x16_t bytes, is_space;
+    uint64_t mask = 0;
+#else
+    parson_word word = 0;
+#endif
+    /* most runs are empty or a single separator, those don't pay for the block setup */
+    if (!isspace((unsigned char)string[0])) {
+        return string;
+    } else if (!isspace((unsigned char)string[1])) {
+        return string + 1;
+    }
+    string += 2;
+#if defined(PARSON_SSE2)
+    while (end - string >= 16) {
+        bytes = _mm_loadu_si128((const __m128i*)string);
+        mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(
+                   _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))),
+                   _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')))));
+        mask = ~mask & 0xFFFF;
+        if (mask != 0) {
+            return string + parson_ctz(mask);
+        }
+        string += 16;
+    }
+#elif defined(PARSON_NEON)
+    while (end - string >= 16) {
+        bytes = vld1q_u8((const uint8_t*)string);
+        is_space = vorrq_u8(vorrq_u8(vceqq_u8(bytes, vdupq_n_u8(' ')), vceqq_u8(bytes, vdupq_n_u8('\n'))),
+                            vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('\r')), vceqq_u8(bytes, vdupq_n_u8('\t'))));
+        /* 4 bits per byte */
+        mask = ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(is_space), 4)), 0);
+        if (mask != 0) {
+            return string + parson_ctz(mask) / 4;
+        }
+        string += 16;
+    }
+#else
+    while (((uintptr_t)string & (sizeof(parson_word) - 1)) != 0 && *string == ' ') {
+        string++;
+    }
+    while ((size_t)(end - string) >= sizeof(parson_word)) {
+        memcpy(&word, string, sizeof(parson_word));
+        if (word != WORD_ONES * ' ') {
+            break;
+        }
+        string += sizeof(parson_word);
+    }
+#endif
+    while (isspace((unsigned char)*string)) {
+        string++;
+    }
+    return string;
+}
+
+/* Returns the first '"', '\\' or control character of a string body, end (the terminator) at the
+ * latest. Blocks are read as in skip_whitespaces(). */
+static const char * scan_string_body(const char *string, const char *end) {
+#if defined(PARSON_SSE2)
+    __m128i bytes;
+    unsigned int mask = 0;
+#elif defined(PARSON_NEON)
+    uint8x16_t bytes, stop;
+    uint64_t mask = 0;
+#else
+    parson_word word = 0;
+#endif
+    int i = 0;
+    for (i = 0; i < 4; i++, string++) { /* short strings don't pay for the block setup */
+        if (*string == '\"' || *string == '\\' || (unsigned char)*string < 0x20) {
+            return string;
+        }
+    }
+#if defined(PARSON_SSE2)
+    while (end - string >= 16) {
+        bytes = _mm_loadu_si128((const __m128i*)string);
+        mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(
+                   _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\"')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))),
+                   _mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F)))); /* <= 0x1F */
+        if (mask != 0) {
+            return string + parson_ctz(mask);
+        }
+        string += 16;
+    }
+#elif defined(PARSON_NEON)
+    while (end - string >= 16) {
+        bytes = vld1q_u8((const uint8_t*)string);
+        stop = vorrq_u8(vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('\"')), vceqq_u8(bytes, vdupq_n_u8('\\'))),
+                        vcltq_u8(bytes, vdupq_n_u8(0x20)));
+        mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(stop), 4)), 0);
+        if (mask != 0) {
+            return string + parson_ctz(mask) / 4;
+        }
+        string += 16;
+    }
+#else
+    while (((uintptr_t)string & (sizeof(parson_word) - 1)) != 0) {
+        if (*string == '\"' || *string == '\\' || (unsigned char)*string < 0x20) {
+            return string;
+        }
+        string++;
+    }
+    while ((size_t)(end - string) >= sizeof(parson_word)) {
+        memcpy(&word, string, sizeof(parson_word));
+        if (WORD_HAS_BYTE(word, '\"') || WORD_HAS_BYTE(word, '\\') || WORD_HAS_LESS(word, 0x20)) {
+            break;
+        }
+        string += sizeof(parson_word);
+    }
+#endif
+    while (*string != '\"' && *string != '\\' && (unsigned char)*string >= 0x20) {
+        string++;
+    }
+    return string;
+}
+
+/* Number of leading bytes of string[0..len) that are plain ASCII: not '\\', control characters
+ * or part of a multibyte sequence. */
+static size_t count_unescaped(const char *string, size_t len) {
+    size_t i = 0;
+#if defined(PARSON_SSE2)
+    __m128i bytes;
+    unsigned int mask = 0;
+    for (; i + 16 <= len; i += 16) {
+        bytes = _mm_loadu_si128((const __m128i*)(string + i));
+        mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\')),
+                   _mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F))), bytes)); /* high bit: >= 0x80 */
+        if (mask != 0) {
+            return i + parson_ctz(mask);
+        }
+    }
+#elif defined(PARSON_NEON)
+    uint8x16_t bytes;
+    uint64_t mask = 0;
+    for (; i + 16 <= len; i += 16) {
+        bytes = vld1q_u8((const uint8_t*)string + i);
+        mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(
+                   vorrq_u8(vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('\\')), vcltq_u8(bytes, vdupq_n_u8(0x20))),
+                            vcgeq_u8(bytes, vdupq_n_u8(0x80)))), 4)), 0);
+        if (mask != 0) {
+            return i + parson_ctz(mask) / 4;
+        }
+    }
+#else
+    parson_word word = 0;
+    for (; i + sizeof(parson_word) <= len; i += sizeof(parson_word)) {
+        memcpy(&word, string + i, sizeof(parson_word));
+        if (WORD_HAS_BYTE(word, '\\') || WORD_HAS_LESS(word, 0x20) || (word & WORD_HIGHS)) {
+            break;
+        }
+    }
+#endif
+    while (i < len && string[i] != '\\' && (unsigned char)string[i] >= 0x20 && (unsigned char)string[i] < 0x80) {
+        i++;
     }
-    return -1;
+    return i;
 }
 
+/* Number of leading ASCII bytes of string[0..len). */
+static size_t count_ascii(const char *string, size_t len) {
+    size_t i = 0;
+#if defined(PARSON_SSE2)
+    unsigned int mask = 0;
+    for (; i + 16 <= len; i += 16) {
+        mask = (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(string + i)));
+        if (mask != 0) {
+            return i + parson_ctz(mask);
+        }
+    }
+#elif defined(PARSON_NEON)
+    uint64_t mask = 0;
+    for (; i + 16 <= len; i += 16) {
+        mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(
+                   vcgeq_u8(vld1q_u8((const uint8_t*)string + i), vdupq_n_u8(0x80))), 4)), 0);
+        if (mask != 0) {
+            return i + parson_ctz(mask) / 4;
+        }
+    }
+#else
+    parson_word word = 0;
+    for (; i + sizeof(parson_word) <= len; i += sizeof(parson_word)) {
+        memcpy(&word, string + i, sizeof(parson_word));
+        if (word & WORD_HIGHS) {
+            break;
+        }
+    }
+#endif
+    while (i < len && (unsigned char)string[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+/* Value of each hex digit, -1 for anything else (the terminator included) */
+static const signed char hex_values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+/* A digit that isn't hex makes the whole value negative. Each digit is checked before the next
+ * is read, so a terminator stops the reads. */
 static int parse_utf16_hex(const char *s, unsigned int *result) {
-    int x1, x2, x3, x4;
-    if (s[0] == '\0' || s[1] == '\0' || s[2] == '\0' || s[3] == '\0') {
+    int value = hex_values[(unsigned char)s[0]];
+    if (value < 0) {
+        return 0;
+    }
+    value = (value << 4) | hex_values[(unsigned char)s[1]];
+    if (value < 0) {
+        return 0;
+    }
+    value = (value << 4) | hex_values[(unsigned char)s[2]];
+    if (value < 0) {
         return 0;
     }
-    x1 = hex_char_to_int(s[0]);
-    x2 = hex_char_to_int(s[1]);
-    x3 = hex_char_to_int(s[2]);
-    x4 = hex_char_to_int(s[3]);
-    if (x1 == -1 || x2 == -1 || x3 == -1 || x4 == -1) {
+    value = (value << 4) | hex_values[(unsigned char)s[3]];
+    if (value < 0) {
         return 0;
     }
-    *result = (unsigned int)((x1 << 12) | (x2 << 8) | (x3 << 4) | x4);
+    *result = (unsigned int)value;
     return 1;
 }
 
-static int num_bytes_in_utf8_sequence(unsigned char c) {
-    if (c == 0xC0 || c == 0xC1 || c > 0xF4 || IS_CONT(c)) {
+/* UTF-8 validation is a DFA over byte classes. Bytes from 0x80 up are classified by the table
+ * below, ASCII is class 0:
+ *   1: 80..8F  2: 90..9F  3: A0..BF (continuation bytes, split by the ranges E0, ED, F0 and F4 allow)
+ *   4: C2..DF  5: E0  6: E1..EC, EE..EF  7: ED  8: F0  9: F1..F3  10: F4  11: C0, C1, F5..FF
+ * States: 0 accept, 1..3 continuation bytes left, 4 after E0, 5 after ED, 6 after F0, 7 after F4,
+ * 8 reject. Overlong forms, surrogates and code points past 10FFFF have no path to accept. */
+#define UTF8_ACCEPT 0
+#define UTF8_REJECT 8
+
+static const unsigned char utf8_classes[128] = {
+     1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+     2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+     3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+     3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+    11, 11,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+     4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+     5,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  7,  6,  6,
+     8,  9,  9,  9, 10, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11
+};
+
+static const unsigned char utf8_transitions[9][12] = {
+    { 0, 8, 8, 8, 1, 4, 2, 5, 6, 3, 7, 8 },
+    { 8, 0, 0, 0, 8, 8, 8, 8, 8, 8, 8, 8 },
+    { 8, 1, 1, 1, 8, 8, 8, 8, 8, 8, 8, 8 },
+    { 8, 2, 2, 2, 8, 8, 8, 8, 8, 8, 8, 8 },
+    { 8, 8, 8, 1, 8, 8, 8, 8, 8, 8, 8, 8 },
+    { 8, 1, 1, 8, 8, 8, 8, 8, 8, 8, 8, 8 },
+    { 8, 8, 2, 2, 8, 8, 8, 8, 8, 8, 8, 8 },
+    { 8, 2, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8 },
+    { 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8 }
+};
+
+/* Never reads past string_len, ASCII runs are skipped a block at a time. */
+static int is_valid_utf8(const char *string, size_t string_len) {
+    const unsigned char *bytes = (const unsigned char*)string, *bytes_end = bytes + string_len;
+    unsigned int state = UTF8_ACCEPT;
+    while (bytes < bytes_end) {
+        if (state == UTF8_ACCEPT) {
+            bytes += count_ascii((const char*)bytes, (size_t)(bytes_end - bytes));
+            if (bytes == bytes_end) {
+                break;
+            }
+        }
+        state = utf8_transitions[state][*bytes < 0x80 ? 0 : utf8_classes[*bytes - 0x80]];
+        if (state == UTF8_REJECT) {
+            return 0;
+        }
+        bytes++;
+    }
+    return state == UTF8_ACCEPT;
+}
+
+/* The upper 64 bits of a * b, rounded half up. In 32-bit halves: the targets have no 128-bit type. */
+static uint64_t multiply_high64(uint64_t a, uint64_t b) {
+    uint64_t a_hi = a >> 32, a_lo = a & 0xFFFFFFFFu, b_hi = b >> 32, b_lo = b & 0xFFFFFFFFu;
+    uint64_t middle = ((a_lo * b_lo) >> 32) + ((a_hi * b_lo) & 0xFFFFFFFFu) + ((a_lo * b_hi) & 0xFFFFFFFFu) +
+                      ((uint64_t)1 << 31);
+    return a_hi * b_hi + ((a_hi * b_lo) >> 32) + ((a_lo * b_hi) >> 32) + (middle >> 32);
+}
+
+/* Shifts *f, which isn't 0, left until its top bit is set; returns the shift. */
+static int normalize64(uint64_t *f) {
+    int shift = 0;
+    while ((*f >> 56) == 0) {
+        *f <<= 8;
+        shift += 8;
+    }
+    while ((*f >> 63) == 0) {
+        *f <<= 1;
+        shift++;
+    }
+    return shift;
+}
+
+/* Converts mantissa * 10^exponent10 (mantissa of at most 19 digits, not 0) to the nearest double with
+ * 64-bit arithmetic: mantissa times a cached power of 10, rounded to 64 bits, with a bound on the error
+ * of each step kept in eighths of the last bit. Returns 0, leaving the number to decimal_to_double, if
+ * the exponent is beyond the table, the result is a tiny subnormal, or the bits dropped by rounding to
+ * a double are within the error of halfway (ties included); that's a few numbers in a thousand. */
+static int approximate_decimal(uint64_t mantissa, long exponent10, double *number) {
+    static const uint64_t pow10_significands[CACHED_POW10_COUNT] = {
+        0xfa8fd5a0081c0288, 0xbaaee17fa23ebf76, 0x8b16fb203055ac76, 0xcf42894a5dce35ea,
+        0x9a6bb0aa55653b2d, 0xe61acf033d1a45df, 0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f,
+        0xbe5691ef416bd60c, 0x8dd01fad907ffc3c, 0xd3515c2831559a83, 0x9d71ac8fada6c9b5,
+        0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57, 0xc21094364dfb5637,
+        0x9096ea6f3848984f, 0xd77485cb25823ac7, 0xa086cfcd97bf97f4, 0xef340a98172aace5,
+        0xb23867fb2a35b28e, 0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996,
+        0xdbac6c247d62a584, 0xa3ab66580d5fdaf6, 0xf3e2f893dec3f126, 0xb5b5ada8aaff80b8,
+        0x87625f056c7c4a8b, 0xc9bcff6034c13053, 0x964e858c91ba2655, 0xdff9772470297ebd,
+        0xa6dfbd9fb8e5b88f, 0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+        0xcdb02555653131b6, 0x993fe2c6d07b7fac, 0xe45c10c42a2b3b06, 0xaa242499697392d3,
+        0xfd87b5f28300ca0e, 0xbce5086492111aeb, 0x8cbccc096f5088cc, 0xd1b71758e219652c,
+        0x9c40000000000000, 0xe8d4a51000000000, 0xad78ebc5ac620000, 0x813f3978f8940984,
+        0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70, 0xd5d238a4abe98068, 0x9f4f2726179a2245,
+        0xed63a231d4c4fb27, 0xb0de65388cc8ada8, 0x83c7088e1aab65db, 0xc45d1df942711d9a,
+        0x924d692ca61be758, 0xda01ee641a708dea, 0xa26da3999aef774a, 0xf209787bb47d6b85,
+        0xb454e4a179dd1877, 0x865b86925b9bc5c2, 0xc83553c5c8965d3d, 0x952ab45cfa97a0b3,
+        0xde469fbd99a05fe3, 0xa59bc234db398c25, 0xf6c69a72a3989f5c, 0xb7dcbf5354e9bece,
+        0x88fcf317f22241e2, 0xcc20ce9bd35c78a5, 0x98165af37b2153df, 0xe2a0b5dc971f303a,
+        0xa8d9d1535ce3b396, 0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410, 0x8bab8eefb6409c1a,
+        0xd01fef10a657842c, 0x9b10a4e5e9913129, 0xe7109bfba19c0c9d, 0xac2820d9623bf429,
+        0x80444b5e7aa7cf85, 0xbf21e44003acdd2d, 0x8e679c2f5e44ff8f, 0xd433179d9c8cb841,
+        0x9e19db92b4e31ba9, 0xeb96bf6ebadf77d9, 0xaf87023b9bf0ee6b
+    };
+    static const short pow10_exponents[CACHED_POW10_COUNT] = {
+        -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+        -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+        -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+        -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+        56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+        375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+        694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+        1013, 1039, 1066
+    };
+    static const uint64_t small_pow10[CACHED_POW10_STEP] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000
+    };
+    uint64_t f = mantissa, power = 0, error = 0, low_bits = 0, halfway = 0;
+    int e = 0, index = 0, adjustment = 0, shift = 0, magnitude = 0, dropped = 0;
+
+    if (exponent10 < CACHED_POW10_MIN || exponent10 >= CACHED_POW10_MIN + CACHED_POW10_COUNT * CACHED_POW10_STEP) {
         return 0;
-    } else if ((c & 0x80) == 0) {    /* 0xxxxxxx */
-        return 1;
-    } else if ((c & 0xE0) == 0xC0) { /* 110xxxxx */
-        return 2;
-    } else if ((c & 0xF0) == 0xE0) { /* 1110xxxx */
-        return 3;
-    } else if ((c & 0xF8) == 0xF0) { /* 11110xxx */
-        return 4;
-    }
-    return 0; /* won't happen */
-}
-
-static int verify_utf8_sequence(const unsigned char *string, int *len) {
-    unsigned int cp = 0;
-    *len = num_bytes_in_utf8_sequence(string[0]);
-
-    if (*len == 1) {
-        cp = string[0];
-    } else if (*len == 2 && IS_CONT(string[1])) {
-        cp = string[0] & 0x1F;
-        cp = (cp << 6) | (string[1] & 0x3F);
-    } else if (*len == 3 && IS_CONT(string[1]) && IS_CONT(string[2])) {
-        cp = ((unsigned char)string[0]) & 0xF;
-        cp = (cp << 6) | (string[1] & 0x3F);
-        cp = (cp << 6) | (string[2] & 0x3F);
-    } else if (*len == 4 && IS_CONT(string[1]) && IS_CONT(string[2]) && IS_CONT(string[3])) {
-        cp = string[0] & 0x7;
-        cp = (cp << 6) | (string[1] & 0x3F);
-        cp = (cp << 6) | (string[2] & 0x3F);
-        cp = (cp << 6) | (string[3] & 0x3F);
-    } else {
+    }
+    e = -normalize64(&f);
+    index = (int)(exponent10 - CACHED_POW10_MIN) / CACHED_POW10_STEP;
+    adjustment = (int)(exponent10 - CACHED_POW10_MIN) % CACHED_POW10_STEP;
+    if (adjustment > 0) { /* an exact power of 10 first, the product is rounded */
+        power = small_pow10[adjustment];
+        shift = normalize64(&power);
+        f = multiply_high64(f, power);
+        e += 64 - shift;
+        error = 4;
+    }
+    f = multiply_high64(f, pow10_significands[index]);
+    e += 64 + pow10_exponents[index];
+    error += 4 + (error != 0) + 4; /* the cached power's half bit, the cross term and the rounding */
+    shift = normalize64(&f);
+    e -= shift;
+    error <<= shift;
+
+    /* f * 2^e is in [2^(magnitude - 1), 2^magnitude), keep the bits a double has there */
+    magnitude = 64 + e;
+    dropped = 64 - (magnitude >= -1074 + 53 ? 53 : magnitude + 1074);
+    if (dropped + 3 >= 64) {
         return 0;
     }
-
-    /* overlong encodings */
-    if ((cp < 0x80    && *len > 1) ||
-        (cp < 0x800   && *len > 2) ||
-        (cp < 0x10000 && *len > 3)) {
+    low_bits = (f & (((uint64_t)1 << dropped) - 1)) * 8;
+    halfway = ((uint64_t)1 << (dropped - 1)) * 8;
+    if (low_bits > halfway - error && low_bits < halfway + error) {
         return 0;
     }
+    f = (f >> dropped) + (low_bits >= halfway + error);
+    *number = ldexp((double)f, e + dropped); /* exact, or infinite when out of range */
+    return 1;
+}
 
-    /* invalid unicode */
-    if (cp > 0x10FFFF) {
-        return 0;
+/* The digits of a number being converted by decimal_to_double: 0.d[0]d[1]...d[count - 1] * 10^point,
+ * with no leading or trailing zeros. truncated is set when nonzero digits didn't fit in d. */
+typedef struct json_decimal_t {
+    int           count;
+    int           point;
+    int           truncated;
+    unsigned char d[DECIMAL_MAX_DIGITS];
+} JSON_Decimal;
+
+static void decimal_trim(JSON_Decimal *dec) {
+    while (dec->count > 0 && dec->d[dec->count - 1] == 0) {
+        dec->count--;
+    }
+    if (dec->count == 0) {
+        dec->point = 0;
     }
+}
 
-    /* surrogate halves */
-    if (cp >= 0xD800 && cp <= 0xDFFF) {
-        return 0;
+/* Multiplies dec by 2^shift, shift <= DECIMAL_MAX_SHIFT. The product is written from its last digit
+ * up, ahead of the digits still to be read, then moved down over the room left for its first ones. */
+static void decimal_left_shift(JSON_Decimal *dec, unsigned int shift) {
+    int read = dec->count - 1;
+    int write = dec->count + (int)shift / 3 + 1; /* log10(2) < 1/3: room for every new digit */
+    int produced = 0;
+    uint64_t n = 0, quotient = 0;
+
+    while (read >= 0 || n > 0) {
+        if (read >= 0) {
+            n += (uint64_t)dec->d[read--] << shift;
+        }
+        quotient = n / 10;
+        write--;
+        if (write < DECIMAL_MAX_DIGITS) {
+            dec->d[write] = (unsigned char)(n - quotient * 10);
+        } else if (n - quotient * 10 != 0) {
+            dec->truncated = 1;
+        }
+        n = quotient;
+        produced++;
+    }
+    dec->point += produced - dec->count;
+    dec->count = MIN(produced, DECIMAL_MAX_DIGITS - write);
+    memmove(dec->d, dec->d + write, (size_t)dec->count);
+    decimal_trim(dec);
+}
+
+/* Divides dec by 2^shift, shift <= DECIMAL_MAX_SHIFT, one digit at a time from the first. */
+static void decimal_right_shift(JSON_Decimal *dec, unsigned int shift) {
+    int read = 0, write = 0;
+    uint64_t n = 0, mask = ((uint64_t)1 << shift) - 1;
+
+    while ((n >> shift) == 0) { /* enough leading digits for the first digit of the quotient */
+        if (read < dec->count) {
+            n = n * 10 + dec->d[read];
+        } else if (n == 0) {
+            dec->count = 0;
+            dec->point = 0;
+            return;
+        } else {
+            n = n * 10;
+        }
+        read++;
+    }
+    dec->point -= read - 1;
+    for (; read < dec->count; read++) {
+        dec->d[write++] = (unsigned char)(n >> shift);
+        n = (n & mask) * 10 + dec->d[read];
+    }
+    while (n > 0) {
+        if (write < DECIMAL_MAX_DIGITS) {
+            dec->d[write++] = (unsigned char)(n >> shift);
+        } else if ((n >> shift) != 0) {
+            dec->truncated = 1;
+        }
+        n = (n & mask) * 10;
     }
+    dec->count = write;
+    decimal_trim(dec);
+}
 
-    return 1;
+static void decimal_shift(JSON_Decimal *dec, int shift) {
+    for (; shift > DECIMAL_MAX_SHIFT; shift -= DECIMAL_MAX_SHIFT) {
+        decimal_left_shift(dec, DECIMAL_MAX_SHIFT);
+    }
+    for (; shift < -DECIMAL_MAX_SHIFT; shift += DECIMAL_MAX_SHIFT) {
+        decimal_right_shift(dec, DECIMAL_MAX_SHIFT);
+    }
+    if (shift > 0) {
+        decimal_left_shift(dec, (unsigned int)shift);
+    } else if (shift < 0) {
+        decimal_right_shift(dec, (unsigned int)-shift);
+    }
 }
 
-static int is_valid_utf8(const char *string, size_t string_len) {
-    int len = 0;
-    const char *string_end =  string + string_len;
-    while (string < string_end) {
-        if (!verify_utf8_sequence((const unsigned char*)string, &len)) {
-            return 0;
+/* The integer part of dec (below 2^54 here), rounded half to even on the digits after it. */
+static uint64_t decimal_rounded_integer(const JSON_Decimal *dec) {
+    uint64_t n = 0;
+    int i = 0, round_up = 0;
+
+    for (i = 0; i < dec->point; i++) {
+        n = n * 10 + (i < dec->count ? dec->d[i] : 0);
+    }
+    if (dec->point >= 0 && dec->point < dec->count) {
+        if (dec->d[dec->point] == 5 && dec->point + 1 == dec->count) {
+            round_up = dec->truncated || (n & 1);
+        } else {
+            round_up = dec->d[dec->point] >= 5;
+        }
+    }
+    return n + (uint64_t)round_up;
+}
+
+/* Converts the JSON number string[0..length), which parse_number has validated, to the nearest double
+ * (ties to even), as strtod does in the C locale but without looking at the current one. The digits
+ * are scaled by powers of two into [1/2, 1) and the 53 bits of the mantissa read off them: slower
+ * than strtod, but exact with no tables. The digits live on the heap, they don't fit the stack of
+ * small tasks. Returns 0 if the magnitude is too large for a double or no memory is left; numbers too
+ * small for one become a subnormal or zero. */
+static int decimal_to_double(const char *string, size_t length, double *number) {
+    static const int pow10_bits[] = { 1, 3, 6, 9, 13, 16, 19, 23, 26 }; /* bits of 10^i, rounded down */
+    const char *end = string + length;
+    JSON_Decimal *dec = NULL;
+    int negative = 0, exponent_negative = 0, binary_exponent = 0, shift = 0, overflow = 0;
+    long exponent = 0;
+    uint64_t mantissa = 0;
+
+    dec = (JSON_Decimal*)parson_malloc(sizeof(JSON_Decimal));
+    if (dec == NULL) {
+        return 0;
+    }
+    dec->count = 0;
+    dec->point = 0;
+    dec->truncated = 0;
+    if (string < end && *string == '-') {
+        negative = 1;
+        string++;
+    }
+    for (; string < end && IS_DIGIT(*string); string++) {
+        if (dec->count == 0 && *string == '0') {
+            continue;
+        }
+        if (dec->count < DECIMAL_MAX_DIGITS) {
+            dec->d[dec->count++] = (unsigned char)(*string - '0');
+        } else {
+            dec->truncated |= (*string != '0');
+        }
+        dec->point++;
+    }
+    if (string < end && *string == '.') {
+        for (string++; string < end && IS_DIGIT(*string); string++) {
+            if (dec->count == 0 && *string == '0') {
+                dec->point--;
+            } else if (dec->count < DECIMAL_MAX_DIGITS) {
+                dec->d[dec->count++] = (unsigned char)(*string - '0');
+            } else {
+                dec->truncated |= (*string != '0');
+            }
+        }
+    }
+    if (string < end && (*string == 'e' || *string == 'E')) {
+        string++;
+        if (string < end && (*string == '-' || *string == '+')) {
+            exponent_negative = (*string == '-');
+            string++;
+        }
+        for (; string < end && exponent < 100000; string++) { /* far outside the range of a double already */
+            exponent = exponent * 10 + (*string - '0');
+        }
+        dec->point += (int)(exponent_negative ? -exponent : exponent);
+    }
+    decimal_trim(dec);
+
+    if (dec->count == 0 || dec->point < -330) {
+        mantissa = 0;
+    } else if (dec->point > 310) {
+        overflow = 1;
+    } else {
+        /* 0.d * 2^binary_exponent with 0.d in [1/2, 1) */
+        while (dec->point > 0) {
+            shift = dec->point < (int)(sizeof(pow10_bits) / sizeof(pow10_bits[0])) ? pow10_bits[dec->point] : 27;
+            decimal_shift(dec, -shift);
+            binary_exponent += shift;
+        }
+        while (dec->point < 0 || (dec->point == 0 && dec->d[0] < 5)) {
+            shift = -dec->point < (int)(sizeof(pow10_bits) / sizeof(pow10_bits[0])) ? pow10_bits[-dec->point] : 27;
+            decimal_shift(dec, shift);
+            binary_exponent -= shift;
+        }
+        binary_exponent--; /* 1.x * 2^binary_exponent */
+        if (binary_exponent < -1022) { /* subnormal: fewer bits of mantissa */
+            decimal_shift(dec, binary_exponent + 1022);
+            binary_exponent = -1022;
+        }
+        if (binary_exponent > 1023) {
+            overflow = 1;
+        } else {
+            decimal_shift(dec, 53);
+            mantissa = decimal_rounded_integer(dec);
+            if (mantissa == ((uint64_t)1 << 53)) { /* rounded up to the next power of two */
+                mantissa >>= 1;
+                binary_exponent++;
+                overflow = binary_exponent > 1023;
+            }
         }
-        string += len;
+    }
+    parson_free(dec);
+    if (overflow) {
+        return 0;
+    }
+    /* both steps are exact: mantissa has at most 53 bits, and those below the smallest subnormal
+     * were rounded away above */
+    *number = ldexp((double)mantissa, binary_exponent - 52);
+    if (negative) {
+        *number = -*number;
     }
     return 1;
 }
 
-static int is_decimal(const char *string, size_t length) {
-    if (length > 1 && string[0] == '0' && string[1] != '.') {
+/* Parses a JSON number from at most max_len bytes of string. Up to 19 significant digits with a decimal
+ * exponent within +-22 are converted exactly in place (mantissa and power of 10 are both exact doubles,
+ * so one multiplication or division is correctly rounded), other numbers of up to 19 digits by
+ * approximate_decimal, and the rest by decimal_to_double. None of them depends on the locale, unlike
+ * strtod, which expects a ',' in some.
+ * Returns the number of bytes consumed, or 0 if the input isn't a valid number or is out of range. */
+static size_t parse_number(const char *string, size_t max_len, double *number, int64_t *integer, int *is_integer) {
+    static const double pow10[MAX_EXACT_POW10 + 1] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char *ptr = string;
+    size_t remaining = max_len, length = 0;
+    uint64_t mantissa = 0;
+    int negative = 0, digits = 0, truncated = 0, integral = 1, exponent_negative = 0;
+    long exponent = 0, exponent10 = 0;
+    double result = 0.0;
+
+#define NUMBER_HAS_CHAR() (remaining > 0)
+#define NUMBER_NEXT_CHAR() do { ptr++; remaining--; } while (0)
+    if (NUMBER_HAS_CHAR() && *ptr == '-') {
+        negative = 1;
+        NUMBER_NEXT_CHAR();
+    }
+    if (!NUMBER_HAS_CHAR() || !IS_DIGIT(*ptr)) {
         return 0;
     }
-    if (length > 2 && !strncmp(string, "-0", 2) && string[2] != '.') {
-        return 0;
+    if (*ptr == '0') {
+        NUMBER_NEXT_CHAR();
+        if (NUMBER_HAS_CHAR() && IS_DIGIT(*ptr)) {
+            return 0; /* leading zeros aren't allowed */
+        }
+    }
+    while (NUMBER_HAS_CHAR() && IS_DIGIT(*ptr)) {
+        if (digits < MAX_MANTISSA_DIGITS) {
+            mantissa = mantissa * 10 + (uint64_t)(*ptr - '0');
+            digits++;
+        } else {
+            exponent10++;
+            truncated |= (*ptr != '0');
+        }
+        NUMBER_NEXT_CHAR();
     }
-    while (length--) {
-        if (strchr("xX", string[length])) {
+    if (NUMBER_HAS_CHAR() && *ptr == '.') {
+        integral = 0;
+        NUMBER_NEXT_CHAR();
+        if (!NUMBER_HAS_CHAR() || !IS_DIGIT(*ptr)) {
             return 0;
         }
+        while (NUMBER_HAS_CHAR() && IS_DIGIT(*ptr)) {
+            if (digits < MAX_MANTISSA_DIGITS) {
+                mantissa = mantissa * 10 + (uint64_t)(*ptr - '0');
+                exponent10--;
+                digits += (mantissa != 0); /* leading zeros aren't significant */
+            } else {
+                truncated |= (*ptr != '0');
+            }
+            NUMBER_NEXT_CHAR();
+        }
     }
-    return 1;
+    if (NUMBER_HAS_CHAR() && (*ptr == 'e' || *ptr == 'E')) {
+        integral = 0;
+        NUMBER_NEXT_CHAR();
+        if (NUMBER_HAS_CHAR() && (*ptr == '-' || *ptr == '+')) {
+            exponent_negative = (*ptr == '-');
+            NUMBER_NEXT_CHAR();
+        }
+        if (!NUMBER_HAS_CHAR() || !IS_DIGIT(*ptr)) {
+            return 0;
+        }
+        while (NUMBER_HAS_CHAR() && IS_DIGIT(*ptr)) {
+            if (exponent < 100000) { /* far outside the range of a double already */
+                exponent = exponent * 10 + (*ptr - '0');
+            }
+            NUMBER_NEXT_CHAR();
+        }
+        exponent10 += exponent_negative ? -exponent : exponent;
+    }
+#undef NUMBER_HAS_CHAR
+#undef NUMBER_NEXT_CHAR
+    length = (size_t)(ptr - string);
+
+    *is_integer = 0;
+    if (integral && exponent10 == 0 && !(negative && mantissa == 0) &&
+        mantissa <= (uint64_t)INT64_MAX + (uint64_t)negative) {
+        *integer = negative ? (int64_t)(0 - mantissa) : (int64_t)mantissa;
+        *is_integer = 1;
+    }
+
+    if (!truncated && mantissa == 0) {
+        result = 0.0;
+    } else if (!truncated && mantissa <= MAX_EXACT_MANTISSA &&
+               exponent10 >= -MAX_EXACT_POW10 && exponent10 <= MAX_EXACT_POW10) {
+        result = (double)mantissa;
+        result = exponent10 < 0 ? result / pow10[-exponent10] : result * pow10[exponent10];
+    } else if (truncated || !approximate_decimal(mantissa, exponent10, &result)) {
+        return decimal_to_double(string, length, number) ? length : 0;
+    }
+    if (IS_NUMBER_INVALID(result)) {
+        return 0; /* too large for a double */
+    }
+    *number = negative ? -result : result;
+    return length;
+}
+
+/* Writes number in decimal to buf, which must hold at least 21 bytes. */
+static int int64_to_string(int64_t number, char *buf) {
+    char digits[20];
+    uint64_t magnitude = number < 0 ? (uint64_t)0 - (uint64_t)number : (uint64_t)number;
+    int count = 0, written = 0;
+    do {
+        digits[count++] = (char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (number < 0) {
+        buf[written++] = '-';
+    }
+    while (count > 0) {
+        buf[written++] = digits[--count];
+    }
+    buf[written] = '\0';
+    return written;
 }
 
 #ifdef PARSON_FILES
@@ -352,116 +1514,154 @@ static void remove_comments(char *string, const char *start_token, const char *e
 }
 
 /* JSON Object */
-static JSON_Object * json_object_init(JSON_Value *wrapping_value) {
-    JSON_Object *new_obj = (JSON_Object*)parson_malloc(sizeof(JSON_Object));
-    if (new_obj == NULL) {
-        return NULL;
-    }
-    new_obj->wrapping_value = wrapping_value;
-    new_obj->names = (char**)NULL;
-    new_obj->values = (JSON_Value**)NULL;
-    new_obj->capacity = 0;
-    new_obj->count = 0;
-    return new_obj;
+static void json_object_init(JSON_Object *object, JSON_Value *wrapping_value) {
+    object->wrapping_value = wrapping_value;
+    object->cells = (JSON_Object_Cell*)NULL;
+    object->changes = (JSON_Changes*)NULL;
+    object->capacity = 0;
+    object->count = 0;
 }
 
-static JSON_Status json_object_add(JSON_Object *object, const char *name, JSON_Value *value) {
+static JSON_Status json_object_addn(JSON_Object *object, const char *name, size_t name_len, JSON_Value *value) {
     if (name == NULL) {
         return JSONFailure;
     }
-    return json_object_addn(object, name, strlen(name), value);
+    return json_object_addn_hashed(object, name, name_len, hash_string(name, name_len), value);
 }
 
-static JSON_Status json_object_addn(JSON_Object *object, const char *name, size_t name_len, JSON_Value *value) {
-    size_t index = 0;
+static JSON_Status json_object_addn_hashed(JSON_Object *object, const char *name, size_t name_len, unsigned long hash, JSON_Value *value) {
+    JSON_Object_Cell cell;
     if (object == NULL || name == NULL || value == NULL) {
         return JSONFailure;
     }
-    if (json_object_getn_value(object, name, name_len) != NULL) {
+    if (json_object_find(object, name, name_len, hash) != object->count) {
         return JSONFailure;
     }
+    cell.name = copy_key(name, name_len, hash, &cell.hash);
+    if (cell.name == NULL) {
+        return JSONFailure;
+    }
+    if (json_object_add_cell(object, cell.name, cell.hash, value) == JSONFailure) {
+        free_key(&cell);
+        return JSONFailure;
+    }
+    if (parson_tracked_objects > 0) {
+        json_object_note_added(object, object->count - 1);
+    }
+    return JSONSuccess;
+}
+
+/* Appends a member without checking for duplicates or tracking the change (the parsers and
+ * deep copies build new trees). Takes ownership of name on success, hash is the cell's hash
+ * including the interned flag. */
+static JSON_Status json_object_add_cell(JSON_Object *object, char *name, unsigned long hash, JSON_Value *value) {
+    JSON_Object_Cell *cell = NULL;
     if (object->count >= object->capacity) {
         size_t new_capacity = MAX(object->capacity * 2, STARTING_CAPACITY);
         if (json_object_resize(object, new_capacity) == JSONFailure) {
             return JSONFailure;
         }
     }
-    index = object->count;
-    object->names[index] = parson_strndup(name, name_len);
-    if (object->names[index] == NULL) {
-        return JSONFailure;
-    }
-    value->parent = json_object_get_wrapping_value(object);
-    object->values[index] = value;
+    cell = &object->cells[object->count];
+    cell->name = name;
+    cell->hash = hash;
+    cell->value = value;
+    SET_PARENT(value, json_object_get_wrapping_value(object));
     object->count++;
     return JSONSuccess;
 }
 
 static JSON_Status json_object_resize(JSON_Object *object, size_t new_capacity) {
-    char **temp_names = NULL;
-    JSON_Value **temp_values = NULL;
-
-    if ((object->names == NULL && object->values != NULL) ||
-        (object->names != NULL && object->values == NULL) ||
-        new_capacity == 0) {
-            return JSONFailure; /* Shouldn't happen */
-    }
-    temp_names = (char**)parson_malloc(new_capacity * sizeof(char*));
-    if (temp_names == NULL) {
+    JSON_Object_Cell *temp_cells = NULL;
+    unsigned char *temp_dirty = NULL;
+    if (new_capacity == 0 || new_capacity < object->count) {
         return JSONFailure;
     }
-    temp_values = (JSON_Value**)parson_malloc(new_capacity * sizeof(JSON_Value*));
-    if (temp_values == NULL) {
-        parson_free(temp_names);
-        return JSONFailure;
+    /* the dirty flags only grow, so a failure below leaves them large enough */
+    if (object->changes != NULL && new_capacity > object->capacity) {
+        temp_dirty = (unsigned char*)parson_resize(object->changes->dirty, object->count, new_capacity);
+        if (temp_dirty == NULL) {
+            return JSONFailure;
+        }
+        memset(temp_dirty + object->count, 0, new_capacity - object->count);
+        object->changes->dirty = temp_dirty;
     }
-    if (object->names != NULL && object->values != NULL && object->count > 0) {
-        memcpy(temp_names, object->names, object->count * sizeof(char*));
-        memcpy(temp_values, object->values, object->count * sizeof(JSON_Value*));
+    temp_cells = (JSON_Object_Cell*)parson_resize(object->cells, object->count * sizeof(JSON_Object_Cell),
+                                                  new_capacity * sizeof(JSON_Object_Cell));
+    if (temp_cells == NULL) {
+        return JSONFailure;
     }
-    parson_free(object->names);
-    parson_free(object->values);
-    object->names = temp_names;
-    object->values = temp_values;
+    object->cells = temp_cells;
     object->capacity = new_capacity;
     return JSONSuccess;
 }
 
-static JSON_Value * json_object_getn_value(const JSON_Object *object, const char *name, size_t name_len) {
-    size_t i, name_length;
-    for (i = 0; i < json_object_get_count(object); i++) {
-        name_length = strlen(object->names[i]);
-        if (name_length != name_len) {
-            continue;
-        }
-        if (strncmp(object->names[i], name, name_len) == 0) {
-            return object->values[i];
+/* Returns the index of the member, object->count if there is none */
+static size_t json_object_find(const JSON_Object *object, const char *name, size_t name_len, unsigned long hash) {
+    const JSON_Object_Cell *cell = object->cells;
+    size_t i;
+    for (i = 0; i < object->count; i++, cell++) {
+        if (CELL_HASH(cell) == hash && (cell->name == name || key_equals(cell->name, name, name_len))) {
+            return i;
         }
     }
-    return NULL;
+    return object->count;
+}
+
+static JSON_Value * json_object_getn_value(const JSON_Object *object, const char *name, size_t name_len) {
+    size_t index;
+    if (object == NULL || name == NULL) {
+        return NULL;
+    }
+    index = json_object_find(object, name, name_len, hash_string(name, name_len));
+    return index < object->count ? object->cells[index].value : NULL;
+}
+
+static JSON_Status json_object_setn_value_hashed(JSON_Object *object, const char *name, size_t name_len, unsigned long hash, JSON_Value *value) {
+    size_t index;
+    if (object == NULL || name == NULL || value == NULL || value->parent != NULL) {
+        return JSONFailure;
+    }
+    index = json_object_find(object, name, name_len, hash);
+    if (index == object->count) { /* add new key value pair */
+        return json_object_addn_hashed(object, name, name_len, hash, value);
+    }
+    /* free and overwrite old value */
+    json_object_free_value(object, object->cells[index].name, object->cells[index].value);
+    SET_PARENT(value, json_object_get_wrapping_value(object));
+    object->cells[index].value = value;
+    if (parson_tracked_objects > 0) {
+        json_object_note_added(object, index);
+    }
+    return JSONSuccess;
 }
 
 static JSON_Status json_object_remove_internal(JSON_Object *object, const char *name, int free_value) {
-    size_t i = 0, last_item_index = 0;
-    if (object == NULL || json_object_get_value(object, name) == NULL) {
+    size_t i = 0, last_item_index = 0, name_len = 0;
+    if (object == NULL || name == NULL) {
         return JSONFailure;
     }
-    last_item_index = json_object_get_count(object) - 1;
-    for (i = 0; i < json_object_get_count(object); i++) {
-        if (strcmp(object->names[i], name) == 0) {
-            parson_free(object->names[i]);
-            if (free_value) {
-                json_value_free(object->values[i]);
-            }
-            if (i != last_item_index) { /* Replace key value pair with one from the end */
-                object->names[i] = object->names[last_item_index];
-                object->values[i] = object->values[last_item_index];
-            }
-            object->count -= 1;
-            return JSONSuccess;
+    name_len = strlen(name);
+    i = json_object_find(object, name, name_len, hash_string(name, name_len));
+    if (i == object->count) {
+        return JSONFailure;
+    }
+    last_item_index = object->count - 1;
+    if (parson_tracked_objects > 0) {
+        json_object_note_removed(object, object->cells[i].name);
+    }
+    if (free_value) {
+        json_object_free_value(object, object->cells[i].name, object->cells[i].value);
+    }
+    free_key(&object->cells[i]);
+    if (i != last_item_index) { /* Replace key value pair with one from the end */
+        object->cells[i] = object->cells[last_item_index];
+        if (object->changes != NULL) {
+            object->changes->dirty[i] = object->changes->dirty[last_item_index];
         }
     }
-    return JSONFailure; /* No execution path should end here */
+    object->count -= 1;
+    return JSONSuccess;
 }
 
 static JSON_Status json_object_dotremove_internal(JSON_Object *object, const char *name, int free_value) {
@@ -479,28 +1679,251 @@ static JSON_Status json_object_dotremove_internal(JSON_Object *object, const cha
     return json_object_dotremove_internal(temp_object, dot_pos + 1, free_value);
 }
 
+/* Frees the storage of an object json_value_free emptied, the object itself lives in its
+ * wrapping value's block */
 static void json_object_free(JSON_Object *object) {
-    size_t i;
+    parson_free(object->cells);
+    json_object_untrack(object);
+}
+
+/* Change tracking */
+/* Enables tracking for object and the objects below it, except inside arrays: a merge patch
+ * replaces arrays as a whole, so a change inside one marks the member holding the array. */
+static JSON_Status json_object_track(JSON_Object *object) {
+    JSON_Changes *changes = NULL;
+    JSON_Object *child = NULL;
+    JSON_Status status = JSONSuccess;
+    size_t i = 0;
+    if (object->changes == NULL) {
+        changes = (JSON_Changes*)parson_malloc(sizeof(JSON_Changes));
+        if (changes == NULL) {
+            return JSONFailure;
+        }
+        memset(changes, 0, sizeof(JSON_Changes));
+        if (object->capacity > 0) {
+            changes->dirty = (unsigned char*)parson_malloc(object->capacity);
+            if (changes->dirty == NULL) {
+                parson_free(changes);
+                return JSONFailure;
+            }
+            memset(changes->dirty, 0, object->capacity);
+        }
+        object->changes = changes;
+        parson_tracked_objects++;
+    }
     for (i = 0; i < object->count; i++) {
-        parson_free(object->names[i]);
-        json_value_free(object->values[i]);
+        child = json_value_get_object(object->cells[i].value);
+        if (child != NULL && json_object_track(child) == JSONFailure) {
+            status = JSONFailure; /* changes below child will mark the member holding it */
+        }
     }
-    parson_free(object->names);
-    parson_free(object->values);
-    parson_free(object);
+    return status;
 }
 
-/* JSON Array */
-static JSON_Array * json_array_init(JSON_Value *wrapping_value) {
-    JSON_Array *new_array = (JSON_Array*)parson_malloc(sizeof(JSON_Array));
-    if (new_array == NULL) {
+static void json_object_untrack(JSON_Object *object) {
+    JSON_Object *child = NULL;
+    size_t i = 0;
+    if (object->changes == NULL) {
+        return;
+    }
+    for (i = 0; i < object->count; i++) {
+        child = json_value_get_object(object->cells[i].value);
+        if (child != NULL) {
+            json_object_untrack(child);
+        }
+    }
+    for (i = 0; i < object->changes->removed_count; i++) {
+        parson_free(object->changes->removed[i]);
+    }
+    parson_free(object->changes->removed);
+    parson_free(object->changes->dirty);
+    json_value_free(object->changes->previous);
+    parson_free(object->changes);
+    object->changes = NULL;
+    parson_tracked_objects--;
+}
+
+static void json_object_mark_dirty(JSON_Object *object, size_t index) {
+    object->changes->dirty[index] = 1;
+    json_object_set_pending(object);
+}
+
+/* Flags object and its tracked ancestors as having changes. Stops at the first ancestor already
+ * flagged; an untracked container on the way marks the member holding it instead. */
+static void json_object_set_pending(JSON_Object *object) {
+    JSON_Value *parent = NULL;
+    JSON_Object *parent_object = NULL;
+    int was_pending = 0;
+    for (;;) {
+        was_pending = object->changes->pending;
+        object->changes->pending = 1;
+        parent = json_value_get_parent(json_object_get_wrapping_value(object));
+        if (parent == NULL) {
+            return;
+        }
+        parent_object = json_value_get_object(parent);
+        if (parent_object == NULL || parent_object->changes == NULL) {
+            json_value_note_change(json_object_get_wrapping_value(object));
+            return;
+        }
+        if (was_pending) {
+            return;
+        }
+        object = parent_object;
+    }
+}
+
+static void json_object_note_removed(JSON_Object *object, const char *name) {
+    JSON_Changes *changes = object->changes;
+    char **temp_removed = NULL;
+    size_t i = 0, new_capacity = 0;
+    if (changes == NULL) {
+        json_value_note_change(json_object_get_wrapping_value(object));
+        return;
+    }
+    for (i = 0; i < changes->removed_count; i++) {
+        if (strcmp(changes->removed[i], name) == 0) {
+            break;
+        }
+    }
+    if (i == changes->removed_count) {
+        if (changes->removed_count >= changes->removed_capacity) {
+            new_capacity = MAX(changes->removed_capacity * 2, STARTING_CAPACITY);
+            temp_removed = (char**)parson_malloc(new_capacity * sizeof(char*));
+            if (temp_removed == NULL) {
+                return; /* the removal is lost, like a failed add */
+            }
+            if (changes->removed_count > 0) {
+                memcpy(temp_removed, changes->removed, changes->removed_count * sizeof(char*));
+            }
+            parson_free(changes->removed);
+            changes->removed = temp_removed;
+            changes->removed_capacity = new_capacity;
+        }
+        changes->removed[changes->removed_count] = parson_strdup(name);
+        if (changes->removed[changes->removed_count] == NULL) {
+            return;
+        }
+        changes->removed_count++;
+    }
+    json_object_set_pending(object);
+}
+
+static void json_object_note_added(JSON_Object *object, size_t index) {
+    JSON_Object *child = NULL;
+    if (object->changes == NULL) {
+        json_value_note_change(json_object_get_wrapping_value(object));
+        return;
+    }
+    child = json_value_get_object(object->cells[index].value);
+    if (child != NULL) {
+        json_object_track(child);
+    }
+    json_object_mark_dirty(object, index);
+}
+
+/* Frees a member value being replaced or removed. A merge patch can't replace an object, only merge
+ * into it, so the first object dropped from a member since the last clear is kept to list the
+ * members the patch has to null. */
+static void json_object_free_value(JSON_Object *object, const char *name, JSON_Value *value) {
+    JSON_Changes *changes = object->changes;
+    if (changes == NULL || json_value_get_type(value) != JSONObject) {
+        json_value_free(value);
+        return;
+    }
+    if (changes->previous == NULL) {
+        changes->previous = json_value_init_object();
+    }
+    if (changes->previous == NULL ||
+        json_object_getn_value(json_value_get_object(changes->previous), name, strlen(name)) != NULL) {
+        json_value_free(value);
+        return;
+    }
+    value->parent = NULL;
+    if (json_object_addn(json_value_get_object(changes->previous), name, strlen(name), value) == JSONFailure) {
+        json_value_free(value); /* the patch may leave stale members */
+    }
+}
+
+/* Patch replacing previous with object: every member of object, null for the members previous had
+ * at the last clear that object doesn't have. */
+static JSON_Value * json_object_replacement_patch(const JSON_Object *previous, const JSON_Object *object) {
+    JSON_Value *patch_value = NULL, *member_patch = NULL, *base = NULL;
+    JSON_Object *patch = NULL, *previous_members = NULL;
+    const JSON_Object_Cell *cell = NULL;
+    size_t i = 0, name_len = 0;
+    patch_value = json_value_init_object();
+    if (patch_value == NULL) {
         return NULL;
     }
-    new_array->wrapping_value = wrapping_value;
-    new_array->items = (JSON_Value**)NULL;
-    new_array->capacity = 0;
-    new_array->count = 0;
-    return new_array;
+    patch = json_value_get_object(patch_value);
+    if (previous->changes != NULL) {
+        previous_members = json_value_get_object(previous->changes->previous);
+    }
+    for (i = 0; i < object->count; i++) {
+        cell = &object->cells[i];
+        name_len = strlen(cell->name);
+        base = previous_members != NULL ? json_object_getn_value(previous_members, cell->name, name_len) : NULL;
+        if (base == NULL) {
+            base = json_object_getn_value(previous, cell->name, name_len);
+        }
+        if (json_value_get_type(base) == JSONObject && json_value_get_type(cell->value) == JSONObject) {
+            member_patch = json_object_replacement_patch(json_value_get_object(base), json_value_get_object(cell->value));
+        } else {
+            member_patch = json_value_deep_copy(cell->value);
+        }
+        if (member_patch == NULL || json_object_addn(patch, cell->name, name_len, member_patch) == JSONFailure) {
+            json_value_free(member_patch);
+            json_value_free(patch_value);
+            return NULL;
+        }
+    }
+    for (i = 0; i < previous->count; i++) {
+        if (json_object_get_value(patch, previous->cells[i].name) == NULL &&
+            json_object_set_null(patch, previous->cells[i].name) == JSONFailure) {
+            json_value_free(patch_value);
+            return NULL;
+        }
+    }
+    if (previous->changes != NULL) {
+        for (i = 0; i < previous->changes->removed_count; i++) {
+            if (json_object_get_value(patch, previous->changes->removed[i]) == NULL &&
+                json_object_set_null(patch, previous->changes->removed[i]) == JSONFailure) {
+                json_value_free(patch_value);
+                return NULL;
+            }
+        }
+    }
+    return patch_value;
+}
+
+/* Something inside container (an array or an untracked object) changed: marks the member holding
+ * it in the closest tracked object above, which gets the whole member in its patch. */
+static void json_value_note_change(JSON_Value *container) {
+    JSON_Value *child = container, *parent = NULL;
+    JSON_Object *object = NULL;
+    size_t i = 0;
+    while ((parent = json_value_get_parent(child)) != NULL) {
+        object = json_value_get_object(parent);
+        if (object != NULL && object->changes != NULL) {
+            for (i = 0; i < object->count; i++) {
+                if (object->cells[i].value == child) {
+                    json_object_mark_dirty(object, i);
+                    return;
+                }
+            }
+            return;
+        }
+        child = parent;
+    }
+}
+
+/* JSON Array */
+static void json_array_init(JSON_Array *array, JSON_Value *wrapping_value) {
+    array->wrapping_value = wrapping_value;
+    array->items = (JSON_Value**)NULL;
+    array->capacity = 0;
+    array->count = 0;
 }
 
 static JSON_Status json_array_add(JSON_Array *array, JSON_Value *value) {
@@ -510,7 +1933,7 @@ static JSON_Status json_array_add(JSON_Array *array, JSON_Value *value) {
             return JSONFailure;
         }
     }
-    value->parent = json_array_get_wrapping_value(array);
+    SET_PARENT(value, json_array_get_wrapping_value(array));
     array->items[array->count] = value;
     array->count++;
     return JSONSuccess;
@@ -518,51 +1941,71 @@ static JSON_Status json_array_add(JSON_Array *array, JSON_Value *value) {
 
 static JSON_Status json_array_resize(JSON_Array *array, size_t new_capacity) {
     JSON_Value **new_items = NULL;
-    if (new_capacity == 0) {
+    if (new_capacity == 0 || new_capacity < array->count) {
         return JSONFailure;
     }
-    new_items = (JSON_Value**)parson_malloc(new_capacity * sizeof(JSON_Value*));
+    new_items = (JSON_Value**)parson_resize(array->items, array->count * sizeof(JSON_Value*),
+                                            new_capacity * sizeof(JSON_Value*));
     if (new_items == NULL) {
         return JSONFailure;
     }
-    if (array->items != NULL && array->count > 0) {
-        memcpy(new_items, array->items, array->count * sizeof(JSON_Value*));
-    }
-    parson_free(array->items);
     array->items = new_items;
     array->capacity = new_capacity;
     return JSONSuccess;
 }
 
+/* Frees the storage of an array json_value_free emptied, the array itself lives in its wrapping
+ * value's block */
 static void json_array_free(JSON_Array *array) {
-    size_t i;
-    for (i = 0; i < array->count; i++) {
-        json_value_free(array->items[i]);
-    }
     parson_free(array->items);
-    parson_free(array);
 }
 
 /* JSON Value */
-static JSON_Value * json_value_init_string_no_copy(char *string) {
-    JSON_Value *new_value = (JSON_Value*)parson_malloc(sizeof(JSON_Value));
-    if (!new_value) {
-        return NULL;
+/* Allocates a string value able to hold len bytes plus the terminator. Short strings are stored in the
+ * value's union, longer ones right after the value in the same block. */
+static JSON_Value * json_value_alloc_string(size_t len) {
+    JSON_Value *new_value = NULL;
+    if (len <= SHORT_STRING_MAX_LEN) {
+        new_value = (JSON_Value*)pool_alloc(JSONPoolValue);
+        if (new_value == NULL) {
+            return NULL;
+        }
+        new_value->type = JSONShortString;
+    } else {
+        new_value = (JSON_Value*)parson_malloc(sizeof(JSON_Value) + len + 1);
+        if (new_value == NULL) {
+            return NULL;
+        }
+        new_value->type = JSONString;
+        new_value->value.string = (char*)(new_value + 1);
     }
     new_value->parent = NULL;
-    new_value->type = JSONString;
-    new_value->value.string = string;
+    return new_value;
+}
+
+static JSON_Value * json_value_init_string_n(const char *string, size_t len) {
+    JSON_Value *new_value = json_value_alloc_string(len);
+    char *buf = NULL;
+    if (new_value == NULL) {
+        return NULL;
+    }
+    buf = STRING_BUFFER(new_value);
+    memcpy(buf, string, len);
+    buf[len] = '\0';
     return new_value;
 }
 
 /* Parser */
-static JSON_Status skip_quotes(const char **string) {
+static JSON_Status skip_quotes(const char **string, const char *end) {
     if (**string != '\"') {
         return JSONFailure;
     }
     SKIP_CHAR(string);
-    while (**string != '\"') {
-        if (**string == '\0') {
+    for (;;) {
+        *string = scan_string_body(*string, end);
+        if (**string == '\"') {
+            break;
+        } else if (**string == '\0') {
             return JSONFailure;
         } else if (**string == '\\') {
             SKIP_CHAR(string);
@@ -623,19 +2066,38 @@ static int parse_utf16(const char **unprocessed, char **processed) {
 }
 
 
-/* Copies and processes passed string up to supplied length.
+/* Processes escape sequences of the string body input (len bytes, without quotes) into output,
+which must hold at least len bytes, and checks the rest is valid UTF-8 in the same pass. An escape
+sequence never expands, so output may be the same buffer as input.
 Example: "\u006Corem ipsum" -> lorem ipsum */
-static char* process_string(const char *input, size_t len) {
-    const char *input_ptr = input;
-    size_t initial_size = (len + 1) * sizeof(char);
-    size_t final_size = 0;
-    char *output = NULL, *output_ptr = NULL, *resized_output = NULL;
-    output = (char*)parson_malloc(initial_size);
-    if (output == NULL) {
-        goto error;
-    }
-    output_ptr = output;
-    while ((*input_ptr != '\0') && (size_t)(input_ptr - input) < len) {
+static int unescape_string(const char *input, size_t len, char *output, size_t *output_len) {
+    const char *input_ptr = input, *input_end = input + len;
+    char *output_ptr = output;
+    size_t run_len = 0;
+    unsigned int state = UTF8_ACCEPT;
+    while (input_ptr < input_end) {
+        run_len = count_unescaped(input_ptr, (size_t)(input_end - input_ptr));
+        if (run_len > 0) {
+            if (output_ptr != input_ptr) {
+                memmove(output_ptr, input_ptr, run_len);
+            }
+            output_ptr += run_len;
+            input_ptr += run_len;
+            continue;
+        }
+        if ((unsigned char)*input_ptr >= 0x80) { /* copy the run of multibyte sequences */
+            do {
+                state = utf8_transitions[state][utf8_classes[(unsigned char)*input_ptr - 0x80]];
+                if (state == UTF8_REJECT) {
+                    return JSONFailure;
+                }
+                *output_ptr++ = *input_ptr++;
+            } while (input_ptr < input_end && (unsigned char)*input_ptr >= 0x80);
+            if (state != UTF8_ACCEPT) {
+                return JSONFailure;
+            }
+            continue;
+        }
         if (*input_ptr == '\\') {
             input_ptr++;
             switch (*input_ptr) {
@@ -649,30 +2111,46 @@ static char* process_string(const char *input, size_t len) {
                 case 't':  *output_ptr = '\t'; break;
                 case 'u':
                     if (parse_utf16(&input_ptr, &output_ptr) == JSONFailure) {
-                        goto error;
+                        return JSONFailure;
                     }
                     break;
                 default:
-                    goto error;
+                    return JSONFailure;
             }
         } else if ((unsigned char)*input_ptr < 0x20) {
-            goto error; /* 0x00-0x19 are invalid characters for json string (http://www.ietf.org/rfc/rfc4627.txt) */
+            return JSONFailure; /* 0x00-0x19 are invalid characters for json string (http://www.ietf.org/rfc/rfc4627.txt) */
         } else {
             *output_ptr = *input_ptr;
         }
         output_ptr++;
         input_ptr++;
     }
-    *output_ptr = '\0';
-    /* resize to new length */
-    final_size = (size_t)(output_ptr-output) + 1;
-    /* todo: don't resize if final_size == initial_size */
-    resized_output = (char*)parson_malloc(final_size);
+    *output_len = (size_t)(output_ptr - output);
+    return JSONSuccess;
+}
+
+/* Copies and processes passed string up to supplied length. */
+static char* process_string(const char *input, size_t len) {
+    size_t initial_size = (len + 1) * sizeof(char);
+    size_t final_size = 0;
+    char *output = NULL, *resized_output = NULL;
+    output = (char*)parson_malloc(initial_size);
+    if (output == NULL) {
+        goto error;
+    }
+    if (unescape_string(input, len, output, &final_size) == JSONFailure) {
+        goto error;
+    }
+    output[final_size] = '\0';
+    final_size = final_size + 1;
+    if (final_size == initial_size) {
+        return output;
+    }
+    /* escapes made it shorter */
+    resized_output = (char*)parson_resize(output, final_size, final_size);
     if (resized_output == NULL) {
         goto error;
     }
-    memcpy(resized_output, output, final_size);
-    parson_free(output);
     return resized_output;
 error:
     parson_free(output);
@@ -681,10 +2159,10 @@ error:
 
 /* Return processed contents of a string between quotes and
    skips passed argument to a matching quote. */
-static char * get_quoted_string(const char **string) {
+static char * get_quoted_string(const char **string, const char *end) {
     const char *string_start = *string;
     size_t string_len = 0;
-    JSON_Status status = skip_quotes(string);
+    JSON_Status status = skip_quotes(string, end);
     if (status != JSONSuccess) {
         return NULL;
     }
@@ -692,151 +2170,176 @@ static char * get_quoted_string(const char **string) {
     return process_string(string_start + 1, string_len);
 }
 
-static JSON_Value * parse_value(const char **string, size_t nesting) {
-    if (nesting > MAX_NESTING) {
+/* Reads '"name":', returns the processed name. */
+static char * parse_member_name(const char **string, const char *end, size_t *name_len) {
+    char *name = get_quoted_string(string, end);
+    if (name == NULL) {
         return NULL;
     }
-    SKIP_WHITESPACES(string);
-    switch (**string) {
-        case '{':
-            return parse_object_value(string, nesting + 1);
-        case '[':
-            return parse_array_value(string, nesting + 1);
-        case '\"':
-            return parse_string_value(string);
-        case 'f': case 't':
-            return parse_boolean_value(string);
-        case '-':
-        case '0': case '1': case '2': case '3': case '4':
-        case '5': case '6': case '7': case '8': case '9':
-            return parse_number_value(string);
-        case 'n':
-            return parse_null_value(string);
-        default:
-            return NULL;
+    SKIP_WHITESPACES(string, end);
+    if (**string != ':') {
+        parson_free(name);
+        return NULL;
     }
+    SKIP_CHAR(string);
+    *name_len = strlen(name);
+    return name;
 }
 
-static JSON_Value * parse_object_value(const char **string, size_t nesting) {
-    JSON_Value *output_value = NULL, *new_value = NULL;
-    JSON_Object *output_object = NULL;
-    char *new_key = NULL;
-    output_value = json_value_init_object();
-    if (output_value == NULL) {
-        return NULL;
+/* Adds a parsed member, taking over name (freed on failure, value isn't). Duplicate names fail. */
+static JSON_Status parse_add_member(JSON_Object *object, char *name, size_t name_len, JSON_Value *value) {
+    JSON_Object_Cell cell;
+    unsigned long hash = hash_string(name, name_len);
+    if (json_object_find(object, name, name_len, hash) != object->count) {
+        parson_free(name);
+        return JSONFailure;
     }
-    if (**string != '{') {
-        json_value_free(output_value);
-        return NULL;
+    cell.name = name;
+    cell.hash = hash;
+    if (parson_intern_keys) { /* swap the parsed copy for the shared one */
+        cell.name = copy_key(name, name_len, hash, &cell.hash);
+        parson_free(name);
+        if (cell.name == NULL) {
+            return JSONFailure;
+        }
     }
-    output_object = json_value_get_object(output_value);
-    SKIP_CHAR(string);
-    SKIP_WHITESPACES(string);
-    if (**string == '}') { /* empty object */
-        SKIP_CHAR(string);
-        return output_value;
+    if (json_object_add_cell(object, cell.name, cell.hash, value) == JSONFailure) {
+        free_key(&cell);
+        return JSONFailure;
     }
-    while (**string != '\0') {
-        new_key = get_quoted_string(string);
-        if (new_key == NULL) {
-            json_value_free(output_value);
-            return NULL;
-        }
-        SKIP_WHITESPACES(string);
-        if (**string != ':') {
-            parson_free(new_key);
-            json_value_free(output_value);
-            return NULL;
-        }
-        SKIP_CHAR(string);
-        new_value = parse_value(string, nesting);
-        if (new_value == NULL) {
-            parson_free(new_key);
-            json_value_free(output_value);
-            return NULL;
-        }
-        if (json_object_add(output_object, new_key, new_value) == JSONFailure) {
-            parson_free(new_key);
-            json_value_free(new_value);
-            json_value_free(output_value);
-            return NULL;
-        }
-        parson_free(new_key);
-        SKIP_WHITESPACES(string);
-        if (**string != ',') {
-            break;
-        }
-        SKIP_CHAR(string);
-        SKIP_WHITESPACES(string);
+    return JSONSuccess;
+}
+
+/* Trims a parsed container to its size */
+static JSON_Status parse_close_container(JSON_Value *container) {
+    JSON_Object *object = json_value_get_object(container);
+    JSON_Array *array = json_value_get_array(container);
+    if (object != NULL && object->count > 0) {
+        return json_object_resize(object, object->count);
+    } else if (array != NULL && array->count > 0) {
+        return json_array_resize(array, array->count);
     }
-    SKIP_WHITESPACES(string);
-    if (**string != '}' || /* Trim object after parsing is over */
-        json_object_resize(output_object, json_object_get_count(output_object)) == JSONFailure) {
-            json_value_free(output_value);
-            return NULL;
+    return JSONSuccess;
+}
+
+/* Iterative, so nesting costs no C stack: containers are attached to their parent as soon as they
+ * open and the parent links lead back up when they close. */
+static JSON_Value * parse_value(const char **string, const char *end) {
+    JSON_Value *root = NULL, *container = NULL, *new_value = NULL;
+    char *name = NULL, close_char = '\0';
+    size_t name_len = 0, nesting = 0;
+    int expect_value = 1;
+    for (;;) {
+        if (expect_value) {
+            SKIP_WHITESPACES(string, end);
+            switch (**string) {
+                case '{':
+                    new_value = nesting < parson_max_nesting ? json_value_init_object() : NULL;
+                    break;
+                case '[':
+                    new_value = nesting < parson_max_nesting ? json_value_init_array() : NULL;
+                    break;
+                case '\"':
+                    new_value = parse_string_value(string, end);
+                    break;
+                case 'f': case 't':
+                    new_value = parse_boolean_value(string);
+                    break;
+                case '-':
+                case '0': case '1': case '2': case '3': case '4':
+                case '5': case '6': case '7': case '8': case '9':
+                    new_value = parse_number_value(string);
+                    break;
+                case 'n':
+                    new_value = parse_null_value(string);
+                    break;
+                default:
+                    new_value = NULL;
+                    break;
+            }
+            if (new_value == NULL) {
+                break;
+            }
+            if (container == NULL) {
+                root = new_value;
+            } else if (json_value_get_type(container) == JSONObject) {
+                if (parse_add_member(json_value_get_object(container), name, name_len, new_value) == JSONFailure) {
+                    name = NULL;
+                    json_value_free(new_value);
+                    break;
+                }
+                name = NULL;
+            } else if (json_array_add(json_value_get_array(container), new_value) == JSONFailure) {
+                json_value_free(new_value);
+                break;
+            }
+            expect_value = 0;
+            if (json_value_get_type(new_value) == JSONObject || json_value_get_type(new_value) == JSONArray) {
+                container = new_value;
+                nesting++;
+                close_char = json_value_get_type(container) == JSONObject ? '}' : ']';
+                SKIP_CHAR(string);
+                SKIP_WHITESPACES(string, end);
+                if (**string != close_char) { /* not empty */
+                    if (close_char == '}' && (name = parse_member_name(string, end, &name_len)) == NULL) {
+                        break;
+                    }
+                    expect_value = 1;
+                }
+            }
+        } else {
+            if (container == NULL) {
+                return root;
+            }
+            close_char = json_value_get_type(container) == JSONObject ? '}' : ']';
+            SKIP_WHITESPACES(string, end);
+            if (**string == ',') {
+                SKIP_CHAR(string);
+                SKIP_WHITESPACES(string, end);
+                if (close_char == '}' && (name = parse_member_name(string, end, &name_len)) == NULL) {
+                    break;
+                }
+                expect_value = 1;
+            } else if (**string == close_char && parse_close_container(container) == JSONSuccess) {
+                SKIP_CHAR(string);
+                nesting--;
+                container = json_value_get_parent(container);
+            } else {
+                break;
+            }
+        }
     }
-    SKIP_CHAR(string);
-    return output_value;
+    parson_free(name);
+    json_value_free(root);
+    return NULL;
 }
 
-static JSON_Value * parse_array_value(const char **string, size_t nesting) {
-    JSON_Value *output_value = NULL, *new_array_value = NULL;
-    JSON_Array *output_array = NULL;
-    output_value = json_value_init_array();
-    if (output_value == NULL) {
+static JSON_Value * parse_string_value(const char **string, const char *end) {
+    JSON_Value *value = NULL, *exact_value = NULL;
+    const char *string_start = *string;
+    char *buf = NULL;
+    size_t string_len = 0, processed_len = 0;
+    if (skip_quotes(string, end) != JSONSuccess) {
         return NULL;
     }
-    if (**string != '[') {
-        json_value_free(output_value);
+    string_len = *string - string_start - 2; /* length without quotes */
+    value = json_value_alloc_string(string_len);
+    if (value == NULL) {
         return NULL;
     }
-    output_array = json_value_get_array(output_value);
-    SKIP_CHAR(string);
-    SKIP_WHITESPACES(string);
-    if (**string == ']') { /* empty array */
-        SKIP_CHAR(string);
-        return output_value;
+    buf = STRING_BUFFER(value);
+    if (unescape_string(string_start + 1, string_len, buf, &processed_len) == JSONFailure) {
+        json_value_free(value);
+        return NULL;
     }
-    while (**string != '\0') {
-        new_array_value = parse_value(string, nesting);
-        if (new_array_value == NULL) {
-            json_value_free(output_value);
-            return NULL;
-        }
-        if (json_array_add(output_array, new_array_value) == JSONFailure) {
-            json_value_free(new_array_value);
-            json_value_free(output_value);
-            return NULL;
-        }
-        SKIP_WHITESPACES(string);
-        if (**string != ',') {
-            break;
-        }
-        SKIP_CHAR(string);
-        SKIP_WHITESPACES(string);
-    }
-    SKIP_WHITESPACES(string);
-    if (**string != ']' || /* Trim array after parsing is over */
-        json_array_resize(output_array, json_array_get_count(output_array)) == JSONFailure) {
-            json_value_free(output_value);
-            return NULL;
-    }
-    SKIP_CHAR(string);
-    return output_value;
-}
-
-static JSON_Value * parse_string_value(const char **string) {
-    JSON_Value *value = NULL;
-    char *new_string = get_quoted_string(string);
-    if (new_string == NULL) {
-        return NULL;
+    buf[processed_len] = '\0';
+    if (processed_len == string_len) {
+        return value;
     }
-    value = json_value_init_string_no_copy(new_string);
-    if (value == NULL) {
-        parson_free(new_string);
-        return NULL;
-    }
-    return value;
+    /* escapes made it shorter, don't keep the slack */
+    exact_value = json_value_init_string_n(buf, processed_len);
+    json_value_free(value);
+    return exact_value;
 }
 
 static JSON_Value * parse_boolean_value(const char **string) {
@@ -853,14 +2356,17 @@ static JSON_Value * parse_boolean_value(const char **string) {
 }
 
 static JSON_Value * parse_number_value(const char **string) {
-    char *end;
     double number = 0;
-    errno = 0;
-    number = strtod(*string, &end);
-    if (errno || !is_decimal(*string, end - *string)) {
+    int64_t integer = 0;
+    int is_integer = 0;
+    size_t length = parse_number(*string, (size_t)-1, &number, &integer, &is_integer);
+    if (length == 0) {
         return NULL;
     }
-    *string = end;
+    *string += length;
+    if (is_integer && parson_parse_int64) {
+        return json_value_init_int64(integer);
+    }
     return json_value_init_number(number);
 }
 
@@ -879,116 +2385,110 @@ static JSON_Value * parse_null_value(const char **string) {
                                 if (buf != NULL) { buf += written; }\
                                 written_total += written; } while(0)
 
-#define APPEND_INDENT(level) do { written = append_indent(buf, (level));\
-                                  if (written < 0) { return -1; }\
-                                  if (buf != NULL) { buf += written; }\
+#define APPEND_RUN(str, len) do { written = (int)(len);\
+                                  if (buf != NULL) { memcpy(buf, (str), (size_t)written); buf += written; }\
                                   written_total += written; } while(0)
 
-static int json_serialize_to_buffer_r(const JSON_Value *value, char *buf, int level, int is_pretty, char *num_buf)
-{
-    const char *key = NULL, *string = NULL;
-    JSON_Value *temp_value = NULL;
-    JSON_Array *array = NULL;
-    JSON_Object *object = NULL;
-    size_t i = 0, count = 0;
-    double num = 0.0;
-    int written = -1, written_total = 0;
+/* Adds written to *written_total; 0 if written is an error, or the total would leave no room for the
+ * terminator in a size_t. The indentation of a pretty document grows with the square of its depth. */
+static int add_written(size_t *written_total, int written) {
+    if (written < 0 || (size_t)written >= (size_t)-1 - *written_total) {
+        return 0;
+    }
+    *written_total += (size_t)written;
+    return 1;
+}
 
-    switch (json_value_get_type(value)) {
-        case JSONArray:
-            array = json_value_get_array(value);
-            count = json_array_get_count(array);
-            APPEND_STRING("[");
-            if (count > 0 && is_pretty) {
-                APPEND_STRING("\n");
-            }
-            for (i = 0; i < count; i++) {
-                if (is_pretty) {
-                    APPEND_INDENT(level+1);
-                }
-                temp_value = json_array_get_value(array, i);
-                written = json_serialize_to_buffer_r(temp_value, buf, level+1, is_pretty, num_buf);
-                if (written < 0) {
-                    return -1;
-                }
-                if (buf != NULL) {
-                    buf += written;
-                }
-                written_total += written;
-                if (i < (count - 1)) {
-                    APPEND_STRING(",");
-                }
-                if (is_pretty) {
-                    APPEND_STRING("\n");
-                }
-            }
-            if (count > 0 && is_pretty) {
-                APPEND_INDENT(level);
-            }
-            APPEND_STRING("]");
-            return written_total;
-        case JSONObject:
-            object = json_value_get_object(value);
-            count  = json_object_get_count(object);
-            APPEND_STRING("{");
-            if (count > 0 && is_pretty) {
-                APPEND_STRING("\n");
-            }
-            for (i = 0; i < count; i++) {
-                key = json_object_get_name(object, i);
-                if (key == NULL) {
-                    return -1;
-                }
-                if (is_pretty) {
-                    APPEND_INDENT(level+1);
+#define WALK_APPEND(expr) do { written = (expr);\
+                               if (!add_written(&written_total, written)) { return 0; }\
+                               if (buf != NULL) { buf += written; } } while(0)
+
+/* Returns the length of the serialization, 0 on failure (no value serializes to nothing) */
+static size_t json_serialize_to_buffer_r(const JSON_Value *value, char *buf, int is_pretty, char *num_buf) {
+    JSON_Walk walk;
+    size_t written = 0;
+    walk_init(&walk);
+    written = json_serialize_walk(&walk, value, buf, is_pretty, num_buf);
+    walk_free(&walk);
+    return written;
+}
+
+/* Iterative: walk holds the containers being written and the next member or item of each. */
+static size_t json_serialize_walk(JSON_Walk *walk, const JSON_Value *value, char *buf, int is_pretty, char *num_buf) {
+    JSON_Walk_Frame *frame = NULL;
+    const JSON_Object *object = NULL;
+    size_t count = 0, written_total = 0;
+    int written = -1;
+    do {
+        switch (json_value_get_type(value)) {
+            case JSONArray:
+                WALK_APPEND(append_string(buf, "["));
+                if (json_array_get_count(json_value_get_array(value)) == 0) {
+                    WALK_APPEND(append_string(buf, "]"));
+                } else if (walk_push(walk, value, 0) == NULL) {
+                    return 0;
                 }
-                written = json_serialize_string(key, buf);
-                if (written < 0) {
-                    return -1;
+                break;
+            case JSONObject:
+                WALK_APPEND(append_string(buf, "{"));
+                if (json_object_get_count(json_value_get_object(value)) == 0) {
+                    WALK_APPEND(append_string(buf, "}"));
+                } else if (walk_push(walk, value, 0) == NULL) {
+                    return 0;
                 }
-                if (buf != NULL) {
-                    buf += written;
+                break;
+            default:
+                WALK_APPEND(json_serialize_scalar(value, buf, num_buf));
+                break;
+        }
+        /* find the next value, closing the containers done */
+        value = NULL;
+        while (walk->depth > 0 && value == NULL) {
+            frame = &walk->frames[walk->depth - 1];
+            object = json_value_get_object(frame->container);
+            count = object != NULL ? object->count : json_value_get_array(frame->container)->count;
+            if (frame->index < count) {
+                if (frame->index > 0) {
+                    WALK_APPEND(append_string(buf, ","));
                 }
-                written_total += written;
-                APPEND_STRING(":");
                 if (is_pretty) {
-                    APPEND_STRING(" ");
+                    WALK_APPEND(append_string(buf, "\n"));
+                    WALK_APPEND(append_indent(buf, walk->depth));
                 }
-                temp_value = json_object_get_value(object, key);
-                written = json_serialize_to_buffer_r(temp_value, buf, level+1, is_pretty, num_buf);
-                if (written < 0) {
-                    return -1;
-                }
-                if (buf != NULL) {
-                    buf += written;
-                }
-                written_total += written;
-                if (i < (count - 1)) {
-                    APPEND_STRING(",");
+                if (object != NULL) {
+                    WALK_APPEND(json_serialize_string(object->cells[frame->index].name, buf));
+                    WALK_APPEND(append_string(buf, is_pretty ? ": " : ":"));
+                    value = object->cells[frame->index].value;
+                } else {
+                    value = json_value_get_array(frame->container)->items[frame->index];
                 }
+                frame->index++;
+            } else {
+                walk->depth--;
                 if (is_pretty) {
-                    APPEND_STRING("\n");
+                    WALK_APPEND(append_string(buf, "\n"));
+                    WALK_APPEND(append_indent(buf, walk->depth));
                 }
+                WALK_APPEND(append_string(buf, object != NULL ? "}" : "]"));
             }
-            if (count > 0 && is_pretty) {
-                APPEND_INDENT(level);
-            }
-            APPEND_STRING("}");
-            return written_total;
+        }
+    } while (value != NULL);
+    return written_total;
+}
+
+#undef WALK_APPEND
+
+static int json_serialize_scalar(const JSON_Value *value, char *buf, char *num_buf) {
+    const char *string = NULL;
+    double num = 0.0;
+    int written = -1, written_total = 0;
+    switch (json_value_get_type(value)) {
         case JSONString:
             string = json_value_get_string(value);
             if (string == NULL) {
                 return -1;
             }
-            written = json_serialize_string(string, buf);
-            if (written < 0) {
-                return -1;
-            }
-            if (buf != NULL) {
-                buf += written;
-            }
-            written_total += written;
-            return written_total;
+            return json_serialize_string(string, buf);
         case JSONBoolean:
             if (json_value_get_boolean(value)) {
                 APPEND_STRING("true");
@@ -997,103 +2497,98 @@ static int json_serialize_to_buffer_r(const JSON_Value *value, char *buf, int le
             }
             return written_total;
         case JSONNumber:
-            num = json_value_get_number(value);
             if (buf != NULL) {
                 num_buf = buf;
             }
-            written = sprintf(num_buf, FLOAT_FORMAT, num);
-            if (written < 0) {
-                return -1;
-            }
-            if (buf != NULL) {
-                buf += written;
+            if (value->type == JSONInteger) {
+                written = int64_to_string(value->value.integer, num_buf);
+            } else {
+                num = json_value_get_number(value);
+                written = sprintf(num_buf, FLOAT_FORMAT, num);
             }
-            written_total += written;
-            return written_total;
+            return written;
         case JSONNull:
             APPEND_STRING("null");
             return written_total;
-        case JSONError:
-            return -1;
         default:
             return -1;
     }
 }
 
 static int json_serialize_string(const char *string, char *buf) {
-    size_t i = 0, len = strlen(string);
-    char c = '\0';
+    const char *run = string, *escaped = NULL;
     int written = -1, written_total = 0;
     APPEND_STRING("\"");
-    for (i = 0; i < len; i++) {
-        c = string[i];
-        switch (c) {
-            case '\"': APPEND_STRING("\\\""); break;
-            case '\\': APPEND_STRING("\\\\"); break;
-            case '\b': APPEND_STRING("\\b"); break;
-            case '\f': APPEND_STRING("\\f"); break;
-            case '\n': APPEND_STRING("\\n"); break;
-            case '\r': APPEND_STRING("\\r"); break;
-            case '\t': APPEND_STRING("\\t"); break;
-            case '\x00': APPEND_STRING("\\u0000"); break;
-            case '\x01': APPEND_STRING("\\u0001"); break;
-            case '\x02': APPEND_STRING("\\u0002"); break;
-            case '\x03': APPEND_STRING("\\u0003"); break;
-            case '\x04': APPEND_STRING("\\u0004"); break;
-            case '\x05': APPEND_STRING("\\u0005"); break;
-            case '\x06': APPEND_STRING("\\u0006"); break;
-            case '\x07': APPEND_STRING("\\u0007"); break;
-            /* '\x08' duplicate: '\b' */
-            /* '\x09' duplicate: '\t' */
-            /* '\x0a' duplicate: '\n' */
-            case '\x0b': APPEND_STRING("\\u000b"); break;
-            /* '\x0c' duplicate: '\f' */
-            /* '\x0d' duplicate: '\r' */
-            case '\x0e': APPEND_STRING("\\u000e"); break;
-            case '\x0f': APPEND_STRING("\\u000f"); break;
-            case '\x10': APPEND_STRING("\\u0010"); break;
-            case '\x11': APPEND_STRING("\\u0011"); break;
-            case '\x12': APPEND_STRING("\\u0012"); break;
-            case '\x13': APPEND_STRING("\\u0013"); break;
-            case '\x14': APPEND_STRING("\\u0014"); break;
-            case '\x15': APPEND_STRING("\\u0015"); break;
-            case '\x16': APPEND_STRING("\\u0016"); break;
-            case '\x17': APPEND_STRING("\\u0017"); break;
-            case '\x18': APPEND_STRING("\\u0018"); break;
-            case '\x19': APPEND_STRING("\\u0019"); break;
-            case '\x1a': APPEND_STRING("\\u001a"); break;
-            case '\x1b': APPEND_STRING("\\u001b"); break;
-            case '\x1c': APPEND_STRING("\\u001c"); break;
-            case '\x1d': APPEND_STRING("\\u001d"); break;
-            case '\x1e': APPEND_STRING("\\u001e"); break;
-            case '\x1f': APPEND_STRING("\\u001f"); break;
-            case '/':
-                if (parson_escape_slashes) {
-                    APPEND_STRING("\\/");  /* to make json embeddable in xml\/html */
-                } else {
-                    APPEND_STRING("/");
-                }
-                break;
-            default:
-                if (buf != NULL) {
-                    buf[0] = c;
-                    buf += 1;
-                }
-                written_total += 1;
-                break;
+    for (; *string != '\0'; string++) {
+        escaped = MAY_ESCAPE(*string) ? json_escape_char(*string) : NULL;
+        if (escaped != NULL) {
+            APPEND_RUN(run, string - run);
+            APPEND_RUN(escaped, strlen(escaped));
+            run = string + 1;
         }
     }
+    APPEND_RUN(run, string - run);
     APPEND_STRING("\"");
     return written_total;
 }
 
-static int append_indent(char *buf, int level) {
-    int i;
-    int written = -1, written_total = 0;
-    for (i = 0; i < level; i++) {
-        APPEND_STRING("    ");
+/* Escape sequence written for c, NULL if c is written as is. Shared by both serializers. */
+static const char * json_escape_char(char c) {
+    switch (c) {
+        case '\"': return "\\\"";
+        case '\\': return "\\\\";
+        case '\b': return "\\b";
+        case '\f': return "\\f";
+        case '\n': return "\\n";
+        case '\r': return "\\r";
+        case '\t': return "\\t";
+        case '\x00': return "\\u0000";
+        case '\x01': return "\\u0001";
+        case '\x02': return "\\u0002";
+        case '\x03': return "\\u0003";
+        case '\x04': return "\\u0004";
+        case '\x05': return "\\u0005";
+        case '\x06': return "\\u0006";
+        case '\x07': return "\\u0007";
+        /* '\x08' duplicate: '\b' */
+        /* '\x09' duplicate: '\t' */
+        /* '\x0a' duplicate: '\n' */
+        case '\x0b': return "\\u000b";
+        /* '\x0c' duplicate: '\f' */
+        /* '\x0d' duplicate: '\r' */
+        case '\x0e': return "\\u000e";
+        case '\x0f': return "\\u000f";
+        case '\x10': return "\\u0010";
+        case '\x11': return "\\u0011";
+        case '\x12': return "\\u0012";
+        case '\x13': return "\\u0013";
+        case '\x14': return "\\u0014";
+        case '\x15': return "\\u0015";
+        case '\x16': return "\\u0016";
+        case '\x17': return "\\u0017";
+        case '\x18': return "\\u0018";
+        case '\x19': return "\\u0019";
+        case '\x1a': return "\\u001a";
+        case '\x1b': return "\\u001b";
+        case '\x1c': return "\\u001c";
+        case '\x1d': return "\\u001d";
+        case '\x1e': return "\\u001e";
+        case '\x1f': return "\\u001f";
+        case '/':
+            return parson_escape_slashes ? "\\/" : NULL; /* to make json embeddable in xml\/html */
+        default:
+            return NULL;
     }
-    return written_total;
+}
+
+static int append_indent(char *buf, size_t level) {
+    if (level > INT_MAX / 4) {
+        return -1;
+    }
+    if (buf != NULL) {
+        memset(buf, ' ', level * 4);
+    }
+    return (int)(level * 4);
 }
 
 static int append_string(char *buf, const char *string) {
@@ -1104,816 +2599,2544 @@ static int append_string(char *buf, const char *string) {
 }
 
 #undef APPEND_STRING
-#undef APPEND_INDENT
+#undef APPEND_RUN
 
-/* Parser API */
-#ifdef PARSON_FILES
-JSON_Value * json_parse_file(const char *filename) {
-    char *file_contents = read_file(filename);
-    JSON_Value *output_value = NULL;
-    if (file_contents == NULL) {
-        return NULL;
+/* Streaming serialization */
+static void writer_flush(JSON_Writer *writer) {
+    if (writer->used > 0 && writer->status == JSONSuccess) {
+        writer->status = writer->write(writer->context, writer->chunk, writer->used);
     }
-    output_value = json_parse_string(file_contents);
-    parson_free(file_contents);
-    return output_value;
+    writer->used = 0;
 }
 
-JSON_Value * json_parse_file_with_comments(const char *filename) {
-    char *file_contents = read_file(filename);
-    JSON_Value *output_value = NULL;
-    if (file_contents == NULL) {
-        return NULL;
+static void writer_put(JSON_Writer *writer, const char *data, size_t len) {
+    size_t n = 0;
+    while (len > 0 && writer->status == JSONSuccess) {
+        if (writer->used == 0 && len >= writer->chunk_size) {
+            /* whole chunks of long strings go out without staging */
+            writer->status = writer->write(writer->context, data, writer->chunk_size);
+            n = writer->chunk_size;
+        } else {
+            n = MIN(len, writer->chunk_size - writer->used);
+            memcpy(writer->chunk + writer->used, data, n);
+            writer->used += n;
+            if (writer->used == writer->chunk_size) {
+                writer_flush(writer);
+            }
+        }
+        data += n;
+        len -= n;
     }
-    output_value = json_parse_string_with_comments(file_contents);
-    parson_free(file_contents);
-    return output_value;
 }
-#endif
 
-JSON_Value * json_parse_string(const char *string) {
-    if (string == NULL) {
-        return NULL;
-    }
-    if (string[0] == '\xEF' && string[1] == '\xBB' && string[2] == '\xBF') {
-        string = string + 3; /* Support for UTF-8 BOM */
+static void writer_put_indent(JSON_Writer *writer, size_t level) {
+    size_t i;
+    for (i = 0; i < level; i++) {
+        writer_put(writer, "    ", 4);
     }
-    return parse_value((const char**)&string, 0);
 }
 
-JSON_Value * json_parse_string_with_comments(const char *string) {
-    JSON_Value *result = NULL;
-    char *string_mutable_copy = NULL, *string_mutable_copy_ptr = NULL;
-    string_mutable_copy = parson_strdup(string);
-    if (string_mutable_copy == NULL) {
-        return NULL;
+/* Same output as json_serialize_string(), runs of unescaped bytes are put at once */
+static void writer_put_string(JSON_Writer *writer, const char *string) {
+    const char *run = string, *escaped = NULL;
+    writer_put(writer, "\"", 1);
+    for (; *string != '\0'; string++) {
+        escaped = MAY_ESCAPE(*string) ? json_escape_char(*string) : NULL;
+        if (escaped != NULL) {
+            writer_put(writer, run, (size_t)(string - run));
+            writer_put(writer, escaped, strlen(escaped));
+            run = string + 1;
+        }
     }
-    remove_comments(string_mutable_copy, "/*", "*/");
-    remove_comments(string_mutable_copy, "//", "\n");
-    string_mutable_copy_ptr = string_mutable_copy;
-    result = parse_value((const char**)&string_mutable_copy_ptr, 0);
-    parson_free(string_mutable_copy);
-    return result;
+    writer_put(writer, run, (size_t)(string - run));
+    writer_put(writer, "\"", 1);
 }
 
-/* JSON Object API */
-
-JSON_Value * json_object_get_value(const JSON_Object *object, const char *name) {
-    if (object == NULL || name == NULL) {
-        return NULL;
+static void writer_put_scalar(JSON_Writer *writer, const JSON_Value *value) {
+    char num_buf[NUM_BUF_SIZE];
+    const char *string = NULL;
+    int written = -1;
+    switch (json_value_get_type(value)) {
+        case JSONString:
+            string = json_value_get_string(value);
+            if (string == NULL) {
+                writer->status = JSONFailure;
+                return;
+            }
+            writer_put_string(writer, string);
+            break;
+        case JSONBoolean:
+            string = json_value_get_boolean(value) ? "true" : "false";
+            writer_put(writer, string, strlen(string));
+            break;
+        case JSONNumber:
+            if (value->type == JSONInteger) {
+                written = int64_to_string(value->value.integer, num_buf);
+            } else {
+                written = sprintf(num_buf, FLOAT_FORMAT, json_value_get_number(value));
+            }
+            if (written < 0) {
+                writer->status = JSONFailure;
+                return;
+            }
+            writer_put(writer, num_buf, (size_t)written);
+            break;
+        case JSONNull:
+            writer_put(writer, "null", 4);
+            break;
+        default:
+            writer->status = JSONFailure;
+            break;
     }
-    return json_object_getn_value(object, name, strlen(name));
-}
-
-const char * json_object_get_string(const JSON_Object *object, const char *name) {
-    return json_value_get_string(json_object_get_value(object, name));
 }
 
-double json_object_get_number(const JSON_Object *object, const char *name) {
-    return json_value_get_number(json_object_get_value(object, name));
+/* Same walk as json_serialize_walk(), writing to the sink instead of a buffer */
+static JSON_Status json_serialize_writer_walk(JSON_Walk *walk, const JSON_Value *value, JSON_Writer *writer, int is_pretty) {
+    JSON_Walk_Frame *frame = NULL;
+    const JSON_Object *object = NULL;
+    size_t count = 0;
+    do {
+        switch (json_value_get_type(value)) {
+            case JSONArray:
+                writer_put(writer, "[", 1);
+                if (json_array_get_count(json_value_get_array(value)) == 0) {
+                    writer_put(writer, "]", 1);
+                } else if (walk_push(walk, value, 0) == NULL) {
+                    return JSONFailure;
+                }
+                break;
+            case JSONObject:
+                writer_put(writer, "{", 1);
+                if (json_object_get_count(json_value_get_object(value)) == 0) {
+                    writer_put(writer, "}", 1);
+                } else if (walk_push(walk, value, 0) == NULL) {
+                    return JSONFailure;
+                }
+                break;
+            default:
+                writer_put_scalar(writer, value);
+                break;
+        }
+        if (writer->status == JSONFailure) {
+            return JSONFailure;
+        }
+        /* find the next value, closing the containers done */
+        value = NULL;
+        while (walk->depth > 0 && value == NULL) {
+            frame = &walk->frames[walk->depth - 1];
+            object = json_value_get_object(frame->container);
+            count = object != NULL ? object->count : json_value_get_array(frame->container)->count;
+            if (frame->index < count) {
+                if (frame->index > 0) {
+                    writer_put(writer, ",", 1);
+                }
+                if (is_pretty) {
+                    writer_put(writer, "\n", 1);
+                    writer_put_indent(writer, walk->depth);
+                }
+                if (object != NULL) {
+                    writer_put_string(writer, object->cells[frame->index].name);
+                    writer_put(writer, is_pretty ? ": " : ":", is_pretty ? 2 : 1);
+                    value = object->cells[frame->index].value;
+                } else {
+                    value = json_value_get_array(frame->container)->items[frame->index];
+                }
+                frame->index++;
+            } else {
+                walk->depth--;
+                if (is_pretty) {
+                    writer_put(writer, "\n", 1);
+                    writer_put_indent(writer, walk->depth);
+                }
+                writer_put(writer, object != NULL ? "}" : "]", 1);
+            }
+        }
+    } while (value != NULL && writer->status == JSONSuccess);
+    return writer->status;
 }
 
-JSON_Object * json_object_get_object(const JSON_Object *object, const char *name) {
-    return json_value_get_object(json_object_get_value(object, name));
+static JSON_Status json_serialize_to_writer_r(const JSON_Value *value, char *chunk, size_t chunk_size,
+                                              JSON_Write_Function write_fun, void *context, int is_pretty) {
+    JSON_Writer writer;
+    JSON_Walk walk;
+    JSON_Status status = JSONFailure;
+    if (value == NULL || chunk == NULL || chunk_size == 0 || write_fun == NULL) {
+        return JSONFailure;
+    }
+    writer.write = write_fun;
+    writer.context = context;
+    writer.chunk = chunk;
+    writer.chunk_size = chunk_size;
+    writer.used = 0;
+    writer.status = JSONSuccess;
+    walk_init(&walk);
+    status = json_serialize_writer_walk(&walk, value, &writer, is_pretty);
+    walk_free(&walk);
+    if (status == JSONFailure) {
+        return JSONFailure;
+    }
+    writer_flush(&writer);
+    return writer.status;
 }
 
-JSON_Array * json_object_get_array(const JSON_Object *object, const char *name) {
-    return json_value_get_array(json_object_get_value(object, name));
+/* Binary serialization */
+/* Writes prefix followed by size bytes of n, big endian. buf NULL only counts. */
+static int binary_put_uint(unsigned char *buf, unsigned char prefix, uint64_t n, int size) {
+    int i;
+    if (buf != NULL) {
+        buf[0] = prefix;
+        for (i = size; i > 0; i--) {
+            buf[i] = (unsigned char)n;
+            n >>= 8;
+        }
+    }
+    return size + 1;
 }
 
-int json_object_get_boolean(const JSON_Object *object, const char *name) {
-    return json_value_get_boolean(json_object_get_value(object, name));
+/* Head of an integer, string, array or map. Returns -1 if format can't encode n. */
+static int binary_put_head(unsigned char *buf, JSON_Binary_Format format, JSON_Binary_Kind kind, uint64_t n) {
+    unsigned char major = 0;
+    int64_t integer = 0;
+#ifdef PARSON_MSGPACK
+    if (format == BINARY_MSGPACK) {
+        switch (kind) {
+            case BINARY_UINT:
+                if (n < 0x80) {
+                    return binary_put_uint(buf, (unsigned char)n, 0, 0);
+                }
+                return n <= 0xFF ? binary_put_uint(buf, 0xCC, n, 1) :
+                       n <= 0xFFFF ? binary_put_uint(buf, 0xCD, n, 2) :
+                       n <= 0xFFFFFFFF ? binary_put_uint(buf, 0xCE, n, 4) : binary_put_uint(buf, 0xCF, n, 8);
+            case BINARY_NEGINT:
+                if (n > INT64_MAX) {
+                    return -1;
+                }
+                integer = -1 - (int64_t)n;
+                if (integer >= -32) {
+                    return binary_put_uint(buf, (unsigned char)integer, 0, 0);
+                }
+                return integer >= INT8_MIN ? binary_put_uint(buf, 0xD0, (uint64_t)integer, 1) :
+                       integer >= INT16_MIN ? binary_put_uint(buf, 0xD1, (uint64_t)integer, 2) :
+                       integer >= INT32_MIN ? binary_put_uint(buf, 0xD2, (uint64_t)integer, 4) :
+                       binary_put_uint(buf, 0xD3, (uint64_t)integer, 8);
+            case BINARY_STRING:
+                return n < 32 ? binary_put_uint(buf, (unsigned char)(0xA0 | n), 0, 0) :
+                       n <= 0xFF ? binary_put_uint(buf, 0xD9, n, 1) :
+                       n <= 0xFFFF ? binary_put_uint(buf, 0xDA, n, 2) :
+                       n <= 0xFFFFFFFF ? binary_put_uint(buf, 0xDB, n, 4) : -1;
+            case BINARY_ARRAY:
+            case BINARY_MAP:
+                major = kind == BINARY_ARRAY ? 0x90 : 0x80;
+                return n < 16 ? binary_put_uint(buf, (unsigned char)(major | n), 0, 0) :
+                       n <= 0xFFFF ? binary_put_uint(buf, (unsigned char)(major == 0x90 ? 0xDC : 0xDE), n, 2) :
+                       n <= 0xFFFFFFFF ? binary_put_uint(buf, (unsigned char)(major == 0x90 ? 0xDD : 0xDF), n, 4) : -1;
+            default:
+                return -1;
+        }
+    }
+#endif
+    (void)format;
+    (void)integer;
+    switch (kind) {
+        case BINARY_UINT:   major = 0 << 5; break;
+        case BINARY_NEGINT: major = 1 << 5; break;
+        case BINARY_STRING: major = 3 << 5; break;
+        case BINARY_ARRAY:  major = 4 << 5; break;
+        case BINARY_MAP:    major = 5 << 5; break;
+        default:
+            return -1;
+    }
+    return n < 24 ? binary_put_uint(buf, (unsigned char)(major | n), 0, 0) :
+           n <= 0xFF ? binary_put_uint(buf, (unsigned char)(major | 24), n, 1) :
+           n <= 0xFFFF ? binary_put_uint(buf, (unsigned char)(major | 25), n, 2) :
+           n <= 0xFFFFFFFF ? binary_put_uint(buf, (unsigned char)(major | 26), n, 4) :
+           binary_put_uint(buf, (unsigned char)(major | 27), n, 8);
+}
+
+/* Integral doubles are written as integers, others as single precision when that's exact. -0.0 is
+ * a float, as an integer it would lose its sign. */
+static int binary_put_number(unsigned char *buf, JSON_Binary_Format format, const JSON_Value *value) {
+    int64_t integer = 0;
+    double number = value->value.number;
+    float single = 0.0f;
+    uint32_t single_bits = 0;
+    uint64_t double_bits = 0;
+    if (value->type == JSONInteger) {
+        integer = value->value.integer;
+    } else if (number >= -9223372036854775808.0 && number < 9223372036854775808.0 && (double)(int64_t)number == number &&
+               (number != 0.0 || !signbit(number))) {
+        integer = (int64_t)number;
+    } else {
+        single = (float)number;
+        if ((double)single == number) {
+            memcpy(&single_bits, &single, sizeof(single_bits));
+            return binary_put_uint(buf, (unsigned char)(format == BINARY_CBOR ? 0xFA : 0xCA), single_bits, 4);
+        }
+        memcpy(&double_bits, &number, sizeof(double_bits));
+        return binary_put_uint(buf, (unsigned char)(format == BINARY_CBOR ? 0xFB : 0xCB), double_bits, 8);
+    }
+    if (integer < 0) {
+        return binary_put_head(buf, format, BINARY_NEGINT, (uint64_t)(-1 - integer));
+    }
+    return binary_put_head(buf, format, BINARY_UINT, (uint64_t)integer);
 }
 
-JSON_Value * json_object_dotget_value(const JSON_Object *object, const char *name) {
-    const char *dot_position = strchr(name, '.');
-    if (!dot_position) {
-        return json_object_get_value(object, name);
+static int binary_put_string(unsigned char *buf, JSON_Binary_Format format, const char *string) {
+    size_t len = strlen(string);
+    int written = binary_put_head(buf, format, BINARY_STRING, len);
+    if (written < 0) {
+        return -1;
     }
-    object = json_value_get_object(json_object_getn_value(object, name, dot_position - name));
-    return json_object_dotget_value(object, dot_position + 1);
+    if (buf != NULL) {
+        memcpy(buf + written, string, len);
+    }
+    return written + (int)len;
 }
 
-const char * json_object_dotget_string(const JSON_Object *object, const char *name) {
-    return json_value_get_string(json_object_dotget_value(object, name));
+static int binary_put_scalar(unsigned char *buf, JSON_Binary_Format format, const JSON_Value *value) {
+    switch (json_value_get_type(value)) {
+        case JSONString:
+            return binary_put_string(buf, format, STRING_BUFFER(value));
+        case JSONNumber:
+            return binary_put_number(buf, format, value);
+        case JSONBoolean:
+            if (format == BINARY_CBOR) {
+                return binary_put_uint(buf, (unsigned char)(value->value.boolean ? 0xF5 : 0xF4), 0, 0);
+            }
+            return binary_put_uint(buf, (unsigned char)(value->value.boolean ? 0xC3 : 0xC2), 0, 0);
+        case JSONNull:
+            return binary_put_uint(buf, (unsigned char)(format == BINARY_CBOR ? 0xF6 : 0xC0), 0, 0);
+        default:
+            return -1;
+    }
 }
 
-double json_object_dotget_number(const JSON_Object *object, const char *name) {
-    return json_value_get_number(json_object_dotget_value(object, name));
-}
+#define APPEND_BINARY(expr) do { written = (expr);\
+                                 if (written < 0) { return -1; }\
+                                 if (buf != NULL) { buf += written; }\
+                                 written_total += written; } while(0)
 
-JSON_Object * json_object_dotget_object(const JSON_Object *object, const char *name) {
-    return json_value_get_object(json_object_dotget_value(object, name));
+static int json_serialize_to_binary_r(const JSON_Value *value, unsigned char *buf, JSON_Binary_Format format) {
+    JSON_Walk walk;
+    int written = -1;
+    walk_init(&walk);
+    written = json_serialize_binary_walk(&walk, value, buf, format);
+    walk_free(&walk);
+    return written;
 }
 
-JSON_Array * json_object_dotget_array(const JSON_Object *object, const char *name) {
-    return json_value_get_array(json_object_dotget_value(object, name));
-}
-
-int json_object_dotget_boolean(const JSON_Object *object, const char *name) {
-    return json_value_get_boolean(json_object_dotget_value(object, name));
+/* Iterative like json_serialize_walk */
+static int json_serialize_binary_walk(JSON_Walk *walk, const JSON_Value *value, unsigned char *buf, JSON_Binary_Format format) {
+    JSON_Walk_Frame *frame = NULL;
+    const JSON_Object *object = NULL;
+    size_t count = 0;
+    int written = -1, written_total = 0;
+    do {
+        object = json_value_get_object(value);
+        if (object != NULL || json_value_get_type(value) == JSONArray) {
+            count = object != NULL ? object->count : json_value_get_array(value)->count;
+            APPEND_BINARY(binary_put_head(buf, format, object != NULL ? BINARY_MAP : BINARY_ARRAY, count));
+            if (count > 0 && walk_push(walk, value, 0) == NULL) {
+                return -1;
+            }
+        } else {
+            APPEND_BINARY(binary_put_scalar(buf, format, value));
+        }
+        value = NULL;
+        while (walk->depth > 0 && value == NULL) {
+            frame = &walk->frames[walk->depth - 1];
+            object = json_value_get_object(frame->container);
+            count = object != NULL ? object->count : json_value_get_array(frame->container)->count;
+            if (frame->index == count) {
+                walk->depth--;
+            } else if (object != NULL) {
+                APPEND_BINARY(binary_put_string(buf, format, object->cells[frame->index].name));
+                value = object->cells[frame->index++].value;
+            } else {
+                value = json_value_get_array(frame->container)->items[frame->index++];
+            }
+        }
+    } while (value != NULL);
+    return written_total;
 }
 
-size_t json_object_get_count(const JSON_Object *object) {
-    return object ? object->count : 0;
-}
+#undef APPEND_BINARY
 
-const char * json_object_get_name(const JSON_Object *object, size_t index) {
-    if (object == NULL || index >= json_object_get_count(object)) {
-        return NULL;
+static uint64_t binary_get_uint(const unsigned char *data, int size) {
+    uint64_t n = 0;
+    int i;
+    for (i = 0; i < size; i++) {
+        n = (n << 8) | data[i];
+    }
+    return n;
+}
+
+/* Reads the head of the next item. Strings, arrays and maps are left at their first byte or item. */
+static JSON_Status binary_read_head(const unsigned char **data, const unsigned char *end, JSON_Binary_Format format,
+                                    JSON_Binary_Kind *kind, uint64_t *n, double *number) {
+    static const JSON_Binary_Kind cbor_kinds[] = { BINARY_UINT, BINARY_NEGINT, BINARY_STRING /* byte string, rejected */,
+                                                   BINARY_STRING, BINARY_ARRAY, BINARY_MAP, BINARY_TAG };
+    unsigned char initial = 0, info = 0;
+    int size = 0, half = 0, exponent = 0;
+    uint32_t single_bits = 0;
+    uint64_t double_bits = 0;
+    float single = 0.0f;
+    if (*data >= end) {
+        return JSONFailure;
     }
-    return object->names[index];
-}
-
-JSON_Value * json_object_get_value_at(const JSON_Object *object, size_t index) {
-    if (object == NULL || index >= json_object_get_count(object)) {
-        return NULL;
+    initial = *(*data)++;
+#ifdef PARSON_MSGPACK
+    if (format == BINARY_MSGPACK) {
+        *n = 0;
+        if (initial < 0x80 || initial >= 0xE0) {                  /* fixint */
+            *kind = initial < 0x80 ? BINARY_UINT : BINARY_NEGINT;
+            *n = initial < 0x80 ? initial : (uint64_t)(0xFF - initial);
+            return JSONSuccess;
+        } else if (initial < 0xC0) {                              /* fixmap, fixarray, fixstr */
+            *kind = initial < 0x90 ? BINARY_MAP : initial < 0xA0 ? BINARY_ARRAY : BINARY_STRING;
+            *n = initial & (initial < 0xA0 ? 0x0F : 0x1F);
+            return JSONSuccess;
+        }
+        switch (initial) {
+            case 0xC0: *kind = BINARY_NULL; return JSONSuccess;
+            case 0xC2: *kind = BINARY_FALSE; return JSONSuccess;
+            case 0xC3: *kind = BINARY_TRUE; return JSONSuccess;
+            case 0xCA: *kind = BINARY_FLOAT; size = 4; break;
+            case 0xCB: *kind = BINARY_FLOAT; size = 8; break;
+            case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+                *kind = BINARY_UINT; size = 1 << (initial - 0xCC); break;
+            case 0xD0: case 0xD1: case 0xD2: case 0xD3:
+                *kind = BINARY_NEGINT; size = 1 << (initial - 0xD0); break;
+            case 0xD9: case 0xDA: case 0xDB:
+                *kind = BINARY_STRING; size = 1 << (initial - 0xD9); break;
+            case 0xDC: case 0xDD:
+                *kind = BINARY_ARRAY; size = 2 << (initial - 0xDC); break;
+            case 0xDE: case 0xDF:
+                *kind = BINARY_MAP; size = 2 << (initial - 0xDE); break;
+            default:
+                return JSONFailure; /* bin, ext and reserved */
+        }
+        if (end - *data < size) {
+            return JSONFailure;
+        }
+        *n = binary_get_uint(*data, size);
+        *data += size;
+        if (*kind == BINARY_NEGINT) { /* sign extend, non-negative values are uints */
+            if (size < 8 && (*n >> (size * 8 - 1))) {
+                *n |= UINT64_MAX << (size * 8);
+            }
+            if ((int64_t)*n >= 0) {
+                *kind = BINARY_UINT;
+            } else {
+                *n = (uint64_t)(-1 - (int64_t)*n);
+            }
+        } else if (*kind == BINARY_FLOAT && size == 4) {
+            single_bits = (uint32_t)*n;
+            memcpy(&single, &single_bits, sizeof(single));
+            *number = single;
+        } else if (*kind == BINARY_FLOAT) {
+            memcpy(number, n, sizeof(*number));
+        }
+        return JSONSuccess;
+    }
+#endif
+    (void)format;
+    info = initial & 0x1F;
+    if (initial >> 5 == 7) {
+        switch (info) {
+            case 20: *kind = BINARY_FALSE; return JSONSuccess;
+            case 21: *kind = BINARY_TRUE; return JSONSuccess;
+            case 22: case 23: *kind = BINARY_NULL; return JSONSuccess; /* null, undefined */
+            case 25: case 26: case 27: *kind = BINARY_FLOAT; break;
+            case 31: *kind = BINARY_BREAK; return JSONSuccess;
+            default: return JSONFailure;
+        }
+    } else if (initial >> 5 == 2) {
+        return JSONFailure; /* byte strings have no JSON equivalent */
+    } else {
+        *kind = cbor_kinds[initial >> 5];
+    }
+    if (info < 24) {
+        *n = info;
+        return JSONSuccess;
+    } else if (info == 31) {
+        if (*kind != BINARY_ARRAY && *kind != BINARY_MAP) {
+            return JSONFailure; /* indefinite length strings aren't supported */
+        }
+        *n = BINARY_INDEFINITE;
+        return JSONSuccess;
+    } else if (info > 27) {
+        return JSONFailure;
+    }
+    size = 1 << (info - 24);
+    if (end - *data < size) {
+        return JSONFailure;
+    }
+    *n = binary_get_uint(*data, size);
+    *data += size;
+    if (*kind != BINARY_FLOAT) {
+        return JSONSuccess;
     }
-    return object->values[index];
+    if (size == 2) {
+        half = (int)*n;
+        exponent = (half >> 10) & 0x1F;
+        if (exponent == 31) {
+            return JSONFailure; /* infinity and NaN */
+        }
+        *number = exponent == 0 ? ldexp(half & 0x3FF, -24) : ldexp((half & 0x3FF) + 1024, exponent - 25);
+        *number = (half & 0x8000) ? -*number : *number;
+    } else if (size == 4) {
+        single_bits = (uint32_t)*n;
+        memcpy(&single, &single_bits, sizeof(single));
+        *number = single;
+    } else {
+        double_bits = *n;
+        memcpy(number, &double_bits, sizeof(*number));
+    }
+    return JSONSuccess;
 }
 
-JSON_Value *json_object_get_wrapping_value(const JSON_Object *object) {
-    return object->wrapping_value;
+/* Scalar or empty container of the item whose head was read */
+static JSON_Value * parse_binary_item(const unsigned char **data, const unsigned char *end, JSON_Binary_Kind kind, uint64_t n, double number) {
+    JSON_Value *value = NULL;
+    switch (kind) {
+        case BINARY_UINT:
+            if (parson_parse_int64 && n <= INT64_MAX) {
+                return json_value_init_int64((int64_t)n);
+            }
+            return json_value_init_number((double)n);
+        case BINARY_NEGINT:
+            if (n > INT64_MAX) {
+                return json_value_init_number(-1.0 - (double)n);
+            }
+            if (parson_parse_int64) {
+                return json_value_init_int64(-1 - (int64_t)n);
+            }
+            return json_value_init_number((double)(-1 - (int64_t)n));
+        case BINARY_FLOAT:
+            return json_value_init_number(number);
+        case BINARY_STRING:
+            if (n > (uint64_t)(end - *data) || !is_valid_utf8((const char*)*data, (size_t)n)) {
+                return NULL;
+            }
+            value = json_value_init_string_n((const char*)*data, (size_t)n);
+            *data += n;
+            return value;
+        case BINARY_ARRAY: /* each item takes at least 1 byte, so the count is safe to reserve */
+            if (n == BINARY_INDEFINITE) {
+                return json_value_init_array();
+            }
+            return n <= (uint64_t)(end - *data) ? json_value_init_array_with_capacity((size_t)n) : NULL;
+        case BINARY_MAP:   /* each pair takes at least 2 bytes */
+            if (n == BINARY_INDEFINITE) {
+                return json_value_init_object();
+            }
+            return n <= (uint64_t)(end - *data) / 2 ? json_value_init_object_with_capacity((size_t)n) : NULL;
+        case BINARY_TRUE:
+            return json_value_init_boolean(1);
+        case BINARY_FALSE:
+            return json_value_init_boolean(0);
+        case BINARY_NULL:
+            return json_value_init_null();
+        default:
+            return NULL;
+    }
 }
 
-int json_object_has_value (const JSON_Object *object, const char *name) {
-    return json_object_get_value(object, name) != NULL;
+static JSON_Value * parse_binary_value(const unsigned char **data, const unsigned char *end, JSON_Binary_Format format) {
+    JSON_Walk walk;
+    JSON_Value *root = NULL;
+    walk_init(&walk);
+    root = parse_binary_walk(&walk, data, end, format);
+    walk_free(&walk);
+    return root;
 }
 
-int json_object_has_value_of_type(const JSON_Object *object, const char *name, JSON_Value_Type type) {
-    JSON_Value *val = json_object_get_value(object, name);
-    return val != NULL && json_value_get_type(val) == type;
+/* Iterative like parse_value, walk keeps the number of items left in each open container. */
+static JSON_Value * parse_binary_walk(JSON_Walk *walk, const unsigned char **data, const unsigned char *end, JSON_Binary_Format format) {
+    JSON_Value *root = NULL, *container = NULL, *new_value = NULL;
+    JSON_Walk_Frame *frame = NULL;
+    JSON_Binary_Kind kind = BINARY_NULL;
+    uint64_t n = 0;
+    double number = 0.0;
+    char *name = NULL;
+    size_t name_len = 0;
+    for (;;) {
+        if (container != NULL) {
+            frame = &walk->frames[walk->depth - 1];
+            if (frame->index == WALK_INDEFINITE && *data < end && **data == 0xFF) { /* CBOR break */
+                (*data)++;
+                frame->index = 0;
+            }
+            if (frame->index == 0) {
+                if (parse_close_container(container) == JSONFailure) {
+                    break;
+                }
+                walk->depth--;
+                container = json_value_get_parent(container);
+                if (container == NULL) {
+                    return root;
+                }
+                continue;
+            }
+            if (frame->index != WALK_INDEFINITE) {
+                frame->index--;
+            }
+            if (json_value_get_type(container) == JSONObject) {
+                if (binary_read_head(data, end, format, &kind, &n, &number) == JSONFailure ||
+                    kind != BINARY_STRING || n > (uint64_t)(end - *data) ||
+                    memchr(*data, '\0', (size_t)n) != NULL || !is_valid_utf8((const char*)*data, (size_t)n)) {
+                    break;
+                }
+                name_len = (size_t)n;
+                name = parson_strndup((const char*)*data, name_len);
+                if (name == NULL) {
+                    break;
+                }
+                *data += name_len;
+            }
+        }
+        do {
+            if (binary_read_head(data, end, format, &kind, &n, &number) == JSONFailure) {
+                kind = BINARY_BREAK;
+            }
+        } while (kind == BINARY_TAG);
+        if ((kind == BINARY_ARRAY || kind == BINARY_MAP) && walk->depth >= parson_max_nesting) {
+            break;
+        }
+        new_value = parse_binary_item(data, end, kind, n, number);
+        if (new_value == NULL) {
+            break;
+        }
+        if (container == NULL) {
+            root = new_value;
+        } else if (json_value_get_type(container) == JSONObject) {
+            if (parse_add_member(json_value_get_object(container), name, name_len, new_value) == JSONFailure) {
+                name = NULL;
+                json_value_free(new_value);
+                break;
+            }
+            name = NULL;
+        } else if (json_array_add(json_value_get_array(container), new_value) == JSONFailure) {
+            json_value_free(new_value);
+            break;
+        }
+        if (kind == BINARY_ARRAY || kind == BINARY_MAP) {
+            if (walk_push(walk, new_value, n == BINARY_INDEFINITE ? WALK_INDEFINITE : (size_t)n) == NULL) {
+                break;
+            }
+            container = new_value;
+        } else if (container == NULL) {
+            return root;
+        }
+    }
+    parson_free(name);
+    json_value_free(root);
+    return NULL;
 }
 
-int json_object_dothas_value (const JSON_Object *object, const char *name) {
-    return json_object_dotget_value(object, name) != NULL;
+static size_t json_binary_size(const JSON_Value *value, JSON_Binary_Format format) {
+    int res = json_serialize_to_binary_r(value, NULL, format);
+    return res < 0 ? 0 : (size_t)res;
 }
 
-int json_object_dothas_value_of_type(const JSON_Object *object, const char *name, JSON_Value_Type type) {
-    JSON_Value *val = json_object_dotget_value(object, name);
-    return val != NULL && json_value_get_type(val) == type;
+static JSON_Status json_serialize_to_binary(const JSON_Value *value, void *buf, size_t buf_size_in_bytes, JSON_Binary_Format format) {
+    size_t needed_size_in_bytes = json_binary_size(value, format);
+    if (buf == NULL || needed_size_in_bytes == 0 || buf_size_in_bytes < needed_size_in_bytes) {
+        return JSONFailure;
+    }
+    if (json_serialize_to_binary_r(value, (unsigned char*)buf, format) < 0) {
+        return JSONFailure;
+    }
+    return JSONSuccess;
 }
 
-/* JSON Array API */
-JSON_Value * json_array_get_value(const JSON_Array *array, size_t index) {
-    if (array == NULL || index >= json_array_get_count(array)) {
+static JSON_Value * json_parse_binary(const void *data, size_t size, JSON_Binary_Format format) {
+    const unsigned char *cursor = (const unsigned char*)data;
+    if (data == NULL) {
         return NULL;
     }
-    return array->items[index];
-}
-
-const char * json_array_get_string(const JSON_Array *array, size_t index) {
-    return json_value_get_string(json_array_get_value(array, index));
-}
-
-double json_array_get_number(const JSON_Array *array, size_t index) {
-    return json_value_get_number(json_array_get_value(array, index));
-}
-
-JSON_Object * json_array_get_object(const JSON_Array *array, size_t index) {
-    return json_value_get_object(json_array_get_value(array, index));
-}
-
-JSON_Array * json_array_get_array(const JSON_Array *array, size_t index) {
-    return json_value_get_array(json_array_get_value(array, index));
-}
-
-int json_array_get_boolean(const JSON_Array *array, size_t index) {
-    return json_value_get_boolean(json_array_get_value(array, index));
-}
-
-size_t json_array_get_count(const JSON_Array *array) {
-    return array ? array->count : 0;
-}
-
-JSON_Value * json_array_get_wrapping_value(const JSON_Array *array) {
-    return array->wrapping_value;
-}
-
-/* JSON Value API */
-JSON_Value_Type json_value_get_type(const JSON_Value *value) {
-    return value ? value->type : JSONError;
-}
-
-JSON_Object * json_value_get_object(const JSON_Value *value) {
-    return json_value_get_type(value) == JSONObject ? value->value.object : NULL;
-}
-
-JSON_Array * json_value_get_array(const JSON_Value *value) {
-    return json_value_get_type(value) == JSONArray ? value->value.array : NULL;
+    return parse_binary_value(&cursor, cursor + size, format);
 }
 
-const char * json_value_get_string(const JSON_Value *value) {
-    return json_value_get_type(value) == JSONString ? value->value.string : NULL;
+/* Streaming reader */
+static JSON_Reader_Event reader_fail(JSON_Reader *reader) {
+    reader->state = READER_STATE_ERROR;
+    reader->token = READER_TOKEN_NONE;
+    return JSONReaderError;
 }
 
-double json_value_get_number(const JSON_Value *value) {
-    return json_value_get_type(value) == JSONNumber ? value->value.number : 0;
+/* Called whenever a complete value (scalar or closed container) was read. */
+static JSON_Reader_Event reader_value_done(JSON_Reader *reader, JSON_Reader_Event event) {
+    reader->state = reader->depth == 0 ? READER_STATE_DONE : READER_STATE_COMMA_OR_END;
+    return event;
 }
 
-int json_value_get_boolean(const JSON_Value *value) {
-    return json_value_get_type(value) == JSONBoolean ? value->value.boolean : -1;
+static JSON_Reader_Event reader_push(JSON_Reader *reader, unsigned char is_object) {
+    if (reader->depth >= reader->max_depth) {
+        return reader_fail(reader);
+    }
+    reader->stack[reader->depth++] = is_object;
+    reader->state = is_object ? READER_STATE_KEY_OR_END : READER_STATE_VALUE_OR_END;
+    return is_object ? JSONReaderObjectBegin : JSONReaderArrayBegin;
 }
 
-JSON_Value * json_value_get_parent (const JSON_Value *value) {
-    return value ? value->parent : NULL;
+static JSON_Reader_Event reader_pop(JSON_Reader *reader, unsigned char is_object) {
+    if (reader->depth == 0 || reader->stack[reader->depth - 1] != is_object) {
+        return reader_fail(reader);
+    }
+    reader->depth--;
+    return reader_value_done(reader, is_object ? JSONReaderObjectEnd : JSONReaderArrayEnd);
 }
 
-void json_value_free(JSON_Value *value) {
-    switch (json_value_get_type(value)) {
-        case JSONObject:
-            json_object_free(value->value.object);
-            break;
-        case JSONString:
-            parson_free(value->value.string);
-            break;
-        case JSONArray:
-            json_array_free(value->value.array);
-            break;
+/* Accumulates the token in progress from the current chunk. Returns JSONReaderNeedInput when the
+ * chunk ran out before the token ended. */
+static JSON_Reader_Event reader_continue_token(JSON_Reader *reader) {
+    char c;
+    size_t processed_len = 0;
+    while (reader->input_len > 0) {
+        c = *reader->input;
+        if (reader->token == READER_TOKEN_KEY || reader->token == READER_TOKEN_STRING) {
+            reader->input++;
+            reader->input_len--;
+            reader->position++;
+            if (c == '\"' && !reader->escaped) {
+                reader->token_buf[reader->token_len] = '\0';
+                if (unescape_string(reader->token_buf, reader->token_len, reader->token_buf, &processed_len) == JSONFailure) {
+                    return reader_fail(reader);
+                }
+                reader->token_buf[processed_len] = '\0';
+                reader->token_len = processed_len;
+                if (reader->token == READER_TOKEN_KEY) {
+                    reader->token = READER_TOKEN_NONE;
+                    reader->state = READER_STATE_COLON;
+                    return JSONReaderKey;
+                }
+                reader->token = READER_TOKEN_NONE;
+                return reader_value_done(reader, JSONReaderString);
+            }
+            reader->escaped = (c == '\\' && !reader->escaped);
+        } else if ((reader->token == READER_TOKEN_NUMBER && (IS_DIGIT(c) || strchr("+-.eE", c) != NULL) && c != '\0') ||
+                   (reader->token == READER_TOKEN_LITERAL && c >= 'a' && c <= 'z')) {
+            reader->input++;
+            reader->input_len--;
+            reader->position++;
+        } else {
+            break; /* delimiter, left in the input */
+        }
+        if (reader->token_len >= reader->max_token_len) {
+            return reader_fail(reader);
+        }
+        reader->token_buf[reader->token_len++] = c;
+    }
+    if (reader->input_len == 0 && !reader->input_finished) {
+        return JSONReaderNeedInput;
+    }
+    reader->token_buf[reader->token_len] = '\0';
+    switch (reader->token) {
+        case READER_TOKEN_NUMBER:
+            reader->token = READER_TOKEN_NONE;
+            if (parse_number(reader->token_buf, reader->token_len, &reader->number, &reader->integer, &reader->is_integer) != reader->token_len ||
+                IS_NUMBER_INVALID(reader->number)) {
+                return reader_fail(reader);
+            }
+            return reader_value_done(reader, JSONReaderNumber);
+        case READER_TOKEN_LITERAL:
+            reader->token = READER_TOKEN_NONE;
+            if (strcmp(reader->token_buf, "true") == 0 || strcmp(reader->token_buf, "false") == 0) {
+                reader->boolean = reader->token_buf[0] == 't';
+                return reader_value_done(reader, JSONReaderBoolean);
+            } else if (strcmp(reader->token_buf, "null") == 0) {
+                return reader_value_done(reader, JSONReaderNull);
+            }
+            return reader_fail(reader);
         default:
-            break;
+            return reader_fail(reader); /* unterminated string */
     }
-    parson_free(value);
 }
 
-JSON_Value * json_value_init_object(void) {
-    JSON_Value *new_value = (JSON_Value*)parson_malloc(sizeof(JSON_Value));
-    if (!new_value) {
-        return NULL;
-    }
-    new_value->parent = NULL;
-    new_value->type = JSONObject;
-    new_value->value.object = json_object_init(new_value);
-    if (!new_value->value.object) {
-        parson_free(new_value);
+/* Parser API */
+#ifdef PARSON_FILES
+JSON_Value * json_parse_file(const char *filename) {
+    char *file_contents = read_file(filename);
+    JSON_Value *output_value = NULL;
+    if (file_contents == NULL) {
         return NULL;
     }
-    return new_value;
+    output_value = json_parse_string(file_contents);
+    parson_free(file_contents);
+    return output_value;
 }
 
-JSON_Value * json_value_init_array(void) {
-    JSON_Value *new_value = (JSON_Value*)parson_malloc(sizeof(JSON_Value));
-    if (!new_value) {
-        return NULL;
-    }
-    new_value->parent = NULL;
-    new_value->type = JSONArray;
-    new_value->value.array = json_array_init(new_value);
-    if (!new_value->value.array) {
-        parson_free(new_value);
+JSON_Value * json_parse_file_with_comments(const char *filename) {
+    char *file_contents = read_file(filename);
+    JSON_Value *output_value = NULL;
+    if (file_contents == NULL) {
         return NULL;
     }
-    return new_value;
+    output_value = json_parse_string_with_comments(file_contents);
+    parson_free(file_contents);
+    return output_value;
 }
+#endif
 
-JSON_Value * json_value_init_string(const char *string) {
-    char *copy = NULL;
-    JSON_Value *value;
-    size_t string_len = 0;
+JSON_Value * json_parse_string(const char *string) {
     if (string == NULL) {
         return NULL;
     }
-    string_len = strlen(string);
-    if (!is_valid_utf8(string, string_len)) {
-        return NULL;
+    if (string[0] == '\xEF' && string[1] == '\xBB' && string[2] == '\xBF') {
+        string = string + 3; /* Support for UTF-8 BOM */
     }
-    copy = parson_strndup(string, string_len);
-    if (copy == NULL) {
+    return parse_value((const char**)&string, string + strlen(string));
+}
+
+JSON_Value * json_parse_string_with_comments(const char *string) {
+    JSON_Value *result = NULL;
+    char *string_mutable_copy = NULL, *string_mutable_copy_ptr = NULL;
+    string_mutable_copy = parson_strdup(string);
+    if (string_mutable_copy == NULL) {
         return NULL;
     }
-    value = json_value_init_string_no_copy(copy);
-    if (value == NULL) {
-        parson_free(copy);
-    }
-    return value;
+    remove_comments(string_mutable_copy, "/*", "*/");
+    remove_comments(string_mutable_copy, "//", "\n");
+    string_mutable_copy_ptr = string_mutable_copy;
+    result = parse_value((const char**)&string_mutable_copy_ptr, string_mutable_copy + strlen(string_mutable_copy));
+    parson_free(string_mutable_copy);
+    return result;
 }
 
-JSON_Value * json_value_init_number(double number) {
-    JSON_Value *new_value = NULL;
-    if (IS_NUMBER_INVALID(number)) {
+/* Streaming reader API */
+JSON_Reader * json_reader_init(size_t max_token_len, size_t max_depth) {
+    JSON_Reader *reader = NULL;
+    if (max_depth == 0) {
         return NULL;
     }
-    new_value = (JSON_Value*)parson_malloc(sizeof(JSON_Value));
-    if (new_value == NULL) {
+    /* one block for the reader, the token buffer and the nesting stack */
+    reader = (JSON_Reader*)parson_malloc(sizeof(JSON_Reader) + max_token_len + 1 + max_depth);
+    if (reader == NULL) {
         return NULL;
     }
-    new_value->parent = NULL;
-    new_value->type = JSONNumber;
-    new_value->value.number = number;
-    return new_value;
+    memset(reader, 0, sizeof(JSON_Reader));
+    reader->token_buf = (char*)(reader + 1);
+    reader->token_buf[0] = '\0';
+    reader->max_token_len = max_token_len;
+    reader->stack = (unsigned char*)(reader->token_buf + max_token_len + 1);
+    reader->max_depth = max_depth;
+    reader->state = READER_STATE_VALUE;
+    reader->token = READER_TOKEN_NONE;
+    return reader;
 }
 
-JSON_Value * json_value_init_boolean(int boolean) {
-    JSON_Value *new_value = (JSON_Value*)parson_malloc(sizeof(JSON_Value));
-    if (!new_value) {
-        return NULL;
-    }
-    new_value->parent = NULL;
-    new_value->type = JSONBoolean;
-    new_value->value.boolean = boolean ? 1 : 0;
-    return new_value;
+void json_reader_free(JSON_Reader *reader) {
+    parson_free(reader);
 }
 
-JSON_Value * json_value_init_null(void) {
-    JSON_Value *new_value = (JSON_Value*)parson_malloc(sizeof(JSON_Value));
-    if (!new_value) {
-        return NULL;
+JSON_Status json_reader_feed(JSON_Reader *reader, const char *chunk, size_t chunk_len) {
+    if (reader == NULL || (chunk == NULL && chunk_len > 0) || reader->input_len > 0 || reader->input_finished) {
+        return JSONFailure;
     }
-    new_value->parent = NULL;
-    new_value->type = JSONNull;
-    return new_value;
+    reader->input = chunk;
+    reader->input_len = chunk_len;
+    return JSONSuccess;
 }
 
-JSON_Value * json_value_deep_copy(const JSON_Value *value) {
-    size_t i = 0;
-    JSON_Value *return_value = NULL, *temp_value_copy = NULL, *temp_value = NULL;
-    const char *temp_string = NULL, *temp_key = NULL;
-    char *temp_string_copy = NULL;
-    JSON_Array *temp_array = NULL, *temp_array_copy = NULL;
-    JSON_Object *temp_object = NULL, *temp_object_copy = NULL;
+JSON_Status json_reader_finish(JSON_Reader *reader) {
+    if (reader == NULL) {
+        return JSONFailure;
+    }
+    reader->input_finished = 1;
+    return JSONSuccess;
+}
 
-    switch (json_value_get_type(value)) {
-        case JSONArray:
-            temp_array = json_value_get_array(value);
-            return_value = json_value_init_array();
-            if (return_value == NULL) {
-                return NULL;
-            }
-            temp_array_copy = json_value_get_array(return_value);
-            for (i = 0; i < json_array_get_count(temp_array); i++) {
-                temp_value = json_array_get_value(temp_array, i);
-                temp_value_copy = json_value_deep_copy(temp_value);
-                if (temp_value_copy == NULL) {
-                    json_value_free(return_value);
-                    return NULL;
+JSON_Reader_Event json_reader_next(JSON_Reader *reader) {
+    JSON_Reader_Event event = JSONReaderError;
+    char c;
+    if (reader == NULL || reader->state == READER_STATE_ERROR) {
+        return JSONReaderError;
+    }
+    for (;;) {
+        if (reader->token != READER_TOKEN_NONE) {
+            return reader_continue_token(reader);
+        }
+        if (reader->state == READER_STATE_DONE) {
+            return JSONReaderEnd; /* anything after the root value is ignored, like json_parse_string does */
+        }
+        if (reader->input_len == 0) {
+            return reader->input_finished ? reader_fail(reader) : JSONReaderNeedInput;
+        }
+        c = *reader->input;
+        if (reader->position < 3 && c == "\xEF\xBB\xBF"[reader->position] &&
+            reader->state == READER_STATE_VALUE && reader->depth == 0) {
+            reader->input++; /* Support for UTF-8 BOM */
+            reader->input_len--;
+            reader->position++;
+            continue;
+        }
+        reader->input++;
+        reader->input_len--;
+        reader->position++;
+        if (isspace((unsigned char)c)) {
+            continue;
+        }
+        switch (reader->state) {
+            case READER_STATE_COLON:
+                if (c != ':') {
+                    return reader_fail(reader);
                 }
-                if (json_array_add(temp_array_copy, temp_value_copy) == JSONFailure) {
-                    json_value_free(return_value);
-                    json_value_free(temp_value_copy);
-                    return NULL;
+                reader->state = READER_STATE_VALUE;
+                continue;
+            case READER_STATE_COMMA_OR_END:
+                if (c == ',') {
+                    reader->state = reader->stack[reader->depth - 1] ? READER_STATE_KEY : READER_STATE_VALUE;
+                    continue;
+                } else if (c == '}' || c == ']') {
+                    return reader_pop(reader, c == '}');
                 }
-            }
-            return return_value;
-        case JSONObject:
-            temp_object = json_value_get_object(value);
-            return_value = json_value_init_object();
-            if (return_value == NULL) {
-                return NULL;
-            }
-            temp_object_copy = json_value_get_object(return_value);
-            for (i = 0; i < json_object_get_count(temp_object); i++) {
-                temp_key = json_object_get_name(temp_object, i);
-                temp_value = json_object_get_value(temp_object, temp_key);
-                temp_value_copy = json_value_deep_copy(temp_value);
-                if (temp_value_copy == NULL) {
-                    json_value_free(return_value);
-                    return NULL;
+                return reader_fail(reader);
+            case READER_STATE_KEY_OR_END:
+                if (c == '}') {
+                    return reader_pop(reader, 1);
                 }
-                if (json_object_add(temp_object_copy, temp_key, temp_value_copy) == JSONFailure) {
-                    json_value_free(return_value);
-                    json_value_free(temp_value_copy);
-                    return NULL;
+                /* fall through */
+            case READER_STATE_KEY:
+                if (c != '\"') {
+                    return reader_fail(reader);
                 }
-            }
-            return return_value;
-        case JSONBoolean:
-            return json_value_init_boolean(json_value_get_boolean(value));
-        case JSONNumber:
-            return json_value_init_number(json_value_get_number(value));
-        case JSONString:
-            temp_string = json_value_get_string(value);
-            if (temp_string == NULL) {
-                return NULL;
-            }
-            temp_string_copy = parson_strdup(temp_string);
-            if (temp_string_copy == NULL) {
-                return NULL;
-            }
-            return_value = json_value_init_string_no_copy(temp_string_copy);
-            if (return_value == NULL) {
-                parson_free(temp_string_copy);
-            }
-            return return_value;
-        case JSONNull:
-            return json_value_init_null();
-        case JSONError:
-            return NULL;
-        default:
-            return NULL;
+                reader->token = READER_TOKEN_KEY;
+                reader->token_len = 0;
+                reader->escaped = 0;
+                continue;
+            case READER_STATE_VALUE_OR_END:
+                if (c == ']') {
+                    return reader_pop(reader, 0);
+                }
+                /* fall through */
+            case READER_STATE_VALUE:
+                reader->token_len = 0;
+                reader->escaped = 0;
+                switch (c) {
+                    case '{':
+                        return reader_push(reader, 1);
+                    case '[':
+                        return reader_push(reader, 0);
+                    case '\"':
+                        reader->token = READER_TOKEN_STRING;
+                        continue;
+                    case '-':
+                    case '0': case '1': case '2': case '3': case '4':
+                    case '5': case '6': case '7': case '8': case '9':
+                        reader->token = READER_TOKEN_NUMBER;
+                        break;
+                    case 'f': case 't': case 'n':
+                        reader->token = READER_TOKEN_LITERAL;
+                        break;
+                    default:
+                        return reader_fail(reader);
+                }
+                reader->token_buf[reader->token_len++] = c;
+                if (reader->token_len > reader->max_token_len) {
+                    return reader_fail(reader);
+                }
+                continue;
+            default:
+                return event;
+        }
+    }
+}
+
+const char * json_reader_get_string(const JSON_Reader *reader, size_t *len) {
+    if (reader == NULL) {
+        return NULL;
+    }
+    if (len != NULL) {
+        *len = reader->token_len;
+    }
+    return reader->token_buf;
+}
+
+double json_reader_get_number(const JSON_Reader *reader) {
+    return reader ? reader->number : 0;
+}
+
+JSON_Status json_reader_get_int64(const JSON_Reader *reader, int64_t *number) {
+    if (reader == NULL || number == NULL) {
+        return JSONFailure;
+    }
+    if (reader->is_integer) {
+        *number = reader->integer;
+        return JSONSuccess;
+    }
+    /* written so that NaN fails too */
+    if (!(reader->number >= -9223372036854775808.0 && reader->number < 9223372036854775808.0)) {
+        return JSONFailure;
+    }
+    *number = (int64_t)reader->number;
+    return JSONSuccess;
+}
+
+int json_reader_get_boolean(const JSON_Reader *reader) {
+    return reader ? reader->boolean : -1;
+}
+
+size_t json_reader_get_depth(const JSON_Reader *reader) {
+    return reader ? reader->depth : 0;
+}
+
+/* JSON Object API */
+
+JSON_Value * json_object_get_value(const JSON_Object *object, const char *name) {
+    if (object == NULL || name == NULL) {
+        return NULL;
+    }
+    return json_object_getn_value(object, name, strlen(name));
+}
+
+const char * json_object_get_string(const JSON_Object *object, const char *name) {
+    return json_value_get_string(json_object_get_value(object, name));
+}
+
+double json_object_get_number(const JSON_Object *object, const char *name) {
+    return json_value_get_number(json_object_get_value(object, name));
+}
+
+int64_t json_object_get_int64(const JSON_Object *object, const char *name) {
+    return json_value_get_int64(json_object_get_value(object, name));
+}
+
+JSON_Object * json_object_get_object(const JSON_Object *object, const char *name) {
+    return json_value_get_object(json_object_get_value(object, name));
+}
+
+JSON_Array * json_object_get_array(const JSON_Object *object, const char *name) {
+    return json_value_get_array(json_object_get_value(object, name));
+}
+
+int json_object_get_boolean(const JSON_Object *object, const char *name) {
+    return json_value_get_boolean(json_object_get_value(object, name));
+}
+
+JSON_Value * json_object_dotget_value(const JSON_Object *object, const char *name) {
+    const char *dot_position = strchr(name, '.');
+    if (!dot_position) {
+        return json_object_get_value(object, name);
+    }
+    object = json_value_get_object(json_object_getn_value(object, name, dot_position - name));
+    return json_object_dotget_value(object, dot_position + 1);
+}
+
+const char * json_object_dotget_string(const JSON_Object *object, const char *name) {
+    return json_value_get_string(json_object_dotget_value(object, name));
+}
+
+double json_object_dotget_number(const JSON_Object *object, const char *name) {
+    return json_value_get_number(json_object_dotget_value(object, name));
+}
+
+int64_t json_object_dotget_int64(const JSON_Object *object, const char *name) {
+    return json_value_get_int64(json_object_dotget_value(object, name));
+}
+
+JSON_Object * json_object_dotget_object(const JSON_Object *object, const char *name) {
+    return json_value_get_object(json_object_dotget_value(object, name));
+}
+
+JSON_Array * json_object_dotget_array(const JSON_Object *object, const char *name) {
+    return json_value_get_array(json_object_dotget_value(object, name));
+}
+
+int json_object_dotget_boolean(const JSON_Object *object, const char *name) {
+    return json_value_get_boolean(json_object_dotget_value(object, name));
+}
+
+size_t json_object_get_count(const JSON_Object *object) {
+    return object ? object->count : 0;
+}
+
+const char * json_object_get_name(const JSON_Object *object, size_t index) {
+    if (object == NULL || index >= json_object_get_count(object)) {
+        return NULL;
+    }
+    return object->cells[index].name;
+}
+
+JSON_Value * json_object_get_value_at(const JSON_Object *object, size_t index) {
+    if (object == NULL || index >= json_object_get_count(object)) {
+        return NULL;
+    }
+    return object->cells[index].value;
+}
+
+JSON_Value *json_object_get_wrapping_value(const JSON_Object *object) {
+    return object->wrapping_value;
+}
+
+int json_object_has_value (const JSON_Object *object, const char *name) {
+    return json_object_get_value(object, name) != NULL;
+}
+
+int json_object_has_value_of_type(const JSON_Object *object, const char *name, JSON_Value_Type type) {
+    JSON_Value *val = json_object_get_value(object, name);
+    return val != NULL && json_value_get_type(val) == type;
+}
+
+int json_object_dothas_value (const JSON_Object *object, const char *name) {
+    return json_object_dotget_value(object, name) != NULL;
+}
+
+int json_object_dothas_value_of_type(const JSON_Object *object, const char *name, JSON_Value_Type type) {
+    JSON_Value *val = json_object_dotget_value(object, name);
+    return val != NULL && json_value_get_type(val) == type;
+}
+
+/* JSON Array API */
+JSON_Value * json_array_get_value(const JSON_Array *array, size_t index) {
+    if (array == NULL || index >= json_array_get_count(array)) {
+        return NULL;
+    }
+    return array->items[index];
+}
+
+const char * json_array_get_string(const JSON_Array *array, size_t index) {
+    return json_value_get_string(json_array_get_value(array, index));
+}
+
+double json_array_get_number(const JSON_Array *array, size_t index) {
+    return json_value_get_number(json_array_get_value(array, index));
+}
+
+int64_t json_array_get_int64(const JSON_Array *array, size_t index) {
+    return json_value_get_int64(json_array_get_value(array, index));
+}
+
+JSON_Object * json_array_get_object(const JSON_Array *array, size_t index) {
+    return json_value_get_object(json_array_get_value(array, index));
+}
+
+JSON_Array * json_array_get_array(const JSON_Array *array, size_t index) {
+    return json_value_get_array(json_array_get_value(array, index));
+}
+
+int json_array_get_boolean(const JSON_Array *array, size_t index) {
+    return json_value_get_boolean(json_array_get_value(array, index));
+}
+
+size_t json_array_get_count(const JSON_Array *array) {
+    return array ? array->count : 0;
+}
+
+JSON_Value * json_array_get_wrapping_value(const JSON_Array *array) {
+    return array->wrapping_value;
+}
+
+/* JSON Value API */
+JSON_Value_Type json_value_get_type(const JSON_Value *value) {
+    if (value == NULL) {
+        return JSONError;
+    }
+    return value->type & 0xFF; /* strip JSONInteger and JSONShortString flags */
+}
+
+JSON_Object * json_value_get_object(const JSON_Value *value) {
+    return json_value_get_type(value) == JSONObject ? value->value.object : NULL;
+}
+
+JSON_Array * json_value_get_array(const JSON_Value *value) {
+    return json_value_get_type(value) == JSONArray ? value->value.array : NULL;
+}
+
+const char * json_value_get_string(const JSON_Value *value) {
+    return json_value_get_type(value) == JSONString ? STRING_BUFFER(value) : NULL;
+}
+
+double json_value_get_number(const JSON_Value *value) {
+    if (json_value_get_type(value) != JSONNumber) {
+        return 0;
+    }
+    return value->type == JSONInteger ? (double)value->value.integer : value->value.number;
+}
+
+int64_t json_value_get_int64(const JSON_Value *value) {
+    double number = 0;
+    if (json_value_get_type(value) != JSONNumber) {
+        return 0;
+    }
+    if (value->type == JSONInteger) {
+        return value->value.integer;
+    }
+    number = value->value.number;
+    if (number < -9223372036854775808.0 || number >= 9223372036854775808.0) {
+        return 0; /* doesn't fit */
+    }
+    return (int64_t)number;
+}
+
+int json_value_is_int64(const JSON_Value *value) {
+    return value != NULL && value->type == JSONInteger;
+}
+
+int json_value_get_boolean(const JSON_Value *value) {
+    return json_value_get_type(value) == JSONBoolean ? value->value.boolean : -1;
+}
+
+JSON_Value * json_value_get_parent (const JSON_Value *value) {
+    return value ? value->parent : NULL;
+}
+
+/* Iterative: takes the last member or item of each container until it's empty, descending into
+ * containers and coming back up through the parent links. */
+void json_value_free(JSON_Value *value) {
+    JSON_Value *top = value, *child = NULL;
+    JSON_Object *object = NULL;
+    JSON_Array *array = NULL;
+    if (value == NULL || IS_SHARED_VALUE(value)) {
+        return;
+    }
+    while (value != NULL) {
+        object = json_value_get_object(value);
+        array = json_value_get_array(value);
+        if (object != NULL && object->count > 0) {
+            object->count--;
+            free_key(&object->cells[object->count]);
+            child = object->cells[object->count].value;
+        } else if (array != NULL && array->count > 0) {
+            array->count--;
+            child = array->items[array->count];
+        } else {
+            if (object != NULL) {
+                json_object_free(object);
+            } else if (array != NULL) {
+                json_array_free(array);
+            }
+            child = value;
+            value = value == top ? NULL : json_value_get_parent(value);
+            json_value_release(child);
+            continue;
+        }
+        if (json_value_get_type(child) == JSONObject || json_value_get_type(child) == JSONArray) {
+            value = child;
+        } else if (!IS_SHARED_VALUE(child)) {
+            json_value_release(child);
+        }
+    }
+}
+
+JSON_Value * json_value_init_object(void) {
+    JSON_Value *new_value = (JSON_Value*)pool_alloc(JSONPoolObject);
+    if (!new_value) {
+        return NULL;
+    }
+    new_value->parent = NULL;
+    new_value->type = JSONObject;
+    new_value->value.object = (JSON_Object*)(new_value + 1);
+    json_object_init(new_value->value.object, new_value);
+    return new_value;
+}
+
+JSON_Value * json_value_init_array(void) {
+    JSON_Value *new_value = (JSON_Value*)pool_alloc(JSONPoolArray);
+    if (!new_value) {
+        return NULL;
+    }
+    new_value->parent = NULL;
+    new_value->type = JSONArray;
+    new_value->value.array = (JSON_Array*)(new_value + 1);
+    json_array_init(new_value->value.array, new_value);
+    return new_value;
+}
+
+JSON_Value * json_value_init_object_with_capacity(size_t capacity) {
+    JSON_Value *new_value = json_value_init_object();
+    if (new_value != NULL && capacity > 0 && json_object_resize(new_value->value.object, capacity) == JSONFailure) {
+        json_value_free(new_value);
+        return NULL;
+    }
+    return new_value;
+}
+
+JSON_Value * json_value_init_array_with_capacity(size_t capacity) {
+    JSON_Value *new_value = json_value_init_array();
+    if (new_value != NULL && capacity > 0 && json_array_resize(new_value->value.array, capacity) == JSONFailure) {
+        json_value_free(new_value);
+        return NULL;
+    }
+    return new_value;
+}
+
+JSON_Value * json_value_init_string(const char *string) {
+    size_t string_len = 0;
+    if (string == NULL) {
+        return NULL;
+    }
+    string_len = strlen(string);
+    if (!is_valid_utf8(string, string_len)) {
+        return NULL;
+    }
+    return json_value_init_string_n(string, string_len);
+}
+
+JSON_Value * json_value_init_number(double number) {
+    JSON_Value *new_value = NULL;
+    if (IS_NUMBER_INVALID(number)) {
+        return NULL;
+    }
+    new_value = (JSON_Value*)pool_alloc(JSONPoolValue);
+    if (new_value == NULL) {
+        return NULL;
+    }
+    new_value->parent = NULL;
+    new_value->type = JSONNumber;
+    new_value->value.number = number;
+    return new_value;
+}
+
+JSON_Value * json_value_init_int64(int64_t number) {
+    JSON_Value *new_value = (JSON_Value*)pool_alloc(JSONPoolValue);
+    if (new_value == NULL) {
+        return NULL;
+    }
+    new_value->parent = NULL;
+    new_value->type = JSONInteger;
+    new_value->value.integer = number;
+    return new_value;
+}
+
+JSON_Value * json_value_init_boolean(int boolean) {
+    return boolean ? &parson_true : &parson_false;
+}
+
+JSON_Value * json_value_init_null(void) {
+    return &parson_null;
+}
+
+JSON_Value * json_value_deep_copy(const JSON_Value *value) {
+    size_t i = 0;
+    JSON_Value *return_value = NULL, *temp_value_copy = NULL, *temp_value = NULL;
+    const char *temp_string = NULL;
+    JSON_Object_Cell temp_cell_copy;
+    const JSON_Object_Cell *temp_cell = NULL;
+    JSON_Array *temp_array = NULL, *temp_array_copy = NULL;
+    JSON_Object *temp_object = NULL, *temp_object_copy = NULL;
+
+    switch (json_value_get_type(value)) {
+        case JSONArray:
+            temp_array = json_value_get_array(value);
+            return_value = json_value_init_array_with_capacity(temp_array->count);
+            if (return_value == NULL) {
+                return NULL;
+            }
+            temp_array_copy = json_value_get_array(return_value);
+            for (i = 0; i < json_array_get_count(temp_array); i++) {
+                temp_value = json_array_get_value(temp_array, i);
+                temp_value_copy = json_value_deep_copy(temp_value);
+                if (temp_value_copy == NULL) {
+                    json_value_free(return_value);
+                    return NULL;
+                }
+                if (json_array_add(temp_array_copy, temp_value_copy) == JSONFailure) {
+                    json_value_free(return_value);
+                    json_value_free(temp_value_copy);
+                    return NULL;
+                }
+            }
+            return return_value;
+        case JSONObject:
+            temp_object = json_value_get_object(value);
+            return_value = json_value_init_object_with_capacity(temp_object->count);
+            if (return_value == NULL) {
+                return NULL;
+            }
+            temp_object_copy = json_value_get_object(return_value);
+            for (i = 0; i < temp_object->count; i++) {
+                temp_cell = &temp_object->cells[i];
+                temp_value_copy = json_value_deep_copy(temp_cell->value);
+                if (temp_value_copy == NULL) {
+                    json_value_free(return_value);
+                    return NULL;
+                }
+                if (CELL_IS_INTERNED(temp_cell)) { /* share it, whatever the current setting */
+                    KEY_OF_NAME(temp_cell->name)->refcount++;
+                    temp_cell_copy.name = temp_cell->name;
+                    temp_cell_copy.hash = temp_cell->hash;
+                } else {
+                    temp_cell_copy.name = copy_key(temp_cell->name, strlen(temp_cell->name), CELL_HASH(temp_cell), &temp_cell_copy.hash);
+                }
+                if (temp_cell_copy.name == NULL ||
+                    json_object_add_cell(temp_object_copy, temp_cell_copy.name, temp_cell_copy.hash, temp_value_copy) == JSONFailure) {
+                    if (temp_cell_copy.name != NULL) {
+                        free_key(&temp_cell_copy);
+                    }
+                    json_value_free(return_value);
+                    json_value_free(temp_value_copy);
+                    return NULL;
+                }
+            }
+            return return_value;
+        case JSONBoolean:
+            return json_value_init_boolean(json_value_get_boolean(value));
+        case JSONNumber:
+            if (json_value_is_int64(value)) {
+                return json_value_init_int64(json_value_get_int64(value));
+            }
+            return json_value_init_number(json_value_get_number(value));
+        case JSONString:
+            temp_string = json_value_get_string(value);
+            if (temp_string == NULL) {
+                return NULL;
+            }
+            return json_value_init_string_n(temp_string, strlen(temp_string));
+        case JSONNull:
+            return json_value_init_null();
+        case JSONError:
+            return NULL;
+        default:
+            return NULL;
+    }
+}
+
+size_t json_serialization_size(const JSON_Value *value) {
+    char num_buf[NUM_BUF_SIZE]; /* recursively allocating buffer on stack is a bad idea, so let's do it only once */
+    size_t res = json_serialize_to_buffer_r(value, NULL, 0, num_buf);
+    return res == 0 ? 0 : res + 1;
+}
+
+JSON_Status json_serialize_to_buffer(const JSON_Value *value, char *buf, size_t buf_size_in_bytes) {
+    size_t needed_size_in_bytes = json_serialization_size(value);
+    if (needed_size_in_bytes == 0 || buf_size_in_bytes < needed_size_in_bytes) {
+        return JSONFailure;
+    }
+    if (json_serialize_to_buffer_r(value, buf, 0, NULL) == 0) {
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+#ifdef PARSON_FILES
+JSON_Status json_serialize_to_file(const JSON_Value *value, const char *filename) {
+    JSON_Status return_code = JSONSuccess;
+    FILE *fp = NULL;
+    char *serialized_string = json_serialize_to_string(value);
+    if (serialized_string == NULL) {
+        return JSONFailure;
+    }
+    fp = fopen(filename, "w");
+    if (fp == NULL) {
+        json_free_serialized_string(serialized_string);
+        return JSONFailure;
+    }
+    if (fputs(serialized_string, fp) == EOF) {
+        return_code = JSONFailure;
+    }
+    if (fclose(fp) == EOF) {
+        return_code = JSONFailure;
+    }
+    json_free_serialized_string(serialized_string);
+    return return_code;
+}
+#endif
+
+char * json_serialize_to_string(const JSON_Value *value) {
+    JSON_Status serialization_result = JSONFailure;
+    size_t buf_size_bytes = json_serialization_size(value);
+    char *buf = NULL;
+    if (buf_size_bytes == 0) {
+        return NULL;
+    }
+    buf = (char*)parson_malloc(buf_size_bytes);
+    if (buf == NULL) {
+        return NULL;
+    }
+    serialization_result = json_serialize_to_buffer(value, buf, buf_size_bytes);
+    if (serialization_result == JSONFailure) {
+        json_free_serialized_string(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+size_t json_serialization_size_pretty(const JSON_Value *value) {
+    char num_buf[NUM_BUF_SIZE]; /* recursively allocating buffer on stack is a bad idea, so let's do it only once */
+    size_t res = json_serialize_to_buffer_r(value, NULL, 1, num_buf);
+    return res == 0 ? 0 : res + 1;
+}
+
+JSON_Status json_serialize_to_buffer_pretty(const JSON_Value *value, char *buf, size_t buf_size_in_bytes) {
+    size_t needed_size_in_bytes = json_serialization_size_pretty(value);
+    if (needed_size_in_bytes == 0 || buf_size_in_bytes < needed_size_in_bytes) {
+        return JSONFailure;
+    }
+    if (json_serialize_to_buffer_r(value, buf, 1, NULL) == 0) {
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+#ifdef PARSON_FILES
+JSON_Status json_serialize_to_file_pretty(const JSON_Value *value, const char *filename) {
+    JSON_Status return_code = JSONSuccess;
+    FILE *fp = NULL;
+    char *serialized_string = json_serialize_to_string_pretty(value);
+    if (serialized_string == NULL) {
+        return JSONFailure;
+    }
+    fp = fopen(filename, "w");
+    if (fp == NULL) {
+        json_free_serialized_string(serialized_string);
+        return JSONFailure;
+    }
+    if (fputs(serialized_string, fp) == EOF) {
+        return_code = JSONFailure;
+    }
+    if (fclose(fp) == EOF) {
+        return_code = JSONFailure;
+    }
+    json_free_serialized_string(serialized_string);
+    return return_code;
+}
+#endif
+
+char * json_serialize_to_string_pretty(const JSON_Value *value) {
+    JSON_Status serialization_result = JSONFailure;
+    size_t buf_size_bytes = json_serialization_size_pretty(value);
+    char *buf = NULL;
+    if (buf_size_bytes == 0) {
+        return NULL;
+    }
+    buf = (char*)parson_malloc(buf_size_bytes);
+    if (buf == NULL) {
+        return NULL;
+    }
+    serialization_result = json_serialize_to_buffer_pretty(value, buf, buf_size_bytes);
+    if (serialization_result == JSONFailure) {
+        json_free_serialized_string(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+JSON_Status json_serialize_to_writer(const JSON_Value *value, char *chunk, size_t chunk_size,
+                                     JSON_Write_Function write_fun, void *context) {
+    return json_serialize_to_writer_r(value, chunk, chunk_size, write_fun, context, 0);
+}
+
+JSON_Status json_serialize_to_writer_pretty(const JSON_Value *value, char *chunk, size_t chunk_size,
+                                            JSON_Write_Function write_fun, void *context) {
+    return json_serialize_to_writer_r(value, chunk, chunk_size, write_fun, context, 1);
+}
+
+void json_free_serialized_string(char *string) {
+    parson_free(string);
+}
+
+/* Binary serialization API */
+size_t json_serialization_size_cbor(const JSON_Value *value) {
+    return json_binary_size(value, BINARY_CBOR);
+}
+
+JSON_Status json_serialize_to_buffer_cbor(const JSON_Value *value, void *buf, size_t buf_size_in_bytes) {
+    return json_serialize_to_binary(value, buf, buf_size_in_bytes, BINARY_CBOR);
+}
+
+JSON_Value * json_parse_cbor(const void *data, size_t size) {
+    return json_parse_binary(data, size, BINARY_CBOR);
+}
+
+#ifdef PARSON_MSGPACK
+size_t json_serialization_size_msgpack(const JSON_Value *value) {
+    return json_binary_size(value, BINARY_MSGPACK);
+}
+
+JSON_Status json_serialize_to_buffer_msgpack(const JSON_Value *value, void *buf, size_t buf_size_in_bytes) {
+    return json_serialize_to_binary(value, buf, buf_size_in_bytes, BINARY_MSGPACK);
+}
+
+JSON_Value * json_parse_msgpack(const void *data, size_t size) {
+    return json_parse_binary(data, size, BINARY_MSGPACK);
+}
+#endif
+
+JSON_Status json_array_remove(JSON_Array *array, size_t ix) {
+    size_t to_move_bytes = 0;
+    if (array == NULL || ix >= json_array_get_count(array)) {
+        return JSONFailure;
+    }
+    json_value_free(json_array_get_value(array, ix));
+    to_move_bytes = (json_array_get_count(array) - 1 - ix) * sizeof(JSON_Value*);
+    memmove(array->items + ix, array->items + ix + 1, to_move_bytes);
+    array->count -= 1;
+    if (parson_tracked_objects > 0) {
+        json_value_note_change(json_array_get_wrapping_value(array));
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_replace_value(JSON_Array *array, size_t ix, JSON_Value *value) {
+    if (array == NULL || value == NULL || value->parent != NULL || ix >= json_array_get_count(array)) {
+        return JSONFailure;
+    }
+    json_value_free(json_array_get_value(array, ix));
+    SET_PARENT(value, json_array_get_wrapping_value(array));
+    array->items[ix] = value;
+    if (parson_tracked_objects > 0) {
+        json_value_note_change(json_array_get_wrapping_value(array));
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_replace_string(JSON_Array *array, size_t i, const char* string) {
+    JSON_Value *value = json_value_init_string(string);
+    if (value == NULL) {
+        return JSONFailure;
+    }
+    if (json_array_replace_value(array, i, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_replace_number(JSON_Array *array, size_t i, double number) {
+    JSON_Value *value = json_value_init_number(number);
+    if (value == NULL) {
+        return JSONFailure;
+    }
+    if (json_array_replace_value(array, i, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_replace_boolean(JSON_Array *array, size_t i, int boolean) {
+    JSON_Value *value = json_value_init_boolean(boolean);
+    if (value == NULL) {
+        return JSONFailure;
+    }
+    if (json_array_replace_value(array, i, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_replace_null(JSON_Array *array, size_t i) {
+    JSON_Value *value = json_value_init_null();
+    if (value == NULL) {
+        return JSONFailure;
+    }
+    if (json_array_replace_value(array, i, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_reserve(JSON_Array *array, size_t capacity) {
+    if (array == NULL) {
+        return JSONFailure;
+    }
+    return capacity <= array->capacity ? JSONSuccess : json_array_resize(array, capacity);
+}
+
+JSON_Status json_array_clear(JSON_Array *array) {
+    size_t i = 0;
+    if (array == NULL) {
+        return JSONFailure;
+    }
+    for (i = 0; i < json_array_get_count(array); i++) {
+        json_value_free(json_array_get_value(array, i));
+    }
+    array->count = 0;
+    if (parson_tracked_objects > 0) {
+        json_value_note_change(json_array_get_wrapping_value(array));
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_append_value(JSON_Array *array, JSON_Value *value) {
+    if (array == NULL || value == NULL || value->parent != NULL) {
+        return JSONFailure;
+    }
+    if (json_array_add(array, value) == JSONFailure) {
+        return JSONFailure;
+    }
+    if (parson_tracked_objects > 0) {
+        json_value_note_change(json_array_get_wrapping_value(array));
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_append_string(JSON_Array *array, const char *string) {
+    JSON_Value *value = json_value_init_string(string);
+    if (value == NULL) {
+        return JSONFailure;
+    }
+    if (json_array_append_value(array, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_append_number(JSON_Array *array, double number) {
+    JSON_Value *value = json_value_init_number(number);
+    if (value == NULL) {
+        return JSONFailure;
+    }
+    if (json_array_append_value(array, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_append_int64(JSON_Array *array, int64_t number) {
+    JSON_Value *value = json_value_init_int64(number);
+    if (value == NULL) {
+        return JSONFailure;
+    }
+    if (json_array_append_value(array, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_append_boolean(JSON_Array *array, int boolean) {
+    JSON_Value *value = json_value_init_boolean(boolean);
+    if (value == NULL) {
+        return JSONFailure;
+    }
+    if (json_array_append_value(array, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_array_append_null(JSON_Array *array) {
+    JSON_Value *value = json_value_init_null();
+    if (value == NULL) {
+        return JSONFailure;
+    }
+    if (json_array_append_value(array, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
+    }
+    return JSONSuccess;
+}
+
+JSON_Status json_object_set_value(JSON_Object *object, const char *name, JSON_Value *value) {
+    size_t name_len = 0;
+    if (name == NULL) {
+        return JSONFailure;
+    }
+    name_len = strlen(name);
+    return json_object_setn_value_hashed(object, name, name_len, hash_string(name, name_len), value);
+}
+
+JSON_Status json_object_set_string(JSON_Object *object, const char *name, const char *string) {
+    return json_object_set_value(object, name, json_value_init_string(string));
+}
+
+JSON_Status json_object_set_number(JSON_Object *object, const char *name, double number) {
+    return json_object_set_value(object, name, json_value_init_number(number));
+}
+
+JSON_Status json_object_set_int64(JSON_Object *object, const char *name, int64_t number) {
+    return json_object_set_value(object, name, json_value_init_int64(number));
+}
+
+JSON_Status json_object_set_boolean(JSON_Object *object, const char *name, int boolean) {
+    return json_object_set_value(object, name, json_value_init_boolean(boolean));
+}
+
+JSON_Status json_object_set_null(JSON_Object *object, const char *name) {
+    return json_object_set_value(object, name, json_value_init_null());
+}
+
+JSON_Status json_object_dotset_value(JSON_Object *object, const char *name, JSON_Value *value) {
+    const char *dot_pos = NULL;
+    JSON_Value *temp_value = NULL, *new_value = NULL;
+    JSON_Object *temp_object = NULL, *new_object = NULL;
+    JSON_Status status = JSONFailure;
+    size_t name_len = 0;
+    if (object == NULL || name == NULL || value == NULL) {
+        return JSONFailure;
+    }
+    dot_pos = strchr(name, '.');
+    if (dot_pos == NULL) {
+        return json_object_set_value(object, name, value);
+    }
+    name_len = dot_pos - name;
+    temp_value = json_object_getn_value(object, name, name_len);
+    if (temp_value) {
+        /* Don't overwrite existing non-object (unlike json_object_set_value, but it shouldn't be changed at this point) */
+        if (json_value_get_type(temp_value) != JSONObject) {
+            return JSONFailure;
+        }
+        temp_object = json_value_get_object(temp_value);
+        return json_object_dotset_value(temp_object, dot_pos + 1, value);
+    }
+    new_value = json_value_init_object();
+    if (new_value == NULL) {
+        return JSONFailure;
+    }
+    new_object = json_value_get_object(new_value);
+    status = json_object_dotset_value(new_object, dot_pos + 1, value);
+    if (status != JSONSuccess) {
+        json_value_free(new_value);
+        return JSONFailure;
+    }
+    status = json_object_addn(object, name, name_len, new_value);
+    if (status != JSONSuccess) {
+        json_object_dotremove_internal(new_object, dot_pos + 1, 0);
+        json_value_free(new_value);
+        return JSONFailure;
     }
+    return JSONSuccess;
 }
 
-size_t json_serialization_size(const JSON_Value *value) {
-    char num_buf[NUM_BUF_SIZE]; /* recursively allocating buffer on stack is a bad idea, so let's do it only once */
-    int res = json_serialize_to_buffer_r(value, NULL, 0, 0, num_buf);
-    return res < 0 ? 0 : (size_t)(res + 1);
+JSON_Status json_object_dotset_string(JSON_Object *object, const char *name, const char *string) {
+    JSON_Value *value = json_value_init_string(string);
+    if (value == NULL) {
+        return JSONFailure;
+    }
+    if (json_object_dotset_value(object, name, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
+    }
+    return JSONSuccess;
 }
 
-JSON_Status json_serialize_to_buffer(const JSON_Value *value, char *buf, size_t buf_size_in_bytes) {
-    int written = -1;
-    size_t needed_size_in_bytes = json_serialization_size(value);
-    if (needed_size_in_bytes == 0 || buf_size_in_bytes < needed_size_in_bytes) {
+JSON_Status json_object_dotset_number(JSON_Object *object, const char *name, double number) {
+    JSON_Value *value = json_value_init_number(number);
+    if (value == NULL) {
         return JSONFailure;
     }
-    written = json_serialize_to_buffer_r(value, buf, 0, 0, NULL);
-    if (written < 0) {
+    if (json_object_dotset_value(object, name, value) == JSONFailure) {
+        json_value_free(value);
         return JSONFailure;
     }
     return JSONSuccess;
 }
 
-#ifdef PARSON_FILES
-JSON_Status json_serialize_to_file(const JSON_Value *value, const char *filename) {
-    JSON_Status return_code = JSONSuccess;
-    FILE *fp = NULL;
-    char *serialized_string = json_serialize_to_string(value);
-    if (serialized_string == NULL) {
+JSON_Status json_object_dotset_int64(JSON_Object *object, const char *name, int64_t number) {
+    JSON_Value *value = json_value_init_int64(number);
+    if (value == NULL) {
         return JSONFailure;
     }
-    fp = fopen(filename, "w");
-    if (fp == NULL) {
-        json_free_serialized_string(serialized_string);
+    if (json_object_dotset_value(object, name, value) == JSONFailure) {
+        json_value_free(value);
         return JSONFailure;
     }
-    if (fputs(serialized_string, fp) == EOF) {
-        return_code = JSONFailure;
+    return JSONSuccess;
+}
+
+JSON_Status json_object_dotset_boolean(JSON_Object *object, const char *name, int boolean) {
+    JSON_Value *value = json_value_init_boolean(boolean);
+    if (value == NULL) {
+        return JSONFailure;
     }
-    if (fclose(fp) == EOF) {
-        return_code = JSONFailure;
+    if (json_object_dotset_value(object, name, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
     }
-    json_free_serialized_string(serialized_string);
-    return return_code;
+    return JSONSuccess;
 }
-#endif
 
-char * json_serialize_to_string(const JSON_Value *value) {
-    JSON_Status serialization_result = JSONFailure;
-    size_t buf_size_bytes = json_serialization_size(value);
-    char *buf = NULL;
-    if (buf_size_bytes == 0) {
-        return NULL;
-    }
-    buf = (char*)parson_malloc(buf_size_bytes);
-    if (buf == NULL) {
-        return NULL;
+JSON_Status json_object_dotset_null(JSON_Object *object, const char *name) {
+    JSON_Value *value = json_value_init_null();
+    if (value == NULL) {
+        return JSONFailure;
     }
-    serialization_result = json_serialize_to_buffer(value, buf, buf_size_bytes);
-    if (serialization_result == JSONFailure) {
-        json_free_serialized_string(buf);
-        return NULL;
+    if (json_object_dotset_value(object, name, value) == JSONFailure) {
+        json_value_free(value);
+        return JSONFailure;
     }
-    return buf;
+    return JSONSuccess;
 }
 
-size_t json_serialization_size_pretty(const JSON_Value *value) {
-    char num_buf[NUM_BUF_SIZE]; /* recursively allocating buffer on stack is a bad idea, so let's do it only once */
-    int res = json_serialize_to_buffer_r(value, NULL, 0, 1, num_buf);
-    return res < 0 ? 0 : (size_t)(res + 1);
+JSON_Status json_object_remove(JSON_Object *object, const char *name) {
+    return json_object_remove_internal(object, name, 1);
 }
 
-JSON_Status json_serialize_to_buffer_pretty(const JSON_Value *value, char *buf, size_t buf_size_in_bytes) {
-    int written = -1;
-    size_t needed_size_in_bytes = json_serialization_size_pretty(value);
-    if (needed_size_in_bytes == 0 || buf_size_in_bytes < needed_size_in_bytes) {
+JSON_Status json_object_dotremove(JSON_Object *object, const char *name) {
+    return json_object_dotremove_internal(object, name, 1);
+}
+
+JSON_Status json_object_reserve(JSON_Object *object, size_t capacity) {
+    if (object == NULL) {
         return JSONFailure;
     }
-    written = json_serialize_to_buffer_r(value, buf, 0, 1, NULL);
-    if (written < 0) {
+    return capacity <= object->capacity ? JSONSuccess : json_object_resize(object, capacity);
+}
+
+JSON_Status json_object_clear(JSON_Object *object) {
+    size_t i = 0;
+    if (object == NULL) {
         return JSONFailure;
     }
+    for (i = 0; i < json_object_get_count(object); i++) {
+        if (parson_tracked_objects > 0) {
+            json_object_note_removed(object, object->cells[i].name);
+        }
+        json_object_free_value(object, object->cells[i].name, object->cells[i].value);
+        free_key(&object->cells[i]);
+    }
+    if (object->changes != NULL && object->count > 0) {
+        memset(object->changes->dirty, 0, object->count);
+    }
+    object->count = 0;
     return JSONSuccess;
 }
 
-#ifdef PARSON_FILES
-JSON_Status json_serialize_to_file_pretty(const JSON_Value *value, const char *filename) {
-    JSON_Status return_code = JSONSuccess;
-    FILE *fp = NULL;
-    char *serialized_string = json_serialize_to_string_pretty(value);
-    if (serialized_string == NULL) {
+/* Merge patch API */
+JSON_Status json_object_track_changes(JSON_Object *object, int track) {
+    if (object == NULL) {
         return JSONFailure;
     }
-    fp = fopen(filename, "w");
-    if (fp == NULL) {
-        json_free_serialized_string(serialized_string);
+    if (!track) {
+        json_object_untrack(object);
+        return JSONSuccess;
+    }
+    if (json_object_track(object) == JSONFailure) {
+        json_object_untrack(object);
         return JSONFailure;
     }
-    if (fputs(serialized_string, fp) == EOF) {
-        return_code = JSONFailure;
+    return JSONSuccess;
+}
+
+JSON_Value * json_object_get_changes(const JSON_Object *object) {
+    JSON_Value *patch_value = NULL, *member_patch = NULL, *member = NULL;
+    JSON_Object *patch = NULL, *child = NULL, *previous = NULL;
+    const JSON_Changes *changes = NULL;
+    size_t i = 0;
+    if (object == NULL || object->changes == NULL) {
+        return NULL;
     }
-    if (fclose(fp) == EOF) {
-        return_code = JSONFailure;
+    changes = object->changes;
+    patch_value = json_value_init_object();
+    if (patch_value == NULL || !changes->pending) {
+        return patch_value;
     }
-    json_free_serialized_string(serialized_string);
-    return return_code;
+    patch = json_value_get_object(patch_value);
+    for (i = 0; i < object->count; i++) {
+        member = object->cells[i].value;
+        child = json_value_get_object(member);
+        if (changes->dirty[i]) {
+            previous = json_object_get_object(json_value_get_object(changes->previous), object->cells[i].name);
+            if (previous != NULL && child != NULL) {
+                member_patch = json_object_replacement_patch(previous, child);
+            } else {
+                member_patch = json_value_deep_copy(member);
+            }
+        } else if (child != NULL && child->changes != NULL && child->changes->pending) {
+            member_patch = json_object_get_changes(child);
+            if (member_patch != NULL && json_object_get_count(json_value_get_object(member_patch)) == 0) {
+                json_value_free(member_patch);
+                continue;
+            }
+        } else {
+            continue;
+        }
+        if (member_patch == NULL ||
+            json_object_addn(patch, object->cells[i].name, strlen(object->cells[i].name), member_patch) == JSONFailure) {
+            json_value_free(member_patch);
+            json_value_free(patch_value);
+            return NULL;
+        }
+    }
+    for (i = 0; i < changes->removed_count; i++) {
+        if (json_object_get_value(object, changes->removed[i]) == NULL &&
+            json_object_set_null(patch, changes->removed[i]) == JSONFailure) {
+            json_value_free(patch_value);
+            return NULL;
+        }
+    }
+    return patch_value;
 }
-#endif
 
-char * json_serialize_to_string_pretty(const JSON_Value *value) {
-    JSON_Status serialization_result = JSONFailure;
-    size_t buf_size_bytes = json_serialization_size_pretty(value);
-    char *buf = NULL;
-    if (buf_size_bytes == 0) {
-        return NULL;
+void json_object_clear_changes(JSON_Object *object) {
+    JSON_Changes *changes = NULL;
+    JSON_Object *child = NULL;
+    size_t i = 0;
+    if (object == NULL || object->changes == NULL || !object->changes->pending) {
+        return;
     }
-    buf = (char*)parson_malloc(buf_size_bytes);
-    if (buf == NULL) {
-        return NULL;
+    changes = object->changes;
+    for (i = 0; i < object->count; i++) {
+        changes->dirty[i] = 0;
+        child = json_value_get_object(object->cells[i].value);
+        if (child != NULL) {
+            json_object_clear_changes(child);
+        }
     }
-    serialization_result = json_serialize_to_buffer_pretty(value, buf, buf_size_bytes);
-    if (serialization_result == JSONFailure) {
-        json_free_serialized_string(buf);
-        return NULL;
+    for (i = 0; i < changes->removed_count; i++) {
+        parson_free(changes->removed[i]);
     }
-    return buf;
+    changes->removed_count = 0;
+    json_value_free(changes->previous);
+    changes->previous = NULL;
+    changes->pending = 0;
 }
 
-void json_free_serialized_string(char *string) {
-    parson_free(string);
+JSON_Value * json_value_diff(const JSON_Value *from, const JSON_Value *to) {
+    JSON_Value *patch_value = NULL, *member_patch = NULL, *to_member = NULL, *from_member = NULL;
+    JSON_Object *patch = NULL, *from_object = NULL, *to_object = NULL;
+    const JSON_Object_Cell *cell = NULL;
+    size_t i = 0, name_len = 0;
+    if (from == NULL || to == NULL) {
+        return NULL;
+    }
+    if (json_value_get_type(from) != JSONObject || json_value_get_type(to) != JSONObject) {
+        return json_value_deep_copy(to); /* replaces the whole target */
+    }
+    from_object = json_value_get_object(from);
+    to_object = json_value_get_object(to);
+    patch_value = json_value_init_object();
+    if (patch_value == NULL) {
+        return NULL;
+    }
+    patch = json_value_get_object(patch_value);
+    for (i = 0; i < from_object->count; i++) {
+        cell = &from_object->cells[i];
+        name_len = strlen(cell->name);
+        if (json_object_getn_value(to_object, cell->name, name_len) == NULL &&
+            json_object_addn(patch, cell->name, name_len, json_value_init_null()) == JSONFailure) {
+            json_value_free(patch_value);
+            return NULL;
+        }
+    }
+    for (i = 0; i < to_object->count; i++) {
+        cell = &to_object->cells[i];
+        name_len = strlen(cell->name);
+        to_member = cell->value;
+        from_member = json_object_getn_value(from_object, cell->name, name_len);
+        if (from_member == NULL) {
+            member_patch = json_value_deep_copy(to_member);
+        } else if (json_value_get_type(from_member) == JSONObject && json_value_get_type(to_member) == JSONObject) {
+            member_patch = json_value_diff(from_member, to_member);
+            if (member_patch != NULL && json_object_get_count(json_value_get_object(member_patch)) == 0) {
+                json_value_free(member_patch);
+                continue;
+            }
+        } else if (!json_value_equals(from_member, to_member)) {
+            member_patch = json_value_deep_copy(to_member);
+        } else {
+            continue;
+        }
+        if (member_patch == NULL || json_object_addn(patch, cell->name, name_len, member_patch) == JSONFailure) {
+            json_value_free(member_patch);
+            json_value_free(patch_value);
+            return NULL;
+        }
+    }
+    return patch_value;
 }
 
-JSON_Status json_array_remove(JSON_Array *array, size_t ix) {
-    size_t to_move_bytes = 0;
-    if (array == NULL || ix >= json_array_get_count(array)) {
+JSON_Status json_value_merge_patch(JSON_Value *target, const JSON_Value *patch) {
+    JSON_Object *target_object = NULL, *patch_object = NULL;
+    JSON_Value *target_member = NULL, *new_member = NULL;
+    const JSON_Object_Cell *cell = NULL;
+    size_t i = 0, name_len = 0;
+    if (json_value_get_type(target) != JSONObject || json_value_get_type(patch) != JSONObject) {
         return JSONFailure;
     }
-    json_value_free(json_array_get_value(array, ix));
-    to_move_bytes = (json_array_get_count(array) - 1 - ix) * sizeof(JSON_Value*);
-    memmove(array->items + ix, array->items + ix + 1, to_move_bytes);
-    array->count -= 1;
+    target_object = json_value_get_object(target);
+    patch_object = json_value_get_object(patch);
+    for (i = 0; i < patch_object->count; i++) {
+        cell = &patch_object->cells[i];
+        name_len = strlen(cell->name);
+        if (json_value_get_type(cell->value) == JSONNull) {
+            json_object_remove_internal(target_object, cell->name, 1);
+            continue;
+        }
+        if (json_value_get_type(cell->value) == JSONObject) {
+            target_member = json_object_getn_value(target_object, cell->name, name_len);
+            if (json_value_get_type(target_member) == JSONObject) {
+                if (json_value_merge_patch(target_member, cell->value) == JSONFailure) {
+                    return JSONFailure;
+                }
+                continue;
+            }
+            new_member = json_value_init_object();
+            if (new_member != NULL && json_value_merge_patch(new_member, cell->value) == JSONFailure) {
+                json_value_free(new_member);
+                return JSONFailure;
+            }
+        } else {
+            new_member = json_value_deep_copy(cell->value);
+        }
+        if (new_member == NULL ||
+            json_object_setn_value_hashed(target_object, cell->name, name_len, CELL_HASH(cell), new_member) == JSONFailure) {
+            json_value_free(new_member);
+            return JSONFailure;
+        }
+    }
     return JSONSuccess;
 }
 
-JSON_Status json_array_replace_value(JSON_Array *array, size_t ix, JSON_Value *value) {
-    if (array == NULL || value == NULL || value->parent != NULL || ix >= json_array_get_count(array)) {
-        return JSONFailure;
+/* Compiled path API */
+JSON_Path * json_path_compile(const char *dotted_path) {
+    JSON_Path *path = NULL;
+    char *names = NULL, *name = NULL;
+    size_t count = 1, path_len = 0, i = 0;
+    if (dotted_path == NULL) {
+        return NULL;
     }
-    json_value_free(json_array_get_value(array, ix));
-    value->parent = json_array_get_wrapping_value(array);
-    array->items[ix] = value;
-    return JSONSuccess;
+    path_len = strlen(dotted_path);
+    for (i = 0; i < path_len; i++) {
+        if (dotted_path[i] == '.') {
+            count++;
+        }
+    }
+    /* one block for the path, its segments and a copy of the names */
+    path = (JSON_Path*)parson_malloc(sizeof(JSON_Path) + count * sizeof(JSON_Path_Segment) + path_len + 1);
+    if (path == NULL) {
+        return NULL;
+    }
+    path->segments = (JSON_Path_Segment*)(path + 1);
+    path->count = count;
+    names = (char*)(path->segments + count);
+    memcpy(names, dotted_path, path_len + 1);
+    name = names;
+    for (i = 0; i < count; i++) {
+        path->segments[i].name = name;
+        while (*name != '.' && *name != '\0') {
+            name++;
+        }
+        *name = '\0';
+        path->segments[i].len = name - path->segments[i].name;
+        path->segments[i].hash = hash_string(path->segments[i].name, path->segments[i].len);
+        name++;
+    }
+    return path;
 }
 
-JSON_Status json_array_replace_string(JSON_Array *array, size_t i, const char* string) {
-    JSON_Value *value = json_value_init_string(string);
-    if (value == NULL) {
-        return JSONFailure;
+void json_path_free(JSON_Path *path) {
+    parson_free(path);
+}
+
+JSON_Value * json_path_get_value(const JSON_Object *object, const JSON_Path *path) {
+    const JSON_Path_Segment *segment = NULL;
+    JSON_Value *value = NULL;
+    size_t i = 0, index = 0;
+    if (path == NULL) {
+        return NULL;
     }
-    if (json_array_replace_value(array, i, value) == JSONFailure) {
-        json_value_free(value);
-        return JSONFailure;
+    for (i = 0; i < path->count; i++) {
+        if (object == NULL) {
+            return NULL;
+        }
+        segment = &path->segments[i];
+        index = json_object_find(object, segment->name, segment->len, segment->hash);
+        if (index == object->count) {
+            return NULL;
+        }
+        value = object->cells[index].value;
+        object = json_value_get_object(value);
     }
-    return JSONSuccess;
+    return value;
 }
 
-JSON_Status json_array_replace_number(JSON_Array *array, size_t i, double number) {
-    JSON_Value *value = json_value_init_number(number);
-    if (value == NULL) {
+const char * json_path_get_string(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_string(json_path_get_value(object, path));
+}
+
+double json_path_get_number(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_number(json_path_get_value(object, path));
+}
+
+int64_t json_path_get_int64(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_int64(json_path_get_value(object, path));
+}
+
+JSON_Object * json_path_get_object(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_object(json_path_get_value(object, path));
+}
+
+JSON_Array * json_path_get_array(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_array(json_path_get_value(object, path));
+}
+
+int json_path_get_boolean(const JSON_Object *object, const JSON_Path *path) {
+    return json_value_get_boolean(json_path_get_value(object, path));
+}
+
+/* Same semantics as json_object_dotset_value: missing objects along the path are created, existing
+ * non-object values are not overwritten. */
+JSON_Status json_path_set_value(JSON_Object *object, const JSON_Path *path, JSON_Value *value) {
+    const JSON_Path_Segment *segment = NULL, *last = NULL;
+    JSON_Value *new_value = NULL, *temp_value = NULL;
+    JSON_Object *temp_object = NULL;
+    size_t i = 0, index = 0;
+    if (object == NULL || path == NULL || value == NULL || value->parent != NULL) {
         return JSONFailure;
     }
-    if (json_array_replace_value(array, i, value) == JSONFailure) {
-        json_value_free(value);
+    last = &path->segments[path->count - 1];
+    for (i = 0; i + 1 < path->count; i++) {
+        segment = &path->segments[i];
+        index = json_object_find(object, segment->name, segment->len, segment->hash);
+        if (index == object->count) {
+            break;
+        }
+        object = json_value_get_object(object->cells[index].value);
+        if (object == NULL) {
+            return JSONFailure;
+        }
+    }
+    if (i + 1 == path->count) {
+        return json_object_setn_value_hashed(object, last->name, last->len, last->hash, value);
+    }
+    /* build the missing part in a detached object, then attach it */
+    new_value = json_value_init_object();
+    if (new_value == NULL) {
         return JSONFailure;
     }
-    return JSONSuccess;
-}
-
-JSON_Status json_array_replace_boolean(JSON_Array *array, size_t i, int boolean) {
-    JSON_Value *value = json_value_init_boolean(boolean);
-    if (value == NULL) {
+    temp_object = json_value_get_object(new_value);
+    for (index = i + 1; index + 1 < path->count; index++) {
+        segment = &path->segments[index];
+        temp_value = json_value_init_object();
+        if (temp_value == NULL) {
+            json_value_free(new_value);
+            return JSONFailure;
+        }
+        if (json_object_addn_hashed(temp_object, segment->name, segment->len, segment->hash, temp_value) == JSONFailure) {
+            json_value_free(temp_value);
+            json_value_free(new_value);
+            return JSONFailure;
+        }
+        temp_object = json_value_get_object(temp_value);
+    }
+    if (json_object_addn_hashed(temp_object, last->name, last->len, last->hash, value) == JSONFailure) {
+        json_value_free(new_value);
         return JSONFailure;
     }
-    if (json_array_replace_value(array, i, value) == JSONFailure) {
-        json_value_free(value);
+    segment = &path->segments[i];
+    if (json_object_addn_hashed(object, segment->name, segment->len, segment->hash, new_value) == JSONFailure) {
+        json_object_remove_internal(temp_object, last->name, 0);
+        SET_PARENT(value, NULL);
+        json_value_free(new_value);
         return JSONFailure;
     }
     return JSONSuccess;
 }
 
-JSON_Status json_array_replace_null(JSON_Array *array, size_t i) {
-    JSON_Value *value = json_value_init_null();
+JSON_Status json_path_set_string(JSON_Object *object, const JSON_Path *path, const char *string) {
+    JSON_Value *value = json_value_init_string(string);
     if (value == NULL) {
         return JSONFailure;
     }
-    if (json_array_replace_value(array, i, value) == JSONFailure) {
+    if (json_path_set_value(object, path, value) == JSONFailure) {
         json_value_free(value);
         return JSONFailure;
     }
     return JSONSuccess;
 }
 
-JSON_Status json_array_clear(JSON_Array *array) {
-    size_t i = 0;
-    if (array == NULL) {
-        return JSONFailure;
-    }
-    for (i = 0; i < json_array_get_count(array); i++) {
-        json_value_free(json_array_get_value(array, i));
-    }
-    array->count = 0;
-    return JSONSuccess;
-}
-
-JSON_Status json_array_append_value(JSON_Array *array, JSON_Value *value) {
-    if (array == NULL || value == NULL || value->parent != NULL) {
-        return JSONFailure;
-    }
-    return json_array_add(array, value);
-}
-
-JSON_Status json_array_append_string(JSON_Array *array, const char *string) {
-    JSON_Value *value = json_value_init_string(string);
+JSON_Status json_path_set_number(JSON_Object *object, const JSON_Path *path, double number) {
+    JSON_Value *value = json_value_init_number(number);
     if (value == NULL) {
         return JSONFailure;
     }
-    if (json_array_append_value(array, value) == JSONFailure) {
+    if (json_path_set_value(object, path, value) == JSONFailure) {
         json_value_free(value);
         return JSONFailure;
     }
     return JSONSuccess;
 }
 
-JSON_Status json_array_append_number(JSON_Array *array, double number) {
-    JSON_Value *value = json_value_init_number(number);
+JSON_Status json_path_set_int64(JSON_Object *object, const JSON_Path *path, int64_t number) {
+    JSON_Value *value = json_value_init_int64(number);
     if (value == NULL) {
         return JSONFailure;
     }
-    if (json_array_append_value(array, value) == JSONFailure) {
+    if (json_path_set_value(object, path, value) == JSONFailure) {
         json_value_free(value);
         return JSONFailure;
     }
     return JSONSuccess;
 }
 
-JSON_Status json_array_append_boolean(JSON_Array *array, int boolean) {
+JSON_Status json_path_set_boolean(JSON_Object *object, const JSON_Path *path, int boolean) {
     JSON_Value *value = json_value_init_boolean(boolean);
     if (value == NULL) {
         return JSONFailure;
     }
-    if (json_array_append_value(array, value) == JSONFailure) {
+    if (json_path_set_value(object, path, value) == JSONFailure) {
         json_value_free(value);
         return JSONFailure;
     }
     return JSONSuccess;
 }
 
-JSON_Status json_array_append_null(JSON_Array *array) {
+JSON_Status json_path_set_null(JSON_Object *object, const JSON_Path *path) {
     JSON_Value *value = json_value_init_null();
     if (value == NULL) {
         return JSONFailure;
     }
-    if (json_array_append_value(array, value) == JSONFailure) {
+    if (json_path_set_value(object, path, value) == JSONFailure) {
         json_value_free(value);
         return JSONFailure;
     }
     return JSONSuccess;
 }
 
-JSON_Status json_object_set_value(JSON_Object *object, const char *name, JSON_Value *value) {
-    size_t i = 0;
-    JSON_Value *old_value;
-    if (object == NULL || name == NULL || value == NULL || value->parent != NULL) {
-        return JSONFailure;
+/* Views */
+/* The text of a view isn't NUL terminated, so unlike the parser these never look past end. */
+static const char * view_skip_whitespaces(const char *text, const char *end) {
+    while (text < end && isspace((unsigned char)*text)) {
+        text++;
     }
-    old_value = json_object_get_value(object, name);
-    if (old_value != NULL) { /* free and overwrite old value */
-        json_value_free(old_value);
-        for (i = 0; i < json_object_get_count(object); i++) {
-            if (strcmp(object->names[i], name) == 0) {
-                value->parent = json_object_get_wrapping_value(object);
-                object->values[i] = value;
-                return JSONSuccess;
-            }
-        }
-    }
-    /* add new key value pair */
-    return json_object_add(object, name, value);
-}
-
-JSON_Status json_object_set_string(JSON_Object *object, const char *name, const char *string) {
-    return json_object_set_value(object, name, json_value_init_string(string));
-}
-
-JSON_Status json_object_set_number(JSON_Object *object, const char *name, double number) {
-    return json_object_set_value(object, name, json_value_init_number(number));
-}
-
-JSON_Status json_object_set_boolean(JSON_Object *object, const char *name, int boolean) {
-    return json_object_set_value(object, name, json_value_init_boolean(boolean));
+    return text;
 }
 
-JSON_Status json_object_set_null(JSON_Object *object, const char *name) {
-    return json_object_set_value(object, name, json_value_init_null());
+/* Returns the byte after the string starting at text, NULL if it isn't closed */
+static const char * view_skip_string(const char *text, const char *end) {
+    const char *quote = NULL, *backslashes = NULL;
+    text++;
+    for (;;) {
+        quote = (const char*)memchr(text, '\"', (size_t)(end - text));
+        if (quote == NULL) {
+            return NULL;
+        }
+        for (backslashes = quote; backslashes > text && backslashes[-1] == '\\'; backslashes--) {
+        }
+        if (((quote - backslashes) & 1) == 0) { /* not escaped */
+            return quote + 1;
+        }
+        text = quote + 1;
+    }
 }
 
-JSON_Status json_object_dotset_value(JSON_Object *object, const char *name, JSON_Value *value) {
-    const char *dot_pos = NULL;
-    JSON_Value *temp_value = NULL, *new_value = NULL;
-    JSON_Object *temp_object = NULL, *new_object = NULL;
-    JSON_Status status = JSONFailure;
-    size_t name_len = 0;
-    if (object == NULL || name == NULL || value == NULL) {
-        return JSONFailure;
-    }
-    dot_pos = strchr(name, '.');
-    if (dot_pos == NULL) {
-        return json_object_set_value(object, name, value);
+/* Returns the byte after the value starting at text, NULL if it's cut short. Containers are skipped
+ * by matching brackets, their contents aren't checked. */
+static const char * view_skip_value(const char *text, const char *end) {
+    size_t depth = 0;
+    if (*text == '\"') {
+        return view_skip_string(text, end);
+    } else if (*text != '{' && *text != '[') {
+        while (text < end && strchr(",}] \t\r\n", *text) == NULL) {
+            text++;
+        }
+        return text;
     }
-    name_len = dot_pos - name;
-    temp_value = json_object_getn_value(object, name, name_len);
-    if (temp_value) {
-        /* Don't overwrite existing non-object (unlike json_object_set_value, but it shouldn't be changed at this point) */
-        if (json_value_get_type(temp_value) != JSONObject) {
-            return JSONFailure;
+    do {
+        if (text >= end) {
+            return NULL;
+        } else if (*text == '\"') {
+            text = view_skip_string(text, end);
+            if (text == NULL) {
+                return NULL;
+            }
+            continue;
+        } else if (*text == '{' || *text == '[') {
+            depth++;
+        } else if (*text == '}' || *text == ']') {
+            depth--;
         }
-        temp_object = json_value_get_object(temp_value);
-        return json_object_dotset_value(temp_object, dot_pos + 1, value);
+        text++;
+    } while (depth > 0);
+    return text;
+}
+
+/* Returns the value of the member name in the object starting at text, NULL if there is none.
+ * Stops at the first match, members after it aren't looked at. */
+static const char * view_find_member(const char *text, const char *end, const char *name, size_t name_len) {
+    const char *key = NULL, *key_end = NULL;
+    text = view_skip_whitespaces(text + 1, end);
+    while (text < end && *text == '\"') {
+        key = text + 1;
+        text = view_skip_string(text, end);
+        if (text == NULL) {
+            return NULL;
+        }
+        key_end = text - 1;
+        text = view_skip_whitespaces(text, end);
+        if (text >= end || *text != ':') {
+            return NULL;
+        }
+        text = view_skip_whitespaces(text + 1, end);
+        if (text >= end) {
+            return NULL;
+        } else if (view_key_equals(key, key_end, name, name_len)) {
+            return text;
+        }
+        text = view_skip_value(text, end);
+        if (text == NULL) {
+            return NULL;
+        }
+        text = view_skip_whitespaces(text, end);
+        if (text >= end || *text != ',') {
+            return NULL;
+        }
+        text = view_skip_whitespaces(text + 1, end);
     }
-    new_value = json_value_init_object();
-    if (new_value == NULL) {
-        return JSONFailure;
+    return NULL;
+}
+
+/* Decodes the next character of a string body into out (up to 4 bytes), returns its length or -1 */
+static int view_next_char(const char **raw, const char *end, char *out) {
+    char sequence[13]; /* longest escape: surrogate pair after the backslash */
+    const char *sequence_ptr = sequence;
+    char *out_ptr = out;
+    size_t sequence_len = 0;
+    if (**raw != '\\') {
+        *out = *(*raw)++;
+        return 1;
     }
-    new_object = json_value_get_object(new_value);
-    status = json_object_dotset_value(new_object, dot_pos + 1, value);
-    if (status != JSONSuccess) {
-        json_value_free(new_value);
-        return JSONFailure;
+    (*raw)++;
+    if (*raw >= end) {
+        return -1;
+    }
+    switch (*(*raw)++) {
+        case '\"': *out = '\"';  return 1;
+        case '\\': *out = '\\'; return 1;
+        case '/':  *out = '/';  return 1;
+        case 'b':  *out = '\b'; return 1;
+        case 'f':  *out = '\f'; return 1;
+        case 'n':  *out = '\n'; return 1;
+        case 'r':  *out = '\r'; return 1;
+        case 't':  *out = '\t'; return 1;
+        case 'u':
+            break;
+        default:
+            return -1;
     }
-    status = json_object_addn(object, name, name_len, new_value);
-    if (status != JSONSuccess) {
-        json_object_dotremove_internal(new_object, dot_pos + 1, 0);
-        json_value_free(new_value);
-        return JSONFailure;
+    /* parse_utf16 needs a terminated copy to stay within end */
+    (*raw)--;
+    sequence_len = MIN((size_t)(end - *raw), sizeof(sequence) - 1);
+    memcpy(sequence, *raw, sequence_len);
+    sequence[sequence_len] = '\0';
+    if (parse_utf16(&sequence_ptr, &out_ptr) == JSONFailure) {
+        return -1;
     }
-    return JSONSuccess;
+    *raw += sequence_ptr - sequence + 1;
+    return (int)(out_ptr - out + 1);
 }
 
-JSON_Status json_object_dotset_string(JSON_Object *object, const char *name, const char *string) {
-    JSON_Value *value = json_value_init_string(string);
-    if (value == NULL) {
-        return JSONFailure;
+static int view_key_equals(const char *raw, const char *raw_end, const char *name, size_t name_len) {
+    char decoded[4];
+    int decoded_len = 0;
+    if (memchr(raw, '\\', (size_t)(raw_end - raw)) == NULL) {
+        return (size_t)(raw_end - raw) == name_len && memcmp(raw, name, name_len) == 0;
     }
-    if (json_object_dotset_value(object, name, value) == JSONFailure) {
-        json_value_free(value);
-        return JSONFailure;
+    while (raw < raw_end) {
+        decoded_len = view_next_char(&raw, raw_end, decoded);
+        if (decoded_len < 0 || (size_t)decoded_len > name_len || memcmp(decoded, name, (size_t)decoded_len) != 0) {
+            return 0;
+        }
+        name += decoded_len;
+        name_len -= (size_t)decoded_len;
     }
-    return JSONSuccess;
+    return name_len == 0;
 }
 
-JSON_Status json_object_dotset_number(JSON_Object *object, const char *name, double number) {
-    JSON_Value *value = json_value_init_number(number);
-    if (value == NULL) {
+/* Sets view to the value starting at text, checking scalars */
+static JSON_Status view_init(JSON_View *view, const char *text, const char *end) {
+    const char *value_end = NULL;
+    double number = 0;
+    int64_t integer = 0;
+    int is_integer = 0;
+    if (text >= end) {
         return JSONFailure;
     }
-    if (json_object_dotset_value(object, name, value) == JSONFailure) {
-        json_value_free(value);
+    value_end = view_skip_value(text, end);
+    if (value_end == NULL) {
         return JSONFailure;
     }
-    return JSONSuccess;
+    view->text = text;
+    view->len = (size_t)(value_end - text);
+    switch (*text) {
+        case '{':
+            view->type = JSONObject;
+            return JSONSuccess;
+        case '[':
+            view->type = JSONArray;
+            return JSONSuccess;
+        case '\"':
+            view->type = JSONString;
+            return JSONSuccess;
+        case 't': case 'f':
+            view->type = JSONBoolean;
+            return (view->len == 4 && memcmp(text, "true", 4) == 0) ||
+                   (view->len == 5 && memcmp(text, "false", 5) == 0) ? JSONSuccess : JSONFailure;
+        case 'n':
+            view->type = JSONNull;
+            return view->len == 4 && memcmp(text, "null", 4) == 0 ? JSONSuccess : JSONFailure;
+        default:
+            view->type = JSONNumber;
+            return parse_number(text, view->len, &number, &integer, &is_integer) == view->len ? JSONSuccess : JSONFailure;
+    }
 }
 
-JSON_Status json_object_dotset_boolean(JSON_Object *object, const char *name, int boolean) {
-    JSON_Value *value = json_value_init_boolean(boolean);
-    if (value == NULL) {
+/* View API */
+JSON_Status json_view_find(const char *json, size_t json_len, const char *dotted_path, JSON_View *view) {
+    const char *end = json + json_len, *text = NULL, *dot = NULL;
+    if (json == NULL || view == NULL) {
         return JSONFailure;
     }
-    if (json_object_dotset_value(object, name, value) == JSONFailure) {
-        json_value_free(value);
-        return JSONFailure;
+    text = view_skip_whitespaces(json, end);
+    while (dotted_path != NULL) {
+        if (text >= end || *text != '{') {
+            return JSONFailure;
+        }
+        dot = strchr(dotted_path, '.');
+        text = view_find_member(text, end, dotted_path, dot != NULL ? (size_t)(dot - dotted_path) : strlen(dotted_path));
+        if (text == NULL) {
+            return JSONFailure;
+        }
+        dotted_path = dot != NULL ? dot + 1 : NULL;
     }
-    return JSONSuccess;
+    return view_init(view, text, end);
 }
 
-JSON_Status json_object_dotset_null(JSON_Object *object, const char *name) {
-    JSON_Value *value = json_value_init_null();
-    if (value == NULL) {
+JSON_Status json_view_get_string(const JSON_View *view, char *buf, size_t buf_size) {
+    const char *raw = NULL, *raw_end = NULL;
+    char decoded[4];
+    size_t len = 0;
+    int decoded_len = 0;
+    if (view == NULL || view->type != JSONString || buf == NULL || buf_size == 0) {
         return JSONFailure;
     }
-    if (json_object_dotset_value(object, name, value) == JSONFailure) {
-        json_value_free(value);
-        return JSONFailure;
+    raw = view->text + 1;
+    raw_end = view->text + view->len - 1;
+    if (memchr(raw, '\\', (size_t)(raw_end - raw)) == NULL) {
+        len = (size_t)(raw_end - raw);
+        if (len >= buf_size) {
+            return JSONFailure;
+        }
+        memcpy(buf, raw, len);
+    } else {
+        while (raw < raw_end) {
+            decoded_len = view_next_char(&raw, raw_end, decoded);
+            if (decoded_len < 0 || len + (size_t)decoded_len >= buf_size) {
+                return JSONFailure;
+            }
+            memcpy(buf + len, decoded, (size_t)decoded_len);
+            len += (size_t)decoded_len;
+        }
     }
+    buf[len] = '\0';
     return JSONSuccess;
 }
 
-JSON_Status json_object_remove(JSON_Object *object, const char *name) {
-    return json_object_remove_internal(object, name, 1);
-}
-
-JSON_Status json_object_dotremove(JSON_Object *object, const char *name) {
-    return json_object_dotremove_internal(object, name, 1);
+double json_view_get_number(const JSON_View *view) {
+    double number = 0;
+    int64_t integer = 0;
+    int is_integer = 0;
+    if (view == NULL || view->type != JSONNumber) {
+        return 0;
+    }
+    parse_number(view->text, view->len, &number, &integer, &is_integer);
+    return number;
 }
 
-JSON_Status json_object_clear(JSON_Object *object) {
-    size_t i = 0;
-    if (object == NULL) {
-        return JSONFailure;
+int json_view_get_boolean(const JSON_View *view) {
+    if (view == NULL || view->type != JSONBoolean) {
+        return -1;
     }
-    for (i = 0; i < json_object_get_count(object); i++) {
-        parson_free(object->names[i]);
-        json_value_free(object->values[i]);
-    }
-    object->count = 0;
-    return JSONSuccess;
+    return *view->text == 't';
 }
 
 JSON_Status json_validate(const JSON_Value *schema, const JSON_Value *value) {
@@ -1976,6 +5199,133 @@ JSON_Status json_validate(const JSON_Value *schema, const JSON_Value *value) {
     }
 }
 
+/* Compiled schema API */
+/* Counts the nodes and member name bytes json_schema_compile needs, following json_validate's rules:
+ * only the first item of an array schema matters. */
+static void schema_measure(const JSON_Value *schema, size_t *node_count, size_t *names_size) {
+    const JSON_Object *object = json_value_get_object(schema);
+    const JSON_Array *array = json_value_get_array(schema);
+    size_t i = 0;
+    (*node_count)++;
+    if (object != NULL) {
+        for (i = 0; i < object->count; i++) {
+            *names_size += strlen(object->cells[i].name) + 1;
+            schema_measure(object->cells[i].value, node_count, names_size);
+        }
+    } else if (array != NULL && array->count > 0) {
+        schema_measure(array->items[0], node_count, names_size);
+    }
+}
+
+/* Fills the node at index and its subtree, returns the index after it */
+static size_t schema_compile_node(JSON_Schema *compiled, size_t index, char **names, const JSON_Value *schema) {
+    JSON_Schema_Node *node = &compiled->nodes[index];
+    const JSON_Object *object = json_value_get_object(schema);
+    const JSON_Array *array = json_value_get_array(schema);
+    JSON_Schema_Node *member = NULL;
+    size_t i = 0, next = index + 1;
+    node->type = json_value_get_type(schema);
+    node->count = 0;
+    if (object != NULL) {
+        node->count = object->count;
+        for (i = 0; i < object->count; i++) {
+            member = &compiled->nodes[next];
+            next = schema_compile_node(compiled, next, names, object->cells[i].value);
+            member->name_len = strlen(object->cells[i].name);
+            member->hash = CELL_HASH(&object->cells[i]);
+            member->name = *names;
+            memcpy(*names, object->cells[i].name, member->name_len + 1);
+            *names += member->name_len + 1;
+        }
+    } else if (array != NULL && array->count > 0) {
+        node->count = 1;
+        next = schema_compile_node(compiled, next, names, array->items[0]);
+    }
+    node->next = next;
+    return next;
+}
+
+/* Recurses once per level of the schema, not of the value: deeper parts of the value aren't
+ * visited. */
+static JSON_Status schema_validate_node(const JSON_Schema *compiled, size_t index, const JSON_Value *value) {
+    const JSON_Schema_Node *node = &compiled->nodes[index], *member = NULL;
+    const JSON_Object *object = NULL;
+    const JSON_Array *array = NULL;
+    const JSON_Object_Cell *cell = NULL;
+    size_t i = 0, found = 0;
+    if (node->type == JSONNull) { /* null represents all values */
+        return JSONSuccess;
+    } else if (node->type != json_value_get_type(value)) {
+        return JSONFailure;
+    } else if (node->count == 0) { /* scalars and empty containers accept any value of their type */
+        return JSONSuccess;
+    }
+    if (node->type == JSONArray) {
+        array = json_value_get_array(value);
+        for (i = 0; i < array->count; i++) {
+            if (schema_validate_node(compiled, index + 1, array->items[i]) == JSONFailure) {
+                return JSONFailure;
+            }
+        }
+        return JSONSuccess;
+    }
+    object = json_value_get_object(value);
+    if (object->count < node->count) {
+        return JSONFailure; /* Tested object mustn't have less name-value pairs than schema */
+    }
+    member = &compiled->nodes[index + 1];
+    for (i = 0; i < node->count; i++) {
+        /* documents usually list members in the schema's order, so try the same slot first */
+        cell = &object->cells[i];
+        if (CELL_HASH(cell) != member->hash || !key_equals(cell->name, member->name, member->name_len)) {
+            found = json_object_find(object, member->name, member->name_len, member->hash);
+            if (found == object->count) {
+                return JSONFailure;
+            }
+            cell = &object->cells[found];
+        }
+        if (schema_validate_node(compiled, (size_t)(member - compiled->nodes), cell->value) == JSONFailure) {
+            return JSONFailure;
+        }
+        member = &compiled->nodes[member->next];
+    }
+    return JSONSuccess;
+}
+
+JSON_Schema * json_schema_compile(const JSON_Value *schema) {
+    JSON_Schema *compiled = NULL;
+    char *names = NULL;
+    size_t node_count = 0, names_size = 0;
+    if (schema == NULL || json_value_get_type(schema) == JSONError) {
+        return NULL;
+    }
+    schema_measure(schema, &node_count, &names_size);
+    /* one block for the schema, its nodes and a copy of the member names */
+    compiled = (JSON_Schema*)parson_malloc(sizeof(JSON_Schema) + node_count * sizeof(JSON_Schema_Node) + names_size);
+    if (compiled == NULL) {
+        return NULL;
+    }
+    compiled->nodes = (JSON_Schema_Node*)(compiled + 1);
+    compiled->count = node_count;
+    names = (char*)(compiled->nodes + node_count);
+    compiled->nodes[0].name = NULL;
+    compiled->nodes[0].name_len = 0;
+    compiled->nodes[0].hash = 0;
+    schema_compile_node(compiled, 0, &names, schema);
+    return compiled;
+}
+
+void json_schema_free(JSON_Schema *schema) {
+    parson_free(schema);
+}
+
+JSON_Status json_schema_validate(const JSON_Schema *schema, const JSON_Value *value) {
+    if (schema == NULL || value == NULL) {
+        return JSONFailure;
+    }
+    return schema_validate_node(schema, 0, value);
+}
+
 int json_value_equals(const JSON_Value *a, const JSON_Value *b) {
     JSON_Object *a_object = NULL, *b_object = NULL;
     JSON_Array *a_array = NULL, *b_array = NULL;
@@ -2030,6 +5380,9 @@ int json_value_equals(const JSON_Value *a, const JSON_Value *b) {
         case JSONBoolean:
             return json_value_get_boolean(a) == json_value_get_boolean(b);
         case JSONNumber:
+            if (json_value_is_int64(a) && json_value_is_int64(b)) {
+                return json_value_get_int64(a) == json_value_get_int64(b);
+            }
             return fabs(json_value_get_number(a) - json_value_get_number(b)) < 0.000001; /* EPSILON */
         case JSONError:
             return 1;
@@ -2065,10 +5418,51 @@ int json_boolean(const JSON_Value *value) {
 }
 
 void json_set_allocation_functions(JSON_Malloc_Function malloc_fun, JSON_Free_Function free_fun) {
+    size_t i = 0;
+    for (i = 0; i < POOL_COUNT; i++) { /* pooled blocks came from the previous allocator */
+        pool_trim(&parson_pools[i], 0);
+    }
     parson_malloc = malloc_fun;
     parson_free = free_fun;
+    parson_realloc = malloc_fun == malloc && free_fun == free ? realloc : NULL;
+}
+
+void json_set_reallocation_function(JSON_Realloc_Function realloc_fun) {
+    parson_realloc = realloc_fun;
 }
 
 void json_set_escape_slashes(int escape_slashes) {
     parson_escape_slashes = escape_slashes;
 }
+
+void json_set_parse_int64(int parse_int64) {
+    parson_parse_int64 = parse_int64;
+}
+
+void json_set_intern_keys(int intern_keys) {
+    parson_intern_keys = intern_keys;
+}
+
+size_t json_interned_key_count(void) {
+    return parson_keys_count;
+}
+
+void json_set_max_nesting(size_t max_nesting) {
+    parson_max_nesting = max_nesting;
+}
+
+void json_set_pool_limit(JSON_Pool_Kind kind, size_t max_free) {
+    if (kind < 0 || (size_t)kind >= POOL_COUNT) {
+        return;
+    }
+    parson_pools[kind].max_free = max_free;
+    pool_trim(&parson_pools[kind], max_free);
+}
+
+JSON_Status json_get_pool_stats(JSON_Pool_Kind kind, JSON_Pool_Stats *stats) {
+    if (kind < 0 || (size_t)kind >= POOL_COUNT || stats == NULL) {
+        return JSONFailure;
+    }
+    *stats = parson_pools[kind].stats;
+    return JSONSuccess;
+}
@@ -9,6 +9,7 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
@@ -30,6 +31,12 @@
 #include "azure_c_shared_utility/const_defines.h"
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include "trace_sl.h"
+#include "threadapi_sl.h"
+#include "xio_stats_sl.h"
+
+#define PALALLOC_THIS_MODULE PALALLOC_MODULE_SOCKETIO
+#include "alloc_sl.h"
 
 #define SOCKET_SUCCESS                 0
 #define INVALID_SOCKET                 -1
@@ -65,6 +72,8 @@ typedef struct SOCKET_IO_INSTANCE_TAG
     IO_STATE io_state;
     SINGLYLINKEDLIST_HANDLE pending_io_list;
     unsigned char recv_bytes[XIO_RECEIVE_BUFFER_SIZE];
+    XIO_STATS stats;
+    bool has_connected;
 } SOCKET_IO_INSTANCE;
 
 /*this function will clone an option given by name and value*/
@@ -119,6 +128,56 @@ static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
     }
 }
 
+static void count_send(SOCKET_IO_INSTANCE* socket_io_instance, ssize_t send_result)
+{
+    socket_io_instance->stats.send_calls++;
+    if (send_result > 0)
+    {
+        socket_io_instance->stats.bytes_sent += send_result;
+    }
+    else if (send_result < 0)
+    {
+        if (errno == EAGAIN)
+        {
+            socket_io_instance->stats.eagain_count++;
+        }
+        else
+        {
+            socket_io_instance->stats.last_error = errno;
+        }
+    }
+}
+
+static void count_receive(SOCKET_IO_INSTANCE* socket_io_instance, ssize_t received)
+{
+    socket_io_instance->stats.receive_calls++;
+    if (received > 0)
+    {
+        socket_io_instance->stats.bytes_received += received;
+    }
+    else if (received < 0)
+    {
+        if (errno == EAGAIN)
+        {
+            socket_io_instance->stats.eagain_count++;
+        }
+        else
+        {
+            socket_io_instance->stats.last_error = errno;
+        }
+    }
+}
+
+static void count_queued(SOCKET_IO_INSTANCE* socket_io_instance, size_t added, size_t removed)
+{
+    socket_io_instance->stats.queued_bytes += added;
+    socket_io_instance->stats.queued_bytes -= removed;
+    if (socket_io_instance->stats.queued_bytes > socket_io_instance->stats.queued_bytes_peak)
+    {
+        socket_io_instance->stats.queued_bytes_peak = socket_io_instance->stats.queued_bytes;
+    }
+}
+
 static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned char* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     int result;
@@ -153,6 +212,7 @@ static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned
             }
             else
             {
+                count_queued(socket_io_instance, size, 0);
                 result = 0;
             }
         }
@@ -183,6 +243,7 @@ static int lookup_address_and_initiate_socket_connection(SOCKET_IO_INSTANCE* soc
         if (err != 0)
         {
             LogError("Failure: getaddrinfo failure %d.", err);
+            socket_io_instance->stats.last_error = err;
             result = MU_FAILURE;
         }
         else
@@ -205,6 +266,7 @@ static int lookup_address_and_initiate_socket_connection(SOCKET_IO_INSTANCE* soc
         if (err != 0)
         {
             LogError("Failure: connect failure %d.", errno);
+            socket_io_instance->stats.last_error = errno;
             result = MU_FAILURE;
         }
     }
@@ -273,6 +335,8 @@ CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
                     result->on_bytes_received_context = NULL;
                     result->on_io_error_context = NULL;
                     result->io_state = IO_STATE_CLOSED;
+                    (void)memset(&result->stats, 0, sizeof(result->stats));
+                    result->has_connected = false;
                 }
             }
         }
@@ -348,10 +412,13 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
         }
         else
         {
+            uint64_t connect_start = ThreadAPI_GetMonotonicTime();
+
             socket_io_instance->socket = socket (AF_INET, SOCK_STREAM, 0);
             if (socket_io_instance->socket < SOCKET_SUCCESS)
             {
                 LogError("Failure: socket create failure %d.", socket_io_instance->socket);
+                socket_io_instance->stats.last_error = errno;
                 result = MU_FAILURE;
             }
             else if ((result = lookup_address_and_initiate_socket_connection(socket_io_instance)) != 0)
@@ -361,6 +428,8 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
 
             if (result == 0)
             {
+                socket_io_instance->stats.connect_ms = (uint32_t)(ThreadAPI_GetMonotonicTime() - connect_start);
+
                 socket_io_instance->on_bytes_received = on_bytes_received;
                 socket_io_instance->on_bytes_received_context = on_bytes_received_context;
 
@@ -380,6 +449,15 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
         }
     }
 
+    if (result == 0)
+    {
+        if (socket_io_instance->has_connected)
+        {
+            socket_io_instance->stats.reconnect_count++;
+        }
+        socket_io_instance->has_connected = true;
+    }
+
     if (on_io_open_complete != NULL)
     {
         on_io_open_complete(on_io_open_complete_context, result == 0 ? IO_OPEN_OK : IO_OPEN_ERROR);
@@ -458,6 +536,7 @@ int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size,
             {
 
                 ssize_t send_result = send(socket_io_instance->socket, buffer, size, 0);
+                count_send(socket_io_instance, send_result);
                 if ((send_result < 0) || ((size_t)send_result != size))
                 {
                     if (send_result == INVALID_SOCKET)
@@ -509,6 +588,9 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
         LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+        size_t received_total = 0;
+
+        TRACE_BEGIN(TRACE_EVENT_SOCKETIO_DOWORK, 0);
         while (first_pending_io != NULL)
         {
             PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
@@ -521,6 +603,7 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
             }
 
             ssize_t send_result = send(socket_io_instance->socket, pending_socket_io->bytes, pending_socket_io->size, 0);
+            count_send(socket_io_instance, send_result);
             if ((send_result < 0) || ((size_t)send_result != pending_socket_io->size))
             {
                 if (send_result == INVALID_SOCKET)
@@ -532,6 +615,7 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
                     }
                     else
                     {
+                        count_queued(socket_io_instance, 0, pending_socket_io->size);
                         free(pending_socket_io->bytes);
                         free(pending_socket_io);
                         (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
@@ -546,6 +630,7 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
                     /* simply wait until next dowork */
                     (void)memmove(pending_socket_io->bytes, pending_socket_io->bytes + send_result, pending_socket_io->size - send_result);
                     pending_socket_io->size -= send_result;
+                    count_queued(socket_io_instance, 0, send_result);
                     break;
                 }
             }
@@ -556,6 +641,7 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
                     pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
                 }
 
+                count_queued(socket_io_instance, 0, pending_socket_io->size);
                 free(pending_socket_io->bytes);
                 free(pending_socket_io);
                 if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
@@ -575,8 +661,10 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
             do
             {
                 received = recv(socket_io_instance->socket, socket_io_instance->recv_bytes, XIO_RECEIVE_BUFFER_SIZE, 0);
+                count_receive(socket_io_instance, received);
                 if (received > 0)
                 {
+                    received_total += received;
                     if (socket_io_instance->on_bytes_received != NULL)
                     {
                         /* Explicitly ignoring here the result of the callback */
@@ -596,6 +684,7 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
 
             } while (received > 0 && socket_io_instance->io_state == IO_STATE_OPEN);
         }
+        TRACE_END(TRACE_EVENT_SOCKETIO_DOWORK, received_total);
     }
 }
 
@@ -648,13 +737,42 @@ int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, con
         }
         else if (strcmp(optionName, "tcp_keepalive_time") == 0)
         {
+#if defined(SO_KEEPALIVETIME)
             result = setsockopt(socket_io_instance->socket, SOL_SOCKET, SO_KEEPALIVETIME, value, sizeof(int));
+#else
+            /* the host build: the same setting under its POSIX name */
+            result = setsockopt(socket_io_instance->socket, IPPROTO_TCP, TCP_KEEPIDLE, value, sizeof(int));
+#endif
             if (result == -1) result = errno;
         }
         else if (strcmp(optionName, OPTION_ADDRESS_TYPE) == 0)
         {
             result = socketio_setaddresstype_option(socket_io_instance, (const char*)value);
         }
+        else if (strcmp(optionName, OPTION_XIO_STATS) == 0)
+        {
+            XIO_STATS* stats = *(XIO_STATS* const*)value;
+
+            if (stats == NULL)
+            {
+                LogError("Invalid argument: stats = NULL");
+                result = MU_FAILURE;
+            }
+            else
+            {
+                *stats = socket_io_instance->stats;
+                result = 0;
+            }
+        }
+        else if (strcmp(optionName, OPTION_XIO_STATS_RESET) == 0)
+        {
+            size_t queued_bytes = socket_io_instance->stats.queued_bytes;
+
+            (void)memset(&socket_io_instance->stats, 0, sizeof(socket_io_instance->stats));
+            socket_io_instance->stats.queued_bytes = queued_bytes;
+            socket_io_instance->stats.queued_bytes_peak = queued_bytes;
+            result = 0;
+        }
         else
         {
             LogError("option not supported.");
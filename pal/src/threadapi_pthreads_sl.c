@@ -1,41 +1,171 @@
 // Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // pthread_setname_np, pthread_attr_setaffinity_np
+#endif
+
 #include "azure_macro_utils/macro_utils.h"
 #include "azure_c_shared_utility/threadapi.h"
+#include "threadapi_sl.h"
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <errno.h>
 
 #include <unistd.h>
 
 #include <pthread.h>
+#include <sched.h>
 #include <time.h>
 #include "azure_c_shared_utility/xlogging.h"
 
+#define PALALLOC_THIS_MODULE PALALLOC_MODULE_THREADAPI
+#include "alloc_sl.h"
+
 MU_DEFINE_ENUM_STRINGS(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
 
+#define STACK_PAINT 0xA5
+#define STACK_ALIGNMENT 16
+#define THREAD_NAME_SIZE 16 // Linux limit, terminator included
+
 typedef struct THREAD_INSTANCE_TAG
 {
     pthread_t Pthread_handle;
     THREAD_START_FUNC ThreadStartFunc;
     void* Arg;
+    void* StackBlock;           // NULL when the platform allocated the stack
+    unsigned char* Stack;       // StackBlock aligned, painted with STACK_PAINT
+    size_t StackSize;
+#if defined(__linux__)
+    char Name[THREAD_NAME_SIZE];    // empty for none
+#endif
 } THREAD_INSTANCE;
 
+typedef struct THREADAPI_EVENT_TAG
+{
+    pthread_mutex_t Lock;
+    pthread_cond_t Cond;        // timed waits measured on CLOCK_MONOTONIC
+    int Signaled;
+} THREADAPI_EVENT;
+
+static THREADAPI_ATTRIBUTES defaultAttributes = { 0, THREADAPI_POLICY_DEFAULT, 0, NULL, 0 };
+
 static void* ThreadWrapper(void* threadInstanceArg)
 {
     THREAD_INSTANCE* threadInstance = (THREAD_INSTANCE*)threadInstanceArg;
+#if defined(__linux__)
+    // named from inside, so the name is set before the thread function runs
+    if ((threadInstance->Name[0] != '\0') && (pthread_setname_np(pthread_self(), threadInstance->Name) != 0))
+    {
+        LogError("Failure setting thread name %s", threadInstance->Name);
+    }
+#endif
     int result = threadInstance->ThreadStartFunc(threadInstance->Arg);
     return (void*)(intptr_t)result;
 }
 
+void ThreadAPI_Attributes_Init(THREADAPI_ATTRIBUTES* attributes)
+{
+    if (attributes != NULL)
+    {
+        attributes->stack_size = 0;
+        attributes->policy = THREADAPI_POLICY_DEFAULT;
+        attributes->priority = 0;
+        attributes->name = NULL;
+        attributes->affinity = 0;
+    }
+}
+
+THREADAPI_RESULT ThreadAPI_SetDefaultAttributes(const THREADAPI_ATTRIBUTES* attributes)
+{
+    if (attributes == NULL)
+    {
+        ThreadAPI_Attributes_Init(&defaultAttributes);
+    }
+    else
+    {
+        defaultAttributes = *attributes;
+    }
+
+    return THREADAPI_OK;
+}
+
 THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    return ThreadAPI_CreateWithAttributes(threadHandle, func, arg, &defaultAttributes);
+}
+
+/* Applies attributes to pthreadAttr; allocates and paints the stack of threadInstance if it has a size */
+static int SetPthreadAttributes(pthread_attr_t* pthreadAttr, THREAD_INSTANCE* threadInstance, const THREADAPI_ATTRIBUTES* attributes)
+{
+    int result = 0;
+
+    if (attributes->stack_size != 0)
+    {
+        threadInstance->StackBlock = malloc(attributes->stack_size + STACK_ALIGNMENT);
+        if (threadInstance->StackBlock == NULL)
+        {
+            result = EAGAIN;
+        }
+        else
+        {
+            threadInstance->Stack = (unsigned char*)(((uintptr_t)threadInstance->StackBlock + STACK_ALIGNMENT - 1) & ~(uintptr_t)(STACK_ALIGNMENT - 1));
+            threadInstance->StackSize = attributes->stack_size & ~(size_t)(STACK_ALIGNMENT - 1);
+            (void)memset(threadInstance->Stack, STACK_PAINT, threadInstance->StackSize);
+            result = pthread_attr_setstack(pthreadAttr, threadInstance->Stack, threadInstance->StackSize);
+        }
+    }
+
+    if ((result == 0) && (attributes->policy != THREADAPI_POLICY_DEFAULT))
+    {
+        struct sched_param param;
+
+        (void)memset(&param, 0, sizeof(param));
+        param.sched_priority = attributes->priority;
+#if defined(PTHREAD_EXPLICIT_SCHED)
+        result = pthread_attr_setinheritsched(pthreadAttr, PTHREAD_EXPLICIT_SCHED);
+        if (result == 0)
+#endif
+        {
+            result = pthread_attr_setschedpolicy(pthreadAttr, attributes->policy);
+        }
+        if (result == 0)
+        {
+            result = pthread_attr_setschedparam(pthreadAttr, &param);
+        }
+    }
+
+#if defined(__linux__)
+    if ((result == 0) && (attributes->affinity != 0))
+    {
+        cpu_set_t cpus;
+        unsigned int cpu;
+
+        CPU_ZERO(&cpus);
+        for (cpu = 0; cpu < sizeof(attributes->affinity) * 8; cpu++)
+        {
+            if ((attributes->affinity >> cpu) & 1)
+            {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+        result = pthread_attr_setaffinity_np(pthreadAttr, sizeof(cpus), &cpus);
+    }
+#endif
+
+    return result;
+}
+
+THREADAPI_RESULT ThreadAPI_CreateWithAttributes(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg, const THREADAPI_ATTRIBUTES* attributes)
 {
     THREADAPI_RESULT result;
 
     if ((threadHandle == NULL) ||
-        (func == NULL))
+        (func == NULL) ||
+        (attributes == NULL))
     {
         result = THREADAPI_INVALID_ARG;
         LogError("(result = %" PRI_MU_ENUM ")", MU_ENUM_VALUE(THREADAPI_RESULT, result));
@@ -43,19 +173,45 @@ THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC
     else
     {
         THREAD_INSTANCE* threadInstance = malloc(sizeof(THREAD_INSTANCE));
+        pthread_attr_t pthreadAttr;
+
         if (threadInstance == NULL)
         {
             result = THREADAPI_NO_MEMORY;
             LogError("(result = %" PRI_MU_ENUM ")", MU_ENUM_VALUE(THREADAPI_RESULT, result));
         }
+        else if (pthread_attr_init(&pthreadAttr) != 0)
+        {
+            free(threadInstance);
+
+            result = THREADAPI_ERROR;
+            LogError("(result = %" PRI_MU_ENUM ")", MU_ENUM_VALUE(THREADAPI_RESULT, result));
+        }
         else
         {
             threadInstance->ThreadStartFunc = func;
             threadInstance->Arg = arg;
-            int createResult = pthread_create(&threadInstance->Pthread_handle, NULL, ThreadWrapper, threadInstance);
+            threadInstance->StackBlock = NULL;
+            threadInstance->Stack = NULL;
+            threadInstance->StackSize = 0;
+#if defined(__linux__)
+            threadInstance->Name[0] = '\0';
+            if (attributes->name != NULL)
+            {
+                (void)strncpy(threadInstance->Name, attributes->name, sizeof(threadInstance->Name) - 1);
+                threadInstance->Name[sizeof(threadInstance->Name) - 1] = '\0';
+            }
+#endif
+            int createResult = SetPthreadAttributes(&pthreadAttr, threadInstance, attributes);
+            if (createResult == 0)
+            {
+                createResult = pthread_create(&threadInstance->Pthread_handle, &pthreadAttr, ThreadWrapper, threadInstance);
+            }
+            (void)pthread_attr_destroy(&pthreadAttr);
             switch (createResult)
             {
             default:
+                free(threadInstance->StackBlock);
                 free(threadInstance);
 
                 result = THREADAPI_ERROR;
@@ -67,7 +223,16 @@ THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC
                 result = THREADAPI_OK;
                 break;
 
+            case EINVAL:
+                free(threadInstance->StackBlock);
+                free(threadInstance);
+
+                result = THREADAPI_INVALID_ARG;
+                LogError("(result = %" PRI_MU_ENUM ")", MU_ENUM_VALUE(THREADAPI_RESULT, result));
+                break;
+
             case EAGAIN:
+                free(threadInstance->StackBlock);
                 free(threadInstance);
 
                 result = THREADAPI_NO_MEMORY;
@@ -108,12 +273,45 @@ THREADAPI_RESULT ThreadAPI_Join(THREAD_HANDLE threadHandle, int* res)
             result = THREADAPI_OK;
         }
 
+        free(threadInstance->StackBlock);
         free(threadInstance);
     }
 
     return result;
 }
 
+THREADAPI_RESULT ThreadAPI_GetStackHighWaterMark(THREAD_HANDLE threadHandle, size_t* used)
+{
+    THREADAPI_RESULT result;
+
+    THREAD_INSTANCE* threadInstance = (THREAD_INSTANCE*)threadHandle;
+    if ((threadInstance == NULL) ||
+        (used == NULL))
+    {
+        result = THREADAPI_INVALID_ARG;
+        LogError("(result = %" PRI_MU_ENUM ")", MU_ENUM_VALUE(THREADAPI_RESULT, result));
+    }
+    else if (threadInstance->Stack == NULL)
+    {
+        result = THREADAPI_ERROR;
+        LogError("Stack high-water mark needs a thread created with a stack_size");
+    }
+    else
+    {
+        // stacks grow down: the paint left at the low end was never reached
+        size_t untouched = 0;
+        while ((untouched < threadInstance->StackSize) && (threadInstance->Stack[untouched] == STACK_PAINT))
+        {
+            untouched++;
+        }
+        *used = threadInstance->StackSize - untouched;
+
+        result = THREADAPI_OK;
+    }
+
+    return result;
+}
+
 void ThreadAPI_Exit(int res)
 {
     pthread_exit((void*)(intptr_t)res);
@@ -126,3 +324,174 @@ void ThreadAPI_Sleep(unsigned int milliseconds)
     struct timespec timeToSleep = { seconds, nsRemainder };
     (void)nanosleep(&timeToSleep, NULL);
 }
+
+static struct timespec MonotonicToTimespec(uint64_t milliseconds)
+{
+    struct timespec result;
+    result.tv_sec = (time_t)(milliseconds / 1000);
+    result.tv_nsec = (long)(milliseconds % 1000) * 1000000;
+    return result;
+}
+
+uint64_t ThreadAPI_GetMonotonicTime(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+void ThreadAPI_SleepUntil(uint64_t deadline)
+{
+#if defined(TIMER_ABSTIME)
+    struct timespec wakeTime = MonotonicToTimespec(deadline);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, NULL) == EINTR)
+    {
+    }
+#else
+    uint64_t now = ThreadAPI_GetMonotonicTime();
+    if (deadline > now)
+    {
+        ThreadAPI_Sleep((deadline - now > UINT_MAX) ? UINT_MAX : (unsigned int)(deadline - now));
+    }
+#endif
+}
+
+void ThreadAPI_Ticker_Init(THREADAPI_TICKER* ticker, unsigned int period_ms)
+{
+    if (ticker != NULL)
+    {
+        ticker->period = (period_ms == 0) ? 1 : period_ms;
+        ticker->next = ThreadAPI_GetMonotonicTime() + ticker->period;
+    }
+}
+
+unsigned int ThreadAPI_Ticker_Wait(THREADAPI_TICKER* ticker)
+{
+    unsigned int missed = 0;
+
+    if (ticker == NULL)
+    {
+        LogError("NULL ticker");
+    }
+    else
+    {
+        uint64_t now = ThreadAPI_GetMonotonicTime();
+        if (ticker->next > now)
+        {
+            ThreadAPI_SleepUntil(ticker->next);
+        }
+        else
+        {
+            // late: this tick is due now, drop the ones that passed entirely
+            uint64_t late = (now - ticker->next) / ticker->period;
+            missed = (late > UINT_MAX) ? UINT_MAX : (unsigned int)late;
+            ticker->next += late * ticker->period;
+        }
+        ticker->next += ticker->period;
+    }
+
+    return missed;
+}
+
+THREADAPI_EVENT_HANDLE ThreadAPI_Event_Create(void)
+{
+    THREADAPI_EVENT* result = malloc(sizeof(THREADAPI_EVENT));
+    pthread_condattr_t condAttr;
+
+    if (result == NULL)
+    {
+        LogError("Failure allocating event");
+    }
+    else if (pthread_condattr_init(&condAttr) != 0)
+    {
+        LogError("Failure creating event");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        if ((pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC) != 0) ||
+            (pthread_cond_init(&result->Cond, &condAttr) != 0))
+        {
+            LogError("Failure creating event condition");
+            free(result);
+            result = NULL;
+        }
+        else if (pthread_mutex_init(&result->Lock, NULL) != 0)
+        {
+            LogError("Failure creating event lock");
+            (void)pthread_cond_destroy(&result->Cond);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->Signaled = 0;
+        }
+        (void)pthread_condattr_destroy(&condAttr);
+    }
+
+    return result;
+}
+
+void ThreadAPI_Event_Destroy(THREADAPI_EVENT_HANDLE event)
+{
+    if (event != NULL)
+    {
+        (void)pthread_cond_destroy(&event->Cond);
+        (void)pthread_mutex_destroy(&event->Lock);
+        free(event);
+    }
+}
+
+THREADAPI_RESULT ThreadAPI_Event_Signal(THREADAPI_EVENT_HANDLE event)
+{
+    THREADAPI_RESULT result;
+
+    if (event == NULL)
+    {
+        result = THREADAPI_INVALID_ARG;
+        LogError("(result = %" PRI_MU_ENUM ")", MU_ENUM_VALUE(THREADAPI_RESULT, result));
+    }
+    else
+    {
+        (void)pthread_mutex_lock(&event->Lock);
+        event->Signaled = 1;
+        (void)pthread_cond_signal(&event->Cond);
+        (void)pthread_mutex_unlock(&event->Lock);
+
+        result = THREADAPI_OK;
+    }
+
+    return result;
+}
+
+int ThreadAPI_Event_SleepUntil(THREADAPI_EVENT_HANDLE event, uint64_t deadline)
+{
+    int result;
+
+    if (event == NULL)
+    {
+        LogError("NULL event");
+        ThreadAPI_SleepUntil(deadline);
+        result = 0;
+    }
+    else
+    {
+        struct timespec wakeTime = MonotonicToTimespec(deadline);
+        int waitResult = 0;
+
+        (void)pthread_mutex_lock(&event->Lock);
+        // 0 may be a spurious wakeup; any error but EINTR (EINVAL for a deadline
+        // out of the time_t range, say) would come back every time: take it as the deadline
+        while ((!event->Signaled) && ((waitResult == 0) || (waitResult == EINTR)))
+        {
+            waitResult = pthread_cond_timedwait(&event->Cond, &event->Lock, &wakeTime);
+        }
+        result = event->Signaled;
+        event->Signaled = 0;
+        (void)pthread_mutex_unlock(&event->Lock);
+    }
+
+    return result;
+}
@@ -0,0 +1,335 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "azure_macro_utils/macro_utils.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "threadpool_sl.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <pthread.h>
+#include <semaphore.h>
+#include "azure_c_shared_utility/xlogging.h"
+
+#define PALALLOC_THIS_MODULE PALALLOC_MODULE_THREADPOOL
+#include "alloc_sl.h"
+
+MU_DEFINE_ENUM_STRINGS(THREADPOOL_RESULT, THREADPOOL_RESULT_VALUES);
+
+// The task queue is a bounded ring under a mutex held only to copy a task in
+// or out. A task is written and its position published in the same critical
+// section, before its count is posted to queued, so a worker woken by a count
+// always finds a task to take: it never has to wait for a producer that has
+// claimed a position but not written it yet, which on a single core with a
+// lower-priority producer would keep the worker spinning forever. The mutex
+// inherits the priority of a worker blocked on it.
+typedef struct THREADPOOL_FUTURE_TAG
+{
+    sem_t done;
+    int result;
+} THREADPOOL_FUTURE;
+
+typedef struct TASK_SLOT_TAG
+{
+    THREAD_START_FUNC func;
+    void* arg;
+    THREADPOOL_FUTURE* future;
+} TASK_SLOT;
+
+typedef struct THREADPOOL_TAG
+{
+    TASK_SLOT* slots;
+    size_t mask;
+    size_t enqueue_pos;
+    size_t dequeue_pos;
+    pthread_mutex_t queue_lock;
+    sem_t queued;           // one count per task put, plus one per worker when stopping
+    THREAD_HANDLE* workers;
+    size_t thread_count;
+} THREADPOOL;
+
+static int Queue_Put(THREADPOOL* pool, THREAD_START_FUNC func, void* arg, THREADPOOL_FUTURE* future)
+{
+    TASK_SLOT* slot;
+    int result;
+
+    (void)pthread_mutex_lock(&pool->queue_lock);
+    if (pool->enqueue_pos - pool->dequeue_pos > pool->mask)
+    {
+        result = 0;
+    }
+    else
+    {
+        slot = &pool->slots[pool->enqueue_pos & pool->mask];
+        slot->func = func;
+        slot->arg = arg;
+        slot->future = future;
+        pool->enqueue_pos++;
+        result = 1;
+    }
+    (void)pthread_mutex_unlock(&pool->queue_lock);
+    return result;
+}
+
+// Returns 0 when the queue is empty
+static int Queue_Take(THREADPOOL* pool, TASK_SLOT* task)
+{
+    int result;
+
+    (void)pthread_mutex_lock(&pool->queue_lock);
+    if (pool->dequeue_pos == pool->enqueue_pos)
+    {
+        result = 0;
+    }
+    else
+    {
+        *task = pool->slots[pool->dequeue_pos & pool->mask];
+        pool->dequeue_pos++;
+        result = 1;
+    }
+    (void)pthread_mutex_unlock(&pool->queue_lock);
+    return result;
+}
+
+static int Queue_InitLock(pthread_mutex_t* lock)
+{
+    pthread_mutexattr_t attr;
+    int result;
+
+    if (pthread_mutexattr_init(&attr) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = (pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT) == 0) &&
+            (pthread_mutex_init(lock, &attr) == 0);
+        (void)pthread_mutexattr_destroy(&attr);
+    }
+    return result;
+}
+
+static void Semaphore_Wait(sem_t* semaphore)
+{
+    while ((sem_wait(semaphore) != 0) && (errno == EINTR))
+    {
+    }
+}
+
+static int ThreadPool_Worker(void* arg)
+{
+    THREADPOOL* pool = (THREADPOOL*)arg;
+    TASK_SLOT task;
+    int result;
+
+    for (;;)
+    {
+        Semaphore_Wait(&pool->queued);
+        // Every task's count is posted after the task is in the queue, so the queue is only
+        // empty here for the counts ThreadPool_Stop() posts once the queued tasks have run.
+        if (!Queue_Take(pool, &task))
+        {
+            return 0;
+        }
+
+        result = task.func(task.arg);
+        if (task.future != NULL)
+        {
+            task.future->result = result;
+            (void)sem_post(&task.future->done);
+        }
+    }
+}
+
+static void ThreadPool_Stop(THREADPOOL* pool, size_t started)
+{
+    size_t i;
+
+    for (i = 0; i < started; i++)
+    {
+        (void)sem_post(&pool->queued);
+    }
+    for (i = 0; i < started; i++)
+    {
+        if (ThreadAPI_Join(pool->workers[i], NULL) != THREADAPI_OK)
+        {
+            LogError("Failure joining worker %lu", (unsigned long)i);
+        }
+    }
+}
+
+static void ThreadPool_Free(THREADPOOL* pool)
+{
+    (void)sem_destroy(&pool->queued);
+    (void)pthread_mutex_destroy(&pool->queue_lock);
+    free(pool->workers);
+    free(pool->slots);
+    free(pool);
+}
+
+THREADPOOL_HANDLE ThreadPool_Create(size_t thread_count, size_t queue_size)
+{
+    THREADPOOL* result;
+    size_t capacity = 1;
+
+    while ((capacity < queue_size) && (capacity <= SIZE_MAX / 2 / sizeof(TASK_SLOT)))
+    {
+        capacity <<= 1;
+    }
+
+    if ((thread_count == 0) || (queue_size == 0) || (capacity < queue_size))
+    {
+        LogError("Invalid arguments: thread_count = %lu, queue_size = %lu", (unsigned long)thread_count, (unsigned long)queue_size);
+        result = NULL;
+    }
+    else if ((result = (THREADPOOL*)malloc(sizeof(THREADPOOL))) == NULL)
+    {
+        LogError("Failure allocating thread pool");
+    }
+    else
+    {
+        size_t i;
+
+        result->slots = (TASK_SLOT*)malloc(capacity * sizeof(TASK_SLOT));
+        result->workers = (THREAD_HANDLE*)malloc(thread_count * sizeof(THREAD_HANDLE));
+        if ((result->slots == NULL) || (result->workers == NULL))
+        {
+            LogError("Failure allocating thread pool queue");
+            free(result->workers);
+            free(result->slots);
+            free(result);
+            result = NULL;
+        }
+        else if (sem_init(&result->queued, 0, 0) != 0)
+        {
+            LogError("Failure creating thread pool semaphore");
+            free(result->workers);
+            free(result->slots);
+            free(result);
+            result = NULL;
+        }
+        else if (!Queue_InitLock(&result->queue_lock))
+        {
+            LogError("Failure creating thread pool lock");
+            (void)sem_destroy(&result->queued);
+            free(result->workers);
+            free(result->slots);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->mask = capacity - 1;
+            result->enqueue_pos = 0;
+            result->dequeue_pos = 0;
+            result->thread_count = thread_count;
+
+            for (i = 0; i < thread_count; i++)
+            {
+                if (ThreadAPI_Create(&result->workers[i], ThreadPool_Worker, result) != THREADAPI_OK)
+                {
+                    break;
+                }
+            }
+
+            if (i < thread_count)
+            {
+                LogError("Failure starting worker %lu of %lu", (unsigned long)i, (unsigned long)thread_count);
+                ThreadPool_Stop(result, i);
+                ThreadPool_Free(result);
+                result = NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+void ThreadPool_Destroy(THREADPOOL_HANDLE pool)
+{
+    if (pool == NULL)
+    {
+        LogError("NULL thread pool");
+    }
+    else
+    {
+        ThreadPool_Stop(pool, pool->thread_count);
+        ThreadPool_Free(pool);
+    }
+}
+
+THREADPOOL_RESULT ThreadPool_Submit(THREADPOOL_HANDLE pool, THREAD_START_FUNC func, void* arg, THREADPOOL_FUTURE_HANDLE* future)
+{
+    THREADPOOL_RESULT result;
+    THREADPOOL_FUTURE* task_future = NULL;
+
+    if ((pool == NULL) ||
+        (func == NULL))
+    {
+        result = THREADPOOL_INVALID_ARG;
+        LogError("(result = %" PRI_MU_ENUM ")", MU_ENUM_VALUE(THREADPOOL_RESULT, result));
+    }
+    else if ((future != NULL) &&
+        ((task_future = (THREADPOOL_FUTURE*)malloc(sizeof(THREADPOOL_FUTURE))) == NULL))
+    {
+        result = THREADPOOL_NO_MEMORY;
+        LogError("(result = %" PRI_MU_ENUM ")", MU_ENUM_VALUE(THREADPOOL_RESULT, result));
+    }
+    else if ((task_future != NULL) && (sem_init(&task_future->done, 0, 0) != 0))
+    {
+        free(task_future);
+
+        result = THREADPOOL_ERROR;
+        LogError("(result = %" PRI_MU_ENUM ")", MU_ENUM_VALUE(THREADPOOL_RESULT, result));
+    }
+    else if (!Queue_Put(pool, func, arg, task_future))
+    {
+        if (task_future != NULL)
+        {
+            (void)sem_destroy(&task_future->done);
+            free(task_future);
+        }
+
+        // not logged: a full queue is back pressure for the caller to handle
+        result = THREADPOOL_FULL;
+    }
+    else
+    {
+        (void)sem_post(&pool->queued);
+        if (future != NULL)
+        {
+            *future = task_future;
+        }
+
+        result = THREADPOOL_OK;
+    }
+
+    return result;
+}
+
+THREADPOOL_RESULT ThreadPool_Wait(THREADPOOL_FUTURE_HANDLE future, int* res)
+{
+    THREADPOOL_RESULT result;
+
+    if (future == NULL)
+    {
+        result = THREADPOOL_INVALID_ARG;
+        LogError("(result = %" PRI_MU_ENUM ")", MU_ENUM_VALUE(THREADPOOL_RESULT, result));
+    }
+    else
+    {
+        Semaphore_Wait(&future->done);
+        if (res != NULL)
+        {
+            *res = future->result;
+        }
+        (void)sem_destroy(&future->done);
+        free(future);
+
+        result = THREADPOOL_OK;
+    }
+
+    return result;
+}
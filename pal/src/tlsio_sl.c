@@ -20,6 +20,9 @@
 
 #include "cert_sl.h"
 #include "tlsio_sl.h"
+#include "trace_sl.h"
+#include "threadapi_sl.h"
+#include "xio_stats_sl.h"
 
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/tlsio.h"
@@ -27,6 +30,9 @@
 #include "azure_c_shared_utility/shared_util_options.h"
 #include "azure_c_shared_utility/threadapi.h"
 
+#define PALALLOC_THIS_MODULE PALALLOC_MODULE_TLSIO
+#include "alloc_sl.h"
+
 /*
  * Receive buffer size. Set to 64 as it seems to be the size used in most of
  * the other reference implementations. Increasing this would increase
@@ -62,6 +68,8 @@ typedef struct TLS_IO_INSTANCE_TAG
     int port;
     int sock;
     SlNetSockSecAttrib_t *sec_attrib_hdl;
+    XIO_STATS stats;
+    bool has_connected;
 } TLS_IO_INSTANCE;
 
 /* this function clones an option given by name and value */
@@ -134,20 +142,44 @@ static const IO_INTERFACE_DESCRIPTION tlsio_sl_interface_description =
     tlsio_sl_setoption
 };
 
+static void count_io(TLS_IO_INSTANCE *instance, int res, uint64_t *bytes,
+        uint32_t *calls)
+{
+    (*calls)++;
+    if (res > 0) {
+        *bytes += res;
+    }
+    else if (res < 0) {
+        if (errno == EAGAIN) {
+            instance->stats.eagain_count++;
+        }
+        else {
+            instance->stats.last_error = errno;
+        }
+    }
+}
+
+/* Returns 0, or the status SlNetUtil_getHostByName() failed with */
 static int init_sockaddr(struct sockaddr *addr, int port, const char *hostname)
 {
     struct sockaddr_in taddr = {0};
-    uint32_t ipAddr;
-    uint16_t addrLen = sizeof(ipAddr);
+    int32_t status;
+    /*
+     * ipAddrLen is the size of the array in entries, and a name can resolve
+     * to several addresses: room for four, the first is used.
+     */
+    uint32_t ipAddr[4];
+    uint16_t addrLen = sizeof(ipAddr) / sizeof(ipAddr[0]);
 
-    if (SlNetUtil_getHostByName(0, (char *)hostname, strlen(hostname),
-            &ipAddr, &addrLen, AF_INET) < 0) {
-        return (-1);
+    status = SlNetUtil_getHostByName(0, (char *)hostname, strlen(hostname),
+            ipAddr, &addrLen, AF_INET);
+    if (status < 0) {
+        return ((int)status);
     }
 
     taddr.sin_family = AF_INET;
     taddr.sin_port = htons(port);
-    taddr.sin_addr.s_addr = htonl(ipAddr);
+    taddr.sin_addr.s_addr = htonl(ipAddr[0]);
     *addr = *((struct sockaddr *)&taddr);
 
     return (0);
@@ -294,6 +326,10 @@ int tlsio_sl_open(CONCRETE_IO_HANDLE tls_io,
             return (result);
         }
         else {
+            uint64_t start;
+
+            TRACE_BEGIN(TRACE_EVENT_TLSIO_OPEN, 0);
+
             instance->on_bytes_received = on_bytes_received;
             instance->on_bytes_received_context = on_bytes_received_context;
 
@@ -307,9 +343,11 @@ int tlsio_sl_open(CONCRETE_IO_HANDLE tls_io,
             instance->sock = -1;
 
             struct sockaddr sa;
+            start = ThreadAPI_GetMonotonicTime();
             ret = init_sockaddr(&sa, instance->port, instance->hostname);
             if (ret != 0) {
                 LogError("Cannot resolve hostname");
+                instance->stats.last_error = ret;
                 error = true;
                 goto cleanup;
             }
@@ -321,6 +359,7 @@ int tlsio_sl_open(CONCRETE_IO_HANDLE tls_io,
                             SLNETSOCK_OPSOCK_SLNETSOCKSD,
                             &clientSd, &sdlen) < 0) {
                         LogError("getsockopt failed");
+                        instance->stats.last_error = errno;
                         error = true;
                         goto cleanup;
                     }
@@ -330,6 +369,7 @@ int tlsio_sl_open(CONCRETE_IO_HANDLE tls_io,
                             sizeof(SL_SSL_CA_CERT));
                     if (status < 0) {
                         LogError("SlNetSock_secAttribSet failed");
+                        instance->stats.last_error = status;
                         error = true;
                         goto cleanup;
                     }
@@ -339,6 +379,7 @@ int tlsio_sl_open(CONCRETE_IO_HANDLE tls_io,
                             SLNETSOCK_SEC_BIND_CONTEXT_ONLY);
                     if (status < 0) {
                         LogError("SlNetSock_startSec failed to bind context");
+                        instance->stats.last_error = status;
                         error = true;
                         goto cleanup;
                     }
@@ -347,9 +388,12 @@ int tlsio_sl_open(CONCRETE_IO_HANDLE tls_io,
                             sizeof(struct sockaddr_in));
                     if (ret < 0) {
                         LogError("Cannot connect");
+                        instance->stats.last_error = errno;
                         error = true;
                         goto cleanup;
                     }
+                    instance->stats.connect_ms =
+                            (uint32_t)(ThreadAPI_GetMonotonicTime() - start);
                     /* setup for nonblocking */
                     SlNetSock_Nonblocking_t nb;
                     nb.nonBlockingEnabled = 1;
@@ -359,19 +403,28 @@ int tlsio_sl_open(CONCRETE_IO_HANDLE tls_io,
                 }
                 else {
                     LogError("Cannot open socket");
+                    instance->stats.last_error = errno;
                     error = true;
                     goto cleanup;
                 }
             }
 
+            start = ThreadAPI_GetMonotonicTime();
             status = SlNetSock_startSec(clientSd,
                     instance->sec_attrib_hdl,
                     SLNETSOCK_SEC_START_SECURITY_SESSION_ONLY);
             if (status < 0) {
                 LogError("SlNetSock_startSec failed to start session\n");
+                instance->stats.last_error = status;
                 error = true;
                 goto cleanup;
             }
+            instance->stats.handshake_ms =
+                    (uint32_t)(ThreadAPI_GetMonotonicTime() - start);
+            if (instance->has_connected) {
+                instance->stats.reconnect_count++;
+            }
+            instance->has_connected = true;
 
             IO_OPEN_RESULT oresult = result == MU_FAILURE ? IO_OPEN_ERROR :
                                                              IO_OPEN_OK;
@@ -396,6 +449,7 @@ cleanup:
         }
     }
 
+    TRACE_END(TRACE_EVENT_TLSIO_OPEN, result);
     return result;
 }
 
@@ -438,6 +492,8 @@ int tlsio_sl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t size,
 {
     int result;
 
+    TRACE_BEGIN(TRACE_EVENT_TLSIO_SEND, size);
+
     if (tls_io == NULL) {
         LogError("NULL tls_io");
         result = MU_FAILURE;
@@ -457,6 +513,8 @@ int tlsio_sl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t size,
             result = 0;
             while (size) {
                 int res = send(instance->sock, buf, size, 0);
+                count_io(instance, res, &instance->stats.bytes_sent,
+                        &instance->stats.send_calls);
                 if ((res < 0) && (errno != EAGAIN)) {
                     result = MU_FAILURE;
                     break;
@@ -479,6 +537,7 @@ int tlsio_sl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t size,
         }
     }
 
+    TRACE_END(TRACE_EVENT_TLSIO_SEND, result);
     return result;
 }
 
@@ -495,6 +554,9 @@ void tlsio_sl_dowork(CONCRETE_IO_HANDLE tls_io)
             while (rcv_bytes > 0) {
                 rcv_bytes =  recv(tls_io_instance->sock, buffer,
                         sizeof(buffer), 0);
+                count_io(tls_io_instance, rcv_bytes,
+                        &tls_io_instance->stats.bytes_received,
+                        &tls_io_instance->stats.receive_calls);
                 if (rcv_bytes > 0) {
                     if (tls_io_instance->on_bytes_received != NULL) {
                         tls_io_instance->on_bytes_received(
@@ -518,6 +580,28 @@ int tlsio_sl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName,
     int result = 0;
     TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
 
+    if ((tls_io == NULL) || (optionName == NULL) || (value == NULL)) {
+        LogError("invalid parameter detected: tls_io=%p, optionName=%p, "
+                "value=%p", tls_io, optionName, value);
+        return (MU_FAILURE);
+    }
+
+    if (strcmp(OPTION_XIO_STATS, optionName) == 0) {
+        XIO_STATS *stats = *(XIO_STATS * const *)value;
+
+        if (stats == NULL) {
+            LogError("invalid parameter detected: stats=NULL");
+            return (MU_FAILURE);
+        }
+        *stats = tls_io_instance->stats;
+        return (0);
+    }
+
+    if (strcmp(OPTION_XIO_STATS_RESET, optionName) == 0) {
+        memset(&tls_io_instance->stats, 0, sizeof(tls_io_instance->stats));
+        return (0);
+    }
+
     /*
      * We are expecting 'value' to be the name of the secure object/file
      * containing the certificate/key. This is to allow users the
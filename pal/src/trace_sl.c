@@ -0,0 +1,249 @@
+// Copyright (c) 2020 Texas Instruments Incorporated. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "trace_sl.h"
+
+#if defined(PAL_TRACE)
+
+#include <pthread.h>
+#include <time.h>
+
+#if (TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) != 0
+#error TRACE_RING_SIZE must be a power of two
+#endif
+
+// A record is published like a seqlock: the writer clears its sequence,
+// writes the fields, then stores its index + 1; the drain only keeps records
+// whose sequence is the same before and after it copied them. Every field is
+// 32 bits so the relaxed accesses are plain loads and stores. Compilers
+// without the GNU __atomic builtins, or TRACE_USE_LOCK, use a mutex instead.
+#if !defined(__ATOMIC_ACQUIRE) && !defined(TRACE_USE_LOCK)
+#define TRACE_USE_LOCK 1
+#endif
+
+#if defined(TRACE_USE_LOCK)
+static pthread_mutex_t ringLock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK_RING() (void)pthread_mutex_lock(&ringLock)
+#define UNLOCK_RING() (void)pthread_mutex_unlock(&ringLock)
+#define FETCH_ADD(x, v) (((x) += (v)) - (v))
+#define LOAD_ACQUIRE(x) (x)
+#define LOAD_RELAXED(x) (x)
+#define STORE_RELAXED(x, v) ((x) = (v))
+#define STORE_RELEASE(x, v) ((x) = (v))
+#define FENCE_ACQUIRE()
+#define FENCE_RELEASE()
+#else
+#define LOCK_RING()
+#define UNLOCK_RING()
+#define FETCH_ADD(x, v) __atomic_fetch_add(&(x), (v), __ATOMIC_RELAXED)
+#define LOAD_ACQUIRE(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define LOAD_RELAXED(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define STORE_RELAXED(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#define STORE_RELEASE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+#define TRACE_LINE_SIZE 128
+
+typedef struct TRACE_RECORD_TAG
+{
+    uint32_t sequence;          // index + 1 once written, 0 while being written
+    uint32_t timestamp;
+    uint32_t thread;
+    uint32_t kind;              // event << 8 | phase
+    int32_t value;
+} TRACE_RECORD;
+
+static const char* const eventNames[TRACE_EVENT_COUNT] =
+{
+    "tlsio_open",
+    "tlsio_send",
+    "httpapi_execute",
+    "socketio_dowork"
+};
+
+static TRACE_RECORD ring[TRACE_RING_SIZE];
+static uint32_t head;           // records claimed by writers
+static uint32_t tail;           // records drained
+
+// drain side only
+static size_t lostCount;
+static int clockStarted;
+static uint32_t lastTimestamp;
+static int64_t ticks;           // since the first record drained
+
+uint32_t Trace_GetTimestamp(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000);
+}
+
+void Trace_Record(TRACE_EVENT event, TRACE_PHASE phase, int32_t value)
+{
+    TRACE_RECORD* record;
+    uint32_t index;
+
+    LOCK_RING();
+    index = FETCH_ADD(head, 1);
+    record = &ring[index & (TRACE_RING_SIZE - 1)];
+
+    STORE_RELAXED(record->sequence, 0);
+    FENCE_RELEASE();
+    STORE_RELAXED(record->timestamp, TRACE_TIMESTAMP());
+    STORE_RELAXED(record->thread, (uint32_t)(uintptr_t)pthread_self());
+    STORE_RELAXED(record->kind, ((uint32_t)event << 8) | (uint32_t)phase);
+    STORE_RELAXED(record->value, value);
+    STORE_RELEASE(record->sequence, index + 1);
+    UNLOCK_RING();
+}
+
+/* Returns 1 with a consistent copy of record index, 0 if it isn't written yet, -1 if it was overwritten */
+static int Trace_Read(uint32_t index, TRACE_RECORD* copy)
+{
+    TRACE_RECORD* record = &ring[index & (TRACE_RING_SIZE - 1)];
+    uint32_t sequence;
+    int result;
+
+    LOCK_RING();
+    sequence = LOAD_ACQUIRE(record->sequence);
+    copy->timestamp = LOAD_RELAXED(record->timestamp);
+    copy->thread = LOAD_RELAXED(record->thread);
+    copy->kind = LOAD_RELAXED(record->kind);
+    copy->value = LOAD_RELAXED(record->value);
+    FENCE_ACQUIRE();
+    if (sequence != LOAD_RELAXED(record->sequence))
+    {
+        // rewritten while copied, by a writer a lap ahead
+        result = -1;
+    }
+    else if (sequence == index + 1)
+    {
+        result = 1;
+    }
+    else if ((sequence == 0) || ((int32_t)(index + 1 - sequence) > 0))
+    {
+        // claimed but not published yet, or still the previous lap's
+        result = 0;
+    }
+    else
+    {
+        result = -1;
+    }
+    UNLOCK_RING();
+    return result;
+}
+
+static uint64_t Trace_ToMicroseconds(uint32_t timestamp)
+{
+    if (!clockStarted)
+    {
+        lastTimestamp = timestamp;
+        clockStarted = 1;
+    }
+
+    // records are in claim order, so threads can make the clock step back slightly
+    ticks += (int32_t)(timestamp - lastTimestamp);
+    lastTimestamp = timestamp;
+    if (ticks < 0)
+    {
+        return 0;
+    }
+    return ((uint64_t)ticks / TRACE_TIMESTAMP_HZ) * 1000000 + ((uint64_t)ticks % TRACE_TIMESTAMP_HZ) * 1000000 / TRACE_TIMESTAMP_HZ;
+}
+
+size_t Trace_Drain(TRACE_FORMAT format, TRACE_OUTPUT_FUNCTION output, void* context)
+{
+    static const char phaseLetters[] = "BEi";
+    static const char* const argNames[] = { "begin", "end", "value" };
+    char line[TRACE_LINE_SIZE];
+    TRACE_RECORD copy;
+    uint32_t end;
+    uint32_t index;
+    size_t result = 0;
+
+    if (output == NULL)
+    {
+        return 0;
+    }
+
+    LOCK_RING();
+    end = LOAD_ACQUIRE(head);
+    UNLOCK_RING();
+    index = tail;
+    if (end - index > TRACE_RING_SIZE)
+    {
+        lostCount += end - index - TRACE_RING_SIZE;
+        index = end - TRACE_RING_SIZE;
+    }
+
+    if (format == TRACE_FORMAT_CHROME)
+    {
+        output(context, "{\"traceEvents\":[");
+    }
+
+    for (; index != end; index++)
+    {
+        unsigned int event;
+        unsigned int phase;
+        int read = Trace_Read(index, &copy);
+
+        if (read == 0)
+        {
+            // left for the next drain
+            break;
+        }
+        else if (read < 0)
+        {
+            lostCount++;
+            continue;
+        }
+
+        event = copy.kind >> 8;
+        phase = copy.kind & 0xFF;
+        if ((event >= TRACE_EVENT_COUNT) || (phase > TRACE_PHASE_INSTANT))
+        {
+            lostCount++;
+            continue;
+        }
+
+        if (format == TRACE_FORMAT_CHROME)
+        {
+            (void)snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"%c\",%s\"ts\":%lu,\"pid\":1,\"tid\":%lu,\"args\":{\"%s\":%ld}}",
+                (result == 0) ? "" : ",", eventNames[event], phaseLetters[phase], (phase == TRACE_PHASE_INSTANT) ? "\"s\":\"t\"," : "",
+                (unsigned long)Trace_ToMicroseconds(copy.timestamp), (unsigned long)copy.thread, argNames[phase], (long)copy.value);
+        }
+        else
+        {
+            (void)snprintf(line, sizeof(line), "%10lu us %08lx %c %-16s %ld",
+                (unsigned long)Trace_ToMicroseconds(copy.timestamp), (unsigned long)copy.thread, phaseLetters[phase],
+                eventNames[event], (long)copy.value);
+        }
+        output(context, line);
+        result++;
+    }
+    tail = index;
+
+    if (format == TRACE_FORMAT_CHROME)
+    {
+        output(context, "]}");
+    }
+
+    return result;
+}
+
+size_t Trace_GetLostCount(void)
+{
+    return lostCount;
+}
+
+#else
+
+typedef int trace_disabled; /* ISO C doesn't allow an empty translation unit */
+
+#endif /* PAL_TRACE */
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "azure_c_shared_utility/threadapi.h"
+#include "iothub_client_ll.h"
+#include "threadapi_sl.h"
+
+#include "dowork_scheduler.h"
+
+/*
+ * The HTTP transport polls for C2D messages in the first DoWork at least
+ * MinimumPollingTime after its last poll, timed from inside that DoWork.
+ * Counting from when DoWork returns, plus this margin, makes sure the wakeup
+ * isn't a few ms early and the poll isn't put off by a whole period.
+ */
+#define POLL_MARGIN_MS (10)
+
+struct DoWorkScheduler {
+    IOTHUB_CLIENT_LL_HANDLE client;
+    THREADAPI_EVENT_HANDLE event;
+    uint64_t pollInterval;
+    uint64_t busyInterval;
+    uint64_t nextPoll;
+    uint32_t wakeups;
+};
+
+/*
+ *  ======== DoWorkScheduler_create =======
+ */
+DoWorkScheduler_Handle DoWorkScheduler_create(IOTHUB_CLIENT_LL_HANDLE client,
+        unsigned int minimumPollingTime, unsigned int busyInterval)
+{
+    DoWorkScheduler_Handle scheduler;
+
+    if (client == NULL) {
+        return (NULL);
+    }
+
+    scheduler = malloc(sizeof(struct DoWorkScheduler));
+    if (scheduler == NULL) {
+        return (NULL);
+    }
+
+    scheduler->event = ThreadAPI_Event_Create();
+    if (scheduler->event == NULL) {
+        free(scheduler);
+        return (NULL);
+    }
+
+    scheduler->client = client;
+    scheduler->pollInterval = (uint64_t)minimumPollingTime * 1000;
+    scheduler->busyInterval = busyInterval;
+    scheduler->nextPoll = 0;
+    scheduler->wakeups = 0;
+
+    return (scheduler);
+}
+
+/*
+ *  ======== DoWorkScheduler_delete =======
+ */
+void DoWorkScheduler_delete(DoWorkScheduler_Handle scheduler)
+{
+    if (scheduler != NULL) {
+        ThreadAPI_Event_Destroy(scheduler->event);
+        free(scheduler);
+    }
+}
+
+/*
+ *  ======== DoWorkScheduler_step =======
+ */
+void DoWorkScheduler_step(DoWorkScheduler_Handle scheduler)
+{
+    IOTHUB_CLIENT_STATUS status;
+    uint64_t now;
+    uint64_t deadline;
+
+    IoTHubClient_LL_DoWork(scheduler->client);
+    scheduler->wakeups++;
+
+    now = ThreadAPI_GetMonotonicTime();
+    if (now >= scheduler->nextPoll) {
+        /* this DoWork polled */
+        scheduler->nextPoll = now + scheduler->pollInterval + POLL_MARGIN_MS;
+    }
+
+    deadline = scheduler->nextPoll;
+    if ((IoTHubClient_LL_GetSendStatus(scheduler->client, &status) ==
+            IOTHUB_CLIENT_OK) && (status == IOTHUB_CLIENT_SEND_STATUS_BUSY) &&
+            (now + scheduler->busyInterval < deadline)) {
+        deadline = now + scheduler->busyInterval;
+    }
+
+    (void)ThreadAPI_Event_SleepUntil(scheduler->event, deadline);
+}
+
+/*
+ *  ======== DoWorkScheduler_notify =======
+ */
+void DoWorkScheduler_notify(DoWorkScheduler_Handle scheduler)
+{
+    (void)ThreadAPI_Event_Signal(scheduler->event);
+}
+
+/*
+ *  ======== DoWorkScheduler_getWakeups =======
+ */
+uint32_t DoWorkScheduler_getWakeups(DoWorkScheduler_Handle scheduler)
+{
+    return (scheduler->wakeups);
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __DoWorkScheduler_H
+#define __DoWorkScheduler_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+
+#include "iothub_client_ll.h"
+
+/*
+ *  Runs IoTHubClient_LL_DoWork() only when the client needs it, instead of
+ *  every 100 ms: right away while sends are pending (every busyInterval ms
+ *  until their confirmations arrive), otherwise when the next C2D poll is due
+ *  after minimumPollingTime seconds, the same value given to the
+ *  "MinimumPollingTime" option. Between those the calling thread sleeps, and
+ *  DoWorkScheduler_notify() wakes it early.
+ */
+typedef struct DoWorkScheduler *DoWorkScheduler_Handle;
+
+/*
+ *  ======== DoWorkScheduler_create =======
+ *  Create a scheduler for client; returns NULL on failure
+ */
+DoWorkScheduler_Handle DoWorkScheduler_create(IOTHUB_CLIENT_LL_HANDLE client,
+        unsigned int minimumPollingTime, unsigned int busyInterval);
+
+/*
+ *  ======== DoWorkScheduler_delete =======
+ */
+void DoWorkScheduler_delete(DoWorkScheduler_Handle scheduler);
+
+/*
+ *  ======== DoWorkScheduler_step =======
+ *  Call DoWork, then sleep until it is needed again or notified
+ */
+void DoWorkScheduler_step(DoWorkScheduler_Handle scheduler);
+
+/*
+ *  ======== DoWorkScheduler_notify =======
+ *  Make the sleeping (or next) step run DoWork at once, e.g. after a send is
+ *  queued. Can be called from any thread.
+ */
+void DoWorkScheduler_notify(DoWorkScheduler_Handle scheduler);
+
+/*
+ *  ======== DoWorkScheduler_getWakeups =======
+ *  Number of DoWork calls so far
+ */
+uint32_t DoWorkScheduler_getWakeups(DoWorkScheduler_Handle scheduler);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
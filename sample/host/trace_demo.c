@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2020, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ======== trace_demo.c ========
+ *  Host demo of the PAL trace (trace_sl.c): two threads stand in for the
+ *  SDK, one sending telemetry through HTTPAPI_ExecuteRequest() and one
+ *  running socketio_dowork(), and mark the same events the PAL does. The
+ *  trace is written as a Chrome trace; open the file in chrome://tracing or
+ *  https://ui.perfetto.dev to see the nested calls of each thread on a
+ *  timeline.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include "trace_sl.h"
+
+#define SENDS   (8)
+#define DOWORKS (40)
+
+/*
+ *  ======== sleepMs ========
+ */
+static void sleepMs(unsigned int ms)
+{
+    struct timespec delay;
+
+    delay.tv_sec = ms / 1000;
+    delay.tv_nsec = (long)(ms % 1000) * 1000000;
+    (void)nanosleep(&delay, NULL);
+}
+
+/*
+ *  ======== sender ========
+ *  One HTTP request per message, opening the TLS connection on the first.
+ */
+static void *sender(void *arg)
+{
+    int i;
+
+    (void)arg;
+    for (i = 0; i < SENDS; i++) {
+        size_t bytes = 180 + (size_t)(rand() % 80);
+
+        TRACE_BEGIN(TRACE_EVENT_HTTPAPI_EXECUTE, bytes);
+        if (i == 0) {
+            TRACE_BEGIN(TRACE_EVENT_TLSIO_OPEN, 0);
+            sleepMs(40);
+            TRACE_END(TRACE_EVENT_TLSIO_OPEN, 0);
+        }
+        TRACE_BEGIN(TRACE_EVENT_TLSIO_SEND, bytes + 420);
+        sleepMs(5 + rand() % 10);
+        TRACE_END(TRACE_EVENT_TLSIO_SEND, 0);
+
+        /* waiting for the response */
+        sleepMs(20 + rand() % 30);
+        TRACE_END(TRACE_EVENT_HTTPAPI_EXECUTE, 0);
+
+        sleepMs(10);
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== worker ========
+ */
+static void *worker(void *arg)
+{
+    int i;
+
+    (void)arg;
+    for (i = 0; i < DOWORKS; i++) {
+        int received = (i % 7 == 0) ? 64 * (1 + rand() % 4) : 0;
+
+        TRACE_BEGIN(TRACE_EVENT_SOCKETIO_DOWORK, 0);
+        sleepMs(received ? 3 : 1);
+        TRACE_END(TRACE_EVENT_SOCKETIO_DOWORK, received);
+
+        sleepMs(10);
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== writeLine ========
+ */
+static void writeLine(void *context, const char *line)
+{
+    fprintf((FILE *)context, "%s\n", line);
+}
+
+/*
+ *  ======== main ========
+ */
+int main(int argc, char *argv[])
+{
+    const char *path = (argc > 1) ? argv[1] : "trace.json";
+    pthread_t threads[2];
+    FILE *file;
+    size_t count;
+
+    srand((unsigned int)time(NULL));
+
+    /* the run records about 115 events, well within the default ring */
+    if ((pthread_create(&threads[0], NULL, sender, NULL) != 0) ||
+            (pthread_create(&threads[1], NULL, worker, NULL) != 0)) {
+        fprintf(stderr, "Failed to start threads\n");
+        return (1);
+    }
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+
+    file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return (1);
+    }
+    count = Trace_Drain(TRACE_FORMAT_CHROME, writeLine, file);
+    fclose(file);
+
+    printf("%lu events written to %s, %lu lost\n", (unsigned long)count,
+            path, (unsigned long)Trace_GetLostCount());
+    return (0);
+}
@@ -17,6 +17,9 @@ and removing calls to _DoWork will yield the same results. */
 #include "serializer.h"
 #include "iothub_client_ll.h"
 #include "iothubtransporthttp.h"
+#include "parson_sl.h"
+#include "dowork_scheduler.h"
+#include "trace_sl.h"
 
 #include <ti/display/Display.h>
 
@@ -87,6 +90,17 @@ void Display_log(LOG_CATEGORY log_category, const char* file, const char* func,
 }
 #endif // ENABLE_LOGGING
 
+/*
+ * To print the timing of the PAL's TLS, socket and HTTP calls after each
+ * DoWork, build the PAL library and this sample with PAL_TRACE defined.
+ */
+#ifdef PAL_TRACE
+static void Display_trace(void* context, const char* line)
+{
+    Display_printf(display, 0, 0, "%s", line);
+}
+#endif // PAL_TRACE
+
 EXECUTE_COMMAND_RESULT TurnFanOn(ContosoAnemometer* device)
 {
     (void)device;
@@ -147,13 +161,31 @@ static IOTHUBMESSAGE_DISPOSITION_RESULT IoTHubMessage(IOTHUB_MESSAGE_HANDLE mess
     IOTHUBMESSAGE_DISPOSITION_RESULT result;
     const unsigned char* buffer;
     size_t size;
+    JSON_View nameView;
+    char name[32];
     if (IoTHubMessage_GetByteArray(message, &buffer, &size) != IOTHUB_MESSAGE_OK)
     {
         Display_printf(display, 0, 0, "unable to IoTHubMessage_GetByteArray");
         result = IOTHUBMESSAGE_ABANDONED;
     }
+    /*look at the command name in place, messages without one aren't worth copying and parsing*/
+    else if (json_view_find((const char*)buffer, size, "Name", &nameView) != JSONSuccess ||
+        nameView.type != JSONString)
+    {
+        Display_printf(display, 0, 0, "message has no command name");
+        result = IOTHUBMESSAGE_REJECTED;
+    }
     else
     {
+        /*the name is only copied for display, the serializer matches it against the model*/
+        if (json_view_get_string(&nameView, name, sizeof(name)) == JSONSuccess)
+        {
+            Display_printf(display, 0, 0, "Received command %s", name);
+        }
+        else
+        {
+            Display_printf(display, 0, 0, "Received a command with a long name");
+        }
         /*buffer is not zero terminated*/
         char* temp = malloc(size + 1);
         if (temp == NULL)
@@ -209,8 +241,8 @@ void simplesample_http_run(void)
             }
             else
             {
-                // Because it can poll "after 9 seconds" polls will happen
-                // effectively at ~10 seconds.
+                // The scheduler below wakes for each poll as soon as the
+                // 9 seconds have passed.
                 // Note that for scalabilty, the default value of minimumPollingTime
                 // is 25 minutes. For more information, see:
                 // https://azure.microsoft.com/documentation/articles/iot-hub-devguide/#messaging
@@ -285,11 +317,21 @@ void simplesample_http_run(void)
                             }
                         }
 
-                        /* wait for commands */
-                        while (1)
+                        /* wait for commands, waking only when a poll is due or a send is in flight */
+                        DoWorkScheduler_Handle scheduler = DoWorkScheduler_create(iotHubClientHandle, minimumPollingTime, 100);
+                        if (scheduler == NULL)
                         {
-                            IoTHubClient_LL_DoWork(iotHubClientHandle);
-                            ThreadAPI_Sleep(100);
+                            Display_printf(display, 0, 0, "Failed on DoWorkScheduler_create");
+                        }
+                        else
+                        {
+                            while (1)
+                            {
+                                DoWorkScheduler_step(scheduler);
+#ifdef PAL_TRACE
+                                (void)Trace_Drain(TRACE_FORMAT_TEXT, Display_trace, NULL);
+#endif // PAL_TRACE
+                            }
                         }
                     }
 